@@ -26,6 +26,52 @@
 
 #include "Plugins.h"
 
+static FilmProfile alephbet1_0 = {
+	true,  // keyframe_fix
+	false, // damage_aggressor_last_in_tag
+	true,  // swipe_nearby_items_fix
+	true,  // initial_monster_fix
+	true,  // long_distance_physics
+	true,  // animate_items
+	true,  // inexplicable_pin_change
+	false, // increased_dynamic_limits_1_0
+	true,  // increased_dynamic_limits_1_1
+	true,  // line_is_obstructed_fix
+	false, // a1_smg
+	true,  // infinity_smg
+	true,  // use_vertical_kick_threshold
+	true,  // infinity_tag_fix
+	true,  // adjacent_polygons_always_intersect
+	true,  // early_object_initialization
+	true,  // fix_sliding_on_platforms
+	true,  // prevent_dead_projectile_owners
+	true,  // validate_random_ranged_attack
+	true,  // allow_short_kamikaze
+	true,  // ketchup_fix
+	false, // lua_increments_rng
+	true,  // destroy_players_ball_fix
+	true,  // calculate_terminal_lines_correctly
+	true,  // key_frame_zero_shrapnel_fix
+	true,  // count_dead_dropped_items_correctly
+	true,  // m1_low_gravity_projectiles
+	true,  // m1_buggy_repair_goal
+	false, // find_action_key_target_has_side_effects
+	true,  // m1_object_unused
+	true,  // m1_platform_flood
+	true,  // m1_teleport_without_delay
+	true,  // better_terminal_word_wrap
+	true,  // lua_monster_killed_trigger_fix
+	true,  // chip_insertion_ignores_tag_state
+	true,  // page_up_past_full_width_term_pict
+	true,  // fix_destroy_scenery_random_frame
+	true,  // m1_reload_sound
+	true,  // m1_landscape_effects
+	true,  // m1_bce_pickup
+	false, // hierarchical_pathfinding
+	false, // potentially_visible_sets
+	false, // m1_exploration_portals
+};
+
 static FilmProfile alephone1_7 = {
 	true,  // keyframe_fix
 	false, // damage_aggressor_last_in_tag
@@ -67,6 +113,9 @@ static FilmProfile alephone1_7 = {
 	true,  // m1_reload_sound
 	true,  // m1_landscape_effects
 	true,  // m1_bce_pickup
+	false, // hierarchical_pathfinding
+	false, // potentially_visible_sets
+	false, // m1_exploration_portals
 };
 
 static FilmProfile alephone1_4 = {
@@ -110,6 +159,9 @@ static FilmProfile alephone1_4 = {
 	false, // m1_reload_sound
 	false, // m1_landscape_effects
 	false, // m1_bce_pickup
+	false, // hierarchical_pathfinding
+	false, // potentially_visible_sets
+	false, // m1_exploration_portals
 };
 
 
@@ -154,6 +206,9 @@ static FilmProfile alephone1_3 = {
 	false, // m1_reload_sound
 	false, // m1_landscape_effects
 	false, // m1_bce_pickup
+	false, // hierarchical_pathfinding
+	false, // potentially_visible_sets
+	false, // m1_exploration_portals
 };
 
 static FilmProfile alephone1_2 = {
@@ -197,6 +252,9 @@ static FilmProfile alephone1_2 = {
 	false, // m1_reload_sound
 	false, // m1_landscape_effects
 	false, // m1_bce_pickup
+	false, // hierarchical_pathfinding
+	false, // potentially_visible_sets
+	false, // m1_exploration_portals
 };
 
 static FilmProfile alephone1_1 = {
@@ -240,6 +298,9 @@ static FilmProfile alephone1_1 = {
 	false, // m1_reload_sound
 	false, // m1_landscape_effects
 	false, // m1_bce_pickup
+	false, // hierarchical_pathfinding
+	false, // potentially_visible_sets
+	false, // m1_exploration_portals
 };
 
 static FilmProfile alephone1_0 = {
@@ -283,6 +344,9 @@ static FilmProfile alephone1_0 = {
 	false, // m1_reload_sound
 	false, // m1_landscape_effects
 	false, // m1_bce_pickup
+	false, // hierarchical_pathfinding
+	false, // potentially_visible_sets
+	false, // m1_exploration_portals
 };
 
 static FilmProfile marathon2 = {
@@ -326,6 +390,9 @@ static FilmProfile marathon2 = {
 	false, // m1_reload_sound
 	false, // m1_landscape_effects
 	false, // m1_bce_pickup
+	false, // hierarchical_pathfinding
+	false, // potentially_visible_sets
+	false, // m1_exploration_portals
 };
 
 static FilmProfile marathon_infinity = {
@@ -369,6 +436,9 @@ static FilmProfile marathon_infinity = {
 	false, // m1_reload_sound
 	false, // m1_landscape_effects
 	false, // m1_bce_pickup
+	false, // hierarchical_pathfinding
+	false, // potentially_visible_sets
+	false, // m1_exploration_portals
 };
 
 FilmProfile film_profile = alephone1_7;
@@ -381,6 +451,13 @@ void load_film_profile(FilmProfileType type, bool reload_mml)
 	switch (type)
 	{
 	case FILM_PROFILE_DEFAULT:
+		film_profile = alephbet1_0;
+		break;
+	case FILM_PROFILE_ALEPH_BET_1_0_HIERARCHICAL_PATHFINDING:
+		film_profile = alephbet1_0;
+		film_profile.hierarchical_pathfinding = true;
+		break;
+	case FILM_PROFILE_ALEPH_ONE_1_7:
 		film_profile = alephone1_7;
 		break;
 	case FILM_PROFILE_MARATHON_2:
@@ -112,6 +112,11 @@ struct FilmProfile
 	bool m1_reload_sound;		// play the reload sound on the key frame
 	bool m1_landscape_effects;	// projectiles detonate on M1 landscapes
 	bool m1_bce_pickup;	 // you can pick up another BCE if you already have one
+
+	// Aleph Bet 1.0 additions
+	bool hierarchical_pathfinding; // monsters path through polygon clusters first
+	bool potentially_visible_sets; // line of sight and M1 exploration skip polygons that can't be seen; no profile uses it yet
+	bool m1_exploration_portals; // M1 exploration walks the transparent lines in view instead of building a view tree; no profile uses it yet
 };
 
 extern FilmProfile film_profile;
@@ -124,7 +129,9 @@ enum FilmProfileType {
 	FILM_PROFILE_ALEPH_ONE_1_2,
 	FILM_PROFILE_ALEPH_ONE_1_3,
 	FILM_PROFILE_ALEPH_ONE_1_4,
+	FILM_PROFILE_ALEPH_ONE_1_7,
 	FILM_PROFILE_DEFAULT,
+	FILM_PROFILE_ALEPH_BET_1_0_HIERARCHICAL_PATHFINDING, // the default, with hierarchical_pathfinding
 };
 
 void load_film_profile(FilmProfileType type, bool reload_mml = true);
@@ -143,7 +143,10 @@ extern bool MainScreenVisible(void);
 
 void alert_user(const char *message, short severity) 
 {
-  if (!MainScreenVisible()) {
+  if (!SDL_WasInit(SDL_INIT_VIDEO)) {
+	// headless (alephbet-replay): nobody is around to click a message box
+	fprintf(stderr, "%s: %s\n", severity == infoError ? "WARNING" : "ERROR", message);
+  } else if (!MainScreenVisible()) {
 	SDL_ShowSimpleMessageBox(severity == infoError ? SDL_MESSAGEBOX_WARNING : SDL_MESSAGEBOX_ERROR, severity == infoError ? "Warning" : "Error", message, NULL);
   } else {
     dialog d;
@@ -288,7 +288,7 @@ static void unicode_to_utf8(uint16 c, string& output)
 	}
 }
 
-static uint16 utf8_to_unicode(const char *s, int &chars_used)
+uint16 utf8_to_unicode(const char *s, int &chars_used)
 {
 	const unsigned char *input = (unsigned char *) s;
 	if ((unsigned char) input[0] < 0x80)
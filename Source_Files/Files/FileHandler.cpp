@@ -48,6 +48,7 @@
 #include <vector>
 #include <functional>
 #include <map>
+#include <algorithm>
 
 #include <SDL2/SDL_endian.h>
 
@@ -1730,3 +1731,45 @@ ScopedSearchPath::~ScopedSearchPath()
 	assert(data_search_path.size() && data_search_path.front() == d);
 	data_search_path.erase(data_search_path.begin());
 }
+
+void prune_cache_directory(const DirectorySpecifier& directory, const char *prefix, size_t limit)
+{
+	struct cache_entry
+	{
+		FileSpecifier file;
+		TimeType date;
+		size_t size;
+	};
+	std::vector<cache_entry> entries;
+	size_t total = 0;
+	size_t prefix_length = strlen(prefix);
+
+	FileSpecifier dir = directory;
+	for (const auto& it : dir.ReadDirectory())
+	{
+		if (it.is_directory || it.name.compare(0, prefix_length, prefix) != 0)
+			continue;
+
+		FileSpecifier file = dir + it.name;
+		OpenedFile opened;
+		int32 length = 0;
+		if (!file.Open(opened) || !opened.GetLength(length))
+			continue;
+		opened.Close();
+
+		entries.push_back({file, it.date, static_cast<size_t>(length)});
+		total += length;
+	}
+
+	if (total <= limit)
+		return;
+
+	std::sort(entries.begin(), entries.end(), [](const cache_entry& a, const cache_entry& b) { return a.date < b.date; });
+	for (auto& it : entries)
+	{
+		if (total <= limit / 4 * 3)
+			break;
+		if (it.file.Delete())
+			total -= it.size;
+	}
+}
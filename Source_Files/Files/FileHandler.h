@@ -349,5 +349,10 @@ private:
 	const DirectorySpecifier d;
 };
 
+// once the files in directory whose names start with prefix come to more than
+// limit bytes, deletes the oldest of them until they're down to three quarters
+// of it (leaving some room for this run's files)
+void prune_cache_directory(const DirectorySpecifier& directory, const char *prefix, size_t limit);
+
 #endif
 
@@ -274,3 +274,35 @@ uint16 calculate_data_crc_ccitt(unsigned char *data, int32 length)
   }
   return (uint16)(crc ^ 0);
 }
+
+uint32 calculate_data_fnv1a(
+	const void *buffer,
+	size_t length,
+	uint32 hash)
+{
+	const uint8 *bytes= static_cast<const uint8 *>(buffer);
+	
+	for (size_t i= 0; i<length; ++i)
+	{
+		hash^= bytes[i];
+		hash*= 16777619u;
+	}
+	
+	return hash;
+}
+
+uint64_t calculate_data_fnv1a_64(
+	const void *buffer,
+	size_t length,
+	uint64_t hash)
+{
+	const uint8 *bytes= static_cast<const uint8 *>(buffer);
+	
+	for (size_t i= 0; i<length; ++i)
+	{
+		hash^= bytes[i];
+		hash*= 1099511628211ull;
+	}
+	
+	return hash;
+}
@@ -36,4 +36,24 @@ uint32 calculate_data_crc(unsigned char *buffer, int32 length);
 
 uint16 calculate_data_crc_ccitt(unsigned char *buffer, int32 length);
 
+// FNV-1a, which is much quicker than a CRC and good enough to tell maps, cache
+// keys or world states apart; pass an earlier result as hash to carry on from it
+#define FNV1A_OFFSET_BASIS 2166136261u
+#define FNV1A_64_OFFSET_BASIS 14695981039346656037ull
+
+uint32 calculate_data_fnv1a(const void *buffer, size_t length, uint32 hash= FNV1A_OFFSET_BASIS);
+uint64_t calculate_data_fnv1a_64(const void *buffer, size_t length, uint64_t hash= FNV1A_64_OFFSET_BASIS);
+
+// the four bytes of value, least significant first, so every machine agrees
+static inline uint32 calculate_value_fnv1a(int32 value, uint32 hash)
+{
+	for (int i= 0; i<4; ++i, value>>= 8)
+	{
+		hash^= static_cast<uint8>(value);
+		hash*= 16777619u;
+	}
+	
+	return hash;
+}
+
 #endif
@@ -59,6 +59,8 @@
 #include "SoundManager.h"
 #include "Plugins.h"
 #include "ephemera.h"
+#include "pvs.h"
+#include "map_index_cache.h"
 
 // LP change: added chase-cam init and render allocation
 #include "ChaseCam.h"
@@ -870,6 +872,8 @@ void allocate_map_for_counts(
 	// Stuff that needs the max number of polygons
 	allocate_render_memory();
 	allocate_flood_map_memory();
+	invalidate_polygon_grid();
+	invalidate_potentially_visible_sets();
 }
 
 void load_points(
@@ -1957,10 +1961,11 @@ static void load_redundant_map_data(
 		assert(0 <= static_cast<int16>(count));
 		dynamic_world->map_index_count= static_cast<int16>(count);
 	}
-	else
+	else if (!load_cached_map_indexes())
 	{
 		recalculate_redundant_map();
 		precalculate_map_indexes();
+		save_cached_map_indexes();
 	}
 }
 
@@ -0,0 +1,202 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+#include "WorldUpdateThread.h"
+
+#include "Console.h"
+#include "interface.h"
+#include "Logging.h"
+#include "map.h"
+#include "Movie.h"
+
+// Lua scripts and the deeper recursions of the world code want more than
+// some platforms give a new thread by default
+static constexpr size_t kStackSize = 8 * 1024 * 1024;
+
+struct world_thread_command
+{
+	void operator() (const std::string& arg) const {
+		WorldUpdateThread* thread = WorldUpdateThread::instance();
+		if (arg == "on")
+			thread->enable(true);
+		else if (arg == "off")
+			thread->enable(false);
+		else
+		{
+			screen_printf("world_thread on|off");
+			return;
+		}
+		screen_printf("world update thread (experimental) %s", thread->enabled() ? "on" : "off");
+	}
+};
+
+WorldUpdateThread* WorldUpdateThread::instance()
+{
+	static WorldUpdateThread* m_instance = nullptr;
+	if (!m_instance)
+		m_instance = new WorldUpdateThread;
+	return m_instance;
+}
+
+WorldUpdateThread::WorldUpdateThread() :
+	m_thread(nullptr), m_thread_id(0), m_running(false), m_main_thread_request(nullptr),
+	m_has_pending(false), m_pending{false, 0, 0}, m_enabled(false)
+{
+}
+
+void WorldUpdateThread::register_console_command()
+{
+	Console::instance()->register_command("world_thread", world_thread_command());
+}
+
+std::pair<bool, int16> WorldUpdateThread::update_world()
+{
+	std::pair<bool, int16> result(false, 0);
+	if (m_has_pending)
+	{
+		m_has_pending = false;
+		result = finish_world_update(m_pending);
+	}
+
+	// the ticks may have ended the game
+	if (get_game_state() == _game_in_progress)
+	{
+		std::pair<bool, int16> due = ::update_world();
+		result.first = result.first || due.first;
+		result.second += due.second;
+	}
+
+	return result;
+}
+
+bool WorldUpdateThread::begin_present()
+{
+	// a movie frame is taken after the present, and mixes in the sound of
+	// the frame it was taken for
+	if (!m_enabled || m_running || m_has_pending || get_game_state() != _game_in_progress || Movie::instance()->IsRecording())
+		return false;
+
+	if (!m_thread)
+	{
+		m_thread = SDL_CreateThreadWithStackSize(run, "WorldUpdateThread", kStackSize, this);
+		if (!m_thread)
+		{
+			logWarning("Couldn't start the world update thread: %s", SDL_GetError());
+			m_enabled = false;
+			return false;
+		}
+		m_thread_id = SDL_GetThreadID(m_thread);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_running = true;
+	}
+	m_start.notify_all();
+	return true;
+}
+
+void WorldUpdateThread::end_present()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		m_done.wait(lock, [this] { return !m_running || m_main_thread_request; });
+		if (!m_main_thread_request)
+			break;
+
+		const std::function<void()>* request = m_main_thread_request;
+		lock.unlock();
+		try {
+			(*request)();
+		}
+		catch (...) {
+			m_main_thread_exception = std::current_exception();
+		}
+		lock.lock();
+
+		m_main_thread_request = nullptr;
+		m_start.notify_all();
+	}
+
+	if (m_exception)
+	{
+		std::exception_ptr exception = m_exception;
+		m_exception = nullptr;
+		std::rethrow_exception(exception);
+	}
+}
+
+void WorldUpdateThread::run_on_main_thread(const std::function<void()>& fn)
+{
+	if (!m_thread || SDL_ThreadID() != m_thread_id)
+	{
+		fn();
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_main_thread_request = &fn;
+	m_done.notify_all();
+	m_start.wait(lock, [this] { return !m_main_thread_request; });
+
+	if (m_main_thread_exception)
+	{
+		std::exception_ptr exception = m_main_thread_exception;
+		m_main_thread_exception = nullptr;
+		std::rethrow_exception(exception);
+	}
+}
+
+int WorldUpdateThread::run(void *arg)
+{
+	static_cast<WorldUpdateThread*>(arg)->worker();
+	return 0;
+}
+
+void WorldUpdateThread::worker()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		m_start.wait(lock, [this] { return m_running; });
+		lock.unlock();
+
+		world_update_ticks result{false, 0, 0};
+		std::exception_ptr exception;
+		try {
+			result = update_world_ticks();
+		}
+		catch (...) {
+			exception = std::current_exception();
+		}
+
+		lock.lock();
+		m_pending = result;
+		m_has_pending = !exception;
+		m_exception = exception;
+		m_running = false;
+		m_done.notify_all();
+	}
+}
@@ -0,0 +1,122 @@
+#ifndef WORLD_UPDATE_THREAD_H
+#define WORLD_UPDATE_THREAD_H
+
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  WorldUpdateThread.h - running the world's ticks while a frame is presented
+ *
+ *  An experiment in overlapping the ticks with the buffer swap, not a
+ *  decoupling of the world from rendering: the ticks still run once per
+ *  frame and every frame still waits for them, so the most it saves is the
+ *  time the swap takes. Off by default; ".world_thread on" in the console
+ *  turns it on, and there is no preference for it.
+ *
+ *  Once a frame has been drawn, render_screen() hands update_world_ticks()
+ *  to a thread of its own and presents the frame (the buffer swap, or the
+ *  upload of the software frame) meanwhile; it waits for the ticks before
+ *  returning, so nothing else ever sees the world while they run. The next
+ *  idle_game_state() runs finish_world_update() on their result, on the main
+ *  thread, instead of updating the world itself; that is where the HUD, the
+ *  fades, a game over and the end of a film are dealt with. Action flags are
+ *  still queued on the main thread, between frames, so the ticks consume them
+ *  exactly as they would otherwise.
+ *
+ *  Everything a tick may call that needs the window, the GL context or the
+ *  audio device goes through run_on_main_thread(). Nothing checks this; it
+ *  rests on the list below, which anything new that a tick can reach and
+ *  that touches those has to be added to:
+ *    transfer_to_new_level()           check_level_change()
+ *    save_game()                       Lua Game.save
+ *    update_interface()                player.cpp, new and revived players
+ *    start_fade(), set_fade_effect()   damage, pickups, liquids, Lua Player.fade
+ *    draw_panels()                     Lua motion sensor and texture palette
+ *    change_screen_mode()              Lua show/hide interface
+ *    Music                             every Lua Music binding
+ *  Sounds are safe: the main thread leaves the sound manager alone while
+ *  it presents, and the OpenAL manager locks against its own audio thread.
+ *  screen_printf() only stores a message for the next frame to draw.
+ */
+
+#include "cseries.h"
+#include "map.h"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+#include <SDL2/SDL_thread.h>
+
+class WorldUpdateThread
+{
+public:
+	static WorldUpdateThread* instance();
+
+	static void register_console_command();
+
+	bool enabled() const { return m_enabled; }
+	void enable(bool enabled) { m_enabled = enabled; }
+
+	// in place of update_world(): finishes the ticks run during the last
+	// present, together with the ticks that have come due since
+	std::pair<bool, int16> update_world();
+
+	// render_screen() brackets presenting a frame with these; begin does
+	// nothing, and returns false, unless the thread is on, a game is running
+	// and the last ticks it ran have been finished; only call end after a
+	// true begin
+	bool begin_present();
+	void end_present();
+
+	// runs fn right away, or, from the update thread, on the main thread as
+	// soon as it is done presenting, and waits for it
+	void run_on_main_thread(const std::function<void()>& fn);
+
+private:
+	WorldUpdateThread();
+
+	static int run(void *arg);
+	void worker();
+
+	SDL_Thread* m_thread;
+	SDL_threadID m_thread_id;
+	std::mutex m_mutex;
+	std::condition_variable m_start, m_done;
+
+	bool m_running;	// update_world_ticks() has been handed to the thread
+	const std::function<void()>* m_main_thread_request;
+	std::exception_ptr m_exception;
+	std::exception_ptr m_main_thread_exception;
+
+	// returned by the ticks run during the last present, until finished
+	bool m_has_pending;
+	world_update_ticks m_pending;
+
+	bool m_enabled;
+};
+
+#endif
@@ -28,6 +28,7 @@
 #include "interface.h"
 #include "lua_script.h"
 #include "map.h"
+#include "world_snapshot.h"
 
 class ObjectDataPool {
 public:
@@ -48,6 +49,11 @@ public:
 	int16_t get_unused(); // marks as unused before returning
 	void release(int16_t object_index);
 
+	void add_snapshot_regions(world_snapshot_regions& regions) {
+		regions.push_back({ pool_.data(), pool_.size() * sizeof(object_data) });
+		regions.push_back({ &first_unused_, sizeof(first_unused_) });
+	}
+
 private:
 	std::vector<object_data> pool_;
 	int16_t first_unused_;
@@ -98,6 +104,12 @@ void ObjectDataPool::release(int16_t index)
 	first_unused_ = index;
 }
 
+void add_ephemera_snapshot_regions(world_snapshot_regions& regions)
+{
+	ephemera_pool.add_snapshot_regions(regions);
+	regions.push_back({ polygon_ephemera.data(), polygon_ephemera.size() * sizeof(int16_t) });
+}
+
 void allocate_ephemera_storage(int max_ephemera)
 {
 	ephemera_pool.resize(max_ephemera);
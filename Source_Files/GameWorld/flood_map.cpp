@@ -46,51 +46,83 @@ on very small maps, choose_random_flood_node() may not terminate
 #define NODE_IS_UNEXPANDED(n) (!NODE_IS_EXPANDED(n))
 #define MARK_NODE_AS_EXPANDED(n) ((n)->flags|=(uint16)0x8000)
 
-namespace alephbet {
-namespace flood_map {
+using namespace alephbet::flood_map;
 
-struct node_data /* 16 bytes */
-{
-	uint16 flags;
-	
-	int16 parent_node_index; /* node index of the node we came from to get here; only used for backtracking */
-	int16 polygon_index; /* index of this polygon */
-	int32 cost; /* the cost to evaluate this entry */
+/* ---------- globals */
 
-	int16 depth;
+static FloodContext default_flood_context;
 
-	int32 user_flags;
-};
+/* ---------- code */
 
-}
+void allocate_flood_map_memory(
+	void)
+{
+	default_flood_context.allocate();
 }
 
-using namespace alephbet::flood_map;
+/* returns next polygon index or NONE if there are no more polygons left cheaper than maximum_cost */
+short flood_map(
+	short first_polygon_index,
+	int32 maximum_cost,
+	cost_proc_ptr cost_proc,
+	short flood_mode,
+	void *caller_data)
+{
+	return default_flood_context.flood(first_polygon_index, maximum_cost, cost_proc, flood_mode, caller_data);
+}
 
-/* ---------- globals */
+short reverse_flood_map(
+	void)
+{
+	return default_flood_context.reverse();
+}
 
-static short node_count= 0, last_node_index_expanded= NONE;
-static struct node_data *nodes = NULL;
-static short *visited_polygons = NULL;
+short flood_depth(
+	void)
+{
+	return default_flood_context.depth();
+}
 
-/* ---------- private prototypes */
+void choose_random_flood_node(
+	world_vector2d *bias)
+{
+	default_flood_context.choose_random_node(bias);
+}
 
-static void add_node(short parent_node_index, short polygon_index, short depth, int32 cost, int32 user_flags);
+FloodContext::FloodContext() :
+	node_count(0), last_node_index_expanded(NONE), nodes(NULL), visited_polygons(NULL),
+	heap(NULL), heap_positions(NULL), heap_count(0), heap_valid(false)
+{
+}
 
-/* ---------- code */
+FloodContext::~FloodContext()
+{
+	delete []nodes;
+	delete []visited_polygons;
+	delete []heap;
+	delete []heap_positions;
+}
 
-void allocate_flood_map_memory(
-	void)
+void FloodContext::allocate()
 {
 	// Made reentrant because this must be called every time a map is loaded
 	if (nodes) delete []nodes;
 	nodes= new node_data[MAXIMUM_FLOOD_NODES];
 	if (visited_polygons) delete []visited_polygons;
 	visited_polygons= new short[MAXIMUM_POLYGONS_PER_MAP];
+	objlist_set(visited_polygons, NONE, MAXIMUM_POLYGONS_PER_MAP);
+	if (heap) delete []heap;
+	heap= new short[MAXIMUM_FLOOD_NODES];
+	if (heap_positions) delete []heap_positions;
+	heap_positions= new short[MAXIMUM_FLOOD_NODES];
+
+	node_count= 0;
+	last_node_index_expanded= NONE;
+	heap_count= 0;
+	heap_valid= false;
 }
 
-/* returns next polygon index or NONE if there are no more polygons left cheaper than maximum_cost */
-short flood_map(
+short FloodContext::flood(
 	short first_polygon_index,
 	int32 maximum_cost,
 	cost_proc_ptr cost_proc,
@@ -105,11 +137,17 @@ short flood_map(
 	/* initialize ourselves if first_polygon_index!=NONE */
 	if (first_polygon_index!=NONE)
 	{
-		/* clear the visited polygon array */
-		objlist_set(visited_polygons, NONE, MAXIMUM_POLYGONS_PER_MAP);
+		/* clear the visited polygon array; only the polygons in the last flood's node
+			list can be marked, which is far cheaper than clearing every polygon */
+		for (node_index= 0; node_index<node_count; ++node_index)
+		{
+			visited_polygons[nodes[node_index].polygon_index]= UNVISITED;
+		}
 		
 		node_count= 0;
 		last_node_index_expanded= NONE;
+		heap_count= 0;
+		heap_valid= (flood_mode==_best_first);
 		add_node(NONE, first_polygon_index, 0, 0, (flood_mode==_flagged_breadth_first) ? *((int32*)caller_data) : 0);
 	}
 	
@@ -117,14 +155,16 @@ short flood_map(
 	{
 		case _best_first:
 			/* find the unexpanded node with the lowest cost */
-			lowest_cost= maximum_cost, lowest_cost_node_index= NONE;
-			for (node= nodes, node_index= 0; node_index<node_count; ++node_index, ++node)
+			if (!heap_valid) build_heap();
+			if (heap_count && nodes[heap[0]].cost<maximum_cost)
+			{
+				lowest_cost_node_index= heap[0];
+				lowest_cost= nodes[lowest_cost_node_index].cost;
+				heap_pop();
+			}
+			else
 			{
-				if (NODE_IS_UNEXPANDED(node)&&node->cost<lowest_cost)
-				{
-					lowest_cost_node_index= node_index;
-					lowest_cost= node->cost;
-				}
+				lowest_cost= maximum_cost, lowest_cost_node_index= NONE;
 			}
 			break;
 		
@@ -207,7 +247,7 @@ short flood_map(
 	when there are no more polygons to return.  this is useful for pathfinding: when
 	flood_map() returns the destination polygon index, calling reverse_flood_map() will return
 	the polygons traversed to reach the destination) */
-short reverse_flood_map(
+short FloodContext::reverse(
 	void)
 {
 	short polygon_index= NONE;
@@ -227,8 +267,8 @@ short reverse_flood_map(
 }
 
 /* returns depth (in polygons) at last_node_index_expanded */
-short flood_depth(
-	void)
+short FloodContext::depth(
+	void) const
 {
 	assert(last_node_index_expanded>=0&&last_node_index_expanded<node_count);
 
@@ -239,7 +279,7 @@ short flood_depth(
 
 /* when looking for a random path, always choose a random node.  if bias is not NULL, then try
 	and choose a destination in that direction */
-void choose_random_flood_node(
+void FloodContext::choose_random_node(
 	world_vector2d *bias)
 {
 	world_point2d origin;
@@ -280,7 +320,7 @@ void choose_random_flood_node(
 /* ---------- private code */
 
 /* checks to see if the given node is already in the node list */
-static void add_node(
+void FloodContext::add_node(
 	short parent_node_index,
 	short polygon_index,
 	short depth,
@@ -313,7 +353,8 @@ static void add_node(
 		
 		if (node)
 		{
-			if (node_index==node_count)
+			bool is_new_node= (node_index==node_count);
+			if (is_new_node)
 			{
 				node_count+= 1;
 			}
@@ -327,8 +368,93 @@ static void add_node(
 			
 			assert(polygon_index>=0&&polygon_index<dynamic_world->polygon_count);
 			visited_polygons[polygon_index]= node_index;
+
+			/* a replaced node is unexpanded, so it is still in the heap; its cost only ever drops */
+			if (heap_valid)
+			{
+				if (is_new_node) heap_push(node_index);
+				else heap_sift_up(heap_positions[node_index]);
+			}
 			
 //			dprintf("added polygon #%d to node #%d (nodes=%p,visited=%p)", polygon_index, node_index, nodes, visited_polygons);
 		}
 	}
 }
+
+bool FloodContext::heap_less(
+	short a,
+	short b) const
+{
+	return nodes[a].cost<nodes[b].cost || (nodes[a].cost==nodes[b].cost && a<b);
+}
+
+void FloodContext::heap_push(
+	short node_index)
+{
+	heap[heap_count]= node_index;
+	heap_positions[node_index]= heap_count;
+	heap_count+= 1;
+	heap_sift_up(heap_count-1);
+}
+
+void FloodContext::heap_pop(
+	void)
+{
+	assert(heap_count>0);
+	heap_positions[heap[0]]= NONE;
+	heap_count-= 1;
+	if (heap_count)
+	{
+		heap[0]= heap[heap_count];
+		heap_positions[heap[0]]= 0;
+		heap_sift_down(0);
+	}
+}
+
+void FloodContext::heap_sift_up(
+	short position)
+{
+	assert(position>=0&&position<heap_count);
+	short node_index= heap[position];
+	while (position>0)
+	{
+		short parent= (position-1)/2;
+		if (!heap_less(node_index, heap[parent])) break;
+		heap[position]= heap[parent];
+		heap_positions[heap[position]]= position;
+		position= parent;
+	}
+	heap[position]= node_index;
+	heap_positions[node_index]= position;
+}
+
+void FloodContext::heap_sift_down(
+	short position)
+{
+	short node_index= heap[position];
+	for (;;)
+	{
+		short child= 2*position+1;
+		if (child>=heap_count) break;
+		if (child+1<heap_count && heap_less(heap[child+1], heap[child])) child+= 1;
+		if (!heap_less(heap[child], node_index)) break;
+		heap[position]= heap[child];
+		heap_positions[heap[position]]= position;
+		position= child;
+	}
+	heap[position]= node_index;
+	heap_positions[node_index]= position;
+}
+
+/* a flood started breadth-first and continued best-first (no caller does this today) */
+void FloodContext::build_heap(
+	void)
+{
+	heap_count= 0;
+	for (short node_index= 0; node_index<node_count; ++node_index)
+	{
+		heap_positions[node_index]= NONE;
+		if (NODE_IS_UNEXPANDED(nodes+node_index)) heap_push(node_index);
+	}
+	heap_valid= true;
+}
@@ -52,6 +52,69 @@ short new_path(world_point2d *source_point, short source_polygon_index,
 bool move_along_path(short path_index, world_point2d *p);
 void delete_path(short path_index);
 
+/* ---------- flood contexts */
+
+namespace alephbet {
+namespace flood_map {
+
+struct node_data /* 16 bytes */
+{
+	uint16 flags;
+	
+	int16 parent_node_index; /* node index of the node we came from to get here; only used for backtracking */
+	int16 polygon_index; /* index of this polygon */
+	int32 cost; /* the cost to evaluate this entry */
+
+	int16 depth;
+
+	int32 user_flags;
+};
+
+}
+}
+
+/* one flood in flight; the free functions below all use a single shared context, but
+	independent floods (on other threads, or nested inside a cost_proc) each need their own */
+class FloodContext
+{
+public:
+	FloodContext();
+	~FloodContext();
+
+	/* must be called again whenever a map is loaded */
+	void allocate();
+
+	short flood(short first_polygon_index, int32 maximum_cost, cost_proc_ptr cost_proc, short flood_mode, void *caller_data);
+	short reverse();
+	short depth() const;
+	void choose_random_node(world_vector2d *bias);
+
+private:
+	void add_node(short parent_node_index, short polygon_index, short depth, int32 cost, int32 user_flags);
+
+	/* best-first keeps its unexpanded nodes in an indexed binary heap ordered by
+		(cost, node index), which picks exactly the node a linear scan would */
+	bool heap_less(short a, short b) const;
+	void heap_push(short node_index);
+	void heap_pop();
+	void heap_sift_up(short position);
+	void heap_sift_down(short position);
+	void build_heap();
+
+	short node_count;
+	short last_node_index_expanded;
+	alephbet::flood_map::node_data *nodes;
+	short *visited_polygons;
+
+	short *heap;
+	short *heap_positions; /* NONE if the node is not in the heap */
+	short heap_count;
+	bool heap_valid; /* only maintained while flooding _best_first */
+
+	FloodContext(const FloodContext&) = delete;
+	FloodContext& operator=(const FloodContext&) = delete;
+};
+
 /* ---------- prototypes/FLOOD_MAP.C */
 
 void allocate_flood_map_memory(void);
@@ -67,6 +67,10 @@ struct environment_definition
 
 #define DEFAULT_MAP_MEMORY_SIZE (128*KILO)
 
+// world_point_to_polygon_index() grid: about this many cells per polygon, capped per axis
+#define POLYGON_GRID_CELLS_PER_POLYGON 2
+#define MAXIMUM_POLYGON_GRID_DIMENSION 256
+
 /* ---------- globals */
 
 // LP: modified texture-environment management so as to be easier to handle with XML
@@ -170,6 +174,24 @@ bool LandscapesLoaded = true;
 // needed for infravision fog when landscapes are switched off
 short LoadedWallTexture = NONE;
 
+// Uniform grid over the map's extent for world_point_to_polygon_index(). Each cell lists, in
+// ascending order, every polygon that point_in_polygon() could accept a point of that cell for.
+// Polygons whose edge test isn't confined to the map's extent (no vertices, zero area, broken
+// winding) are checked for every point instead; merging the two by index finds the same
+// (lowest-indexed) polygon the old linear search did. Points off the grid still get that search,
+// as do maps too wide for point_in_polygon()'s cross products to stay in range. Built on first
+// use after a load.
+static struct polygon_grid_data
+{
+	bool valid;
+	int32 x0, y0;
+	int32 cell_size;
+	int32 columns, rows;
+	std::vector<int32> cell_offsets; // columns*rows+1 offsets into cell_polygons
+	std::vector<int16> cell_polygons;
+	std::vector<int16> unbounded_polygons; // ascending, and not in any cell
+} polygon_grid;
+
 /* ---------- private prototypes */
 
 static short _new_map_object(shape_descriptor shape, angle facing);
@@ -185,6 +207,9 @@ inline void add_object_to_polygon_object_list(short object_index)
 
 short _find_line_crossed_leaving_polygon(short polygon_index, world_point2d *p0, world_point2d *p1, bool *last_line);
 
+static bool get_polygon_edge_test_bounds(short polygon_index, int32& x0, int32& y0, int32& x1, int32& y1);
+static void build_polygon_grid(void);
+
 /* ---------- code */
 
 // Accessors moved here to shrink the code
@@ -1286,20 +1311,60 @@ short clockwise_endpoint_in_line(
 	return line->endpoint_indexes[index];
 }
 
+void invalidate_polygon_grid(
+	void)
+{
+	polygon_grid.valid= false;
+}
+
 short world_point_to_polygon_index(
 	world_point2d *location)
 {
-	short polygon_index;
-	struct polygon_data *polygon;
+	short polygon_index= NONE;
 	
-	for (polygon_index=0,polygon=map_polygons;polygon_index<dynamic_world->polygon_count;++polygon_index,++polygon)
+	if (!polygon_grid.valid) build_polygon_grid();
+	
+	int32 column= (location->x-polygon_grid.x0)/polygon_grid.cell_size;
+	int32 row= (location->y-polygon_grid.y0)/polygon_grid.cell_size;
+	if (location->x<polygon_grid.x0 || location->y<polygon_grid.y0 ||
+		column>=polygon_grid.columns || row>=polygon_grid.rows)
 	{
-		if (!POLYGON_IS_DETACHED(polygon))
+		for (polygon_index=0;polygon_index<dynamic_world->polygon_count;++polygon_index)
 		{
-			if (point_in_polygon(polygon_index, location)) break;
+			if (!POLYGON_IS_DETACHED(get_polygon_data(polygon_index)) &&
+				point_in_polygon(polygon_index, location))
+			{
+				return polygon_index;
+			}
+		}
+		
+		return NONE;
+	}
+	
+	int32 cell= row*polygon_grid.columns+column;
+	for (int32 i= polygon_grid.cell_offsets[cell]; i<polygon_grid.cell_offsets[cell+1]; ++i)
+	{
+		short candidate_index= polygon_grid.cell_polygons[i];
+		
+		if (!POLYGON_IS_DETACHED(get_polygon_data(candidate_index)) &&
+			point_in_polygon(candidate_index, location))
+		{
+			polygon_index= candidate_index;
+			break;
+		}
+	}
+	
+	/* the polygons outside the grid win if they come first */
+	for (auto candidate_index : polygon_grid.unbounded_polygons)
+	{
+		if (polygon_index!=NONE && candidate_index>polygon_index) break;
+		if (!POLYGON_IS_DETACHED(get_polygon_data(candidate_index)) &&
+			point_in_polygon(candidate_index, location))
+		{
+			polygon_index= candidate_index;
+			break;
 		}
 	}
-	if (polygon_index==dynamic_world->polygon_count) polygon_index= NONE;
 
 	return polygon_index;
 }
@@ -2287,6 +2352,160 @@ void random_point_on_circle(
 
 /* ---------- private code */
 
+/* a box holding every point point_in_polygon() accepts for this polygon: the region its edge
+	tests leave, clipped out of the whole world with a little slack so rounding can only make it
+	bigger. false if that region is empty or barely has any area, which is what an edge test
+	along a single line (a zero-area polygon) leaves */
+static bool get_polygon_edge_test_bounds(
+	short polygon_index,
+	int32& x0,
+	int32& y0,
+	int32& x1,
+	int32& y1)
+{
+	struct polygon_data *polygon= get_polygon_data(polygon_index);
+	const double limit= 65536.0;
+	std::vector<std::pair<double, double>> region= { {-limit, -limit}, {limit, -limit}, {limit, limit}, {-limit, limit} };
+	std::vector<std::pair<double, double>> clipped;
+	
+	for (short i= 0; i<polygon->vertex_count && !region.empty(); ++i)
+	{
+		struct line_data *line= get_line_data(polygon->line_indexes[i]);
+		bool clockwise= line->endpoint_indexes[0]==polygon->endpoint_indexes[i];
+		world_point2d *e0= &get_endpoint_data(line->endpoint_indexes[0])->vertex;
+		world_point2d *e1= &get_endpoint_data(line->endpoint_indexes[1])->vertex;
+		double dx= e1->x-e0->x, dy= e1->y-e0->y;
+		double slack= 0.01*sqrt(dx*dx+dy*dy);
+		if (slack==0) continue; /* a zero-length line passes every point */
+		
+		/* the same cross product point_in_polygon() tests, negated for counterclockwise lines */
+		auto outside= [&](const std::pair<double, double>& q) {
+			double cross_product= (q.first-e0->x)*dy - (q.second-e0->y)*dx;
+			return (clockwise ? cross_product : -cross_product) - slack;
+		};
+		
+		clipped.clear();
+		for (size_t j= 0; j<region.size(); ++j)
+		{
+			const auto& q0= region[j];
+			const auto& q1= region[(j+1)%region.size()];
+			double d0= outside(q0), d1= outside(q1);
+			if (d0<=0) clipped.push_back(q0);
+			if ((d0<=0)!=(d1<=0))
+			{
+				double t= d0/(d0-d1);
+				clipped.push_back({q0.first+t*(q1.first-q0.first), q0.second+t*(q1.second-q0.second)});
+			}
+		}
+		region.swap(clipped);
+	}
+	
+	if (region.size()<3) return false;
+	
+	double area= 0, bx0= limit, by0= limit, bx1= -limit, by1= -limit;
+	for (size_t j= 0; j<region.size(); ++j)
+	{
+		const auto& q0= region[j];
+		const auto& q1= region[(j+1)%region.size()];
+		area+= q0.first*q1.second - q1.first*q0.second;
+		bx0= std::min(bx0, q0.first), bx1= std::max(bx1, q0.first);
+		by0= std::min(by0, q0.second), by1= std::max(by1, q0.second);
+	}
+	/* anything thinner than the slack could be a line the exact test accepts points along */
+	if (fabs(area)/2 <= (bx1-bx0+by1-by0+1)) return false;
+	
+	x0= static_cast<int32>(floor(bx0))-1, y0= static_cast<int32>(floor(by0))-1;
+	x1= static_cast<int32>(ceil(bx1))+1, y1= static_cast<int32>(ceil(by1))+1;
+	return true;
+}
+
+static void build_polygon_grid(
+	void)
+{
+	struct polygon_data *polygon;
+	short polygon_index;
+	int32 x0= INT32_MAX, y0= INT32_MAX, x1= INT32_MIN, y1= INT32_MIN;
+	
+	for (polygon_index=0,polygon=map_polygons;polygon_index<dynamic_world->polygon_count;++polygon_index,++polygon)
+	{
+		for (short i= 0; i<polygon->vertex_count; ++i)
+		{
+			world_point2d *vertex= &get_endpoint_data(polygon->endpoint_indexes[i])->vertex;
+			x0= std::min<int32>(x0, vertex->x), x1= std::max<int32>(x1, vertex->x);
+			y0= std::min<int32>(y0, vertex->y), y1= std::max<int32>(y1, vertex->y);
+		}
+	}
+	if (x0>x1) x0= x1= y0= y1= 0;
+	/* room for the slack around the edge tests of the polygons along the map's edge */
+	x0-= 2, y0-= 2, x1+= 2, y1+= 2;
+	
+	/* the polygons whose edge tests stay inside the map's extent go into the grid, by the box
+		around what their edge tests accept; everything else is checked for every point. past
+		32767 across, point_in_polygon()'s cross products can wrap, so nothing goes in the grid */
+	bool wraps= x1-x0>=32767 || y1-y0>=32767;
+	std::vector<int32> bounds(4*dynamic_world->polygon_count);
+	polygon_grid.unbounded_polygons.clear();
+	for (polygon_index=0;polygon_index<dynamic_world->polygon_count;++polygon_index)
+	{
+		int32 *box= &bounds[4*polygon_index];
+		if (wraps || !get_polygon_edge_test_bounds(polygon_index, box[0], box[1], box[2], box[3]) ||
+			box[0]<x0 || box[1]<y0 || box[2]>x1 || box[3]>y1)
+		{
+			box[0]= box[1]= 0, box[2]= box[3]= -1;
+			polygon_grid.unbounded_polygons.push_back(polygon_index);
+		}
+	}
+	
+	/* square cells, sized so the grid has roughly POLYGON_GRID_CELLS_PER_POLYGON cells per polygon */
+	int32 width= x1-x0+1, height= y1-y0+1;
+	int32 target_cells= std::max(1, POLYGON_GRID_CELLS_PER_POLYGON*dynamic_world->polygon_count);
+	int32 cell_size= std::max<int32>(1, static_cast<int32>(sqrt(static_cast<double>(width)*height/target_cells)));
+	cell_size= std::max(cell_size, (std::max(width, height)+MAXIMUM_POLYGON_GRID_DIMENSION-1)/MAXIMUM_POLYGON_GRID_DIMENSION);
+	
+	polygon_grid.x0= x0, polygon_grid.y0= y0;
+	polygon_grid.cell_size= cell_size;
+	polygon_grid.columns= (width+cell_size-1)/cell_size;
+	polygon_grid.rows= (height+cell_size-1)/cell_size;
+	
+	/* two passes over the bounding boxes: count each cell's polygons, then fill them in
+		(in polygon order, which keeps every cell sorted) */
+	std::vector<int32>& offsets= polygon_grid.cell_offsets;
+	offsets.assign(polygon_grid.columns*polygon_grid.rows+1, 0);
+	for (int pass= 0; pass<2; ++pass)
+	{
+		for (polygon_index=0,polygon=map_polygons;polygon_index<dynamic_world->polygon_count;++polygon_index,++polygon)
+		{
+			const int32 *box= &bounds[4*polygon_index];
+			int32 px0= box[0], py0= box[1], px1= box[2], py1= box[3];
+			if (px0>px1) continue;
+			
+			for (int32 row= (py0-y0)/cell_size; row<=(py1-y0)/cell_size; ++row)
+			{
+				for (int32 column= (px0-x0)/cell_size; column<=(px1-x0)/cell_size; ++column)
+				{
+					int32 cell= row*polygon_grid.columns+column;
+					if (pass==0) offsets[cell+1]+= 1;
+					else polygon_grid.cell_polygons[offsets[cell]++]= polygon_index;
+				}
+			}
+		}
+		
+		if (pass==0)
+		{
+			for (size_t cell= 1; cell<offsets.size(); ++cell) offsets[cell]+= offsets[cell-1];
+			polygon_grid.cell_polygons.resize(offsets.back());
+		}
+		else
+		{
+			/* filling advanced each offset to the start of the next cell; shift them back */
+			for (size_t cell= offsets.size()-1; cell>0; --cell) offsets[cell]= offsets[cell-1];
+			offsets[0]= 0;
+		}
+	}
+	
+	polygon_grid.valid= true;
+}
+
 /* returns the line_index of the line we intersected to leave this polygon, or NONE if destination
 	is in the given polygon */
 short _find_line_crossed_leaving_polygon(
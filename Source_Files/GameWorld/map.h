@@ -1076,6 +1076,20 @@ bool entering_map(bool restoring_saved);
 // (used to return only the latter)
 std::pair<bool, int16> update_world(void);
 
+// update_world() in two halves, for the world update thread: the ticks, which
+// only touch the world, and what has to follow them on the main thread
+struct world_update_ticks
+{
+	bool advanced;	// false if the network held the world back
+	int16 result;
+	int16 elapsed;
+};
+world_update_ticks update_world_ticks(void);
+std::pair<bool, int16> finish_world_update(const world_update_ticks& ticks);
+
+// steps exactly one tick of a film being replayed headless; false once it has ended
+bool update_world_headless(void);
+
 // ZZZ: these really don't go here, but they live in marathon2.cpp where update_world() lives.....
 void reset_intermediate_action_queues();
 void set_prediction_wanted(bool inPrediction);
@@ -1166,6 +1180,8 @@ void initialize_map_for_new_player(void);
 void generate_map(short level);
 
 short world_point_to_polygon_index(world_point2d *location);
+// must be called whenever polygon or endpoint geometry is replaced (e.g., a new map is loaded)
+void invalidate_polygon_grid(void);
 short clockwise_endpoint_in_line(short polygon_index, short line_index, short index);
 
 short find_adjacent_polygon(short polygon_index, short line_index);
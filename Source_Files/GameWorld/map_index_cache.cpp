@@ -0,0 +1,230 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  map_index_cache.cpp - redundant map data and map indexes, cached on disk
+ *
+ *  The cache holds the endpoint, line, side and polygon lists in their map
+ *  file format (the redundant fields are scattered through them) followed by
+ *  the map indexes. It is named after a hash of the same lists as loaded, so
+ *  a map received over the network finds it as well as one on disk.
+ */
+
+#include "cseries.h"
+#include "map_index_cache.h"
+#include "map.h"
+#include "FilmProfile.h"
+#include "FileHandler.h"
+#include "Logging.h"
+#include "Packing.h"
+#include "crc.h"
+
+#include <vector>
+
+/* ---------- constants */
+
+// bump whenever precalculate_map_indexes() or the recalculate_redundant_*()
+// functions would come out differently, so old cache files are ignored
+#define MAP_INDEX_CACHE_VERSION 1
+#define MAP_INDEX_CACHE_TAG FOUR_CHARS_TO_INT('m','i','x','1')
+#define MAP_INDEX_CACHE_HEADER_SIZE 36
+
+// once everything cached for every map ever played grows past this, the oldest files are removed
+#define MAXIMUM_MAP_CACHE_SIZE (size_t(128) << 20)
+
+/* ---------- globals */
+
+// the map as loaded, before anything was recalculated
+static uint64_t map_data_hash;
+
+/* ---------- private prototypes */
+
+static size_t get_packed_map_size(void);
+static void pack_map_lists(std::vector<uint8>& data);
+static uint64_t calculate_map_data_hash(void);
+static FileSpecifier get_map_index_cache_file(void);
+
+/* ---------- code */
+
+bool load_cached_map_indexes(
+	void)
+{
+	map_data_hash= calculate_map_data_hash();
+	
+	FileSpecifier file= get_map_index_cache_file();
+	OpenedFile in;
+	int32 length;
+	
+	if (!file.Exists() || !file.Open(in) || !in.GetLength(length) ||
+		length<static_cast<int32>(MAP_INDEX_CACHE_HEADER_SIZE + get_packed_map_size()))
+	{
+		return false;
+	}
+	
+	std::vector<uint8> data(length);
+	if (!in.Read(length, data.data())) return false;
+	
+	uint8 *S= data.data();
+	uint32 tag, version, hash_high, hash_low, endpoint_count, line_count, side_count, polygon_count, map_index_count;
+	StreamToValue(S, tag);
+	StreamToValue(S, version);
+	StreamToValue(S, hash_high);
+	StreamToValue(S, hash_low);
+	StreamToValue(S, endpoint_count);
+	StreamToValue(S, line_count);
+	StreamToValue(S, side_count);
+	StreamToValue(S, polygon_count);
+	StreamToValue(S, map_index_count);
+	if (tag!=MAP_INDEX_CACHE_TAG || version!=MAP_INDEX_CACHE_VERSION || ((uint64_t(hash_high)<<32) | hash_low)!=map_data_hash ||
+		endpoint_count!=static_cast<uint32>(dynamic_world->endpoint_count) ||
+		line_count!=static_cast<uint32>(dynamic_world->line_count) ||
+		side_count!=static_cast<uint32>(dynamic_world->side_count) ||
+		polygon_count!=static_cast<uint32>(dynamic_world->polygon_count) ||
+		map_index_count>=UINT16_MAX ||
+		static_cast<size_t>(length)!=MAP_INDEX_CACHE_HEADER_SIZE + get_packed_map_size() + 2*map_index_count)
+	{
+		return false;
+	}
+	
+	S= unpack_endpoint_data(S, map_endpoints, endpoint_count);
+	S= unpack_line_data(S, map_lines, line_count);
+	S= unpack_side_data(S, map_sides, side_count);
+	S= unpack_polygon_data(S, map_polygons, polygon_count);
+	
+	MapIndexList.resize(map_index_count);
+	StreamToList(S, map_indexes, map_index_count);
+	dynamic_world->map_index_count= static_cast<int16>(map_index_count);
+	
+	return true;
+}
+
+void save_cached_map_indexes(
+	void)
+{
+	std::vector<uint8> data;
+	pack_map_lists(data);
+	
+	std::vector<uint8> header(MAP_INDEX_CACHE_HEADER_SIZE);
+	uint8 *S= header.data();
+	ValueToStream(S, uint32(MAP_INDEX_CACHE_TAG));
+	ValueToStream(S, uint32(MAP_INDEX_CACHE_VERSION));
+	ValueToStream(S, uint32(map_data_hash>>32));
+	ValueToStream(S, uint32(map_data_hash));
+	ValueToStream(S, uint32(dynamic_world->endpoint_count));
+	ValueToStream(S, uint32(dynamic_world->line_count));
+	ValueToStream(S, uint32(dynamic_world->side_count));
+	ValueToStream(S, uint32(dynamic_world->polygon_count));
+	ValueToStream(S, uint32(MapIndexList.size()));
+	data.insert(data.begin(), header.begin(), header.end());
+	
+	size_t lists_size= data.size();
+	data.resize(lists_size + 2*MapIndexList.size());
+	S= data.data() + lists_size;
+	ListToStream(S, map_indexes, MapIndexList.size());
+	
+	FileSpecifier file= get_map_index_cache_file();
+	OpenedFile out;
+	
+	file.Delete();
+	if (!file.Open(out, true) || !out.Write(static_cast<int32>(data.size()), data.data()))
+	{
+		logWarning("Couldn't write map indexes to %s", file.GetPath());
+	}
+}
+
+FileSpecifier get_map_cache_directory(
+	void)
+{
+	FileSpecifier directory;
+	
+	directory.SetToLocalDataDir();
+	directory+= "Map Cache";
+	directory.CreateDirectory();
+	
+	return directory;
+}
+
+void prune_map_cache(
+	void)
+{
+	/* nothing else lives in there, so every file counts */
+	prune_cache_directory(get_map_cache_directory(), "", MAXIMUM_MAP_CACHE_SIZE);
+}
+
+/* ---------- private code */
+
+static size_t get_packed_map_size(
+	void)
+{
+	return dynamic_world->endpoint_count*SIZEOF_endpoint_data + dynamic_world->line_count*SIZEOF_line_data +
+		dynamic_world->side_count*SIZEOF_side_data + dynamic_world->polygon_count*SIZEOF_polygon_data;
+}
+
+static void pack_map_lists(
+	std::vector<uint8>& data)
+{
+	// zeroed, since the packers skip over their padding
+	data.assign(get_packed_map_size(), 0);
+	
+	uint8 *S= data.data();
+	S= pack_endpoint_data(S, map_endpoints, dynamic_world->endpoint_count);
+	S= pack_line_data(S, map_lines, dynamic_world->line_count);
+	S= pack_side_data(S, map_sides, dynamic_world->side_count);
+	S= pack_polygon_data(S, map_polygons, dynamic_world->polygon_count);
+	assert(S == data.data() + data.size());
+}
+
+/* 64-bit FNV-1a over everything the calculation reads; the cache is trusted if it matches */
+static uint64_t calculate_map_data_hash(
+	void)
+{
+	uint64_t hash= FNV1A_64_OFFSET_BASIS;
+	auto add= [&hash](const uint8 *bytes, size_t count) { hash= calculate_data_fnv1a_64(bytes, count, hash); };
+	
+	std::vector<uint8> data;
+	pack_map_lists(data);
+	add(data.data(), data.size());
+	
+	// sound sources come from the saved objects
+	data.assign(dynamic_world->initial_objects_count*SIZEOF_map_object, 0);
+	pack_map_object(data.data(), saved_objects, dynamic_world->initial_objects_count);
+	add(data.data(), data.size());
+	
+	uint8 settings[]= { MAP_INDEX_CACHE_VERSION, film_profile.adjacent_polygons_always_intersect };
+	add(settings, sizeof(settings));
+	
+	return hash;
+}
+
+static FileSpecifier get_map_index_cache_file(
+	void)
+{
+	FileSpecifier file= get_map_cache_directory();
+	char name[64];
+	
+	snprintf(name, sizeof(name), "indexes_%016llx.dat", static_cast<unsigned long long>(map_data_hash));
+	file+= name;
+	
+	return file;
+}
@@ -0,0 +1,55 @@
+#ifndef __MAP_INDEX_CACHE_H
+#define __MAP_INDEX_CACHE_H
+
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  map_index_cache.h - redundant map data and map indexes, cached on disk
+ *
+ *  Maps without precalculated redundant data need recalculate_redundant_map()
+ *  and precalculate_map_indexes() on every load, which floods outward from
+ *  every polygon. Both only depend on the map itself, so the results are
+ *  kept in a file named after a hash of everything they read.
+ *
+ *  They share the "Map Cache" directory, and its size limit, with the
+ *  potentially visible sets.
+ */
+
+#include "cstypes.h"
+
+class FileSpecifier;
+
+// fills in the redundant data and map indexes for the map just loaded, if an
+// earlier load of the same map left them in the cache
+bool load_cached_map_indexes(void);
+// after they've been calculated the slow way
+void save_cached_map_indexes(void);
+
+// the directory everything cached per map goes in
+FileSpecifier get_map_cache_directory(void);
+// removes the oldest files from it once it grows too large; called at startup
+void prune_map_cache(void);
+
+#endif
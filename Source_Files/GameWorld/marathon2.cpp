@@ -28,6 +28,9 @@
 #include "interface.h"
 #include "FilmProfile.h"
 #include "flood_map.h"
+#include "pvs.h"
+#include "world_snapshot.h"
+#include "world_hash.h"
 #include "effects.h"
 #include "monsters.h"
 #include "projectiles.h"
@@ -66,6 +69,8 @@
 #include "Console.h"
 #include "Movie.h"
 #include "Statistics.h"
+#include "TickProfiler.h"
+#include "WorldUpdateThread.h"
 
 #include "motion_sensor.h"
 
@@ -91,6 +96,7 @@ static uint32	sMostRecentFlagsForPlayer[MAXIMUM_NUMBER_OF_PLAYERS];
 /* ---------- private prototypes */
 
 static void game_timed_out(void);
+static void world_tick_finished(void);
 
 static void load_all_game_sounds(short environment_code);
 
@@ -120,6 +126,9 @@ void initialize_marathon(
 	OGL_Initialize();
 #endif
 	GameQueue = new ModifiableActionQueues(MAXIMUM_NUMBER_OF_PLAYERS, ACTION_QUEUE_BUFFER_DIAMETER, true);
+
+	TickProfiler::register_console_command();
+	WorldUpdateThread::register_console_command();
 }
 
 static size_t sPredictedTicks = 0;
@@ -342,6 +351,8 @@ extern void update_world_view_camera();
 static int
 update_world_elements_one_tick(bool& call_postidle)
 {
+	TickPhaseTimer tick_timer(_tick_phase_total);
+
 	if (m1_solo_player_in_terminal()) 
 	{
 		update_m1_solo_player_in_terminal(GameQueue);
@@ -350,24 +361,24 @@ update_world_elements_one_tick(bool& call_postidle)
 	else
 	{
 		decode_hotkeys(*GameQueue);
-		L_Call_Idle();
+		{ TickPhaseTimer timer(_tick_phase_lua_idle); L_Call_Idle(); }
 		call_postidle = true;
 		
-		update_lights();
-		update_medias();
-		update_platforms();
+		{ TickPhaseTimer timer(_tick_phase_lights); update_lights(); }
+		{ TickPhaseTimer timer(_tick_phase_medias); update_medias(); }
+		{ TickPhaseTimer timer(_tick_phase_platforms); update_platforms(); }
 		
 		update_control_panels(); // don't put after update_players
-		update_players(GameQueue, false);
-		move_projectiles();
-		move_monsters();
-		update_effects();
-		recreate_objects();
+		{ TickPhaseTimer timer(_tick_phase_players); update_players(GameQueue, false); }
+		{ TickPhaseTimer timer(_tick_phase_projectiles); move_projectiles(); }
+		{ TickPhaseTimer timer(_tick_phase_monsters); move_monsters(); }
+		{ TickPhaseTimer timer(_tick_phase_effects); update_effects(); }
+		{ TickPhaseTimer timer(_tick_phase_recreate_objects); recreate_objects(); }
 		
 		handle_random_sound_image();
 		animate_scenery();
 
-		update_ephemera();
+		{ TickPhaseTimer timer(_tick_phase_ephemera); update_ephemera(); }
 		
 		// LP additions:
 		if (film_profile.animate_items)
@@ -377,14 +388,17 @@ update_world_elements_one_tick(bool& call_postidle)
 		
 		AnimTxtr_Update();
 		ChaseCam_Update();
-		motion_sensor_scan();
+		{ TickPhaseTimer timer(_tick_phase_motion_sensor); motion_sensor_scan(); }
 		check_m1_exploration();
 		
 #if !defined(DISABLE_NETWORKING)
-		update_net_game();
+		{ TickPhaseTimer timer(_tick_phase_net_game); update_net_game(); }
 #endif // !defined(DISABLE_NETWORKING)
 	}
 
+	// loading the next level isn't simulation cost
+	tick_timer.stop();
+
         if(check_level_change()) 
         {
                 sync_heartbeat_count();
@@ -410,6 +424,14 @@ update_world_elements_one_tick(bool& call_postidle)
 
 std::pair<bool, int16>
 update_world()
+{
+	return finish_world_update(update_world_ticks());
+}
+
+// The ticks themselves; this half only touches the world, the network and
+// the action queues, so the world update thread can run it
+world_update_ticks
+update_world_ticks()
 {
         short theElapsedTime = 0;
         bool canUpdate = true;
@@ -422,7 +444,7 @@ update_world()
 
 		if (!NetCheckWorldUpdate())
 		{
-			return std::pair<bool, int16_t>(false, 0);
+			return world_update_ticks{false, kUpdateNormalCompletion, 0};
 		}
 	}
 #endif
@@ -472,7 +494,12 @@ update_world()
 		theElapsedTime++;
 		
 		if (call_postidle)
+		{
+			TickPhaseTimer timer(_tick_phase_lua_postidle);
 			L_Call_PostIdle();
+		}
+		world_tick_finished();
+
 		if(theUpdateResult != kUpdateNormalCompletion || Movie::instance()->IsRecording())
 		{
 			canUpdate = false;
@@ -480,6 +507,21 @@ update_world()
 
 		}
 
+	return world_update_ticks{true, static_cast<int16>(theUpdateResult), theElapsedTime};
+}
+
+// What follows the ticks: the HUD, fades, the end of the game or of a film,
+// then prediction; always on the main thread
+std::pair<bool, int16>
+finish_world_update(const world_update_ticks& ticks)
+{
+	if (!ticks.advanced)
+	{
+		return std::pair<bool, int16_t>(false, 0);
+	}
+
+        short theElapsedTime = ticks.elapsed;
+        int theUpdateResult = ticks.result;
 
         // This and the following voodoo comes, effectively, from Bungie's code.
         if(theUpdateResult == kUpdateChangeLevel)
@@ -548,6 +590,42 @@ update_world()
 	return std::pair<bool, int16>(didPredict || theElapsedTime != 0, theElapsedTime);
 }
 
+// No heartbeat, prediction or interpolation here: the caller (alephbet-replay)
+// drives the world as fast as it can, one tick per call.
+bool
+update_world_headless()
+{
+	if(GameQueue->countActionFlags(0) == 0)
+	{
+		if(!pull_replay_flags_for_one_tick() ||
+		   !overlay_queue_with_queue_into_queue(GetRealActionQueues(), GetLuaActionQueues(), GameQueue))
+		{
+			return false;
+		}
+	}
+
+	for(short i = 0; i < dynamic_world->player_count; i++)
+		sMostRecentFlagsForPlayer[i] = GameQueue->peekActionFlags(i, 0);
+
+	bool call_postidle = true;
+	int theUpdateResult = update_world_elements_one_tick(call_postidle);
+
+	if (call_postidle)
+	{
+		TickPhaseTimer timer(_tick_phase_lua_postidle);
+		L_Call_PostIdle();
+	}
+	world_tick_finished();
+
+	if(theUpdateResult == kUpdateGameOver)
+	{
+		game_timed_out();
+		return false;
+	}
+
+	return true;
+}
+
 /* call this function before leaving the old level, but DO NOT call it when saving the player.
 	it should be called when you're leaving the game (i.e., quitting or reverting, etc.) */
 void leaving_map(
@@ -566,6 +644,8 @@ void leaving_map(
     MarkLuaHUDCollections(false);
 	L_Call_Cleanup ();
 
+	TickProfiler::instance()->level_finished(mac_roman_to_utf8(static_world->level_name));
+
 	// don't send stats on film replay
 	// don't call player_controlling_game() since game_state.state has changed
 	short user = get_game_controller();
@@ -613,6 +693,9 @@ bool entering_map(bool restoring_saved)
 
 	/* and since no monsters have paths, we should make sure no paths think they have monsters */
 	reset_paths();
+
+	/* build these now rather than on the first line-of-sight check */
+	if (film_profile.potentially_visible_sets) build_potentially_visible_sets();
 	
 	/* mark our shape collections for loading and load them */
 	mark_environment_collections(static_world->environment_code, true);
@@ -649,6 +732,10 @@ bool entering_map(bool restoring_saved)
 
 	init_interpolated_world();
 
+	/* everything the snapshots copy has its final size by now */
+	reset_world_snapshots();
+	reset_world_hash();
+
 #if !defined(DISABLE_NETWORKING)
 	NetSetChatCallbacks(InGameChatCallbacks::instance());
 #endif // !defined(DISABLE_NETWORKING)
@@ -882,6 +969,34 @@ void cause_polygon_damage(
 
 /* ---------- private code */
 	
+/* hashes the finished tick, compares the hash with the other players' once a
+	sample is complete, and hands the tick to the film */
+static void world_tick_finished(
+	void)
+{
+	bool world_hash_sampled= update_world_hash();
+
+#if !defined(DISABLE_NETWORKING)
+	if (world_hash_sampled && game_is_networked)
+	{
+		NetNoteWorldHash(get_world_hash_sample());
+
+		short player_index;
+		int32 tick;
+		uint32 subsystems;
+		if (NetGetWorldHashDesync(player_index, tick, subsystems))
+		{
+			const char *name= player_index < dynamic_world->player_count ? get_player_data(player_index)->name : "";
+			logError("out of sync with %s (player %d) from tick %d (%s)", name, player_index, tick,
+					 describe_world_hash_subsystems(subsystems).c_str());
+			screen_printf("Out of sync with %s from tick %d", name, tick);
+		}
+	}
+#endif
+
+	film_tick_finished(world_hash_sampled);
+}
+
 /* They ran out of time.  This means different things depending on the */
 /* type of game.. */
 static void game_timed_out(
@@ -31,6 +31,7 @@
 #include "interface.h"
 #include "FilmProfile.h"
 #include "flood_map.h"
+#include "pvs.h"
 #include "effects.h"
 #include "monsters.h"
 #include "projectiles.h"
@@ -68,6 +69,10 @@
 
 #define MINIMUM_ACTIVATION_SEPARATION TICKS_PER_SECOND
 
+/* monsters waiting in line for a new path get one every fourth tick; hierarchical searches are
+	cheap enough to give this many every tick */
+#define HIERARCHICAL_PATHS_PER_TICK 2
+
 /* when looking for things under or at this light intensity the monster must use his dark visual range */
 #define LOW_LIGHT_INTENSITY 0
 
@@ -393,7 +398,9 @@ void move_monsters(
 {
 	struct monster_data *monster;
 	bool monster_got_time= false;
-	bool monster_built_path= (dynamic_world->tick_count&3) ? true : false;
+	short paths_per_tick= film_profile.hierarchical_pathfinding ? HIERARCHICAL_PATHS_PER_TICK :
+		((dynamic_world->tick_count&3) ? 0 : 1);
+	short paths_left= paths_per_tick;
 	short monster_index;
 
 	for (monster_index= 0, monster= monsters; monster_index<MAXIMUM_MONSTERS_PER_MAP; ++monster_index, ++monster)
@@ -455,16 +462,16 @@ void move_monsters(
 						if (monster_got_time) dynamic_world->last_monster_index_to_get_time= monster_index;
 					}
 		
-					/* if this monster needs a path, generate one (unless we’ve already generated a
-						path this frame in which case we’ll wait until next frame, UNLESS the monster
+					/* if this monster needs a path, generate one (unless we’ve already generated our
+						paths this frame in which case we’ll wait until next frame, UNLESS the monster
 						has no path in which case it needs one regardless) */
 					if (MONSTER_NEEDS_PATH(monster) && !MONSTER_IS_DYING(monster) && !MONSTER_IS_ATTACKING(monster) &&
-						((!monster_built_path && monster_index>dynamic_world->last_monster_index_to_build_path) || monster->path==NONE))
+						((paths_left>0 && monster_index>dynamic_world->last_monster_index_to_build_path) || monster->path==NONE))
 					{
 						generate_new_path_for_monster(monster_index);
-						if (!monster_built_path)
+						if (paths_left>0)
 						{
-							monster_built_path= true;
+							paths_left-= 1;
 							dynamic_world->last_monster_index_to_build_path= monster_index;
 						}
 					}
@@ -587,7 +594,7 @@ void move_monsters(
 	/* either there are no unlocked monsters or ‘dynamic_world->last_monster_index_to_get_time’ is higher than
 		all of them (so we reset it to zero) ... same for paths */
 	if (!monster_got_time) dynamic_world->last_monster_index_to_get_time= -1;
-	if (!monster_built_path) dynamic_world->last_monster_index_to_build_path= -1;
+	if (paths_left>0) dynamic_world->last_monster_index_to_build_path= -1;
 
 	if (dynamic_world->civilians_killed_by_players)
 	{
@@ -2320,6 +2327,14 @@ static bool clear_line_of_sight(
 			}
 		}
 
+		/* if no straight line could get from the viewer’s polygon to the target’s, don’t bother
+			walking one */
+		if (target_visible && film_profile.potentially_visible_sets &&
+			!polygon_is_potentially_visible(viewer_object->polygon, target_object->polygon))
+		{
+			target_visible= false;
+		}
+
 		/* make sure there are no non-transparent lines between the viewer and the target */
 		if (target_visible)
 		{
@@ -30,6 +30,11 @@
 #include "map.h"
 #include "flood_map.h"
 #include "dynamic_limits.h"
+#include "FilmProfile.h"
+#include "world_snapshot.h"
+
+#include <algorithm>
+#include <vector>
 
 #ifdef DEBUG
 //#define VALIDATE_PATH_SPACE
@@ -54,6 +59,9 @@ we should cut corners instead of blindly following map geometry (i.e., separate
 
 #define PATH_VALIDATION_AREA_SIZE 64*1024
 
+// hierarchical pathfinding groups adjacent polygons into clusters of at most this many
+#define MAXIMUM_POLYGONS_PER_CLUSTER 16
+
 /* ---------- structures */
 
 struct path_definition /* 256 bytes */
@@ -65,10 +73,33 @@ struct path_definition /* 256 bytes */
 	world_point2d points[MAXIMUM_POINTS_PER_PATH];
 };
 
+/* a line leading out of a cluster into a neighboring one */
+struct cluster_crossing
+{
+	short cluster_index, adjacent_cluster_index;
+	short polygon_index, line_index, adjacent_polygon_index;
+};
+
 /* ---------- globals */
 
 static struct path_definition *paths = NULL;
 
+/* polygon clusters for hierarchical pathfinding; rebuilt on first use after reset_paths().
+	they depend only on the map, never on what the world was doing when they were built */
+static struct path_hierarchy_data
+{
+	bool valid;
+	short cluster_count;
+	std::vector<short> polygon_clusters; /* NONE for detached polygons */
+	std::vector<int32> crossing_offsets; /* cluster_count+1 offsets into crossings */
+	std::vector<cluster_crossing> crossings; /* grouped by cluster, then by adjacent cluster */
+} path_hierarchy;
+
+/* state for search_cost_proc() and corridor_cost_proc() during one search */
+static cost_proc_ptr caller_cost_proc;
+static void *search_cost_data;
+static std::vector<bool> search_corridor; /* by cluster */
+
 #ifdef VERIFY_PATH_SYNC
 static byte *path_validation_area = NULL;
 static int32 path_validation_area_index;
@@ -80,6 +111,21 @@ static short path_run_count;
 static void calculate_midpoint_of_shared_line(short polygon1, short polygon2,
 	world_distance minimum_separation, world_point2d *midpoint);
 
+static short new_hierarchical_path(short path_index, short source_polygon_index,
+	world_point2d *destination_point, short destination_polygon_index,
+	world_distance minimum_separation, cost_proc_ptr cost, void *data);
+static short build_path_from_route(short path_index, const std::vector<short>& polygon_indexes,
+	bool reached_destination, world_point2d *destination_point, world_distance minimum_separation);
+static bool search_route(short source_polygon_index, short destination_polygon_index,
+	std::vector<short>& polygon_indexes);
+static bool flood_to_destination(short source_polygon_index, short destination_polygon_index,
+	cost_proc_ptr cost, std::vector<short>& polygon_indexes);
+static int32 search_cost_proc(short source_polygon_index, short line_index,
+	short destination_polygon_index, void *caller_data);
+static int32 corridor_cost_proc(short source_polygon_index, short line_index,
+	short destination_polygon_index, void *caller_data);
+static void build_path_hierarchy(void);
+
 /* ---------- code */
 
 void allocate_pathfinding_memory(
@@ -104,6 +150,9 @@ void reset_paths(
 
 	for (path_index=0;path_index<MAXIMUM_PATHS;++path_index) paths[path_index].step_count= NONE;
 
+	/* a new level: the polygon clusters belong to the old one */
+	path_hierarchy.valid= false;
+
 #ifdef VERIFY_PATH_SYNC
 	path_run_count+= 1;
 	path_validation_area_index= 0;
@@ -150,7 +199,12 @@ short new_path(
 	}
 	if (path_index==MAXIMUM_PATHS) path_index= NONE;
 	
-	if (path_index!=NONE)
+	if (path_index!=NONE && film_profile.hierarchical_pathfinding && destination_polygon_index!=NONE)
+	{
+		path_index= new_hierarchical_path(path_index, source_polygon_index, destination_point,
+			destination_polygon_index, minimum_separation, cost, data);
+	}
+	else if (path_index!=NONE)
 	{
 		bool reached_destination;
 		short polygon_index;
@@ -309,8 +363,248 @@ void delete_path(
 	paths[path_index].step_count= NONE;
 }
 
+void add_path_snapshot_regions(
+	world_snapshot_regions& regions)
+{
+	/* the polygon clusters only depend on the map, so they can be left alone */
+	regions.push_back({ paths, MAXIMUM_PATHS*sizeof(struct path_definition) });
+}
+
 /* ---------- private code */
 
+/* finds a route through the cluster graph first and then floods only the polygons in those
+	clusters, which usually touches far fewer polygons than flooding outward from the source.
+	every search runs against the world as it is now (no routes are kept between calls), so the
+	path never depends on which searches came before it */
+static short new_hierarchical_path(
+	short path_index,
+	short source_polygon_index,
+	world_point2d *destination_point,
+	short destination_polygon_index,
+	world_distance minimum_separation,
+	cost_proc_ptr cost,
+	void *data)
+{
+	std::vector<short> polygon_indexes;
+	bool reached_destination;
+	
+	caller_cost_proc= cost;
+	search_cost_data= data;
+	reached_destination= search_route(source_polygon_index, destination_polygon_index, polygon_indexes);
+	
+	return build_path_from_route(path_index, polygon_indexes, reached_destination,
+		destination_point, minimum_separation);
+}
+
+/* fills polygon_indexes with the route from source to destination, or if the destination can’t be
+	reached, to the last polygon the flood expanded (just like the non-hierarchical search) */
+static bool search_route(
+	short source_polygon_index,
+	short destination_polygon_index,
+	std::vector<short>& polygon_indexes)
+{
+	if (!path_hierarchy.valid) build_path_hierarchy();
+	
+	short source_cluster_index= path_hierarchy.polygon_clusters[source_polygon_index];
+	short destination_cluster_index= path_hierarchy.polygon_clusters[destination_polygon_index];
+	
+	if (source_cluster_index!=NONE && destination_cluster_index!=NONE)
+	{
+		/* breadth-first search of the cluster graph; a neighboring cluster is reachable if
+			the cost function lets us across any of the lines between the two */
+		std::vector<short> parents(path_hierarchy.cluster_count, NONE);
+		std::vector<short> queue;
+		size_t queue_index;
+		
+		parents[source_cluster_index]= source_cluster_index;
+		queue.push_back(source_cluster_index);
+		for (queue_index= 0; queue_index<queue.size() && parents[destination_cluster_index]==NONE; ++queue_index)
+		{
+			short cluster_index= queue[queue_index];
+			int32 end= path_hierarchy.crossing_offsets[cluster_index+1];
+			
+			for (int32 i= path_hierarchy.crossing_offsets[cluster_index]; i<end; ++i)
+			{
+				const cluster_crossing& crossing= path_hierarchy.crossings[i];
+				
+				if (parents[crossing.adjacent_cluster_index]==NONE &&
+					search_cost_proc(crossing.polygon_index, crossing.line_index, crossing.adjacent_polygon_index, search_cost_data)>0)
+				{
+					parents[crossing.adjacent_cluster_index]= cluster_index;
+					queue.push_back(crossing.adjacent_cluster_index);
+				}
+			}
+		}
+		
+		/* refine: flood through the corridor of clusters we found */
+		if (parents[destination_cluster_index]!=NONE)
+		{
+			search_corridor.assign(path_hierarchy.cluster_count, false);
+			for (short cluster_index= destination_cluster_index; ; cluster_index= parents[cluster_index])
+			{
+				search_corridor[cluster_index]= true;
+				if (cluster_index==source_cluster_index) break;
+			}
+			
+			if (flood_to_destination(source_polygon_index, destination_polygon_index, corridor_cost_proc, polygon_indexes)) return true;
+		}
+	}
+	
+	/* the corridor was blocked inside a cluster (or ran out of flood nodes); flood the whole map */
+	return flood_to_destination(source_polygon_index, destination_polygon_index, search_cost_proc, polygon_indexes);
+}
+
+static bool flood_to_destination(
+	short source_polygon_index,
+	short destination_polygon_index,
+	cost_proc_ptr cost,
+	std::vector<short>& polygon_indexes)
+{
+	short polygon_index;
+	
+	polygon_index= flood_map(source_polygon_index, INT32_MAX, cost, _breadth_first, search_cost_data);
+	while (polygon_index!=NONE&&polygon_index!=destination_polygon_index)
+	{
+		polygon_index= flood_map(NONE, INT32_MAX, cost, _breadth_first, search_cost_data);
+	}
+	
+	polygon_indexes.clear();
+	while ((polygon_index= reverse_flood_map())!=NONE) polygon_indexes.push_back(polygon_index);
+	std::reverse(polygon_indexes.begin(), polygon_indexes.end());
+	
+	return !polygon_indexes.empty() && polygon_indexes.back()==destination_polygon_index;
+}
+
+/* the caller’s cost function, or the polygon’s area (as in flood_map()) if there isn’t one */
+static int32 search_cost_proc(
+	short source_polygon_index,
+	short line_index,
+	short destination_polygon_index,
+	void *caller_data)
+{
+	return caller_cost_proc ? caller_cost_proc(source_polygon_index, line_index, destination_polygon_index, caller_data) :
+		get_polygon_data(source_polygon_index)->area;
+}
+
+static int32 corridor_cost_proc(
+	short source_polygon_index,
+	short line_index,
+	short destination_polygon_index,
+	void *caller_data)
+{
+	short cluster_index= path_hierarchy.polygon_clusters[destination_polygon_index];
+	
+	if (cluster_index==NONE || !search_corridor[cluster_index]) return -1;
+	
+	return search_cost_proc(source_polygon_index, line_index, destination_polygon_index, caller_data);
+}
+
+/* same point layout as new_path(): the midpoint of each shared line along the route, and then the
+	destination itself if we reached it; points past MAXIMUM_POINTS_PER_PATH are dropped */
+static short build_path_from_route(
+	short path_index,
+	const std::vector<short>& polygon_indexes,
+	bool reached_destination,
+	world_point2d *destination_point,
+	world_distance minimum_separation)
+{
+	short depth= polygon_indexes.empty() ? 0 : static_cast<short>(polygon_indexes.size()-1);
+	short step_count= reached_destination ? depth+1 : depth;
+	
+	if (step_count>0)
+	{
+		struct path_definition *path= paths+path_index;
+		
+		obj_set(*path, 0x80);
+		path->step_count= step_count>MAXIMUM_POINTS_PER_PATH ? MAXIMUM_POINTS_PER_PATH : step_count;
+		path->current_step= 0;
+		
+		if (reached_destination && depth<MAXIMUM_POINTS_PER_PATH) path->points[depth]= *destination_point;
+		for (short i= depth-1; i>=0; --i)
+		{
+			if (i<MAXIMUM_POINTS_PER_PATH) calculate_midpoint_of_shared_line(polygon_indexes[i+1], polygon_indexes[i], minimum_separation, path->points+i);
+		}
+	}
+	else
+	{
+		path_index= NONE;
+	}
+	
+	return path_index;
+}
+
+/* grows clusters outward from each unclustered polygon in index order, so the result depends only
+	on the map */
+static void build_path_hierarchy(
+	void)
+{
+	std::vector<short>& clusters= path_hierarchy.polygon_clusters;
+	std::vector<short> members;
+	short polygon_index;
+	
+	clusters.assign(dynamic_world->polygon_count, NONE);
+	path_hierarchy.cluster_count= 0;
+	for (polygon_index= 0; polygon_index<dynamic_world->polygon_count; ++polygon_index)
+	{
+		if (clusters[polygon_index]!=NONE || POLYGON_IS_DETACHED(get_polygon_data(polygon_index))) continue;
+		
+		short cluster_index= path_hierarchy.cluster_count++;
+		members.clear();
+		members.push_back(polygon_index);
+		clusters[polygon_index]= cluster_index;
+		for (size_t member= 0; member<members.size() && members.size()<MAXIMUM_POLYGONS_PER_CLUSTER; ++member)
+		{
+			struct polygon_data *polygon= get_polygon_data(members[member]);
+			
+			for (short i= 0; i<polygon->vertex_count && members.size()<MAXIMUM_POLYGONS_PER_CLUSTER; ++i)
+			{
+				short adjacent_polygon_index= polygon->adjacent_polygon_indexes[i];
+				
+				if (adjacent_polygon_index!=NONE && clusters[adjacent_polygon_index]==NONE &&
+					!POLYGON_IS_DETACHED(get_polygon_data(adjacent_polygon_index)))
+				{
+					clusters[adjacent_polygon_index]= cluster_index;
+					members.push_back(adjacent_polygon_index);
+				}
+			}
+		}
+	}
+	
+	path_hierarchy.crossings.clear();
+	for (polygon_index= 0; polygon_index<dynamic_world->polygon_count; ++polygon_index)
+	{
+		struct polygon_data *polygon= get_polygon_data(polygon_index);
+		
+		if (clusters[polygon_index]==NONE) continue;
+		for (short i= 0; i<polygon->vertex_count; ++i)
+		{
+			short adjacent_polygon_index= polygon->adjacent_polygon_indexes[i];
+			
+			if (adjacent_polygon_index!=NONE && clusters[adjacent_polygon_index]!=NONE &&
+				clusters[adjacent_polygon_index]!=clusters[polygon_index])
+			{
+				cluster_crossing crossing= { clusters[polygon_index], clusters[adjacent_polygon_index],
+					polygon_index, polygon->line_indexes[i], adjacent_polygon_index };
+				path_hierarchy.crossings.push_back(crossing);
+			}
+		}
+	}
+	std::stable_sort(path_hierarchy.crossings.begin(), path_hierarchy.crossings.end(),
+		[](const cluster_crossing& a, const cluster_crossing& b) {
+			return a.cluster_index<b.cluster_index ||
+				(a.cluster_index==b.cluster_index && a.adjacent_cluster_index<b.adjacent_cluster_index);
+		});
+	
+	path_hierarchy.crossing_offsets.assign(path_hierarchy.cluster_count+1, 0);
+	for (const auto& crossing : path_hierarchy.crossings) path_hierarchy.crossing_offsets[crossing.cluster_index+1]+= 1;
+	for (short cluster_index= 0; cluster_index<path_hierarchy.cluster_count; ++cluster_index)
+	{
+		path_hierarchy.crossing_offsets[cluster_index+1]+= path_hierarchy.crossing_offsets[cluster_index];
+	}
+	
+	path_hierarchy.valid= true;
+}
+
 static void calculate_midpoint_of_shared_line(
 	short polygon1,
 	short polygon2,
@@ -0,0 +1,476 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  pvs.cpp - per-polygon potentially visible sets
+ *
+ *  clear_line_of_sight() and the render tree both follow a straight line
+ *  from polygon to polygon, leaving each one through an edge the line
+ *  passes through (find_line_crossed_leaving_polygon() accepts lines that
+ *  touch the edge's endpoints). So a polygon B can only be reached from A if
+ *  some line passes through every edge of a chain of adjacent polygons from
+ *  A to B. Crossing an edge puts its clockwise endpoint on one side of the
+ *  line and the other endpoint on the other side, so such a line exists
+ *  exactly when the two sets of endpoints can be separated by a line.
+ *
+ *  We search outward from every polygon, carrying a separating line for the
+ *  chain so far. Most new edges already fit that line. When one doesn't, a
+ *  new separating line (if any exists) can be found through the new
+ *  endpoint, because separating lines form a convex cone.
+ */
+
+#include "cseries.h"
+#include "pvs.h"
+#include "map.h"
+#include "map_index_cache.h"
+#include "FileHandler.h"
+#include "Logging.h"
+#include "Packing.h"
+#include "crc.h"
+
+#include <vector>
+
+/* ---------- constants */
+
+// bump whenever the sets would come out differently, so old cache files are ignored
+#define PVS_CACHE_VERSION 1
+#define PVS_CACHE_TAG FOUR_CHARS_TO_INT('p','v','s','1')
+#define PVS_CACHE_HEADER_SIZE 16
+
+// a search from one polygon that takes more steps than this gives up and marks everything it
+// could reach through polygon edges instead, which is always safe
+#define MAXIMUM_PVS_STEPS_PER_POLYGON 8192
+
+/* ---------- structures */
+
+/* a*x + b*y + c; left points are >=0 and right points <=0 */
+struct separating_line
+{
+	int64_t a, b, c;
+};
+
+struct pvs_search_frame
+{
+	short polygon_index;
+	short next_edge;
+	separating_line line;
+};
+
+/* ---------- globals */
+
+static struct pvs_data
+{
+	bool valid;
+	int32 words_per_polygon;
+	std::vector<uint32> bits;
+} pvs;
+
+/* ---------- private prototypes */
+
+static bool calculate_polygon_pvs(short polygon_index, uint32 *row, std::vector<pvs_search_frame>& stack,
+	std::vector<bool>& in_path, std::vector<world_point2d>& left_points, std::vector<world_point2d>& right_points);
+static void mark_reachable_polygons(short polygon_index, uint32 *row);
+static bool add_portal_point(std::vector<world_point2d>& points, const world_point2d& p, bool have_line,
+	std::vector<world_point2d>& left_points, std::vector<world_point2d>& right_points, separating_line *line);
+static bool find_separating_line(const std::vector<world_point2d>& left_points, const std::vector<world_point2d>& right_points,
+	const world_point2d *pivot, separating_line *line);
+static bool line_separates(const separating_line& line, const std::vector<world_point2d>& left_points,
+	const std::vector<world_point2d>& right_points);
+static bool points_are_collinear(const std::vector<world_point2d>& left_points, const std::vector<world_point2d>& right_points,
+	size_t left_count, size_t right_count);
+static uint32 calculate_geometry_hash(void);
+static FileSpecifier get_pvs_cache_file(void);
+static bool load_pvs_cache(uint32 geometry_hash);
+static void save_pvs_cache(uint32 geometry_hash);
+
+/* ---------- code */
+
+void build_potentially_visible_sets(
+	void)
+{
+	if (pvs.valid) return;
+	
+	short polygon_count= dynamic_world->polygon_count;
+	uint32 geometry_hash= calculate_geometry_hash();
+	
+	pvs.words_per_polygon= (polygon_count+31)/32;
+	if (!load_pvs_cache(geometry_hash))
+	{
+		std::vector<pvs_search_frame> stack;
+		std::vector<bool> in_path(polygon_count, false);
+		std::vector<world_point2d> left_points, right_points;
+		uint32 start_ticks= machine_tick_count();
+		short truncated_count= 0;
+		
+		pvs.bits.assign(static_cast<size_t>(pvs.words_per_polygon)*polygon_count, 0);
+		for (short polygon_index= 0; polygon_index<polygon_count; ++polygon_index)
+		{
+			if (!calculate_polygon_pvs(polygon_index, &pvs.bits[static_cast<size_t>(pvs.words_per_polygon)*polygon_index],
+				stack, in_path, left_points, right_points))
+			{
+				truncated_count+= 1;
+			}
+		}
+		
+		/* this is the load-time cost of the sets on a map we haven't seen before */
+		logNote("built potentially visible sets for %d polygons in %u ms (%u KB, %d searches hit the step limit)",
+			polygon_count, machine_tick_count()-start_ticks, static_cast<unsigned>(4*pvs.bits.size()/1024), truncated_count);
+		
+		save_pvs_cache(geometry_hash);
+	}
+	
+	pvs.valid= true;
+}
+
+void invalidate_potentially_visible_sets(
+	void)
+{
+	pvs.valid= false;
+	pvs.bits.clear();
+}
+
+bool polygon_is_potentially_visible(
+	short from_polygon_index,
+	short to_polygon_index)
+{
+	if (!pvs.valid) build_potentially_visible_sets();
+	
+	assert(from_polygon_index>=0&&from_polygon_index<dynamic_world->polygon_count);
+	assert(to_polygon_index>=0&&to_polygon_index<dynamic_world->polygon_count);
+	const uint32 *row= &pvs.bits[static_cast<size_t>(pvs.words_per_polygon)*from_polygon_index];
+	
+	return (row[to_polygon_index>>5]>>(to_polygon_index&31))&1;
+}
+
+/* ---------- private code */
+
+/* depth-first search over chains of adjacent polygons that a single line can pass through;
+	returns false if it gave up and fell back to marking everything reachable */
+static bool calculate_polygon_pvs(
+	short polygon_index,
+	uint32 *row,
+	std::vector<pvs_search_frame>& stack,
+	std::vector<bool>& in_path,
+	std::vector<world_point2d>& left_points,
+	std::vector<world_point2d>& right_points)
+{
+	int32 steps= 0;
+	
+	row[polygon_index>>5]|= 1u<<(polygon_index&31);
+	
+	stack.clear();
+	left_points.clear();
+	right_points.clear();
+	stack.push_back({polygon_index, 0, {0, 0, 0}});
+	in_path[polygon_index]= true;
+	
+	while (!stack.empty())
+	{
+		pvs_search_frame& frame= stack.back();
+		struct polygon_data *polygon= get_polygon_data(frame.polygon_index);
+		
+		if (frame.next_edge>=polygon->vertex_count)
+		{
+			in_path[frame.polygon_index]= false;
+			stack.pop_back();
+			if (!stack.empty()) left_points.pop_back(), right_points.pop_back();
+			continue;
+		}
+		
+		short i= frame.next_edge++;
+		short adjacent_polygon_index= find_adjacent_polygon(frame.polygon_index, polygon->line_indexes[i]);
+		if (adjacent_polygon_index==NONE || in_path[adjacent_polygon_index]) continue;
+		
+		if (++steps>MAXIMUM_PVS_STEPS_PER_POLYGON)
+		{
+			/* too many chains to follow; fall back to everything we can walk to */
+			for (const auto& f : stack) in_path[f.polygon_index]= false;
+			mark_reachable_polygons(polygon_index, row);
+			return false;
+		}
+		
+		/* e1 is clockwise from e0, and ends up on the left of any line leaving through this edge */
+		const world_point2d& e0= get_endpoint_data(polygon->endpoint_indexes[i])->vertex;
+		const world_point2d& e1= get_endpoint_data(polygon->endpoint_indexes[i==polygon->vertex_count-1 ? 0 : i+1])->vertex;
+		separating_line line= frame.line;
+		
+		if (!add_portal_point(left_points, e1, stack.size()>1, left_points, right_points, &line))
+		{
+			left_points.pop_back();
+			continue;
+		}
+		if (!add_portal_point(right_points, e0, true, left_points, right_points, &line))
+		{
+			left_points.pop_back();
+			right_points.pop_back();
+			continue;
+		}
+		
+		row[adjacent_polygon_index>>5]|= 1u<<(adjacent_polygon_index&31);
+		in_path[adjacent_polygon_index]= true;
+		stack.push_back({adjacent_polygon_index, 0, line});
+	}
+	
+	return true;
+}
+
+static void mark_reachable_polygons(
+	short polygon_index,
+	uint32 *row)
+{
+	std::vector<short> queue(1, polygon_index);
+	
+	row[polygon_index>>5]|= 1u<<(polygon_index&31);
+	for (size_t queue_index= 0; queue_index<queue.size(); ++queue_index)
+	{
+		struct polygon_data *polygon= get_polygon_data(queue[queue_index]);
+		
+		for (short i= 0; i<polygon->vertex_count; ++i)
+		{
+			short adjacent_polygon_index= find_adjacent_polygon(queue[queue_index], polygon->line_indexes[i]);
+			
+			if (adjacent_polygon_index!=NONE && !((row[adjacent_polygon_index>>5]>>(adjacent_polygon_index&31))&1))
+			{
+				row[adjacent_polygon_index>>5]|= 1u<<(adjacent_polygon_index&31);
+				queue.push_back(adjacent_polygon_index);
+			}
+		}
+	}
+}
+
+/* appends p to points (one of left_points or right_points) and makes sure line still separates
+	the two sets, finding a new one if it has to; returns false if no line can.  line is only
+	trusted if have_line is set */
+static bool add_portal_point(
+	std::vector<world_point2d>& points,
+	const world_point2d& p,
+	bool have_line,
+	std::vector<world_point2d>& left_points,
+	std::vector<world_point2d>& right_points,
+	separating_line *line)
+{
+	bool left= &points==&left_points;
+	size_t left_count= left_points.size(), right_count= right_points.size();
+	
+	points.push_back(p);
+	if (have_line)
+	{
+		int64_t side= line->a*p.x + line->b*p.y + line->c;
+		if (left ? side>=0 : side<=0) return true;
+	}
+	
+	/* if any line separates the new sets, one passes through p (unless the old points were all
+		on one line, in which case we have to look harder) */
+	if (find_separating_line(left_points, right_points, &p, line)) return true;
+	return points_are_collinear(left_points, right_points, left_count, right_count) &&
+		find_separating_line(left_points, right_points, NULL, line);
+}
+
+/* tries every line through pivot and another point (or through any two points, if pivot is NULL) */
+static bool find_separating_line(
+	const std::vector<world_point2d>& left_points,
+	const std::vector<world_point2d>& right_points,
+	const world_point2d *pivot,
+	separating_line *line)
+{
+	size_t count= left_points.size()+right_points.size();
+	auto point= [&](size_t i) -> const world_point2d& {
+		return i<left_points.size() ? left_points[i] : right_points[i-left_points.size()];
+	};
+	bool found_distinct_points= false;
+	
+	for (size_t i= 0; i<count; ++i)
+	{
+		const world_point2d& p0= pivot ? *pivot : point(i);
+		
+		for (size_t j= pivot ? 0 : i+1; j<count; ++j)
+		{
+			const world_point2d& p1= point(j);
+			separating_line candidate;
+			
+			if (p0.x==p1.x && p0.y==p1.y) continue;
+			found_distinct_points= true;
+			
+			candidate.a= p1.y-p0.y;
+			candidate.b= p0.x-p1.x;
+			candidate.c= -(candidate.a*p0.x + candidate.b*p0.y);
+			if (line_separates(candidate, left_points, right_points))
+			{
+				*line= candidate;
+				return true;
+			}
+			
+			candidate.a= -candidate.a, candidate.b= -candidate.b, candidate.c= -candidate.c;
+			if (line_separates(candidate, left_points, right_points))
+			{
+				*line= candidate;
+				return true;
+			}
+		}
+		
+		if (pivot) break;
+	}
+	
+	if (!found_distinct_points && count)
+	{
+		/* every point is the same point; any line through it will do */
+		const world_point2d& p= pivot ? *pivot : point(0);
+		
+		line->a= 1, line->b= 0, line->c= -p.x;
+		return true;
+	}
+	
+	return false;
+}
+
+static bool line_separates(
+	const separating_line& line,
+	const std::vector<world_point2d>& left_points,
+	const std::vector<world_point2d>& right_points)
+{
+	for (const auto& p : left_points)
+	{
+		if (line.a*p.x + line.b*p.y + line.c<0) return false;
+	}
+	for (const auto& p : right_points)
+	{
+		if (line.a*p.x + line.b*p.y + line.c>0) return false;
+	}
+	
+	return true;
+}
+
+/* are the first left_count left points and right_count right points all on one line? */
+static bool points_are_collinear(
+	const std::vector<world_point2d>& left_points,
+	const std::vector<world_point2d>& right_points,
+	size_t left_count,
+	size_t right_count)
+{
+	std::vector<world_point2d> points(left_points.begin(), left_points.begin()+left_count);
+	points.insert(points.end(), right_points.begin(), right_points.begin()+right_count);
+	
+	size_t i;
+	for (i= 1; i<points.size() && points[i].x==points[0].x && points[i].y==points[0].y; ++i)
+		;
+	for (size_t j= i+1; j<points.size(); ++j)
+	{
+		int64_t cross= int64_t(points[i].x-points[0].x)*(points[j].y-points[0].y) -
+			int64_t(points[i].y-points[0].y)*(points[j].x-points[0].x);
+		if (cross) return false;
+	}
+	
+	return true;
+}
+
+/* FNV-1a over everything the search looks at */
+static uint32 calculate_geometry_hash(
+	void)
+{
+	uint32 hash= FNV1A_OFFSET_BASIS;
+	auto add= [&hash](int32 value) { hash= calculate_value_fnv1a(value, hash); };
+	
+	add(PVS_CACHE_VERSION);
+	add(dynamic_world->polygon_count);
+	for (short polygon_index= 0; polygon_index<dynamic_world->polygon_count; ++polygon_index)
+	{
+		struct polygon_data *polygon= get_polygon_data(polygon_index);
+		
+		add(polygon->vertex_count);
+		for (short i= 0; i<polygon->vertex_count; ++i)
+		{
+			world_point2d& vertex= get_endpoint_data(polygon->endpoint_indexes[i])->vertex;
+			struct line_data *line= get_line_data(polygon->line_indexes[i]);
+			
+			add(vertex.x), add(vertex.y);
+			add(line->clockwise_polygon_owner), add(line->counterclockwise_polygon_owner);
+		}
+	}
+	
+	return hash;
+}
+
+static FileSpecifier get_pvs_cache_file(
+	void)
+{
+	FileSpecifier file= get_map_cache_directory();
+	char name[64];
+	
+	snprintf(name, sizeof(name), "pvs_%08x_%d.dat", get_current_map_checksum(), dynamic_world->current_level_number);
+	file+= name;
+	
+	return file;
+}
+
+static bool load_pvs_cache(
+	uint32 geometry_hash)
+{
+	FileSpecifier file= get_pvs_cache_file();
+	OpenedFile in;
+	int32 expected_length= PVS_CACHE_HEADER_SIZE + 4*pvs.words_per_polygon*dynamic_world->polygon_count;
+	int32 length;
+	
+	if (!file.Exists() || !file.Open(in) || !in.GetLength(length) || length!=expected_length) return false;
+	
+	std::vector<uint8> data(length);
+	if (!in.Read(length, data.data())) return false;
+	
+	uint8 *S= data.data();
+	uint32 tag, version, hash, polygon_count;
+	StreamToValue(S, tag);
+	StreamToValue(S, version);
+	StreamToValue(S, hash);
+	StreamToValue(S, polygon_count);
+	if (tag!=PVS_CACHE_TAG || version!=PVS_CACHE_VERSION || hash!=geometry_hash ||
+		polygon_count!=static_cast<uint32>(dynamic_world->polygon_count))
+	{
+		return false;
+	}
+	
+	pvs.bits.resize(static_cast<size_t>(pvs.words_per_polygon)*dynamic_world->polygon_count);
+	StreamToList(S, pvs.bits.data(), pvs.bits.size());
+	
+	return true;
+}
+
+static void save_pvs_cache(
+	uint32 geometry_hash)
+{
+	FileSpecifier file= get_pvs_cache_file();
+	OpenedFile out;
+	std::vector<uint8> data(PVS_CACHE_HEADER_SIZE + 4*pvs.bits.size());
+	uint8 *S= data.data();
+	
+	ValueToStream(S, uint32(PVS_CACHE_TAG));
+	ValueToStream(S, uint32(PVS_CACHE_VERSION));
+	ValueToStream(S, geometry_hash);
+	ValueToStream(S, uint32(dynamic_world->polygon_count));
+	ListToStream(S, pvs.bits.data(), pvs.bits.size());
+	
+	file.Delete();
+	if (!file.Open(out, true) || !out.Write(static_cast<int32>(data.size()), data.data()))
+	{
+		logWarning("Couldn't write potentially visible sets to %s", file.GetPath());
+	}
+}
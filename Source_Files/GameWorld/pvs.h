@@ -0,0 +1,52 @@
+#ifndef __PVS_H
+#define __PVS_H
+
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  pvs.h - per-polygon potentially visible sets
+ *
+ *  For every polygon, a bitset of the polygons that some straight line from
+ *  it could reach by crossing polygon edges, which is exactly how
+ *  clear_line_of_sight() and the render tree walk the map. A polygon that
+ *  is not in the set can never be seen, so callers can skip their walk.
+ *  The sets only depend on 2D geometry and are cached on disk.
+ *
+ *  Building them for a map that isn't cached yet happens all at once when
+ *  the level is entered, and on big open maps many searches hit their step
+ *  limit and keep everything reachable, so no film profile turns them on
+ *  until the build is bounded.
+ */
+
+#include "cstypes.h"
+
+// builds (or loads from the cache) the sets for the current map
+void build_potentially_visible_sets(void);
+// must be called whenever polygon or endpoint geometry is replaced
+void invalidate_potentially_visible_sets(void);
+
+bool polygon_is_potentially_visible(short from_polygon_index, short to_polygon_index);
+
+#endif
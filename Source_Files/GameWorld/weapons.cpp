@@ -37,6 +37,7 @@
 
 #include "Packing.h"
 #include "shell.h"
+#include "world_snapshot.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -258,6 +259,12 @@ void initialize_weapon_manager(
 	objlist_clear(player_weapons_array, MAXIMUM_NUMBER_OF_PLAYERS);
 }
 
+void add_player_weapon_snapshot_regions(
+	world_snapshot_regions& regions)
+{
+	regions.push_back({ player_weapons_array, MAXIMUM_NUMBER_OF_PLAYERS*sizeof(struct player_weapon_data) });
+}
+
 void initialize_player_weapons_for_new_game(
 	short player_index)
 {
@@ -0,0 +1,286 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  world_hash.cpp - a running hash of the deterministic world state
+ *
+ *  Only fields that every peer computes identically go in: no render or
+ *  interface state (like _object_was_rendered), nothing local to one player.
+ */
+
+#include "cseries.h"
+#include "world_hash.h"
+
+#include "world.h"
+#include "player.h"
+#include "monsters.h"
+#include "projectiles.h"
+#include "effects.h"
+#include "platforms.h"
+#include "lightsource.h"
+#include "media.h"
+#include "world_snapshot.h"
+#include "crc.h"
+
+/* ---------- globals */
+
+// the chains are world state too, so world snapshots carry them
+static struct world_hash_data
+{
+	uint32 subsystem_hashes[NUMBER_OF_WORLD_HASH_SUBSYSTEMS];
+	world_hash_sample sample; // being filled in
+	world_hash_sample last_sample;
+} world_hash;
+
+static const char *subsystem_names[NUMBER_OF_WORLD_HASH_SUBSYSTEMS]=
+{
+	"random seed",
+	"players",
+	"monsters",
+	"objects",
+	"projectiles",
+	"effects",
+	"platforms",
+	"lights and medias"
+};
+
+/* ---------- private code */
+
+static inline void hash_value(
+	uint32& hash,
+	int32 value)
+{
+	hash= calculate_value_fnv1a(value, hash);
+}
+
+static void hash_random_seed(
+	uint32& hash)
+{
+	hash_value(hash, dynamic_world->tick_count);
+	hash_value(hash, get_random_seed());
+}
+
+static void hash_players(
+	uint32& hash)
+{
+	for (short i= 0; i<dynamic_world->player_count; ++i)
+	{
+		player_data *player= get_player_data(i);
+
+		hash_value(hash, player->location.x);
+		hash_value(hash, player->location.y);
+		hash_value(hash, player->location.z);
+		hash_value(hash, player->facing);
+		hash_value(hash, player->elevation);
+		hash_value(hash, player->suit_energy);
+		hash_value(hash, player->suit_oxygen);
+		hash_value(hash, player->monster_index);
+	}
+}
+
+static void hash_monsters(
+	uint32& hash)
+{
+	monster_data *monster= monsters;
+	for (short i= 0; i<MAXIMUM_MONSTERS_PER_MAP; ++i, ++monster)
+	{
+		if (!SLOT_IS_USED(monster)) continue;
+
+		hash_value(hash, i);
+		hash_value(hash, monster->type);
+		hash_value(hash, monster->vitality);
+		hash_value(hash, monster->flags);
+		hash_value(hash, monster->mode);
+		hash_value(hash, monster->action);
+		hash_value(hash, monster->target_index);
+	}
+}
+
+static void hash_objects(
+	uint32& hash)
+{
+	object_data *object= objects;
+	for (short i= 0; i<MAXIMUM_OBJECTS_PER_MAP; ++i, ++object)
+	{
+		if (!SLOT_IS_USED(object)) continue;
+
+		hash_value(hash, i);
+		hash_value(hash, object->location.x);
+		hash_value(hash, object->location.y);
+		hash_value(hash, object->location.z);
+		hash_value(hash, object->polygon);
+		hash_value(hash, object->facing);
+	}
+}
+
+static void hash_projectiles(
+	uint32& hash)
+{
+	projectile_data *projectile= projectiles;
+	for (short i= 0; i<MAXIMUM_PROJECTILES_PER_MAP; ++i, ++projectile)
+	{
+		if (!SLOT_IS_USED(projectile)) continue;
+
+		hash_value(hash, i);
+		hash_value(hash, projectile->type);
+		hash_value(hash, projectile->object_index);
+		hash_value(hash, projectile->owner_index);
+		hash_value(hash, projectile->target_index);
+		hash_value(hash, projectile->distance_travelled);
+	}
+}
+
+static void hash_effects(
+	uint32& hash)
+{
+	effect_data *effect= effects;
+	for (short i= 0; i<MAXIMUM_EFFECTS_PER_MAP; ++i, ++effect)
+	{
+		if (!SLOT_IS_USED(effect)) continue;
+
+		hash_value(hash, i);
+		hash_value(hash, effect->type);
+		hash_value(hash, effect->object_index);
+		hash_value(hash, effect->delay);
+	}
+}
+
+static void hash_platforms(
+	uint32& hash)
+{
+	for (short i= 0; i<dynamic_world->platform_count; ++i)
+	{
+		platform_data *platform= get_platform_data(i);
+
+		hash_value(hash, platform->dynamic_flags);
+		hash_value(hash, platform->floor_height);
+		hash_value(hash, platform->ceiling_height);
+	}
+}
+
+static void hash_lights_and_medias(
+	uint32& hash)
+{
+	for (size_t i= 0; i<LightList.size(); ++i)
+	{
+		hash_value(hash, LightList[i].state);
+		hash_value(hash, LightList[i].intensity);
+	}
+	for (size_t i= 0; i<MediaList.size(); ++i)
+	{
+		hash_value(hash, MediaList[i].height);
+	}
+}
+
+/* ---------- code */
+
+void reset_world_hash(
+	void)
+{
+	obj_clear(world_hash);
+	for (auto& hash : world_hash.subsystem_hashes) hash= FNV1A_OFFSET_BASIS;
+	world_hash.last_sample.tick_count= NONE;
+}
+
+bool update_world_hash(
+	void)
+{
+	uint32 *hashes= world_hash.subsystem_hashes;
+	hash_random_seed(hashes[_world_hash_random_seed]);
+	hash_players(hashes[_world_hash_players]);
+	hash_monsters(hashes[_world_hash_monsters]);
+	hash_objects(hashes[_world_hash_objects]);
+	hash_projectiles(hashes[_world_hash_projectiles]);
+	hash_effects(hashes[_world_hash_effects]);
+	hash_platforms(hashes[_world_hash_platforms]);
+	hash_lights_and_medias(hashes[_world_hash_lights_and_medias]);
+
+	uint32 combined= FNV1A_OFFSET_BASIS;
+	for (short i= 0; i<NUMBER_OF_WORLD_HASH_SUBSYSTEMS; ++i) hash_value(combined, hashes[i]);
+
+	int32 tick_count= dynamic_world->tick_count;
+	world_hash.sample.tick_hashes[(tick_count+WORLD_HASH_PERIOD-1)%WORLD_HASH_PERIOD]= combined;
+
+	if (tick_count%WORLD_HASH_PERIOD) return false;
+
+	world_hash.sample.level_number= dynamic_world->current_level_number;
+	world_hash.sample.tick_count= tick_count;
+	objlist_copy(world_hash.sample.subsystem_hashes, hashes, NUMBER_OF_WORLD_HASH_SUBSYSTEMS);
+	world_hash.last_sample= world_hash.sample;
+
+	return true;
+}
+
+const world_hash_sample& get_world_hash_sample(
+	void)
+{
+	return world_hash.last_sample;
+}
+
+bool compare_world_hash_samples(
+	const world_hash_sample& ours,
+	const world_hash_sample& theirs,
+	int32& first_divergent_tick,
+	uint32& divergent_subsystems)
+{
+	divergent_subsystems= 0;
+	for (short i= 0; i<NUMBER_OF_WORLD_HASH_SUBSYSTEMS; ++i)
+	{
+		if (ours.subsystem_hashes[i]!=theirs.subsystem_hashes[i]) divergent_subsystems|= 1<<i;
+	}
+	if (!divergent_subsystems) return false;
+
+	first_divergent_tick= ours.tick_count;
+	for (short i= 0; i<WORLD_HASH_PERIOD; ++i)
+	{
+		if (ours.tick_hashes[i]!=theirs.tick_hashes[i])
+		{
+			first_divergent_tick= ours.tick_count-WORLD_HASH_PERIOD+1+i;
+			break;
+		}
+	}
+
+	return true;
+}
+
+std::string describe_world_hash_subsystems(
+	uint32 subsystems)
+{
+	std::string description;
+	for (short i= 0; i<NUMBER_OF_WORLD_HASH_SUBSYSTEMS; ++i)
+	{
+		if (!(subsystems & (1<<i))) continue;
+
+		if (!description.empty()) description+= ", ";
+		description+= subsystem_names[i];
+	}
+
+	return description;
+}
+
+void add_world_hash_snapshot_regions(
+	world_snapshot_regions& regions)
+{
+	regions.push_back({ &world_hash, sizeof(world_hash) });
+}
@@ -0,0 +1,84 @@
+#ifndef __WORLD_HASH_H
+#define __WORLD_HASH_H
+
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  world_hash.h - a running hash of the deterministic world state
+ *
+ *  Every peer in a network game (and every replay of a film) should step
+ *  the world identically, so hashing a few fields of everything that
+ *  moves after each tick, and comparing the hashes, finds a desync when
+ *  it happens instead of minutes later. Each subsystem's hash is chained
+ *  from tick to tick, so comparing once per period also catches
+ *  divergence that happened between samples; the combined hash after
+ *  every tick of the period pins down the first tick that differs.
+ */
+
+#include "cstypes.h"
+#include "map.h"
+
+#include <string>
+
+enum /* subsystems */
+{
+	_world_hash_random_seed,
+	_world_hash_players,
+	_world_hash_monsters,
+	_world_hash_objects,
+	_world_hash_projectiles,
+	_world_hash_effects,
+	_world_hash_platforms,
+	_world_hash_lights_and_medias,
+	NUMBER_OF_WORLD_HASH_SUBSYSTEMS
+};
+
+enum
+{
+	WORLD_HASH_PERIOD= TICKS_PER_SECOND // ticks per sample
+};
+
+struct world_hash_sample
+{
+	int16 level_number;
+	int32 tick_count; // the sample is complete after this tick
+	uint32 tick_hashes[WORLD_HASH_PERIOD]; // combined hash after each tick of the period, oldest first
+	uint32 subsystem_hashes[NUMBER_OF_WORLD_HASH_SUBSYSTEMS];
+};
+
+// when a level is entered; every peer has to start from the same place
+void reset_world_hash(void);
+// after every world tick; true if that completed a sample
+bool update_world_hash(void);
+const world_hash_sample& get_world_hash_sample(void);
+
+// false if the samples agree; otherwise the first tick whose hash differs and a
+// bit for each subsystem that has diverged by the end of the sample
+bool compare_world_hash_samples(const world_hash_sample& ours, const world_hash_sample& theirs,
+	int32& first_divergent_tick, uint32& divergent_subsystems);
+// "monsters, objects"
+std::string describe_world_hash_subsystems(uint32 subsystems);
+
+#endif
@@ -0,0 +1,363 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  world_snapshot.cpp - in-memory copies of the whole game world
+ *
+ *  Every snapshot in the ring shares one layout: the list of regions
+ *  (pointer and size) that make up the world. The layout is collected
+ *  again before every snapshot is taken; if anything was reallocated or
+ *  resized in the meantime (a new level, or a Lua script adding sides), the
+ *  old snapshots no longer describe the world and are dropped.
+ */
+
+#include "cseries.h"
+#include "world_snapshot.h"
+
+#include "map.h"
+#include "monsters.h"
+#include "projectiles.h"
+#include "effects.h"
+#include "platforms.h"
+#include "lightsource.h"
+#include "media.h"
+#include "player.h"
+#include "interpolated_world.h"
+#include "Logging.h"
+
+#include <string.h>
+
+/* ---------- constants */
+
+// written in native order, so state from a machine of the other byte order is refused
+#define WORLD_STATE_BYTE_ORDER_MARK 0x01020304
+
+/* ---------- structures */
+
+struct world_snapshot
+{
+	int32 tick_count;
+	uint16 random_seed;
+	std::vector<uint8> arena;
+};
+
+/* ---------- globals */
+
+static struct world_snapshot_ring
+{
+	std::vector<world_snapshot> snapshots;
+	int oldest;
+	int count;
+
+	world_snapshot_regions layout;
+	size_t arena_size;
+
+	// reused so checking the layout doesn't allocate
+	world_snapshot_regions scratch_layout;
+} snapshot_ring;
+
+/* ---------- private prototypes */
+
+static void collect_world_regions(world_snapshot_regions& regions);
+static bool layout_is_current(void);
+static void resize_snapshot_arenas(void);
+static world_snapshot *get_snapshot(int position);
+
+/* ---------- code */
+
+void allocate_world_snapshots(
+	int count)
+{
+	snapshot_ring.snapshots.clear();
+	snapshot_ring.snapshots.resize(count);
+	snapshot_ring.layout.clear();
+	snapshot_ring.arena_size= 0;
+	snapshot_ring.oldest= snapshot_ring.count= 0;
+}
+
+void reset_world_snapshots(
+	void)
+{
+	if (snapshot_ring.snapshots.empty()) return;
+
+	resize_snapshot_arenas();
+}
+
+bool take_world_snapshot(
+	void)
+{
+	if (snapshot_ring.snapshots.empty()) return false;
+
+	// snapshots hold the real tick, not the positions we are drawing between ticks
+	exit_interpolated_world();
+
+	if (!layout_is_current()) resize_snapshot_arenas();
+
+	int size= static_cast<int>(snapshot_ring.snapshots.size());
+	world_snapshot *snapshot;
+	if (snapshot_ring.count && get_snapshot(snapshot_ring.count-1)->tick_count==dynamic_world->tick_count)
+	{
+		/* nothing has happened since the last one */
+		snapshot= get_snapshot(snapshot_ring.count-1);
+	}
+	else if (snapshot_ring.count<size)
+	{
+		snapshot= get_snapshot(snapshot_ring.count++);
+	}
+	else
+	{
+		snapshot= get_snapshot(0);
+		snapshot_ring.oldest= (snapshot_ring.oldest+1)%size;
+	}
+
+	snapshot->tick_count= dynamic_world->tick_count;
+	snapshot->random_seed= get_random_seed();
+
+	uint8 *p= snapshot->arena.data();
+	for (auto& region : snapshot_ring.layout)
+	{
+		memcpy(p, region.data, region.size);
+		p+= region.size;
+	}
+
+	return true;
+}
+
+bool restore_world_snapshot(
+	int32 tick_count)
+{
+	int position;
+	for (position= snapshot_ring.count-1; position>=0; --position)
+	{
+		if (get_snapshot(position)->tick_count==tick_count) break;
+	}
+	if (position<0) return false;
+
+	exit_interpolated_world();
+
+	if (!layout_is_current())
+	{
+		logWarning("world layout changed since tick %d was saved; dropping world snapshots", tick_count);
+		resize_snapshot_arenas();
+		return false;
+	}
+
+	world_snapshot *snapshot= get_snapshot(position);
+	const uint8 *p= snapshot->arena.data();
+	for (auto& region : snapshot_ring.layout)
+	{
+		memcpy(region.data, p, region.size);
+		p+= region.size;
+	}
+	set_random_seed(snapshot->random_seed);
+
+	snapshot_ring.count= position+1;
+
+	// otherwise we'd draw the restored world moving from where it was before
+	init_interpolated_world();
+
+	return true;
+}
+
+int32 get_oldest_world_snapshot_tick(
+	void)
+{
+	return snapshot_ring.count ? get_snapshot(0)->tick_count : NONE;
+}
+
+int32 get_newest_world_snapshot_tick(
+	void)
+{
+	return snapshot_ring.count ? get_snapshot(snapshot_ring.count-1)->tick_count : NONE;
+}
+
+void save_world_state(
+	std::vector<uint8>& data)
+{
+	exit_interpolated_world();
+
+	world_snapshot_regions& layout= snapshot_ring.scratch_layout;
+	collect_world_regions(layout);
+
+	size_t header_size= sizeof(uint32)*(2+layout.size())+sizeof(uint16);
+	size_t size= header_size;
+	for (auto& region : layout) size+= region.size;
+	data.resize(size);
+
+	uint8 *p= data.data();
+	uint32 value= WORLD_STATE_BYTE_ORDER_MARK;
+	memcpy(p, &value, sizeof(value)); p+= sizeof(value);
+	value= static_cast<uint32>(layout.size());
+	memcpy(p, &value, sizeof(value)); p+= sizeof(value);
+	for (auto& region : layout)
+	{
+		value= static_cast<uint32>(region.size);
+		memcpy(p, &value, sizeof(value)); p+= sizeof(value);
+	}
+	uint16 seed= get_random_seed();
+	memcpy(p, &seed, sizeof(seed)); p+= sizeof(seed);
+
+	for (auto& region : layout)
+	{
+		memcpy(p, region.data, region.size);
+		p+= region.size;
+	}
+}
+
+bool restore_world_state(
+	const uint8 *data,
+	size_t size)
+{
+	world_snapshot_regions& layout= snapshot_ring.scratch_layout;
+	collect_world_regions(layout);
+
+	size_t header_size= sizeof(uint32)*(2+layout.size())+sizeof(uint16);
+	if (size<header_size) return false;
+
+	const uint8 *p= data;
+	uint32 value;
+	memcpy(&value, p, sizeof(value)); p+= sizeof(value);
+	if (value!=WORLD_STATE_BYTE_ORDER_MARK) return false;
+	memcpy(&value, p, sizeof(value)); p+= sizeof(value);
+	if (value!=layout.size()) return false;
+
+	size_t expected_size= header_size;
+	for (auto& region : layout)
+	{
+		memcpy(&value, p, sizeof(value)); p+= sizeof(value);
+		if (value!=region.size) return false;
+		expected_size+= region.size;
+	}
+	if (size!=expected_size) return false;
+
+	uint16 seed;
+	memcpy(&seed, p, sizeof(seed)); p+= sizeof(seed);
+
+	exit_interpolated_world();
+
+	for (auto& region : layout)
+	{
+		memcpy(region.data, p, region.size);
+		p+= region.size;
+	}
+	set_random_seed(seed);
+
+	snapshot_ring.oldest= snapshot_ring.count= 0;
+	init_interpolated_world();
+
+	return true;
+}
+
+/* ---------- private code */
+
+template <typename T>
+static void add_region(
+	world_snapshot_regions& regions,
+	T *data,
+	size_t count)
+{
+	if (data && count) regions.push_back({ data, count*sizeof(T) });
+}
+
+template <typename T>
+static void add_region(
+	world_snapshot_regions& regions,
+	std::vector<T>& list)
+{
+	add_region(regions, list.data(), list.size());
+}
+
+static void collect_world_regions(
+	world_snapshot_regions& regions)
+{
+	regions.clear();
+
+	add_region(regions, dynamic_world, 1);
+	add_region(regions, players, MAXIMUM_NUMBER_OF_PLAYERS);
+
+	add_region(regions, ObjectList);
+	add_region(regions, MonsterList);
+	add_region(regions, ProjectileList);
+	add_region(regions, EffectList);
+	add_region(regions, PlatformList);
+	add_region(regions, LightList);
+	add_region(regions, MediaList);
+
+	/* platforms move floors and ceilings, objects move between polygons and
+		control panels change their sides */
+	add_region(regions, EndpointList);
+	add_region(regions, LineList);
+	add_region(regions, SideList);
+	add_region(regions, PolygonList);
+	add_region(regions, AutomapLineList);
+	add_region(regions, AutomapPolygonList);
+
+	add_region(regions, get_placement_info(), 2*MAXIMUM_OBJECT_TYPES);
+
+	add_ephemera_snapshot_regions(regions);
+	add_path_snapshot_regions(regions);
+	add_player_weapon_snapshot_regions(regions);
+	add_player_terminal_snapshot_regions(regions);
+	add_world_hash_snapshot_regions(regions);
+}
+
+static bool layout_is_current(
+	void)
+{
+	collect_world_regions(snapshot_ring.scratch_layout);
+
+	const world_snapshot_regions& current= snapshot_ring.scratch_layout;
+	const world_snapshot_regions& layout= snapshot_ring.layout;
+	if (current.size()!=layout.size()) return false;
+	for (size_t i= 0; i<current.size(); ++i)
+	{
+		if (current[i].data!=layout[i].data || current[i].size!=layout[i].size) return false;
+	}
+
+	return true;
+}
+
+static void resize_snapshot_arenas(
+	void)
+{
+	collect_world_regions(snapshot_ring.layout);
+
+	snapshot_ring.arena_size= 0;
+	for (auto& region : snapshot_ring.layout) snapshot_ring.arena_size+= region.size;
+
+	for (auto& snapshot : snapshot_ring.snapshots)
+	{
+		snapshot.tick_count= NONE;
+		snapshot.arena.resize(snapshot_ring.arena_size);
+	}
+	snapshot_ring.oldest= snapshot_ring.count= 0;
+}
+
+/* position 0 is the oldest snapshot */
+static world_snapshot *get_snapshot(
+	int position)
+{
+	int size= static_cast<int>(snapshot_ring.snapshots.size());
+	return &snapshot_ring.snapshots[(snapshot_ring.oldest+position)%size];
+}
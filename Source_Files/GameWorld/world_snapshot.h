@@ -0,0 +1,91 @@
+#ifndef __WORLD_SNAPSHOT_H
+#define __WORLD_SNAPSHOT_H
+
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  world_snapshot.h - in-memory copies of the whole game world
+ *
+ *  A ring of the most recent snapshots, each a flat arena holding every
+ *  piece of per-level game state (dynamic_world, players, objects,
+ *  monsters, projectiles, effects, platforms, lights, medias, ephemera,
+ *  paths, map geometry and the random seed). Taking or restoring one is a
+ *  memcpy per container, with no packing and no allocation once the arenas
+ *  are sized, so it can be used for rollback, quick saves and rewinding.
+ *
+ *  Lua state is not part of a snapshot; neither is the network game's
+ *  prediction, so don't take or restore one while predicting.
+ */
+
+#include "cstypes.h"
+
+#include <stddef.h>
+#include <vector>
+
+// how many snapshots to keep; zero (the default) turns snapshots off
+void allocate_world_snapshots(int count);
+// drops all snapshots and sizes the arenas for the current level
+void reset_world_snapshots(void);
+
+// saves the world as of dynamic_world->tick_count, replacing the oldest snapshot
+// if the ring is full; false if snapshots are off
+bool take_world_snapshot(void);
+// puts the world back the way it was at tick_count and drops every newer snapshot;
+// false if there is no snapshot for that tick
+bool restore_world_snapshot(int32 tick_count);
+
+// NONE if there are no snapshots
+int32 get_oldest_world_snapshot_tick(void);
+int32 get_newest_world_snapshot_tick(void);
+
+// the same copy, into storage the caller keeps (films embed these); the
+// region sizes go first, so a copy made by a build with other structure
+// sizes or dynamic limits is refused instead of restored
+void save_world_state(std::vector<uint8>& data);
+// drops the snapshot ring, since the world is no longer where it was
+bool restore_world_state(const uint8 *data, size_t size);
+
+/* ---------- for modules that keep game state in their own storage */
+
+struct world_snapshot_region
+{
+	void *data;
+	size_t size;
+};
+
+typedef std::vector<world_snapshot_region> world_snapshot_regions;
+
+// in ephemera.cpp
+void add_ephemera_snapshot_regions(world_snapshot_regions& regions);
+// in pathfinding.cpp
+void add_path_snapshot_regions(world_snapshot_regions& regions);
+// in weapons.cpp
+void add_player_weapon_snapshot_regions(world_snapshot_regions& regions);
+// in computer_interface.cpp
+void add_player_terminal_snapshot_regions(world_snapshot_regions& regions);
+// in world_hash.cpp
+void add_world_hash_snapshot_regions(world_snapshot_regions& regions);
+
+#endif
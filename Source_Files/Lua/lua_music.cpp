@@ -24,18 +24,28 @@
 
 #include "lua_music.h"
 #include "Music.h"
+#include "WorldUpdateThread.h"
+
+// scripts call these from within the world's ticks, and the music is
+// streamed and mixed on the main thread
+static void run_on_main_thread(const std::function<void()>& fn)
+{
+	WorldUpdateThread::instance()->run_on_main_thread(fn);
+}
 
 static int Lua_MusicManager_Clear(lua_State* L)
 {
-	Music::instance()->ClearLevelMusic();
+	run_on_main_thread([] { Music::instance()->ClearLevelMusic(); });
 	return 0;
 }
 
 static int Lua_MusicManager_Fade(lua_State* L)
 {
 	int duration = lua_isnumber(L, 1) ? static_cast<int>(lua_tonumber(L, 1) * 1000) : 1000;
-	Music::instance()->Fade(0, duration);
-	Music::instance()->ClearLevelMusic();
+	run_on_main_thread([duration] {
+		Music::instance()->Fade(0, duration);
+		Music::instance()->ClearLevelMusic();
+	});
 	return 0;
 }
 
@@ -49,35 +59,39 @@ static int Lua_Music_Fade(lua_State* L)
 	bool stopOnNoVolume = lua_isboolean(L, 4) ? static_cast<bool>(lua_toboolean(L, 4)) : true;
 
 	int index = Lua_Music::Index(L, 1) + Music::reserved_music_slots;
-	Music::instance()->Fade(limitVolume, duration, stopOnNoVolume, index);
+	run_on_main_thread([=] { Music::instance()->Fade(limitVolume, duration, stopOnNoVolume, index); });
 	return 0;
 }
 
 static int Lua_Music_Play(lua_State* L)
 {
 	int index = Lua_Music::Index(L, 1) + Music::reserved_music_slots;
-	Music::instance()->Play(index);
+	run_on_main_thread([index] { Music::instance()->Play(index); });
 	return 0;
 }
 
 static int Lua_Music_Stop(lua_State* L)
 {
 	int index = Lua_Music::Index(L, 1) + Music::reserved_music_slots;
-	Music::instance()->Pause(index);
+	run_on_main_thread([index] { Music::instance()->Pause(index); });
 	return 0;
 }
 
 static int Lua_Music_Active_Get(lua_State* L)
 {
 	int index = Lua_Music::Index(L, 1) + Music::reserved_music_slots;
-	lua_pushboolean(L, Music::instance()->Playing(index));
+	bool playing = false;
+	run_on_main_thread([index, &playing] { playing = Music::instance()->Playing(index); });
+	lua_pushboolean(L, playing);
 	return 1;
 }
 
 static int Lua_Music_Volume_Get(lua_State* L)
 {
 	int index = Lua_Music::Index(L, 1) + Music::reserved_music_slots;
-	lua_pushnumber(L, static_cast<double>(Music::instance()->GetVolume(index)));
+	float volume = 0;
+	run_on_main_thread([index, &volume] { volume = Music::instance()->GetVolume(index); });
+	lua_pushnumber(L, static_cast<double>(volume));
 	return 1;
 }
 
@@ -87,13 +101,17 @@ static int Lua_Music_Volume_Set(lua_State* L)
 		return luaL_error(L, "volume: incorrect argument type");
 
 	int index = Lua_Music::Index(L, 1) + Music::reserved_music_slots;
-	Music::instance()->SetVolume(index, static_cast<float>(lua_tonumber(L, 2)));
+	float volume = static_cast<float>(lua_tonumber(L, 2));
+	run_on_main_thread([index, volume] { Music::instance()->SetVolume(index, volume); });
 	return 0;
 }
 
 static bool Lua_Music_Valid(int16 index)
 {
-	return index >= 0 && Music::instance()->IsInit(index + Music::reserved_music_slots);
+	bool valid = false;
+	if (index >= 0)
+		run_on_main_thread([index, &valid] { valid = Music::instance()->IsInit(index + Music::reserved_music_slots); });
+	return valid;
 }
 
 static int Lua_MusicManager_New(lua_State* L)
@@ -116,7 +134,8 @@ static int Lua_MusicManager_New(lua_State* L)
 		if (!file.SetNameWithPath(lua_tostring(L, 1))) return 0;
 	}
 
-	int id = Music::instance()->Load(file, loop, volume);
+	int id = 0;
+	run_on_main_thread([&] { id = Music::instance()->Load(file, loop, volume); });
 	if (id < Music::reserved_music_slots) return 0;
 
 	Lua_Music::Push(L, id - Music::reserved_music_slots);
@@ -136,12 +155,12 @@ static int Lua_MusicManager_Play(lua_State* L)
 		if (search_path.size())
 		{
 			if (file.SetNameWithPath(lua_tostring(L, n), search_path))
-				Music::instance()->PushBackLevelMusic(file);
+				run_on_main_thread([&file] { Music::instance()->PushBackLevelMusic(file); });
 		}
 		else
 		{
 			if (file.SetNameWithPath(lua_tostring(L, n)))
-				Music::instance()->PushBackLevelMusic(file);
+				run_on_main_thread([&file] { Music::instance()->PushBackLevelMusic(file); });
 		}
 	}
 
@@ -150,8 +169,10 @@ static int Lua_MusicManager_Play(lua_State* L)
 
 static int Lua_MusicManager_Stop(lua_State* L)
 {
-	Music::instance()->ClearLevelMusic();
-	Music::instance()->StopLevelMusic();
+	run_on_main_thread([] {
+		Music::instance()->ClearLevelMusic();
+		Music::instance()->StopLevelMusic();
+	});
 
 	return 0;
 }
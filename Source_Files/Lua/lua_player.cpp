@@ -48,6 +48,7 @@
 #include "shell.h"
 #include "SoundManager.h"
 #include "ViewControl.h"
+#include "WorldUpdateThread.h"
 
 #include <boost/iostreams/device/array.hpp>
 #include <boost/iostreams/stream_buffer.hpp>
@@ -1177,7 +1178,7 @@ static int Lua_Texture_Palette_Set_Selected(lua_State *L)
 			return luaL_error(L, "highlight: invalid slot");
 
 		lua_texture_palette_selected = selected;
-		draw_panels();
+		WorldUpdateThread::instance()->run_on_main_thread(draw_panels);
 	}
 	else
 		return luaL_error(L, "highlight: incorrect argument type");
@@ -1204,7 +1205,7 @@ static int Lua_Texture_Palette_Set_Size(lua_State *L)
 	if (lua_texture_palette_selected >= lua_texture_palette.size())
 		lua_texture_palette_selected = -1;
 
-	draw_panels();
+	WorldUpdateThread::instance()->run_on_main_thread(draw_panels);
 	return 0;
 }
 
@@ -2338,7 +2339,7 @@ static int Lua_Player_Set_Motion_Sensor(lua_State *L)
 		if (MotionSensorActive != state)
 		{
 			MotionSensorActive = lua_toboolean(L, 2);
-			draw_panels();
+			WorldUpdateThread::instance()->run_on_main_thread(draw_panels);
 		}
 	}
 	
@@ -2742,7 +2743,7 @@ int Lua_Game_Random_Local(lua_State *L)
 int Lua_Game_Save(lua_State *L)
 {
 	if (!game_is_networked)
-		save_game();
+		WorldUpdateThread::instance()->run_on_main_thread(save_game);
 	
 	return 0;
 }
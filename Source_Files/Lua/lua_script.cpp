@@ -74,6 +74,7 @@ extern "C"
 #include "Plugins.h"
 #include "shell_options.h"
 #include "interpolated_world.h"
+#include "WorldUpdateThread.h"
 
 #include "lua_script.h"
 #include "lua_music.h"
@@ -1455,7 +1456,7 @@ int L_Hide_Interface(lua_State *L)
 	if(the_mode->hud)
 	{
 		the_mode->hud = false;
-		change_screen_mode(the_mode,true);
+		WorldUpdateThread::instance()->run_on_main_thread([the_mode] { change_screen_mode(the_mode, true); });
 	}
 
 	return 0;
@@ -1504,8 +1505,10 @@ int L_Show_Interface(lua_State *L)
 	if (!the_mode->hud)
 	{
 		the_mode->hud = true;
-		change_screen_mode(the_mode,true);
-		draw_panels();
+		WorldUpdateThread::instance()->run_on_main_thread([the_mode] {
+			change_screen_mode(the_mode, true);
+			draw_panels();
+		});
 	}
 
 	return 0;
@@ -2213,6 +2216,19 @@ void UpdateLuaCameras()
 	}
 }
 
+bool LuaScriptsAffectWorld()
+{
+	for (state_map::iterator it = states.begin(); it != states.end(); ++it)
+	{
+		if (it->first != _stats_lua_script && it->second->Running())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool UseLuaCameras()
 {
 	if (!LuaRunning())
@@ -94,6 +94,9 @@ void ResetLuaMute();
 
 bool UseLuaCameras();
 
+// true if a script other than the stats script could be changing the world
+bool LuaScriptsAffectWorld();
+
 void unpack_lua_states(uint8* data, size_t length);
 size_t save_lua_states();
 void pack_lua_states(uint8* data, size_t length);
@@ -0,0 +1,237 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+#include "TickProfiler.h"
+
+#include "Console.h"
+#include "FileHandler.h"
+#include "Logging.h"
+#include "map.h"
+
+#include <algorithm>
+#include <ctime>
+#include <sstream>
+
+static constexpr int32 kTickBudgetMicroseconds = 1000000 / TICKS_PER_SECOND;
+
+static const char* phase_names[NUMBER_OF_TICK_PHASES] = {
+	"lua_idle",
+	"lights",
+	"medias",
+	"platforms",
+	"players",
+	"projectiles",
+	"monsters",
+	"effects",
+	"recreate_objects",
+	"ephemera",
+	"motion_sensor",
+	"net_game",
+	"lua_postidle",
+	"total"
+};
+
+struct tick_profile_command
+{
+	void operator() (const std::string& arg) const {
+		TickProfiler* profiler = TickProfiler::instance();
+		if (arg == "on")
+		{
+			profiler->enable(true);
+			profiler->show_overlay(true);
+			screen_printf("tick profiler on");
+		}
+		else if (arg == "off")
+		{
+			profiler->enable(false);
+			screen_printf("tick profiler off");
+		}
+		else if (arg == "overlay")
+		{
+			profiler->show_overlay(!profiler->overlay_visible());
+		}
+		else if (arg == "reset")
+		{
+			profiler->reset();
+		}
+		else if (arg == "dump")
+		{
+			std::string path;
+			if (profiler->dump_csv(mac_roman_to_utf8(static_world->level_name), path))
+				screen_printf("Saved %s", utf8_to_mac_roman(path).c_str());
+			else
+				screen_printf("No tick profile to save");
+		}
+		else
+		{
+			screen_printf("tick_profile on|off|overlay|reset|dump");
+		}
+	}
+};
+
+TickProfiler* TickProfiler::instance()
+{
+	static TickProfiler* m_instance = nullptr;
+	if (!m_instance)
+		m_instance = new TickProfiler;
+	return m_instance;
+}
+
+TickProfiler::TickProfiler() : m_enabled(false), m_overlay(false)
+{
+	reset();
+}
+
+void TickProfiler::register_console_command()
+{
+	Console::instance()->register_command("tick_profile", tick_profile_command());
+}
+
+void TickProfiler::enable(bool enabled)
+{
+	if (enabled && !m_enabled)
+		reset();
+	m_enabled = enabled;
+}
+
+void TickProfiler::reset()
+{
+	for (auto& stats : m_stats)
+	{
+		stats.window.fill(0);
+		stats.window_count = 0;
+		stats.window_next = 0;
+		stats.histogram.fill(0);
+		stats.total_us = 0;
+		stats.max_us = 0;
+		stats.samples = 0;
+	}
+	m_ticks_over_budget = 0;
+}
+
+void TickProfiler::record(tick_phase phase, clock::duration elapsed)
+{
+	int32 us = static_cast<int32>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+	PhaseStats& stats = m_stats[phase];
+
+	stats.window[stats.window_next] = us;
+	stats.window_next = (stats.window_next + 1) % kWindowTicks;
+	stats.window_count = std::min(stats.window_count + 1, kWindowTicks);
+
+	int bucket = 0;
+	while (bucket < kHistogramBuckets - 1 && us >= (1 << bucket))
+		++bucket;
+	++stats.histogram[bucket];
+
+	stats.total_us += us;
+	stats.max_us = std::max(stats.max_us, us);
+	++stats.samples;
+
+	if (phase == _tick_phase_total && us > kTickBudgetMicroseconds)
+		++m_ticks_over_budget;
+}
+
+TickProfiler::Summary TickProfiler::window_summary(tick_phase phase) const
+{
+	const PhaseStats& stats = m_stats[phase];
+	Summary summary = { stats.window_count, 0, 0, 0 };
+	if (!stats.window_count)
+		return summary;
+
+	std::array<int32, kWindowTicks> sorted;
+	std::copy(stats.window.begin(), stats.window.begin() + stats.window_count, sorted.begin());
+	std::sort(sorted.begin(), sorted.begin() + stats.window_count);
+
+	int64_t sum = 0;
+	for (int i = 0; i < stats.window_count; ++i)
+		sum += sorted[i];
+
+	summary.mean_ms = sum / 1000.0 / stats.window_count;
+	summary.p99_ms = sorted[(stats.window_count - 1) * 99 / 100] / 1000.0;
+	summary.max_ms = sorted[stats.window_count - 1] / 1000.0;
+	return summary;
+}
+
+const char* TickProfiler::phase_name(tick_phase phase)
+{
+	return phase_names[phase];
+}
+
+bool TickProfiler::dump_csv(const std::string& level_name, std::string& path)
+{
+	if (!m_stats[_tick_phase_total].samples)
+		return false;
+
+	std::ostringstream csv;
+	csv << "# level: " << level_name << "\n";
+	csv << "# ticks over " << kTickBudgetMicroseconds << " us budget: " << m_ticks_over_budget << "\n";
+	csv << "phase,samples,mean_us,max_us";
+	for (int i = 0; i < kHistogramBuckets - 1; ++i)
+		csv << ",lt_" << (1 << i) << "us";
+	csv << ",ge_" << (1 << (kHistogramBuckets - 2)) << "us\n";
+
+	for (int phase = 0; phase < NUMBER_OF_TICK_PHASES; ++phase)
+	{
+		const PhaseStats& stats = m_stats[phase];
+		csv << phase_names[phase] << "," << stats.samples << ","
+			<< (stats.samples ? stats.total_us / stats.samples : 0) << "," << stats.max_us;
+		for (auto count : stats.histogram)
+			csv << "," << count;
+		csv << "\n";
+	}
+
+	time_t t;
+	time(&t);
+	char timestamp[80];
+	strftime(timestamp, sizeof(timestamp), "%Y%m%d%H%M%S", localtime(&t));
+
+	FileSpecifier file;
+	file.SetToLocalDataDir();
+	file += std::string("TickProfile_") + timestamp + ".csv";
+
+	OpenedFile out;
+	if (!file.OpenForWritingText(out))
+		return false;
+
+	std::string data = csv.str();
+	bool success = out.Write(static_cast<int32>(data.size()), &data[0]);
+	out.Close();
+
+	if (success)
+		path = file.GetPath();
+	else
+		logWarning("Couldn't write tick profile %s", file.GetPath());
+	return success;
+}
+
+void TickProfiler::level_finished(const std::string& level_name)
+{
+	if (!m_enabled)
+		return;
+
+	std::string path;
+	if (dump_csv(level_name, path))
+		logNote("Tick profile saved to %s", path.c_str());
+	reset();
+}
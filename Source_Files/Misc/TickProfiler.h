@@ -0,0 +1,150 @@
+#ifndef TICK_PROFILER_H
+#define TICK_PROFILER_H
+
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  TickProfiler.h - wall-clock cost of each phase of a world tick
+ *
+ *  Off by default; ".tick_profile on" in the console starts collecting.
+ *  Each phase keeps the last kWindowTicks samples (for the overlay) and a
+ *  log2 histogram over the whole level, which is written to a CSV file in
+ *  the local data directory when the level is left.
+ */
+
+#include "cseries.h"
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+enum tick_phase {
+	_tick_phase_lua_idle,
+	_tick_phase_lights,
+	_tick_phase_medias,
+	_tick_phase_platforms,
+	_tick_phase_players,
+	_tick_phase_projectiles,
+	_tick_phase_monsters,
+	_tick_phase_effects,
+	_tick_phase_recreate_objects,
+	_tick_phase_ephemera,
+	_tick_phase_motion_sensor,
+	_tick_phase_net_game,
+	_tick_phase_lua_postidle,
+	_tick_phase_total,	// all of update_world_elements_one_tick (lua_postidle runs after it)
+	NUMBER_OF_TICK_PHASES
+};
+
+class TickProfiler
+{
+public:
+	static TickProfiler* instance();
+
+	// adds "tick_profile" to the console; called at startup
+	static void register_console_command();
+
+	typedef std::chrono::steady_clock clock;
+
+	static constexpr int kWindowTicks = 256;
+	// bucket i holds samples under 2^i microseconds; the last one is open-ended
+	static constexpr int kHistogramBuckets = 18;
+
+	bool enabled() const { return m_enabled; }
+	void enable(bool enabled);
+
+	bool overlay_visible() const { return m_enabled && m_overlay; }
+	void show_overlay(bool show) { m_overlay = show; }
+
+	void record(tick_phase phase, clock::duration elapsed);
+
+	struct Summary {
+		int32 samples;
+		double mean_ms;
+		double p99_ms;
+		double max_ms;
+	};
+
+	// statistics over the rolling window, for the overlay
+	Summary window_summary(tick_phase phase) const;
+	int32 ticks_over_budget() const { return m_ticks_over_budget; }
+
+	static const char* phase_name(tick_phase phase);
+
+	// writes the level's histograms to a CSV file (if anything was
+	// collected) and starts over; called when leaving a level
+	void level_finished(const std::string& level_name);
+	bool dump_csv(const std::string& level_name, std::string& path);
+
+	void reset();
+
+private:
+	TickProfiler();
+
+	struct PhaseStats {
+		std::array<int32, kWindowTicks> window;	// microseconds
+		int32 window_count;
+		int32 window_next;
+
+		std::array<int32, kHistogramBuckets> histogram;
+		int64_t total_us;
+		int32 max_us;
+		int32 samples;
+	};
+
+	std::array<PhaseStats, NUMBER_OF_TICK_PHASES> m_stats;
+	int32 m_ticks_over_budget;
+
+	bool m_enabled;
+	bool m_overlay;
+};
+
+// Times one phase for as long as it is in scope; costs one branch when the
+// profiler is off.
+class TickPhaseTimer
+{
+public:
+	TickPhaseTimer(tick_phase phase) : m_phase(phase), m_active(TickProfiler::instance()->enabled()) {
+		if (m_active)
+			m_start = TickProfiler::clock::now();
+	}
+
+	~TickPhaseTimer() { stop(); }
+
+	// records now instead of at the end of the scope
+	void stop() {
+		if (m_active)
+			TickProfiler::instance()->record(m_phase, TickProfiler::clock::now() - m_start);
+		m_active = false;
+	}
+
+private:
+	tick_phase m_phase;
+	bool m_active;
+	TickProfiler::clock::time_point m_start;
+};
+
+#endif
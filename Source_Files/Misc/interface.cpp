@@ -76,6 +76,7 @@ extern TP2PerfGlobals perf_globals;
 #include "Statistics.h"
 #include "shell_options.h"
 #include "OpenALManager.h"
+#include "WorldUpdateThread.h"
 
 #ifdef HAVE_FFMPEG
 #include "SDL_ffmpeg.h"
@@ -99,10 +100,12 @@ enum recording_version {
 	RECORDING_VERSION_ALEPH_ONE_1_2 = 9,
 	RECORDING_VERSION_ALEPH_ONE_1_3 = 10,
 	RECORDING_VERSION_ALEPH_ONE_1_4 = 11,
-	RECORDING_VERSION_ALEPH_ONE_1_7 = 12
+	RECORDING_VERSION_ALEPH_ONE_1_7 = 12,
+	RECORDING_VERSION_ALEPH_BET_1_0 = 13,
+	RECORDING_VERSION_ALEPH_BET_1_0_HIERARCHICAL_PATHFINDING = 14
 };
-const short default_recording_version = RECORDING_VERSION_ALEPH_ONE_1_7;
-const short max_handled_recording= RECORDING_VERSION_ALEPH_ONE_1_7;
+const short default_recording_version = RECORDING_VERSION_ALEPH_BET_1_0;
+const short max_handled_recording= RECORDING_VERSION_ALEPH_BET_1_0_HIERARCHICAL_PATHFINDING;
 
 #include "screen_definitions.h"
 #include "interface_menus.h"
@@ -298,7 +301,7 @@ void initialize_game_state(
 	  alert_user(expand_app_variables("Insecure Lua has been manually enabled. Malicious Lua scripts can use Insecure Lua to take over your computer. Unless you specifically trust every single Lua script that will be running, you should quit $appName$ IMMEDIATELY.").c_str());
 	}
 
-	if (!shell_options.editor && shell_options.replay_directory.empty())
+	if (!shell_options.editor && shell_options.replay_directory.empty() && !shell_options.headless)
 	{
 		if (shell_options.skip_intro)
 		{
@@ -832,6 +835,29 @@ bool handle_open_replay(FileSpecifier& File)
 	return success;
 }
 
+bool run_headless_replay(FileSpecifier& File, int32& ticks, bool (*each_tick)())
+{
+	assert(shell_options.headless);
+	DraggedReplayFile = File;
+	ticks = 0;
+
+	if (!begin_game(_replay_from_file, false))
+		return false;
+
+	while (game_state.state == _game_in_progress && update_world_headless())
+	{
+		++ticks;
+		if (each_tick && !each_tick())
+			break;
+	}
+
+	// the film ran out (or the game ended) mid-level
+	if (game_state.state == _game_in_progress || game_state.state == _switch_demo)
+		finish_game(false);
+
+	return true;
+}
+
 bool handle_edit_map()
 {
 	bool success;
@@ -850,7 +876,8 @@ bool check_level_change(
 
 	if(game_state.state==_change_level)
 	{
-		transfer_to_new_level(game_state.current_screen);
+		// loads the level, with its loading screen and textures
+		WorldUpdateThread::instance()->run_on_main_thread([] { transfer_to_new_level(game_state.current_screen); });
 		level_changed= true;
 	}
 	
@@ -1035,7 +1062,7 @@ bool idle_game_state(uint32 time)
 	{
 		// ZZZ change: update_world() whether or not get_keyboard_controller_status() is true
 		// This way we won't fill up queues and stall netgames if one player switches out for a bit.
-		std::pair<bool, int16> theUpdateResult= update_world();
+		std::pair<bool, int16> theUpdateResult= WorldUpdateThread::instance()->update_world();
 		short ticks_elapsed= theUpdateResult.second;
 		bool redraw = false;
 
@@ -1792,6 +1819,22 @@ static void transfer_to_new_level(
 	}
 #endif // !defined(DISABLE_NETWORKING)
 
+	if(success && shell_options.headless)
+	{
+		// alephbet-replay: no movies, chapter screens or fades between levels
+		if (level_number == (shapes_file_is_m1() ? 100 : EPILOGUE_LEVEL_NUMBER)) {
+			finish_game(false);
+			return;
+		}
+
+		if (goto_level(&entry, false, dynamic_world->player_count)) {
+			start_game(game_state.user, true);
+		} else {
+			finish_game(false);
+		}
+		return;
+	}
+
 	if(success)
 	{
 		stop_fade();
@@ -2015,8 +2058,14 @@ static bool begin_game(
 						load_film_profile(FILM_PROFILE_ALEPH_ONE_1_4);
 						break;
 					case RECORDING_VERSION_ALEPH_ONE_1_7:
+						load_film_profile(FILM_PROFILE_ALEPH_ONE_1_7);
+						break;
+					case RECORDING_VERSION_ALEPH_BET_1_0:
 						load_film_profile(FILM_PROFILE_DEFAULT);
 						break;
+					case RECORDING_VERSION_ALEPH_BET_1_0_HIERARCHICAL_PATHFINDING:
+						load_film_profile(FILM_PROFILE_ALEPH_BET_1_0_HIERARCHICAL_PATHFINDING);
+						break;
 					default:
 						load_film_profile(environment_preferences->film_profile);
 						break;
@@ -2066,7 +2115,15 @@ static bool begin_game(
 			switch (player_preferences->solo_profile)
 			{
 				case _solo_profile_aleph_one:
-					load_film_profile(FILM_PROFILE_DEFAULT);
+					if (player_preferences->hierarchical_pathfinding)
+					{
+						load_film_profile(FILM_PROFILE_ALEPH_BET_1_0_HIERARCHICAL_PATHFINDING);
+						record_game_version = RECORDING_VERSION_ALEPH_BET_1_0_HIERARCHICAL_PATHFINDING;
+					}
+					else
+					{
+						load_film_profile(FILM_PROFILE_DEFAULT);
+					}
 					break;
 				case _solo_profile_marathon_2:
 					load_film_profile(FILM_PROFILE_MARATHON_2);
@@ -2107,13 +2164,13 @@ static bool begin_game(
 	{
 		hide_cursor();
 		/* This has already been done to get to gather/join */
-		if(can_interface_fade_out()) 
+		if(can_interface_fade_out() && !shell_options.headless) 
 		{
 			interface_fade_out(MAIN_MENU_BASE, true);
 		}
 
 		/* Try to display the first chapter screen.. */
-		if (user != _network_player && user != _demo)
+		if (user != _network_player && user != _demo && !shell_options.headless)
 		{
 			FindLevelMovie(entry.level_number);
 			show_movie(entry.level_number);
@@ -2122,8 +2179,11 @@ static bool begin_game(
 
 		Plugins::instance()->set_mode(number_of_players > 1 ? Plugins::kMode_Net : Plugins::kMode_Solo);
 		Crosshairs_SetActive(player_preferences->crosshairs_active);
-		LoadHUDLua();
-		RunLuaHUDScript();
+		if (!shell_options.headless)
+		{
+			LoadHUDLua();
+			RunLuaHUDScript();
+		}
 		
 		/* Begin the game! */
 		success= new_game(number_of_players, is_networked, &game_information, starts, &entry);
@@ -2148,27 +2208,35 @@ static void start_game(
 	short user,
 	bool changing_level)
 {
-	/* Change our menus.. */
-	toggle_menus(true);
-	
-	// LP change: reset screen so that extravision will not be persistent
-	reset_screen();
-	
-	enter_screen();
-	if (!changing_level)
-		L_Call_HUDInit();
-	
-	// LP: this is in case we are starting underneath a liquid
-	if (!OGL_IsActive() || !(TEST_FLAG(Get_OGL_ConfigureData().Flags,OGL_Flag_Fader)))
+	if (!shell_options.headless)
 	{
-		set_fade_effect(NONE);
-		SetFadeEffectDelay(TICKS_PER_SECOND/2);
-	}
+		/* Change our menus.. */
+		toggle_menus(true);
 
-	// Screen should already be black! 
-	validate_world_window();
-	
-	draw_interface();
+		// LP change: reset screen so that extravision will not be persistent
+		reset_screen();
+
+		enter_screen();
+		if (!changing_level)
+			L_Call_HUDInit();
+
+		// LP: this is in case we are starting underneath a liquid
+		if (!OGL_IsActive() || !(TEST_FLAG(Get_OGL_ConfigureData().Flags,OGL_Flag_Fader)))
+		{
+			set_fade_effect(NONE);
+			SetFadeEffectDelay(TICKS_PER_SECOND/2);
+		}
+
+		// Screen should already be black! 
+		validate_world_window();
+
+		draw_interface();
+	}
+	else if (shell_options.offscreen)
+	{
+		reset_screen();
+		enter_screen();
+	}
 
 #ifdef PERFORMANCE	
 	PerfControl(perf_globals, true);
@@ -2184,6 +2252,10 @@ static void start_game(
 	game_state.user= user;
 	game_state.flags= 0;
 
+	// the headless runner feeds the world itself; the input task must stay off
+	if (shell_options.headless)
+		return;
+
 	assert((!changing_level&&!get_keyboard_controller_status()) || (changing_level && get_keyboard_controller_status()));
 	if(!changing_level)
 	{
@@ -2230,12 +2302,19 @@ static void finish_game(
 	/* Note that we have to deal with the switch demo state later because */
 	/* Alain's code calls us at interrupt level 1. (so we defer it) */
 	assert(game_state.state==_game_in_progress || game_state.state==_switch_demo || game_state.state==_revert_game || game_state.state==_change_level || game_state.state==_begin_display_of_epilogue);
-	toggle_menus(false);
+	if (!shell_options.headless)
+	{
+		toggle_menus(false);
 
-	stop_fade();
-	set_fade_effect(NONE);
-	L_Call_HUDCleanup();
-	exit_screen();
+		stop_fade();
+		set_fade_effect(NONE);
+		L_Call_HUDCleanup();
+		exit_screen();
+	}
+	else if (shell_options.offscreen)
+	{
+		exit_screen();
+	}
 
 	/* Stop the replay */
 	switch(game_state.user)
@@ -2270,14 +2349,17 @@ static void finish_game(
 		}
 	}
 
-	/* Fade out! (Pray) */ // should be interface_color_table for valkyrie, but doesn't work.
-	Music::instance()->ClearLevelMusic();
-	Music::instance()->Fade(0, MACHINE_TICKS_PER_SECOND / 2);
-	full_fade(_cinematic_fade_out, interface_color_table);
-	paint_window_black();
-	full_fade(_end_cinematic_fade_out, interface_color_table);
+	if (!shell_options.headless)
+	{
+		/* Fade out! (Pray) */ // should be interface_color_table for valkyrie, but doesn't work.
+		Music::instance()->ClearLevelMusic();
+		Music::instance()->Fade(0, MACHINE_TICKS_PER_SECOND / 2);
+		full_fade(_cinematic_fade_out, interface_color_table);
+		paint_window_black();
+		full_fade(_end_cinematic_fade_out, interface_color_table);
 
-	show_cursor();
+		show_cursor();
+	}
 
 	leaving_map();
 	CloseLuaHUDScript();
@@ -2304,7 +2386,12 @@ static void finish_game(
 
 	if (game_state.user == _replay)
 	{
-		if (!shell_options.replay_directory.empty())
+		if (shell_options.headless)
+		{
+			game_state.state = _display_main_menu;
+			return_to_main_menu = false;
+		}
+		else if (!shell_options.replay_directory.empty())
 		{
 			game_state.state = _quit_game;
 			return_to_main_menu = false;
@@ -2358,7 +2445,10 @@ static void clean_up_after_failed_game(bool inNetgame, bool inRecording, bool in
                 }
 
                 /* Display the main menu on failure.... */
-                display_main_menu();
+                if (shell_options.headless)
+                        stop_replay(); // alephbet-replay moves on to the next film
+                else
+                        display_main_menu();
         }
         set_game_error(systemError, errNone);
 }
@@ -250,6 +250,11 @@ void paint_window_black(void);
 void set_game_focus_lost();
 void set_game_focus_gained();
 
+// alephbet-replay: plays a film to its end without a window, timer task or
+// frame pacing; ticks receives the number of world ticks stepped. each_tick,
+// if given, runs after every tick and stops the film early by returning false
+bool run_headless_replay(FileSpecifier& File, int32& ticks, bool (*each_tick)() = nullptr);
+
 /* ---------- prototypes/INTERFACE_MACINTOSH.C */
 void do_preferences(void);
 short get_level_number_from_user(void);
@@ -350,6 +355,12 @@ void stop_recording(void);
 void stop_replay(void);
 void move_replay(void);
 void check_recording_replaying(void);
+bool pull_replay_flags_for_one_tick(void);
+void film_tick_finished(bool world_hash_sampled);
+int32 get_replay_film_tick(void);
+// true if the replay's world hash stopped matching the one recorded in the film
+bool get_replay_world_hash_desync(int32& film_tick, uint32& subsystems);
+bool seek_replay(int32 film_tick);
 bool has_recording_file(void);
 void increment_replay_speed(void);
 void decrement_replay_speed(void);
@@ -169,6 +169,7 @@ OpenGLDialog::~OpenGLDialog()
 	delete m_anisotropicWidget;
 	delete m_sRGBWidget;
 	delete m_useNPOTWidget;
+	delete m_textureArraysWidget;
 	delete m_vsyncWidget;
 	delete m_wallsFilterWidget;
 	delete m_spritesFilterWidget;
@@ -215,6 +216,9 @@ void OpenGLDialog::OpenGLPrefsByRunning ()
 	
 	BoolPref useNPOTPref (graphics_preferences->OGL_Configure.Use_NPOT);
 	binders.insert<bool> (m_useNPOTWidget, &useNPOTPref);
+
+	BitPref textureArraysPref (graphics_preferences->OGL_Configure.Flags, OGL_Flag_TextureArrays);
+	binders.insert<bool> (m_textureArraysWidget, &textureArraysPref);
 	
 	BoolPref vsyncPref (graphics_preferences->OGL_Configure.WaitForVSync);
 	binders.insert<bool> (m_vsyncWidget, &vsyncPref);
@@ -429,6 +433,12 @@ public:
 		advanced_table->dual_add_row(new w_static_text("Non-power-of-two textures conserve memory,"), m_dialog);
 		advanced_table->dual_add_row(new w_static_text("but cause problems on some machines."), m_dialog);
 
+		w_toggle *texture_arrays_w = new w_toggle(false);
+		advanced_table->dual_add(texture_arrays_w->label("Wall Texture Arrays"), m_dialog);
+		advanced_table->dual_add(texture_arrays_w, m_dialog);
+		advanced_table->dual_add_row(new w_static_text("Texture arrays let walls be drawn in fewer calls,"), m_dialog);
+		advanced_table->dual_add_row(new w_static_text("but need a driver with texture array support."), m_dialog);
+
 		advanced_table->add_row(new w_spacer(), true);
 		advanced_table->dual_add_row(new w_static_text("Texture Filtering"), m_dialog);
 		advanced_placer->add(advanced_table, true);
@@ -534,6 +544,7 @@ public:
 		m_sRGBWidget = new ToggleWidget(srgb_w);
 
 		m_useNPOTWidget = new ToggleWidget (use_npot_w);
+		m_textureArraysWidget = new ToggleWidget (texture_arrays_w);
 		m_vsyncWidget = new ToggleWidget (vsync_w);
 		
 		m_wallsFilterWidget = new SelectSelectorWidget (far_filter_wa[OGL_Txtr_Wall]);
@@ -70,6 +70,7 @@ protected:
 	SelectorWidget* m_modelQualityWidget;
 	
 	ToggleWidget*		m_useNPOTWidget;
+	ToggleWidget*		m_textureArraysWidget;
 	ToggleWidget* m_vsyncWidget;
 	SelectSelectorWidget*		m_wallsFilterWidget;
 	SelectSelectorWidget*		m_spritesFilterWidget;
@@ -495,6 +495,13 @@ static void player_dialog(void *arg)
 
 		table->dual_add_row(new w_static_text("Note: net games always use Aleph One fixes"), d);
 	}
+
+	table->add_row(new w_spacer(), true);
+
+	w_toggle *hierarchical_pathfinding_w = new w_toggle(player_preferences->hierarchical_pathfinding);
+	table->dual_add(hierarchical_pathfinding_w->label("Clustered Monster Pathfinding"), d);
+	table->dual_add(hierarchical_pathfinding_w, d);
+	table->dual_add_row(new w_static_text("Solo Aleph One gameplay only; monsters may take different routes"), d);
 	
 	table->add_row(new w_spacer(), true);
 
@@ -575,6 +582,13 @@ static void player_dialog(void *arg)
 			}
 		}
 
+		bool hierarchical_pathfinding = hierarchical_pathfinding_w->get_selection() != 0;
+		if (hierarchical_pathfinding != player_preferences->hierarchical_pathfinding)
+		{
+			player_preferences->hierarchical_pathfinding = hierarchical_pathfinding;
+			changed = true;
+		}
+
 		int16 color = static_cast<int16>(pcolor_w->get_selection());
 		assert(color >= 0);
 		if (color != player_preferences->color) {
@@ -1095,6 +1109,10 @@ static void software_rendering_options_dialog(void* arg)
 	table->dual_add(sw_alpha_blending_w->label("Transparent Liquids"), d);
 	table->dual_add(sw_alpha_blending_w, d);
 
+	w_toggle *sw_threads_w = new w_toggle(graphics_preferences->software_rendering_threads != 1);
+	table->dual_add(sw_threads_w->label("Multithreaded Rendering"), d);
+	table->dual_add(sw_threads_w, d);
+
 	w_select* ephemera_quality_w = new w_select(graphics_preferences->ephemera_quality, ephemera_quality_labels);
 	table->dual_add(ephemera_quality_w->label("Scripted Effects Quality"), d);
 	table->dual_add(ephemera_quality_w, d);
@@ -1142,6 +1160,13 @@ static void software_rendering_options_dialog(void* arg)
 			changed = true;
 		}
 
+		bool sw_threads = sw_threads_w->get_selection() != 0;
+		if (sw_threads != (graphics_preferences->software_rendering_threads != 1))
+		{
+			graphics_preferences->software_rendering_threads = sw_threads ? 0 : 1;
+			changed = true;
+		}
+
 		if (sw_driver_w->get_selection() != graphics_preferences->software_sdl_driver)
 		{
 			graphics_preferences->software_sdl_driver = sw_driver_w->get_selection();
@@ -3550,6 +3575,7 @@ InfoTree graphics_preferences_tree()
 	root.put_attr("ogl_flags", graphics_preferences->OGL_Configure.Flags);
 	root.put_attr("software_alpha_blending", graphics_preferences->software_alpha_blending);
 	root.put_attr("software_sdl_driver", graphics_preferences->software_sdl_driver);
+	root.put_attr("software_rendering_threads", graphics_preferences->software_rendering_threads);
 	root.put_attr("fps_target", graphics_preferences->fps_target);
 	root.put_attr("anisotropy_level", graphics_preferences->OGL_Configure.AnisotropyLevel);
 	root.put_attr("multisamples", graphics_preferences->OGL_Configure.Multisamples);
@@ -3615,6 +3641,7 @@ InfoTree player_preferences_tree()
 	root.put_child("crosshairs", cross);
 
 	root.put_attr("solo_profile", player_preferences->solo_profile);
+	root.put_attr("hierarchical_pathfinding", player_preferences->hierarchical_pathfinding);
 
 	return root;
 }
@@ -4061,6 +4088,7 @@ static void default_graphics_preferences(graphics_preferences_data *preferences)
 
 	preferences->software_alpha_blending = _sw_alpha_off;
 	preferences->software_sdl_driver = _sw_driver_default;
+	preferences->software_rendering_threads = 0;
 	preferences->fps_target = 30;
 
 	preferences->movie_export_video_quality = 50;
@@ -4137,6 +4165,7 @@ static void default_player_preferences(player_preferences_data *preferences)
 	preferences->Crosshairs.PreCalced = false;
 
 	preferences->solo_profile = _solo_profile_aleph_one;
+	preferences->hierarchical_pathfinding = false;
 }
 
 static void default_input_preferences(input_preferences_data *preferences)
@@ -4535,6 +4564,7 @@ void parse_graphics_preferences(InfoTree root, std::string version)
 	root.read_attr("ogl_flags", graphics_preferences->OGL_Configure.Flags);
 	root.read_attr("software_alpha_blending", graphics_preferences->software_alpha_blending);
 	root.read_attr("software_sdl_driver", graphics_preferences->software_sdl_driver);
+	root.read_attr("software_rendering_threads", graphics_preferences->software_rendering_threads);
 	root.read_attr("fps_target", graphics_preferences->fps_target);
 	root.read_attr("anisotropy_level", graphics_preferences->OGL_Configure.AnisotropyLevel);
 	root.read_attr("multisamples", graphics_preferences->OGL_Configure.Multisamples);
@@ -4616,6 +4646,8 @@ void parse_player_preferences(InfoTree root, std::string version)
 	{
 		root.read_attr("solo_profile", player_preferences->solo_profile);
 	}
+
+	root.read_attr("hierarchical_pathfinding", player_preferences->hierarchical_pathfinding);
 }
 
 SDL_Scancode translate_old_key(int code)
@@ -67,6 +67,7 @@ struct graphics_preferences_data
 
 	int16 software_alpha_blending;
 	int16 software_sdl_driver;
+	int16 software_rendering_threads; // 0 = one per core; 1 = draw on the main thread only
 	int16 fps_target; // should be a multiple of 30; 0 = unlimited
 
 	int16 movie_export_video_quality;
@@ -142,6 +143,7 @@ struct player_preferences_data
 	struct CrosshairData Crosshairs;
 
 	int solo_profile;
+	bool hierarchical_pathfinding; // solo games only; recorded in the film's version
 };
 
 // LP addition: input-modifier flags
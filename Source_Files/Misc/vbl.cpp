@@ -46,6 +46,14 @@
 #include "joystick.h"
 #include "Movie.h"
 #include "InfoTree.h"
+#include "world_snapshot.h"
+#include "world_hash.h"
+#include "interpolated_world.h"
+#include "lua_script.h"
+#include "SoundManager.h"
+
+#include <vector>
+#include <zlib.h>
 
 /* ---------- constants */
 
@@ -57,6 +65,19 @@
 #define MAXIMUM_REPLAY_SPEED         5
 #define MINIMUM_REPLAY_SPEED        -5
 
+// Keyframes are whole-world snapshots stored after the end of the flag
+// stream (which header.length bounds, so older builds never see them),
+// followed by an index and a trailer pointing at it. Version 2 adds the
+// world hash samples taken while recording, so a replay can tell where it
+// stopped matching.
+#define FILM_KEYFRAME_INTERVAL      (30*TICKS_PER_SECOND)
+#define FILM_KEYFRAME_INDEX_TAG     FOUR_CHARS_TO_INT('k','f','i','x')
+#define FILM_KEYFRAME_TRAILER_TAG   FOUR_CHARS_TO_INT('k','f','r','m')
+#define FILM_KEYFRAME_VERSION       2
+#define SIZEOF_film_keyframe_entry  26
+#define SIZEOF_film_keyframe_trailer 8
+#define SIZEOF_film_world_hash_entry (4 + 2 + 4 + 1 + 4*WORLD_HASH_PERIOD + 1 + 4*NUMBER_OF_WORLD_HASH_SUBSYSTEMS)
+
 /* ---------- macros */
 
 #define INCREMENT_QUEUE_COUNTER(c) { (c)++; if ((c)>=MAXIMUM_QUEUE_SIZE) (c) = 0; }
@@ -79,6 +100,40 @@ static OpenedFile FilmFile;
 
 struct replay_private_data replay;
 
+struct film_keyframe
+{
+	int32 film_tick; // ticks since the film started
+	int32 flag_position; // flags per player the world had used up by then
+	int16 level_number;
+
+	int32 chunk_offset; // file offset of the chunk holding flag_position
+	int32 data_offset;
+	int32 data_size;
+	int32 state_size; // uncompressed
+
+	std::vector<uint8> data; // compressed world state, while recording
+};
+
+struct film_world_hash
+{
+	int32 film_tick;
+	world_hash_sample sample;
+};
+
+static struct film_keyframe_data
+{
+	int32 film_tick;
+	int32 recorded_flags; // for player 0, who always exists
+
+	std::vector<int32> chunk_offsets; // where each round of chunks was written
+	std::vector<film_keyframe> keyframes;
+	std::vector<film_world_hash> world_hashes; // in film_tick order
+
+	bool world_hash_desync;
+	int32 world_hash_desync_tick;
+	uint32 world_hash_desync_subsystems;
+} film_keyframes;
+
 #ifdef DEBUG
 ActionQueue *get_player_recording_queue(
 	short player_index)
@@ -90,6 +145,8 @@ ActionQueue *get_player_recording_queue(
 }
 #endif
 
+extern ModifiableActionQueues *GetGameQueue();
+
 /* ---------- private prototypes */
 static void remove_input_controller(void);
 static void save_recording_queue_chunk(short player_index);
@@ -103,6 +160,13 @@ static short get_recording_queue_size(short which_queue);
 static uint8 *unpack_recording_header(uint8 *Stream, recording_header *Objects, size_t Count);
 static uint8 *pack_recording_header(uint8 *Stream, recording_header *Objects, size_t Count);
 
+static void reset_film_keyframes(void);
+static void record_film_keyframe(void);
+static void write_film_keyframes(void);
+static void read_film_keyframe_index(void);
+static bool restore_film_keyframe(const film_keyframe& keyframe);
+static void check_film_world_hash(void);
+
 // #define DEBUG_REPLAY
 
 #ifdef DEBUG_REPLAY
@@ -112,6 +176,27 @@ static void close_stream_file(void);
 #endif
 
 /* ---------- code */
+
+// seek [minutes:]seconds, while watching a film
+struct seek_command
+{
+	void operator() (const std::string& arg) const {
+		int minutes = 0, seconds = 0;
+		if (sscanf(arg.c_str(), "%d:%d", &minutes, &seconds) != 2)
+		{
+			minutes = 0;
+			if (sscanf(arg.c_str(), "%d", &seconds) != 1)
+			{
+				screen_printf("seek [minutes:]seconds");
+				return;
+			}
+		}
+
+		if (!seek_replay((minutes * 60 + seconds) * TICKS_PER_SECOND))
+			screen_printf("Couldn't seek there");
+	}
+};
+
 void initialize_keyboard_controller(
 	void)
 {
@@ -142,6 +227,8 @@ void initialize_keyboard_controller(
 		queue->buffer= new uint32[MAXIMUM_QUEUE_SIZE];
 	}
 	enter_mouse(0);
+
+	Console::instance()->register_command("seek", seek_command());
 }
 
 void set_keyboard_controller_status(
@@ -307,6 +394,7 @@ static void record_action_flags(
 	
 	queue= get_player_recording_queue(player_identifier);
 	assert(queue && queue->write_index >= 0 && queue->write_index < MAXIMUM_QUEUE_SIZE);
+	if (player_identifier == 0) film_keyframes.recorded_flags+= count;
 	for (index= 0; index<count; index++)
 	{
 		*(queue->buffer + queue->write_index) = *action_flags++;
@@ -428,6 +516,20 @@ static short pull_flags_from_recording(
 	return true_count;
 }
 
+/* The headless replay runner has no input task; it asks for one tick at a time */
+bool pull_replay_flags_for_one_tick(
+	void)
+{
+	assert(replay.game_is_being_replayed);
+
+	check_recording_replaying();
+	if (!pull_flags_from_recording(1))
+		return false;
+
+	heartbeat_count++;
+	return true;
+}
+
 static short get_recording_queue_size(
 	short which_queue)
 {
@@ -505,6 +607,9 @@ bool setup_for_replay_from_file(
 		FilmFile.Read(SIZEOF_recording_header,Header);
 		unpack_recording_header(Header,&replay.header,1);
 		replay.header.game_information.cheat_flags = _allow_crosshair | _allow_tunnel_vision | _allow_behindview | _allow_overlay_map;
+
+		reset_film_keyframes();
+		read_film_keyframe_index();
 	
 		/* Set to the mapfile this replay came from.. */
 		if(use_map_file(replay.header.map_checksum))
@@ -548,6 +653,7 @@ void start_recording(
 		if (FilmFileSpec.Open(FilmFile,true))
 		{
 			replay.game_is_being_recorded= true;
+			reset_film_keyframes();
 	
 			// save a header containing information about the game.
 			byte Header[SIZEOF_recording_header];
@@ -568,6 +674,7 @@ void stop_recording(
 		int32 total_length;
 
 		assert(replay.valid);
+		film_keyframes.chunk_offsets.push_back(replay.header.length);
 		for (player_index= 0; player_index<dynamic_world->player_count; player_index++)
 		{
 			save_recording_queue_chunk(player_index);
@@ -586,6 +693,8 @@ void stop_recording(
 		
 		FilmFile.GetLength(total_length);
 		assert(total_length==replay.header.length);
+
+		write_film_keyframes();
 		
 		FilmFile.Close();
 	}
@@ -616,6 +725,7 @@ void rewind_recording(
 		
 		// Use the packed length here!!!
 		replay.header.length= SIZEOF_recording_header;
+		reset_film_keyframes();
 	}
 }
 
@@ -646,6 +756,7 @@ void check_recording_replaying(
 			success= FilmFile_Check.GetFreeSpace(freespace);
 			if (success && freespace>(RECORD_CHUNK_SIZE*sizeof(int16)*sizeof(uint32)*dynamic_world->player_count))
 			{
+				film_keyframes.chunk_offsets.push_back(replay.header.length);
 				for (player_index= 0; player_index<dynamic_world->player_count; player_index++)
 				{
 					save_recording_queue_chunk(player_index);
@@ -712,6 +823,366 @@ void stop_replay(
 	replay.valid= false;
 }
 
+/*********************************************************************************************
+ *
+ * Function: film_tick_finished
+ * Purpose:  counts world ticks of the film being recorded or replayed, and takes a keyframe
+ *           every FILM_KEYFRAME_INTERVAL of them while recording. World hash samples are
+ *           kept while recording and checked while replaying.
+ *
+ *********************************************************************************************/
+void film_tick_finished(
+	bool world_hash_sampled)
+{
+	if (!replay.game_is_being_recorded && !replay.game_is_being_replayed) return;
+
+	++film_keyframes.film_tick;
+	if (replay.game_is_being_recorded && film_keyframes.film_tick % FILM_KEYFRAME_INTERVAL == 0)
+	{
+		record_film_keyframe();
+	}
+
+	if (world_hash_sampled)
+	{
+		if (replay.game_is_being_recorded)
+		{
+			film_keyframes.world_hashes.push_back({ film_keyframes.film_tick, get_world_hash_sample() });
+		}
+		else
+		{
+			check_film_world_hash();
+		}
+	}
+}
+
+bool get_replay_world_hash_desync(
+	int32& film_tick,
+	uint32& subsystems)
+{
+	if (!film_keyframes.world_hash_desync) return false;
+
+	film_tick= film_keyframes.world_hash_desync_tick;
+	subsystems= film_keyframes.world_hash_desync_subsystems;
+	return true;
+}
+
+int32 get_replay_film_tick(
+	void)
+{
+	return film_keyframes.film_tick;
+}
+
+/*********************************************************************************************
+ *
+ * Function: seek_replay
+ * Purpose:  moves the replay to film_tick, by restoring the closest keyframe before it (if
+ *           that beats just playing on) and simulating the ticks in between.
+ * Returns:  false if the replay couldn't get there; seeking backwards needs a keyframe from
+ *           the level being played.
+ *
+ *********************************************************************************************/
+bool seek_replay(
+	int32 film_tick)
+{
+	if (!replay.game_is_being_replayed || replay.resource_data) return false;
+
+	const film_keyframe *best= NULL;
+	for (auto& keyframe : film_keyframes.keyframes)
+	{
+		if (keyframe.level_number == dynamic_world->current_level_number &&
+			keyframe.film_tick <= film_tick &&
+			(!best || keyframe.film_tick > best->film_tick))
+		{
+			best= &keyframe;
+		}
+	}
+
+	// no point going back to a keyframe we have already passed on the way there
+	if (best && film_tick >= film_keyframes.film_tick && best->film_tick <= film_keyframes.film_tick)
+	{
+		best= NULL;
+	}
+
+	if (best && !restore_film_keyframe(*best))
+	{
+		logWarning("couldn't restore the film keyframe at tick %d", best->film_tick);
+		best= NULL;
+	}
+	if (!best && film_tick < film_keyframes.film_tick) return false;
+
+	while (film_keyframes.film_tick < film_tick)
+	{
+		if (!update_world_headless()) break;
+	}
+
+	sync_heartbeat_count();
+	init_interpolated_world();
+	// everything the skipped ticks started playing at once
+	SoundManager::instance()->StopAllSounds();
+
+	return film_keyframes.film_tick == film_tick;
+}
+
+static void reset_film_keyframes(
+	void)
+{
+	film_keyframes.film_tick= 0;
+	film_keyframes.recorded_flags= 0;
+	film_keyframes.chunk_offsets.clear();
+	film_keyframes.keyframes.clear();
+	film_keyframes.world_hashes.clear();
+	film_keyframes.world_hash_desync= false;
+}
+
+static void check_film_world_hash(
+	void)
+{
+	if (film_keyframes.world_hash_desync) return;
+
+	auto recorded= std::lower_bound(film_keyframes.world_hashes.begin(), film_keyframes.world_hashes.end(), film_keyframes.film_tick,
+		[](const film_world_hash& hash, int32 film_tick) { return hash.film_tick < film_tick; });
+	if (recorded == film_keyframes.world_hashes.end() || recorded->film_tick != film_keyframes.film_tick) return;
+
+	const world_hash_sample& sample= get_world_hash_sample();
+	int32 tick;
+	uint32 subsystems;
+	if (compare_world_hash_samples(sample, recorded->sample, tick, subsystems))
+	{
+		film_keyframes.world_hash_desync= true;
+		film_keyframes.world_hash_desync_tick= film_keyframes.film_tick - (sample.tick_count - tick);
+		film_keyframes.world_hash_desync_subsystems= subsystems;
+
+		logError("replay diverged from the recording at film tick %d (%s)", film_keyframes.world_hash_desync_tick,
+				 describe_world_hash_subsystems(subsystems).c_str());
+		screen_printf("Replay out of sync from tick %d", film_keyframes.world_hash_desync_tick);
+	}
+}
+
+static void record_film_keyframe(
+	void)
+{
+	// Lua state is not part of a snapshot, so a keyframe couldn't be trusted
+	if (LuaScriptsAffectWorld()) return;
+
+	film_keyframe keyframe;
+	keyframe.film_tick= film_keyframes.film_tick;
+	// flags still queued up have been recorded, but not used yet
+	keyframe.flag_position= film_keyframes.recorded_flags -
+		GetRealActionQueues()->countActionFlags(0) - GetGameQueue()->countActionFlags(0);
+	keyframe.level_number= dynamic_world->current_level_number;
+	keyframe.chunk_offset= keyframe.data_offset= NONE;
+
+	static std::vector<uint8> state;
+	save_world_state(state);
+
+	uLongf size= compressBound(state.size());
+	keyframe.data.resize(size);
+	if (compress2(keyframe.data.data(), &size, state.data(), state.size(), Z_BEST_SPEED) != Z_OK)
+	{
+		logWarning("couldn't compress the film keyframe at tick %d", keyframe.film_tick);
+		return;
+	}
+	keyframe.data.resize(size);
+	keyframe.data_size= static_cast<int32>(size);
+	keyframe.state_size= static_cast<int32>(state.size());
+
+	film_keyframes.keyframes.push_back(std::move(keyframe));
+}
+
+static void write_film_keyframes(
+	void)
+{
+	std::vector<film_keyframe*> written;
+	int32 offset= replay.header.length;
+
+	FilmFile.SetPosition(offset);
+	for (auto& keyframe : film_keyframes.keyframes)
+	{
+		// the chunk holding the keyframe's next flag has to be in the film
+		size_t chunk= keyframe.flag_position / RECORD_CHUNK_SIZE;
+		if (keyframe.flag_position < 0 || chunk >= film_keyframes.chunk_offsets.size()) continue;
+
+		keyframe.chunk_offset= film_keyframes.chunk_offsets[chunk];
+		keyframe.data_offset= offset;
+		if (!FilmFile.Write(keyframe.data_size, keyframe.data.data())) return;
+		offset+= keyframe.data_size;
+		written.push_back(&keyframe);
+	}
+	if (written.empty() && film_keyframes.world_hashes.empty()) return;
+
+	const auto& world_hashes= film_keyframes.world_hashes;
+	std::vector<uint8> index(4 + 2 + 4 + written.size()*SIZEOF_film_keyframe_entry +
+		4 + world_hashes.size()*SIZEOF_film_world_hash_entry + SIZEOF_film_keyframe_trailer);
+	uint8 *S= index.data();
+	ValueToStream(S, uint32(FILM_KEYFRAME_INDEX_TAG));
+	ValueToStream(S, int16(FILM_KEYFRAME_VERSION));
+	ValueToStream(S, int32(written.size()));
+	for (auto keyframe : written)
+	{
+		ValueToStream(S, keyframe->film_tick);
+		ValueToStream(S, keyframe->flag_position);
+		ValueToStream(S, keyframe->level_number);
+		ValueToStream(S, keyframe->chunk_offset);
+		ValueToStream(S, keyframe->data_offset);
+		ValueToStream(S, keyframe->data_size);
+		ValueToStream(S, keyframe->state_size);
+	}
+	ValueToStream(S, int32(world_hashes.size()));
+	for (auto& hash : world_hashes)
+	{
+		ValueToStream(S, hash.film_tick);
+		ValueToStream(S, hash.sample.level_number);
+		ValueToStream(S, hash.sample.tick_count);
+		*S++= WORLD_HASH_PERIOD;
+		ListToStream(S, hash.sample.tick_hashes, WORLD_HASH_PERIOD);
+		*S++= NUMBER_OF_WORLD_HASH_SUBSYSTEMS;
+		ListToStream(S, hash.sample.subsystem_hashes, NUMBER_OF_WORLD_HASH_SUBSYSTEMS);
+	}
+	ValueToStream(S, offset);
+	ValueToStream(S, uint32(FILM_KEYFRAME_TRAILER_TAG));
+	assert(S == index.data() + index.size());
+
+	if (!FilmFile.Write(static_cast<int32>(index.size()), index.data()))
+	{
+		logWarning("couldn't write the film keyframe index");
+	}
+}
+
+static void read_film_keyframe_index(
+	void)
+{
+	int32 position, file_length;
+	FilmFile.GetPosition(position);
+	FilmFile.GetLength(file_length);
+
+	if (file_length - replay.header.length >= 4 + 2 + 4 + SIZEOF_film_keyframe_trailer)
+	{
+		uint8 trailer[SIZEOF_film_keyframe_trailer];
+		int32 index_offset;
+		uint32 tag;
+		uint8 *S= trailer;
+		if (FilmFile.SetPosition(file_length - SIZEOF_film_keyframe_trailer) &&
+			FilmFile.Read(SIZEOF_film_keyframe_trailer, trailer))
+		{
+			StreamToValue(S, index_offset);
+			StreamToValue(S, tag);
+		}
+		else
+		{
+			tag= 0;
+		}
+
+		std::vector<uint8> index;
+		if (tag == FILM_KEYFRAME_TRAILER_TAG && index_offset >= replay.header.length &&
+			index_offset <= file_length - SIZEOF_film_keyframe_trailer - (4 + 2 + 4))
+		{
+			index.resize(file_length - SIZEOF_film_keyframe_trailer - index_offset);
+			if (!FilmFile.SetPosition(index_offset) || !FilmFile.Read(static_cast<int32>(index.size()), index.data()))
+			{
+				index.clear();
+			}
+		}
+
+		if (!index.empty())
+		{
+			int16 version;
+			int32 count;
+			S= index.data();
+			StreamToValue(S, tag);
+			StreamToValue(S, version);
+			StreamToValue(S, count);
+
+			size_t keyframes_size= 4 + 2 + 4 + size_t(count)*SIZEOF_film_keyframe_entry;
+			if (tag == FILM_KEYFRAME_INDEX_TAG && count >= 0 &&
+				((version == 1 && index.size() == keyframes_size) ||
+				 (version == FILM_KEYFRAME_VERSION && index.size() >= keyframes_size + 4)))
+			{
+				for (int32 i= 0; i < count; ++i)
+				{
+					film_keyframe keyframe;
+					StreamToValue(S, keyframe.film_tick);
+					StreamToValue(S, keyframe.flag_position);
+					StreamToValue(S, keyframe.level_number);
+					StreamToValue(S, keyframe.chunk_offset);
+					StreamToValue(S, keyframe.data_offset);
+					StreamToValue(S, keyframe.data_size);
+					StreamToValue(S, keyframe.state_size);
+
+					if (keyframe.chunk_offset >= SIZEOF_recording_header && keyframe.chunk_offset < replay.header.length &&
+						keyframe.data_offset >= replay.header.length && keyframe.data_size > 0 &&
+						keyframe.data_size <= index_offset - keyframe.data_offset && keyframe.state_size > 0)
+					{
+						film_keyframes.keyframes.push_back(std::move(keyframe));
+					}
+				}
+
+				int32 hash_count= 0;
+				if (version >= 2) StreamToValue(S, hash_count);
+				if (hash_count > 0 && index.size() == keyframes_size + 4 + size_t(hash_count)*SIZEOF_film_world_hash_entry)
+				{
+					for (int32 i= 0; i < hash_count; ++i)
+					{
+						film_world_hash hash;
+						uint8 period, subsystem_count;
+						StreamToValue(S, hash.film_tick);
+						StreamToValue(S, hash.sample.level_number);
+						StreamToValue(S, hash.sample.tick_count);
+						period= *S++;
+						StreamToList(S, hash.sample.tick_hashes, WORLD_HASH_PERIOD);
+						subsystem_count= *S++;
+						StreamToList(S, hash.sample.subsystem_hashes, NUMBER_OF_WORLD_HASH_SUBSYSTEMS);
+
+						// recorded by a build that hashes differently
+						if (period != WORLD_HASH_PERIOD || subsystem_count != NUMBER_OF_WORLD_HASH_SUBSYSTEMS) break;
+						film_keyframes.world_hashes.push_back(hash);
+					}
+				}
+			}
+		}
+	}
+
+	FilmFile.SetPosition(position);
+}
+
+static bool restore_film_keyframe(
+	const film_keyframe& keyframe)
+{
+	std::vector<uint8> data(keyframe.data_size);
+	std::vector<uint8> state(keyframe.state_size);
+
+	int32 position;
+	FilmFile.GetPosition(position);
+	bool read= FilmFile.SetPosition(keyframe.data_offset) && FilmFile.Read(keyframe.data_size, data.data());
+	FilmFile.SetPosition(position);
+	if (!read) return false;
+
+	uLongf state_size= state.size();
+	if (uncompress(state.data(), &state_size, data.data(), data.size()) != Z_OK || state_size != state.size()) return false;
+	if (!restore_world_state(state.data(), state.size())) return false;
+
+	/* throw away every flag we had read ahead, and start again with the chunk
+		holding the keyframe's next tick */
+	reset_recording_and_playback_queues();
+	GetRealActionQueues()->reset();
+	reset_intermediate_action_queues();
+
+	FilmFile.SetPosition(keyframe.chunk_offset);
+	replay.location_in_cache= NULL;
+	replay.bytes_in_cache= 0;
+	replay.have_read_last_chunk= false;
+	read_recording_queue_chunks();
+
+	for (short player_index= 0; player_index < dynamic_world->player_count; player_index++)
+	{
+		ActionQueue *queue= get_player_recording_queue(player_index);
+		short skip= MIN(keyframe.flag_position % RECORD_CHUNK_SIZE, get_recording_queue_size(player_index));
+		while (skip--) INCREMENT_QUEUE_COUNTER(queue->read_index);
+	}
+
+	film_keyframes.film_tick= keyframe.film_tick;
+	return true;
+}
+
 static void read_recording_queue_chunks(
 	void)
 {
@@ -73,6 +73,15 @@ static void FindBoneTransform(Model3D_Transform& T, Model3D_Bone& Bone,
 // Res = A * B, in that order
 static void TMatMultiply(Model3D_Transform& Res, Model3D_Transform& A, Model3D_Transform& B);
 
+// Cumulative bone transforms of a frame -> BoneMatrices
+static void FindBoneMatrices(Model3D& Model,
+	GLshort FrameIndex, GLfloat MixFrac, GLshort AddlFrameIndex);
+
+// Sequence frame -> its frame indices and overall transform; false for bad inputs
+static bool FindSeqFrameTransform(Model3D& Model, Model3D_Transform& TSF,
+	GLshort& Frame, GLfloat& MixFrac, GLshort& AddlFrame,
+	GLshort SeqIndex, GLshort FrameIndex, GLshort AddlFrameIndex);
+
 	
 // Trig-function conversion:
 const GLfloat TrigNorm = GLfloat(1)/GLfloat(TRIG_MAGNITUDE);
@@ -786,52 +795,7 @@ bool Model3D::FindPositions_Frame(bool UseModelTransform,
 	size_t NumVertices = VtxSrcIndices.size();
 	Positions.resize(3*NumVertices);
 	
-	// Set sizes:
-	BoneMatrices.resize(NumBones);
-	BoneStack.resize(NumBones);
-	
-	// Find which frame; remember that frame data comes in [NumBones] sets
-	Model3D_Frame *FramePtr = &Frames[NumBones*FrameIndex];
-	Model3D_Frame *AddlFramePtr = &Frames[NumBones*AddlFrameIndex];
-	
-	// Find the individual-bone transformation matrices:
-	for (size_t ib=0; ib<NumBones; ib++)
-		FindBoneTransform(BoneMatrices[ib],Bones[ib],
-			FramePtr[ib],MixFrac,AddlFramePtr[ib]);
-	
-	// Find the cumulative-bone transformation matrices:
-	int StackIndx = -1;
-	size_t Parent = UNONE;
-	for (unsigned int ib=0; ib<NumBones; ib++)
-	{
-		Model3D_Bone& Bone = Bones[ib];
-		
-		// Do the pop-push with the stack
-		// to get the bone's parent bone
-		if (TEST_FLAG(Bone.Flags,Model3D_Bone::Pop))
-		{
-			if (StackIndx >= 0)
-				Parent = BoneStack[StackIndx--];
-			else
-				Parent = UNONE;
-		}
-		if (TEST_FLAG(Bone.Flags,Model3D_Bone::Push))
-		{
-			StackIndx = MAX(StackIndx,-1);
-			BoneStack[++StackIndx] = Parent;
-		}
-		
-		// Do the transform!
-		if (Parent != UNONE)
-		{
-			Model3D_Transform Res;
-			TMatMultiply(Res,BoneMatrices[Parent],BoneMatrices[ib]);
-			obj_copy(BoneMatrices[ib],Res);
-		}
-	
-		// Default: parent of next bone is current bone
-		Parent = ib;
-	}
+	FindBoneMatrices(*this,FrameIndex,MixFrac,AddlFrameIndex);
 		
 	bool NormalsPresent = !NormSources.empty();
 	if (NormalsPresent) Normals.resize(NormSources.size());
@@ -936,29 +900,12 @@ bool Model3D::FindPositions_Sequence(bool UseModelTransform, GLshort SeqIndex,
 {
 	// Bad inputs: do nothing and return false
 	
-	GLshort NumSF = NumSeqFrames(SeqIndex);
-	if (NumSF <= 0) return false;
-	
-	if (FrameIndex < 0 || FrameIndex >= NumSF) return false;
-	
 	Model3D_Transform TSF;
+	GLshort Frame, AddlFrame;
+	if (!FindSeqFrameTransform(*this,TSF,Frame,MixFrac,AddlFrame,
+		SeqIndex,FrameIndex,AddlFrameIndex)) return false;
 	
-	Model3D_SeqFrame& SF = SeqFrames[SeqFrmPointers[SeqIndex] + FrameIndex];
-	
-	if (MixFrac != 0 && AddlFrameIndex != FrameIndex)
-	{
-		if (AddlFrameIndex < 0 || AddlFrameIndex >= NumSF) return false;
-		
-		Model3D_SeqFrame& ASF = SeqFrames[SeqFrmPointers[SeqIndex] + AddlFrameIndex];
-		FindFrameTransform(TSF,SF,MixFrac,ASF);
-		
-		if (!FindPositions_Frame(false,SF.Frame,MixFrac,ASF.Frame)) return false;
-	}
-	else
-	{
-		if (!FindPositions_Frame(false,SF.Frame)) return false;
-		FindFrameTransform(TSF,SF,0,SF);
-	}
+	if (!FindPositions_Frame(false,Frame,MixFrac,AddlFrame)) return false;
 	
 	Model3D_Transform TTot;
 	if (UseModelTransform)
@@ -998,6 +945,121 @@ bool Model3D::FindPositions_Sequence(bool UseModelTransform, GLshort SeqIndex,
 	return true;
 }
 
+bool Model3D::FindBoneTransforms_Sequence(vector<Model3D_Transform>& Transforms, GLshort SeqIndex,
+	GLshort FrameIndex, GLfloat MixFrac, GLshort AddlFrameIndex)
+{
+	Model3D_Transform TSF;
+	GLshort Frame, AddlFrame;
+	if (!FindSeqFrameTransform(*this,TSF,Frame,MixFrac,AddlFrame,
+		SeqIndex,FrameIndex,AddlFrameIndex)) return false;
+	
+	size_t NumBones = Bones.size();
+	if (Frame < 0 || NumBones*Frame >= Frames.size()) return false;
+	if (AddlFrame < 0 || NumBones*AddlFrame >= Frames.size()) return false;
+	
+	FindBoneMatrices(*this,Frame,MixFrac,AddlFrame);
+	
+	// The sequence-frame and model transforms are affine,
+	// so they may be applied to each bone before the blending
+	Model3D_Transform TTot;
+	TMatMultiply(TTot,TransformPos,TSF);
+	
+	Transforms.resize(NumBones+1);
+	for (size_t ib=0; ib<NumBones; ib++)
+		TMatMultiply(Transforms[ib],TTot,BoneMatrices[ib]);
+	obj_copy(Transforms[NumBones],TTot);
+	
+	return true;
+}
+
+
+static void FindBoneMatrices(Model3D& Model,
+	GLshort FrameIndex, GLfloat MixFrac, GLshort AddlFrameIndex)
+{
+	size_t NumBones = Model.Bones.size();
+	
+	// Set sizes:
+	BoneMatrices.resize(NumBones);
+	BoneStack.resize(NumBones);
+	
+	// Find which frame; remember that frame data comes in [NumBones] sets
+	Model3D_Frame *FramePtr = &Model.Frames[NumBones*FrameIndex];
+	Model3D_Frame *AddlFramePtr = &Model.Frames[NumBones*AddlFrameIndex];
+	
+	// Find the individual-bone transformation matrices:
+	for (size_t ib=0; ib<NumBones; ib++)
+		FindBoneTransform(BoneMatrices[ib],Model.Bones[ib],
+			FramePtr[ib],MixFrac,AddlFramePtr[ib]);
+	
+	// Find the cumulative-bone transformation matrices:
+	int StackIndx = -1;
+	size_t Parent = UNONE;
+	for (unsigned int ib=0; ib<NumBones; ib++)
+	{
+		Model3D_Bone& Bone = Model.Bones[ib];
+		
+		// Do the pop-push with the stack
+		// to get the bone's parent bone
+		if (TEST_FLAG(Bone.Flags,Model3D_Bone::Pop))
+		{
+			if (StackIndx >= 0)
+				Parent = BoneStack[StackIndx--];
+			else
+				Parent = UNONE;
+		}
+		if (TEST_FLAG(Bone.Flags,Model3D_Bone::Push))
+		{
+			StackIndx = MAX(StackIndx,-1);
+			BoneStack[++StackIndx] = Parent;
+		}
+		
+		// Do the transform!
+		if (Parent != UNONE)
+		{
+			Model3D_Transform Res;
+			TMatMultiply(Res,BoneMatrices[Parent],BoneMatrices[ib]);
+			obj_copy(BoneMatrices[ib],Res);
+		}
+	
+		// Default: parent of next bone is current bone
+		Parent = ib;
+	}
+}
+
+static bool FindSeqFrameTransform(Model3D& Model, Model3D_Transform& TSF,
+	GLshort& Frame, GLfloat& MixFrac, GLshort& AddlFrame,
+	GLshort SeqIndex, GLshort FrameIndex, GLshort AddlFrameIndex)
+{
+	// Bad inputs: do nothing and return false
+	
+	GLshort NumSF = Model.NumSeqFrames(SeqIndex);
+	if (NumSF <= 0) return false;
+	
+	if (FrameIndex < 0 || FrameIndex >= NumSF) return false;
+	
+	Model3D_SeqFrame& SF = Model.SeqFrames[Model.SeqFrmPointers[SeqIndex] + FrameIndex];
+	
+	if (MixFrac != 0 && AddlFrameIndex != FrameIndex)
+	{
+		if (AddlFrameIndex < 0 || AddlFrameIndex >= NumSF) return false;
+		
+		Model3D_SeqFrame& ASF = Model.SeqFrames[Model.SeqFrmPointers[SeqIndex] + AddlFrameIndex];
+		FindFrameTransform(TSF,SF,MixFrac,ASF);
+		
+		Frame = SF.Frame;
+		AddlFrame = ASF.Frame;
+	}
+	else
+	{
+		FindFrameTransform(TSF,SF,0,SF);
+		
+		Frame = AddlFrame = SF.Frame;
+		MixFrac = 0;
+	}
+	
+	return true;
+}
+
 
 void Model3D_Transform::Identity()
 {
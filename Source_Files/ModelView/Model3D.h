@@ -253,6 +253,13 @@ struct Model3D
 	bool FindPositions_Sequence(bool UseModelTransform, GLshort SeqIndex,
 		GLshort FrameIndex, GLfloat MixFrac = 0, GLshort AddlFrameIndex = 0);
 	
+	// For skinning the neutral vertices elsewhere (in a vertex shader):
+	// finds what FindPositions_Sequence(true,...) would apply to each vertex source,
+	// one transform per bone followed by one for the assumed root bone.
+	// Returns whether or not the indices were in range.
+	bool FindBoneTransforms_Sequence(vector<Model3D_Transform>& Transforms, GLshort SeqIndex,
+		GLshort FrameIndex, GLfloat MixFrac = 0, GLshort AddlFrameIndex = 0);
+	
 	// Constructor
 	Model3D() {FindBoundingBox(); TransformPos.Identity(); TransformNorm.Identity();}
 };
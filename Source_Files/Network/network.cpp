@@ -3047,6 +3047,26 @@ int32 NetGetLatency() {
 	}
 }
 
+extern void spoke_note_world_hash(const world_hash_sample& inSample);
+extern bool spoke_get_world_hash_desync(size_t& outPlayerIndex, int32& outTick, uint32& outSubsystems);
+
+void NetNoteWorldHash(const world_hash_sample& sample)
+{
+	if (sCurrentGameProtocol == static_cast<NetworkGameProtocol*>(&sStarGameProtocol) && connection_to_server) {
+		spoke_note_world_hash(sample);
+	}
+}
+
+bool NetGetWorldHashDesync(short& player_index, int32& tick, uint32& subsystems)
+{
+	size_t index;
+	if (sCurrentGameProtocol == static_cast<NetworkGameProtocol*>(&sStarGameProtocol) && spoke_get_world_hash_desync(index, tick, subsystems)) {
+		player_index = static_cast<short>(index);
+		return true;
+	}
+	return false;
+}
+
 const NetworkStats& NetGetStats(int player_index)
 {
 	if (sCurrentGameProtocol == static_cast<NetworkGameProtocol*>(&sStarGameProtocol))
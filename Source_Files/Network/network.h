@@ -323,4 +323,10 @@ int32 NetGetLatency();
 const NetworkStats& NetGetStats(int player_index);
 bool NetCheckWorldUpdate();
 
+// world hash samples are compared between players (star protocol only); a
+// desync is reported once
+struct world_hash_sample;
+void NetNoteWorldHash(const world_hash_sample& sample);
+bool NetGetWorldHashDesync(short& player_index, int32& tick, uint32& subsystems);
+
 #endif
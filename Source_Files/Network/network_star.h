@@ -47,6 +47,8 @@ enum {
         kPlayerNetDeadMessageType = 0x4e44,	// 'ND'
 	kSpokeToHubLossyByteStreamMessageType = 0x534c,	// 'SL'
 	kHubToSpokeLossyByteStreamMessageType = 0x484c, // 'HL'
+	kSpokeToHubWorldHashMessageType = 0x5357,	// 'SW'
+	kHubToSpokeWorldHashMessageType = 0x4857,	// 'HW'
 
 	kSpokeToHubIdentification = 0x4944,   // 'ID'
 	kSpokeToHubGameDataPacketV1Magic = 0x5331, // 'S1'
@@ -90,6 +92,10 @@ extern int32 hub_latency(int player_index); // in ms, kNetLatencyInvalid if not
 extern TickBasedActionQueue* spoke_get_unconfirmed_flags_queue();
 extern int32 spoke_get_smallest_unconfirmed_tick();
 extern bool spoke_check_world_update();
+// Sends our world hash sample to the hub, which passes the newest one it hears on to
+// everyone else; any mismatch with another player's sample is remembered until asked for.
+extern void spoke_note_world_hash(const struct world_hash_sample& inSample);
+extern bool spoke_get_world_hash_desync(size_t& outPlayerIndex, int32& outTick, uint32& outSubsystems);
 extern void DefaultSpokePreferences();
 extern InfoTree SpokePreferencesTree();
 extern void SpokeParsePreferencesTree(InfoTree prefs, std::string version);
@@ -232,6 +232,9 @@ struct NetworkPlayer_hub {
 	std::deque<int32> mLatencyBuffer;
 
 	NetworkStats mStats;
+
+	// Does this player still need the current world hash sample?
+	bool		mWorldHashPending;
 };
 
 // Housekeeping queues:
@@ -318,6 +321,17 @@ static CircularQueue<HubLossyByteStreamChunkDescriptor> sOutgoingLossyByteStream
 // It's used in both directions, but that's ok because the routines that do so are mutex.
 static byte sScratchBuffer[kLossyByteStreamDataBufferSize];
 
+// The newest world hash sample any spoke has reported, passed on once to everyone else.
+// We don't look inside it beyond the level and tick (the standalone hub has no world),
+// so spokes compare against whoever reports first; that's enough to spot a desync.
+enum {
+	kMaximumWorldHashSampleLength = 512
+};
+static std::vector<byte> sWorldHashSample;
+static uint8 sWorldHashReporter;
+static int16 sWorldHashLevel;
+static int32 sWorldHashTick;
+
 
 static myTMTaskPtr	sHubTickTask = NULL;
 static std::atomic_bool	sHubActive = { false };	// used to enable the packet handler
@@ -335,6 +349,7 @@ static void hub_received_ping_request(AIStream& ps, NetAddrBlock address);
 static void hub_received_ping_response(AIStream& ps, NetAddrBlock address);
 static void process_messages(AIStream& ps, int inSenderIndex);
 static void process_optional_message(AIStream& ps, int inSenderIndex, uint16 inMessageType);
+static void process_world_hash_message(AIStream& ps, int inSenderIndex, uint16 inLength);
 static void make_player_netdead(int inPlayerIndex);
 static bool hub_tick();
 static void send_packets();
@@ -484,6 +499,8 @@ hub_initialize(int32 inStartingTick, int inNumPlayers, const NetAddrBlock* const
 	sOutgoingLossyByteStreamDescriptors.reset();
 	sOutgoingLossyByteStreamData.reset();
 
+	sWorldHashSample.clear();
+
         for(size_t i = 0; i < inNumPlayers; i++)
         {
                 NetworkPlayer_hub& thePlayer = sNetworkPlayers[i];
@@ -528,6 +545,8 @@ hub_initialize(int32 inStartingTick, int inNumPlayers, const NetAddrBlock* const
 		thePlayer.mStats.pregame_state = thePlayer.mConnected ? NetworkStats::invalid : NetworkStats::disconnected;
 		thePlayer.mStats.errors = 0;
 
+		thePlayer.mWorldHashPending = false;
+
                 sFlagsQueues[i].reset(theFirstTick);
 		sLateFlagsQueues[i].reset(theFirstTick);
         }
@@ -1268,6 +1287,8 @@ process_optional_message(AIStream& ps, int inSenderIndex, uint16 inMessageType)
 
 	if(inMessageType == kSpokeToHubLossyByteStreamMessageType)
 		process_lossy_byte_stream_message(ps, inSenderIndex, theMessageLength);
+	else if(inMessageType == kSpokeToHubWorldHashMessageType)
+		process_world_hash_message(ps, inSenderIndex, theMessageLength);
 	else
 	{
 		// Currently we ignore (skip) all optional messages
@@ -1277,6 +1298,42 @@ process_optional_message(AIStream& ps, int inSenderIndex, uint16 inMessageType)
 
 
 
+static void
+process_world_hash_message(AIStream& ps, int inSenderIndex, uint16 inLength)
+{
+	assert(inSenderIndex >= 0 && inSenderIndex < static_cast<int>(sNetworkPlayers.size()));
+
+	int16 theLevel;
+	int32 theTick;
+	if(inLength > kMaximumWorldHashSampleLength || inLength < sizeof(theLevel) + sizeof(theTick))
+	{
+		ps.ignore(inLength);
+		return;
+	}
+
+	std::vector<byte> theSample(inLength);
+	ps.read(theSample.data(), inLength);
+
+	AIStreamBE theHeader(theSample.data(), inLength);
+	theHeader >> theLevel >> theTick;
+
+	// Older samples (including everyone else's report of the tick we already have) are dropped
+	if(!sWorldHashSample.empty() && theLevel == sWorldHashLevel && theTick <= sWorldHashTick)
+		return;
+
+	logDumpNMT("world hash for level %d tick %d from player %d", theLevel, theTick, inSenderIndex);
+
+	sWorldHashSample.swap(theSample);
+	sWorldHashReporter = inSenderIndex;
+	sWorldHashLevel = theLevel;
+	sWorldHashTick = theTick;
+
+	for(size_t i = 0; i < sNetworkPlayers.size(); i++)
+		sNetworkPlayers[i].mWorldHashPending = (static_cast<int>(i) != inSenderIndex);
+}
+
+
+
 static void
 make_player_netdead(int inPlayerIndex)
 {
@@ -1546,6 +1603,16 @@ send_packets()
 
 					ps.write(sScratchBuffer, theDescriptor.mLength);
 				}
+
+				// World hash sample?  Sent once, like lossy streaming data.
+				if(thePlayer.mWorldHashPending)
+				{
+					thePlayer.mWorldHashPending = false;
+					ps << (uint16)kHubToSpokeWorldHashMessageType
+						<< (uint16)(sizeof(sWorldHashReporter) + sWorldHashSample.size())
+						<< sWorldHashReporter;
+					ps.write(sWorldHashSample.data(), sWorldHashSample.size());
+				}
         
                                 // End of messages
                                 ps << (uint16)kEndOfMessagesMessageType;
@@ -39,7 +39,9 @@
 #include "crc.h"
 #include "player.h"
 #include "InfoTree.h"
+#include "world_hash.h"
 #include <map>
+#include <deque>
 
 extern void make_player_really_net_dead(size_t inPlayerIndex);
 extern void call_distribution_response_function_if_available(byte* inBuffer, uint16 inBufferSize, int16 inDistributionType, uint8 inSendingPlayerIndex);
@@ -54,7 +56,8 @@ enum {
 	kDefaultTimingNthElement = kDefaultTimingWindowSize / 2,
 	kLossyByteStreamDataBufferSize = 1280,
 	kTypicalLossyByteStreamChunkSize = 56,
-	kLossyByteStreamDescriptorCount = kLossyByteStreamDataBufferSize / kTypicalLossyByteStreamChunkSize
+	kLossyByteStreamDescriptorCount = kLossyByteStreamDataBufferSize / kTypicalLossyByteStreamChunkSize,
+	kWorldHashHistorySize = 8	// samples kept to compare against reports that arrive early or late
 };
 
 struct SpokePreferences
@@ -139,6 +142,21 @@ static CircularQueue<SpokeLossyByteStreamChunkDescriptor> sOutgoingLossyByteStre
 // This is currently used only to hold incoming streaming data until it's passed to the upper-level code
 static byte sScratchBuffer[kLossyByteStreamDataBufferSize];
 
+// World hash samples: ours (waiting for other players' samples of the same tick) and
+// theirs (waiting for ours).  Only the first desync is reported.
+struct RemoteWorldHashSample {
+	uint8 mPlayerIndex;
+	world_hash_sample mSample;
+};
+static std::deque<world_hash_sample> sLocalWorldHashes;
+static std::deque<RemoteWorldHashSample> sRemoteWorldHashes;
+static bool sNeedToSendWorldHash = false;
+static bool sWorldHashDesyncFound = false;
+static bool sWorldHashDesyncReported = false;
+static size_t sWorldHashDesyncPlayerIndex;
+static int32 sWorldHashDesyncTick;
+static uint32 sWorldHashDesyncSubsystems;
+
 
 static void spoke_became_disconnected();
 static void spoke_received_game_data_packet_v1(AIStream& ps, bool reflected_flags);
@@ -149,6 +167,8 @@ static void handle_end_of_messages_message(AIStream& ps, IncomingGameDataPacketP
 static void handle_player_net_dead_message(AIStream& ps, IncomingGameDataPacketProcessingContext& context);
 static void handle_timing_adjustment_message(AIStream& ps, IncomingGameDataPacketProcessingContext& context);
 static void handle_lossy_byte_stream_message(AIStream& ps, IncomingGameDataPacketProcessingContext& context);
+static void handle_world_hash_message(AIStream& ps, IncomingGameDataPacketProcessingContext& context);
+static void compare_world_hashes();
 static void process_optional_message(AIStream& ps, IncomingGameDataPacketProcessingContext& context, uint16 inMessageType);
 static bool spoke_tick();
 static void send_packet();
@@ -261,6 +281,13 @@ spoke_initialize(const NetAddrBlock& inHubAddress, int32 inFirstTick, size_t inN
         sMessageTypeToMessageHandler[kTimingAdjustmentMessageType] = handle_timing_adjustment_message;
         sMessageTypeToMessageHandler[kPlayerNetDeadMessageType] = handle_player_net_dead_message;
 	sMessageTypeToMessageHandler[kHubToSpokeLossyByteStreamMessageType] = handle_lossy_byte_stream_message;
+	sMessageTypeToMessageHandler[kHubToSpokeWorldHashMessageType] = handle_world_hash_message;
+
+	sLocalWorldHashes.clear();
+	sRemoteWorldHashes.clear();
+	sNeedToSendWorldHash = false;
+	sWorldHashDesyncFound = false;
+	sWorldHashDesyncReported = false;
 
         sNeedToSendLocalOutgoingBuffer = false;
 
@@ -879,6 +906,137 @@ handle_lossy_byte_stream_message(AIStream& ps, IncomingGameDataPacketProcessingC
 
 
 
+// The sample goes over the wire with its own array sizes, so a build that hashes
+// differently is ignored rather than misread.
+static const uint16 kWorldHashSampleLength = sizeof(int16) + sizeof(int32)
+	+ sizeof(uint8) + WORLD_HASH_PERIOD * sizeof(uint32)
+	+ sizeof(uint8) + NUMBER_OF_WORLD_HASH_SUBSYSTEMS * sizeof(uint32);
+
+static void
+write_world_hash_sample(AOStream& ps, const world_hash_sample& inSample)
+{
+	ps << inSample.level_number << inSample.tick_count;
+	ps << (uint8)WORLD_HASH_PERIOD;
+	for(int i = 0; i < WORLD_HASH_PERIOD; i++)
+		ps << inSample.tick_hashes[i];
+	ps << (uint8)NUMBER_OF_WORLD_HASH_SUBSYSTEMS;
+	for(int i = 0; i < NUMBER_OF_WORLD_HASH_SUBSYSTEMS; i++)
+		ps << inSample.subsystem_hashes[i];
+}
+
+static void
+handle_world_hash_message(AIStream& ps, IncomingGameDataPacketProcessingContext& context)
+{
+	uint16 theMessageLength;
+	ps >> theMessageLength;
+
+	if(theMessageLength != sizeof(uint8) + kWorldHashSampleLength)
+	{
+		logNoteNMT("ignoring world hash message of unexpected length %d", theMessageLength);
+		ps.ignore(theMessageLength);
+		return;
+	}
+
+	RemoteWorldHashSample theRemote;
+	uint8 thePeriod, theSubsystemCount;
+	ps >> theRemote.mPlayerIndex >> theRemote.mSample.level_number >> theRemote.mSample.tick_count;
+	ps >> thePeriod;
+	for(int i = 0; i < WORLD_HASH_PERIOD; i++)
+		ps >> theRemote.mSample.tick_hashes[i];
+	ps >> theSubsystemCount;
+	for(int i = 0; i < NUMBER_OF_WORLD_HASH_SUBSYSTEMS; i++)
+		ps >> theRemote.mSample.subsystem_hashes[i];
+
+	if(thePeriod != WORLD_HASH_PERIOD || theSubsystemCount != NUMBER_OF_WORLD_HASH_SUBSYSTEMS
+	   || theRemote.mPlayerIndex >= sNetworkPlayers.size() || theRemote.mPlayerIndex == sLocalPlayerIndex)
+		return;
+
+	logDumpNMT("world hash from player %d for tick %d", theRemote.mPlayerIndex, theRemote.mSample.tick_count);
+
+	sRemoteWorldHashes.push_back(theRemote);
+	if(sRemoteWorldHashes.size() > kWorldHashHistorySize)
+		sRemoteWorldHashes.pop_front();
+
+	compare_world_hashes();
+}
+
+
+
+// Pairs up our samples with other players' samples of the same level and tick.
+// Remote samples older than anything we still have can never be matched and are dropped.
+static void
+compare_world_hashes()
+{
+	std::deque<RemoteWorldHashSample>::iterator theRemote = sRemoteWorldHashes.begin();
+	while(theRemote != sRemoteWorldHashes.end())
+	{
+		bool theRemoteIsDone = !sLocalWorldHashes.empty()
+			&& theRemote->mSample.level_number == sLocalWorldHashes.front().level_number
+			&& theRemote->mSample.tick_count < sLocalWorldHashes.front().tick_count;
+
+		for(std::deque<world_hash_sample>::const_iterator theLocal = sLocalWorldHashes.begin(); theLocal != sLocalWorldHashes.end(); ++theLocal)
+		{
+			if(theLocal->level_number != theRemote->mSample.level_number || theLocal->tick_count != theRemote->mSample.tick_count)
+				continue;
+
+			int32 theTick;
+			uint32 theSubsystems;
+			if(!sWorldHashDesyncFound && compare_world_hash_samples(*theLocal, theRemote->mSample, theTick, theSubsystems))
+			{
+				sWorldHashDesyncFound = true;
+				sWorldHashDesyncPlayerIndex = theRemote->mPlayerIndex;
+				sWorldHashDesyncTick = theTick;
+				sWorldHashDesyncSubsystems = theSubsystems;
+				logErrorNMT("world state differs from player %d's from tick %d", theRemote->mPlayerIndex, theTick);
+			}
+			theRemoteIsDone = true;
+			break;
+		}
+
+		if(theRemoteIsDone)
+			theRemote = sRemoteWorldHashes.erase(theRemote);
+		else
+			++theRemote;
+	}
+}
+
+
+
+void
+spoke_note_world_hash(const world_hash_sample& inSample)
+{
+	MyTMMutexTaker mutex;
+
+	if(!sSpokeActive)
+		return;
+
+	sLocalWorldHashes.push_back(inSample);
+	if(sLocalWorldHashes.size() > kWorldHashHistorySize)
+		sLocalWorldHashes.pop_front();
+	sNeedToSendWorldHash = true;
+
+	compare_world_hashes();
+}
+
+
+
+bool
+spoke_get_world_hash_desync(size_t& outPlayerIndex, int32& outTick, uint32& outSubsystems)
+{
+	MyTMMutexTaker mutex;
+
+	if(!sWorldHashDesyncFound || sWorldHashDesyncReported)
+		return false;
+
+	sWorldHashDesyncReported = true;
+	outPlayerIndex = sWorldHashDesyncPlayerIndex;
+	outTick = sWorldHashDesyncTick;
+	outSubsystems = sWorldHashDesyncSubsystems;
+	return true;
+}
+
+
+
 static void
 process_optional_message(AIStream& ps, IncomingGameDataPacketProcessingContext& context, uint16 inMessageType)
 {
@@ -1068,6 +1226,14 @@ send_packet()
 
 			ps.write(sScratchBuffer, theDescriptor.mLength);
 		}
+
+		// A new world hash sample?  Sent once; losing one only delays detection.
+		if(sNeedToSendWorldHash && !sLocalWorldHashes.empty())
+		{
+			sNeedToSendWorldHash = false;
+			ps << (uint16)kSpokeToHubWorldHashMessageType << kWorldHashSampleLength;
+			write_world_hash_sample(ps, sLocalWorldHashes.back());
+		}
 		
                 // No more messages
                 ps << (uint16)kEndOfMessagesMessageType;
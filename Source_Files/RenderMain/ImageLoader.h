@@ -35,6 +35,9 @@
 #include "cseries.h"
 #include "FileHandler.h"
 
+class AIStream;
+class AOStream;
+
 // Need an object to hold the read-in image.
 class ImageDescriptor
 {
@@ -87,6 +90,24 @@ public:
 
 	bool Minify();
 
+	// Builds the rest of an RGBA8 image's mipmap chain; needs no OpenGL
+	// context, so it can run on a loader thread
+	bool MakeMipMaps();
+
+	// Box-filters one RGBA8 level into the next, which is
+	// max(1, Width/2) x max(1, Height/2)
+	static void HalveRGBA(const uint32 *Source, int Width, int Height, uint32 *Dest);
+
+	// Exchanges contents without copying any pixels
+	void Swap(ImageDescriptor &Other);
+
+	// Raw form for the texture cache: a short header, then the pixels
+	// (mipmaps included) exactly as they are in memory;
+	// Unpack() throws AStream::failure on a truncated stream
+	uint32 GetPackedSize() const;
+	void Pack(AOStream &Stream) const;
+	void Unpack(AIStream &Stream);
+
 	bool MakeRGBA();
 	bool MakeDXTC3();
 
@@ -43,11 +43,11 @@
 
 #ifdef HAVE_OPENGL
 #include "OGL_Headers.h"
-#include "OGL_Setup.h" // OGL_IsActive
 #endif
 
 #include <cmath>
 #include <stdlib.h>
+#include <utility>
 
 using std::min;
 using std::max;
@@ -142,34 +142,157 @@ bool ImageDescriptor::Minify()
 	else if (Format == RGBA8)
 	{
 		if (!(Width > 1 || Height > 1)) return false;
-		int newWidth = Width >> 1;
-		int newHeight = Height >> 1;
-#ifdef HAVE_OPENGL
-		if (OGL_IsActive())
-		{
-			
-			uint32 *newPixels = new uint32[newWidth * newHeight];
-			gluScaleImage(GL_RGBA, Width, Height, GL_UNSIGNED_BYTE, Pixels, newWidth, newHeight, GL_UNSIGNED_BYTE, newPixels);
-			delete []Pixels;
-			Pixels = newPixels;
-			Width = newWidth;
-			Height = newHeight;
-			Size = newWidth * newHeight;
-			return true;
-			
-		} 
-		else 
-#endif
-		{
-			fprintf(stderr, "GL not active\n");
-			return false;
-		}
+		int newWidth = max(1, Width >> 1);
+		int newHeight = max(1, Height >> 1);
+
+		// Done on the CPU so that loader threads can do it too
+		uint32 *newPixels = new uint32[newWidth * newHeight];
+		HalveRGBA(Pixels, Width, Height, newPixels);
+		delete []Pixels;
+		Pixels = newPixels;
+		Width = newWidth;
+		Height = newHeight;
+		Size = newWidth * newHeight * 4;
+		return true;
 	} 
 	else 
 	{
 		return false;
 	}
 }
+
+void ImageDescriptor::HalveRGBA(const uint32 *Source, int Width, int Height, uint32 *Dest)
+{
+	int DestWidth = max(1, Width >> 1);
+	int DestHeight = max(1, Height >> 1);
+
+	for (int y = 0; y < DestHeight; y++)
+	{
+		const uint32 *Row0 = Source + min(2 * y, Height - 1) * Width;
+		const uint32 *Row1 = Source + min(2 * y + 1, Height - 1) * Width;
+		for (int x = 0; x < DestWidth; x++)
+		{
+			int x0 = min(2 * x, Width - 1);
+			int x1 = min(2 * x + 1, Width - 1);
+			uint32 Pixels[4] = {Row0[x0], Row0[x1], Row1[x0], Row1[x1]};
+
+			uint32 Result = 0;
+			for (int Shift = 0; Shift < 32; Shift += 8)
+			{
+				uint32 Sum = 2;
+				for (auto Pixel : Pixels)
+					Sum += (Pixel >> Shift) & 0xff;
+				Result |= (Sum >> 2) << Shift;
+			}
+			Dest[y * DestWidth + x] = Result;
+		}
+	}
+}
+
+bool ImageDescriptor::MakeMipMaps()
+{
+	if (Format != RGBA8 || !IsPresent()) return false;
+	if (MipMapCount > 1) return true;
+
+	int Levels = static_cast<int>(1 + floor(std::log2(max(Width, Height))));
+	if (Levels <= 1) return true;
+
+	int NewSize = 0;
+	for (int i = 0; i < Levels; i++)
+		NewSize += max(1, Width >> i) * max(1, Height >> i) * 4;
+
+	uint32 *NewPixels = new uint32[NewSize / 4];
+	memcpy(NewPixels, Pixels, Width * Height * 4);
+
+	uint32 *Level = NewPixels;
+	for (int i = 1; i < Levels; i++)
+	{
+		int LevelWidth = max(1, Width >> (i - 1));
+		int LevelHeight = max(1, Height >> (i - 1));
+		uint32 *Next = Level + LevelWidth * LevelHeight;
+		HalveRGBA(Level, LevelWidth, LevelHeight, Next);
+		Level = Next;
+	}
+
+	delete []Pixels;
+	Pixels = NewPixels;
+	Size = NewSize;
+	MipMapCount = Levels;
+	return true;
+}
+
+static constexpr uint32 kPackedHeaderSize = 40;
+
+uint32 ImageDescriptor::GetPackedSize() const
+{
+	return 4 + (IsPresent() ? kPackedHeaderSize + Size : 0);
+}
+
+// AStream has no floating-point types
+static uint64_t DoubleBits(double Value)
+{
+	uint64_t Bits;
+	memcpy(&Bits, &Value, sizeof(Bits));
+	return Bits;
+}
+
+static double BitsDouble(uint32 High, uint32 Low)
+{
+	uint64_t Bits = (uint64_t(High) << 32) | Low;
+	double Value;
+	memcpy(&Value, &Bits, sizeof(Value));
+	return Value;
+}
+
+void ImageDescriptor::Pack(AOStream &Stream) const
+{
+	Stream << uint32(IsPresent());
+	if (!IsPresent()) return;
+
+	uint64_t V = DoubleBits(VScale);
+	uint64_t U = DoubleBits(UScale);
+	Stream << int32(Width) << int32(Height) << int32(Size) << int32(MipMapCount) << int32(Format)
+	       << uint32(PremultipliedAlpha)
+	       << uint32(V >> 32) << uint32(V) << uint32(U >> 32) << uint32(U);
+	Stream.write((char *) Pixels, Size);
+}
+
+void ImageDescriptor::Unpack(AIStream &Stream)
+{
+	Clear();
+
+	uint32 Present;
+	Stream >> Present;
+	if (!Present) return;
+
+	int32 NewWidth, NewHeight, NewSize, NewMipMapCount, NewFormat;
+	uint32 Premultiplied, VHigh, VLow, UHigh, ULow;
+	Stream >> NewWidth >> NewHeight >> NewSize >> NewMipMapCount >> NewFormat
+	       >> Premultiplied >> VHigh >> VLow >> UHigh >> ULow;
+	if (NewWidth <= 0 || NewHeight <= 0 || NewSize <= 0 || NewSize % 4 || NewFormat < RGBA8 || NewFormat >= Unknown)
+		throw AStream::failure("bad packed image header");
+
+	Resize(NewWidth, NewHeight, NewSize);
+	Stream.read((char *) Pixels, NewSize);
+	MipMapCount = NewMipMapCount;
+	Format = static_cast<ImageFormat>(NewFormat);
+	PremultipliedAlpha = Premultiplied != 0;
+	VScale = BitsDouble(VHigh, VLow);
+	UScale = BitsDouble(UHigh, ULow);
+}
+
+void ImageDescriptor::Swap(ImageDescriptor &Other)
+{
+	std::swap(Width, Other.Width);
+	std::swap(Height, Other.Height);
+	std::swap(VScale, Other.VScale);
+	std::swap(UScale, Other.UScale);
+	std::swap(Pixels, Other.Pixels);
+	std::swap(Size, Other.Size);
+	std::swap(MipMapCount, Other.MipMapCount);
+	std::swap(PremultipliedAlpha, Other.PremultipliedAlpha);
+	std::swap(Format, Other.Format);
+}
 	
 
 ImageDescriptor::ImageDescriptor(const ImageDescriptor &copyFrom) :
@@ -29,6 +29,7 @@
 #include "cseries.h"
 #include "OGL_Model_Def.h"
 #include "OGL_Setup.h"
+#include "OGL_Render.h"
 
 #ifdef HAVE_OPENGL
 
@@ -588,10 +589,93 @@ void OGL_ModelData::Unload()
 	Model.Clear();
 	OGL_ResetForceSpriteDepth();
 	
+	// The buffers were filled from that model
+	if (SkinnedBuffersInUse && OGL_IsActive())
+		glDeleteBuffers(NUMBER_OF_SKINNED_BUFFERS,SkinnedBufferIDs);
+	SkinnedBuffersInUse = false;
+	
 	// Don't forget the skins
 	OGL_SkinManager::Unload();
 }
 
+
+bool OGL_ModelData::CanSkin(int MaxBones)
+{
+	size_t NumVertices = Model.VtxSrcIndices.size();
+	return NumVertices > 0 &&
+		!Model.SeqFrames.empty() &&
+		Model.Bones.size() < size_t(MaxBones) &&
+		Model.NormSources.size() == 3*NumVertices;
+}
+
+
+void OGL_ModelData::UseSkinnedBuffers()
+{
+	if (SkinnedBuffersInUse)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER,SkinnedBufferIDs[SkinnedVertices]);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,SkinnedBufferIDs[SkinnedIndices]);
+		return;
+	}
+	
+	glGenBuffers(NUMBER_OF_SKINNED_BUFFERS,SkinnedBufferIDs);
+	SkinnedBuffersInUse = true;
+	
+	size_t NumVertices = Model.VtxSrcIndices.size();
+	size_t NumVtxSources = Model.VtxSources.size();
+	GLfloat RootBone = GLfloat(Model.Bones.size());
+	bool TxtrCoordsPresent = Model.TxtrCoords.size() >= 2*NumVertices;
+	bool TangentsPresent = Model.Tangents.size() >= NumVertices;
+	
+	vector<OGL_SkinnedVertex> Vertices(NumVertices);
+	for (size_t k=0; k<NumVertices; k++)
+	{
+		OGL_SkinnedVertex& Vertex = Vertices[k];
+		obj_clear(Vertex);
+		
+		size_t VSIndex = Model.VtxSrcIndices[k];
+		if (VSIndex < NumVtxSources)
+		{
+			Model3D_VertexSource& VS = Model.VtxSources[VSIndex];
+			objlist_copy(Vertex.Position,VS.Position,3);
+			if (VS.Bone0 >= 0)
+			{
+				Vertex.Bones[0] = Vertex.Bones[1] = VS.Bone0;
+				if (VS.Bone1 >= 0)
+				{
+					Vertex.Bones[1] = VS.Bone1;
+					Vertex.Bones[2] = VS.Blend;
+				}
+			}
+			else
+				Vertex.Bones[0] = Vertex.Bones[1] = RootBone;
+		}
+		else
+			Vertex.Bones[0] = Vertex.Bones[1] = RootBone;
+		
+		objlist_copy(Vertex.Normal,&Model.NormSources[3*k],3);
+		if (TxtrCoordsPresent)
+			objlist_copy(Vertex.TxtrCoord,&Model.TxtrCoords[2*k],2);
+		if (TangentsPresent)
+			objlist_copy(Vertex.Tangent,&Model.Tangents[k][0],4);
+	}
+	
+	glBindBuffer(GL_ARRAY_BUFFER,SkinnedBufferIDs[SkinnedVertices]);
+	glBufferData(GL_ARRAY_BUFFER,Vertices.size()*sizeof(OGL_SkinnedVertex),&Vertices[0],GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,SkinnedBufferIDs[SkinnedIndices]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER,Model.NumVI()*sizeof(GLushort),Model.VIBase(),GL_STATIC_DRAW);
+}
+
+
+void OGL_ModelData::Reset(bool Clear_OGL_Txtrs)
+{
+	if (SkinnedBuffersInUse && Clear_OGL_Txtrs)
+		glDeleteBuffers(NUMBER_OF_SKINNED_BUFFERS,SkinnedBufferIDs);
+	SkinnedBuffersInUse = false;
+	
+	OGL_SkinManager::Reset(Clear_OGL_Txtrs);
+}
+
 int OGL_CountModels(short Collection)
 {
 	return MdlList[Collection].size();
@@ -90,6 +90,19 @@ enum
 };
 
 
+// A model vertex as it is kept on the card for skinning in the vertex shader:
+// the neutral position, normal and tangent, and the two bones and their blend
+// (NONE as bone 0 is the assumed root bone, which is after the others)
+struct OGL_SkinnedVertex
+{
+	GLfloat Position[3];
+	GLfloat Normal[3];
+	GLfloat TxtrCoord[2];
+	GLfloat Tangent[4];
+	GLfloat Bones[3];
+};
+
+
 // Static 3D-Model Data and Options
 class OGL_ModelData: public OGL_SkinManager
 {
@@ -122,13 +135,33 @@ public:
 	Model3D Model;
 	bool ModelPresent() {return !Model.VertIndices.empty();}
 	
+	// Vertex (OGL_SkinnedVertex) and index buffers for drawing an animated model
+	// with its bones transformed in the vertex shader
+	enum
+	{
+		SkinnedVertices,
+		SkinnedIndices,
+		NUMBER_OF_SKINNED_BUFFERS
+	};
+	GLuint SkinnedBufferIDs[NUMBER_OF_SKINNED_BUFFERS];
+	bool SkinnedBuffersInUse;
+	
+	// Whether the model can be drawn that way with so many bone transforms
+	bool CanSkin(int MaxBones);
+	// Binds the buffers, filling them first if need be
+	void UseSkinnedBuffers();
+	
+	// Also releases the buffers
+	void Reset(bool Clear_OGL_Txtrs);
+	
 	// For convenience
 	void Load();
 	void Unload();
 	
 	OGL_ModelData():
 		Scale(1), XRot(0), YRot(0), ZRot(0), XShift(0), YShift(0), ZShift(0), Sidedness(1),
-			NormalType(1), NormalSplit(0.5), LightType(0), DepthType(0), ForceSpriteDepth(false) {}
+			NormalType(1), NormalSplit(0.5), LightType(0), DepthType(0), ForceSpriteDepth(false),
+			SkinnedBuffersInUse(false) {}
 };
 
 
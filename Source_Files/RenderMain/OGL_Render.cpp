@@ -49,6 +49,7 @@
 #include "player.h"
 #include "OGL_Render.h"
 #include "OGL_Textures.h"
+#include "OGL_TextureLoader.h"
 #include "OGL_Blitter.h"
 #include "AnimatedTextures.h"
 #include "Crosshairs.h"
@@ -60,6 +61,7 @@
 #include "Logging.h"
 #include "screen.h"
 #include "OGL_Shader.h"
+#include "overhead_map.h"
 
 #include <cmath>
 
@@ -79,6 +81,11 @@ static void PreloadWallTexture(const TextureWithTransferMode& inTexture);
 // Was OpenGL just inited? If so, then some state may need changing
 static bool JustInited = false;
 
+// How long a level start waits for replacement textures (in machine ticks),
+// and about how much of them gets installed per frame after that
+const uint32 kReplacementTextureHeadStart = 2 * MACHINE_TICKS_PER_SECOND;
+const size_t kReplacementTextureBytesPerFrame = 8 << 20;
+
 // The various boundary rectangles (all of the screen, and the view)
 static Rect SavedScreenBounds = {0,0,0,0};
 static Rect SavedViewBounds = {0,0,0,0};
@@ -520,6 +527,9 @@ bool OGL_StartRun()
 	// Reset the font info for OpenGL rendering
 	FontSpecifier::OGL_ResetFonts(true);
 	
+	// The map's buffers went with the old context
+	OGL_ResetMapGeometry();
+	
 	// Since an OpenGL context has just been created, don't try to clear any OpenGL textures
 	OGL_ResetModelSkins(false);
 
@@ -528,6 +538,16 @@ bool OGL_StartRun()
 	SetupShaders();
 	OGL_ProgressCallback(1);
 
+	// Give the replacement textures a head start behind the loading
+	// screen; whatever isn't ready by then streams in during play
+	uint32 texture_deadline = machine_tick_count() + kReplacementTextureHeadStart;
+	while (OGL_PendingTextureLoads() && static_cast<int32>(texture_deadline - machine_tick_count()) > 0)
+	{
+		OGL_WaitForTextureLoads(static_cast<int32>(texture_deadline - machine_tick_count()));
+		OGL_ProgressCallback(OGL_InstallLoadedTextures(SIZE_MAX));
+	}
+	OGL_ProgressCallback(OGL_InstallLoadedTextures(SIZE_MAX));
+
 	// Avoid lazy initial texture loading
 	PreloadTextures();
 	OGL_ProgressCallback(1);
@@ -721,6 +741,10 @@ bool OGL_SetWindow(Rect &ScreenBounds, Rect &ViewBounds, bool UseBackBuffer)
 bool OGL_StartMain()
 {
 	if (!OGL_IsActive()) return false;
+
+	// Pick up replacement textures that have finished loading; they are
+	// uploaded as they are first drawn, so this also bounds the uploads
+	OGL_InstallLoadedTextures(kReplacementTextureBytesPerFrame);
 	
 	// One-sidedness necessary for correct rendering
 	glEnable(GL_CULL_FACE);
@@ -45,6 +45,7 @@
 #include "OGL_LoadScreen.h"
 #include "progress.h"
 #include "InfoTree.h"
+#include "TextureCache.h"
 
 // Whether or not OpenGL is present and usable
 static bool _OGL_IsPresent = false;
@@ -199,7 +200,7 @@ void OGL_SetDefaults(OGL_ConfigureData& Data)
 	// Reasonable default flags
 	Data.Flags = OGL_Flag_Fader | OGL_Flag_Map |
 		OGL_Flag_HUD | OGL_Flag_LiqSeeThru | OGL_Flag_3D_Models | OGL_Flag_ZBuffer |
-		OGL_Flag_Fog | OGL_Flag_MimicSW;
+		OGL_Flag_Fog | OGL_Flag_MimicSW | OGL_Flag_TextureArrays;
 
         Data.AnisotropyLevel = 0.0; // off
 	Data.Multisamples = 0; // off
@@ -227,14 +228,15 @@ bool hasS3TC = false;
 
 void OGL_TextureOptionsBase::Load()
 {
-	FileSpecifier File;
+	// Check to see if loading needs to be done;
+	// it does not need to be if an image is present.
+	if (NormalImg.IsPresent()) return;
 
-	GLint maxTextureSize = glMaxTextureSize;
-	if (GetMaxSize())
-	{
-		maxTextureSize = MIN(maxTextureSize, GetMaxSize());
-	}
-	
+	LoadImages(GetLoadFlags(), GetLoadMaxSize());
+}
+
+int OGL_TextureOptionsBase::GetLoadFlags()
+{
 	int flags = npotTextures ? 0 : ImageLoader_ResizeToPowersOfTwo;
 		
 	if (Type >= 0 && Type < OGL_NUMBER_OF_TEXTURE_TYPES && Get_OGL_ConfigureData().TxtrConfigList[Type].FarFilter > 1 /* GL_LINEAR */)
@@ -247,12 +249,34 @@ void OGL_TextureOptionsBase::Load()
 		flags |= ImageLoader_CanUseDXTC;
 	}
 
-	// Load the normal image with alpha channel
+	return flags;
+}
 
-	// Check to see if loading needs to be done;
-	// it does not need to be if an image is present.
-	if (NormalImg.IsPresent()) return;
+int OGL_TextureOptionsBase::GetLoadMaxSize()
+{
+	GLint maxTextureSize = glMaxTextureSize;
+	if (GetMaxSize())
+	{
+		maxTextureSize = MIN(maxTextureSize, GetMaxSize());
+	}
+	return maxTextureSize;
+}
+
+void OGL_TextureOptionsBase::LoadImages(int flags, int maxTextureSize)
+{
+	bool LoadBump = TEST_FLAG(Get_OGL_ConfigureData().Flags, OGL_Flag_BumpMap);
 
+	// Everything that changes what gets loaded goes into the cache key
+	std::string CacheKey = std::to_string(flags) + " " + std::to_string(maxTextureSize) + " " +
+		std::to_string(NormalIsPremultiplied) + std::to_string(GlowIsPremultiplied) + std::to_string(LoadBump) + " " +
+		std::to_string(actual_width) + "x" + std::to_string(actual_height);
+	for (FileSpecifier* File : {&NormalColors, &NormalMask, &GlowColors, &GlowMask, &OffsetMap})
+		TextureCache::add_file_to_key(CacheKey, *File);
+
+	if (!GlowImg.IsPresent() && TextureCache::instance()->retrieve(CacheKey, NormalImg, GlowImg, OffsetImg))
+		return;
+
+	// Load the normal image with alpha channel
 	NormalImg.Clear();
 	
 	// Load the normal image if it has a filename specified for it
@@ -270,7 +294,7 @@ void OGL_TextureOptionsBase::Load()
 	}
 
 	// load a heightmap
-	if (TEST_FLAG(Get_OGL_ConfigureData().Flags, OGL_Flag_BumpMap) && OffsetMap != FileSpecifier() && OffsetMap.Exists()) {
+	if (LoadBump && OffsetMap != FileSpecifier() && OffsetMap.Exists()) {
 		if(!OffsetImg.LoadFromFile(OffsetMap, ImageLoader_Colors, flags | (NormalIsPremultiplied ? ImageLoader_ImageIsAlreadyPremultiplied : 0), actual_width, actual_height, maxTextureSize)) {
 			return;
 		}
@@ -343,6 +367,16 @@ void OGL_TextureOptionsBase::Load()
 		GlowImg.Clear();
 	}
 
+	// Build the mipmap chains here rather than at upload time
+	if (flags & ImageLoader_LoadMipMaps)
+	{
+		NormalImg.MakeMipMaps();
+		GlowImg.MakeMipMaps();
+		OffsetImg.MakeMipMaps();
+	}
+
+	if (NormalImg.IsPresent())
+		TextureCache::instance()->store(CacheKey, NormalImg, GlowImg, OffsetImg);
 }
 
 void OGL_TextureOptionsBase::Unload()
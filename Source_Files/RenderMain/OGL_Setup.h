@@ -193,6 +193,7 @@ enum
 	OGL_Flag_Blur		= 0x1000,   // Whether to blur landscapes and glowing textures
 	OGL_Flag_BumpMap	= 0x2000,   // Whether to use bump mapping
 	OGL_Flag_MimicSW    = 0x4000,   // Whether to mimic software perspective
+	OGL_Flag_TextureArrays = 0x8000, // Whether to share texture arrays among wall textures
 };
 
 struct OGL_ConfigureData
@@ -91,7 +91,8 @@ const char* Shader::_uniform_names[NUMBER_OF_UNIFORM_LOCATIONS] =
 	"logicalHeight",
 	"pixelWidth",
 	"pixelHeight",
-	"fogMode"
+	"fogMode",
+	"bones"
 };
 
 const char* Shader::_shader_names[NUMBER_OF_SHADER_TYPES] = 
@@ -117,7 +118,21 @@ const char* Shader::_shader_names[NUMBER_OF_SHADER_TYPES] =
 	"gamma",
 	"landscape_sphere",
 	"landscape_sphere_bloom",
-	"landscape_sphere_infravision"
+	"landscape_sphere_infravision",
+	"wall_array",
+	"wall_array_bloom",
+	"wall_array_infravision",
+	"bump_array",
+	"bump_array_bloom",
+	"invincible_skinned",
+	"invincible_skinned_bloom",
+	"invisible_skinned",
+	"invisible_skinned_bloom",
+	"wall_skinned",
+	"wall_skinned_bloom",
+	"wall_skinned_infravision",
+	"bump_skinned",
+	"bump_skinned_bloom"
 };
 
 
@@ -251,7 +266,7 @@ void Shader::unloadAll() {
 	}
 }
 
-Shader::Shader(const std::string& name) : _programObj(0), _passes(-1), _loaded(false) {
+Shader::Shader(const std::string& name) : _programObj(0), _passes(-1), _loaded(false), _builtIn(true) {
     initDefaultPrograms();
     if (defaultVertexPrograms.count(name) > 0) {
 	    _vert = defaultVertexPrograms[name];
@@ -265,12 +280,14 @@ Shader::Shader(const std::string& name, FileSpecifier& vert, FileSpecifier& frag
 	initDefaultPrograms();
 	
 	parseFile(vert,  _vert);
+	parseFile(frag, _frag);
+	_builtIn = _vert.empty() && _frag.empty();
+
 	if (_vert.empty() && defaultVertexPrograms.count(name) > 0) 
 	{
 		_vert = defaultVertexPrograms[name];
 	}
 	
-	parseFile(frag, _frag);
 	if (_frag.empty() && defaultFragmentPrograms.count(name) > 0) 
 	{
 		_frag = defaultFragmentPrograms[name];
@@ -351,6 +368,11 @@ void Shader::setMatrix4(UniformName name, float *f) {
 	glUniformMatrix4fvARB(getUniformLocation(name), 1, false, f);
 }
 
+void Shader::setVec4Array(UniformName name, int count, const float *f) {
+
+	glUniform4fvARB(getUniformLocation(name), count, f);
+}
+
 Shader::~Shader() {
 	unload();
 }
@@ -585,6 +607,36 @@ void initDefaultPrograms() {
 	defaultFragmentPrograms["landscape_sphere_infravision"] =
 		#include "Shaders/landscape_sphere_infravision.frag"
 	;
+
+	// the same wall programs, sampling a layer of a shared texture array
+	const char* wall_programs[][2] = {
+		{ "wall_array", "wall" },
+		{ "wall_array_bloom", "wall_bloom" },
+		{ "wall_array_infravision", "wall_infravision" },
+		{ "bump_array", "bump" },
+		{ "bump_array_bloom", "bump_bloom" }
+	};
+	for (auto& program : wall_programs) {
+		defaultVertexPrograms[program[0]] = defaultVertexPrograms[program[1]];
+		defaultFragmentPrograms[program[0]] = std::string("#define TEXTURE_ARRAY\n") + defaultFragmentPrograms[program[1]];
+	}
+
+	// the model programs, transforming the vertices by their bones
+	const char* model_programs[][2] = {
+		{ "invincible_skinned", "invincible" },
+		{ "invincible_skinned_bloom", "invincible_bloom" },
+		{ "invisible_skinned", "invisible" },
+		{ "invisible_skinned_bloom", "invisible_bloom" },
+		{ "wall_skinned", "wall" },
+		{ "wall_skinned_bloom", "wall_bloom" },
+		{ "wall_skinned_infravision", "wall_infravision" },
+		{ "bump_skinned", "bump" },
+		{ "bump_skinned_bloom", "bump_bloom" }
+	};
+	for (auto& program : model_programs) {
+		defaultVertexPrograms[program[0]] = "#define SKINNED\n#define MAX_BONES " + std::to_string(Shader::MAX_BONES) + "\n" + defaultVertexPrograms[program[1]];
+		defaultFragmentPrograms[program[0]] = defaultFragmentPrograms[program[1]];
+	}
 }
 
 #endif
@@ -74,9 +74,13 @@ public:
 		U_PixelWidth,
 		U_PixelHeight,
 		U_FogMode,
+		U_BoneTransforms,
 		NUMBER_OF_UNIFORM_LOCATIONS
 	};
 
+	// bone transforms a skinned program can hold, the root bone included
+	enum { MAX_BONES = 64 };
+
 	enum ShaderType {
 		S_Error,
         S_Blur,
@@ -100,6 +104,20 @@ public:
 		S_LandscapeSphere,
 		S_LandscapeSphereBloom,
 		S_LandscapeSphereInfravision,
+		S_WallArray,
+		S_WallArrayBloom,
+		S_WallArrayInfravision,
+		S_BumpArray,
+		S_BumpArrayBloom,
+		S_InvincibleSkinned,
+		S_InvincibleSkinnedBloom,
+		S_InvisibleSkinned,
+		S_InvisibleSkinnedBloom,
+		S_WallSkinned,
+		S_WallSkinnedBloom,
+		S_WallSkinnedInfravision,
+		S_BumpSkinned,
+		S_BumpSkinnedBloom,
 		NUMBER_OF_SHADER_TYPES
 	};
 private:
@@ -109,6 +127,7 @@ private:
 	std::string _frag;
 	int16 _passes;
 	bool _loaded;
+	bool _builtIn;
 
 	static const char* _shader_names[NUMBER_OF_SHADER_TYPES];
 	static std::vector<Shader> _shaders;
@@ -130,7 +149,7 @@ public:
 	static void loadAll();
 	static void unloadAll();
 	
-	Shader() : _programObj(0), _passes(-1), _loaded(false) {}
+	Shader() : _programObj(0), _passes(-1), _loaded(false), _builtIn(true) {}
 	Shader(const std::string& name);
 	Shader(const std::string& name, FileSpecifier& vert, FileSpecifier& frag, int16& passes);
 	~Shader();
@@ -141,9 +160,13 @@ public:
 	void unload();
 	void setFloat(UniformName name, float); // shader must be enabled
 	void setMatrix4(UniformName name, float *f);
+	void setVec4Array(UniformName name, int count, const float *f);
 
 	int16 passes();
 
+	// whether the default programs are in use rather than MML-supplied ones
+	bool builtIn() const { return _builtIn; }
+
 	static void disable();
 };
 
@@ -29,6 +29,7 @@
 
 #include "cseries.h"
 #include "OGL_Subst_Texture_Def.h"
+#include "OGL_TextureLoader.h"
 #include "Logging.h"
 #include "InfoTree.h"
 
@@ -49,6 +50,7 @@ static TOHash Collections[NUMBER_OF_COLLECTIONS];
 // Deletes a collection's texture-options sequences
 void TODelete(short Collection)
 {
+	OGL_CancelTextureLoads(Collection);
 	Collections[Collection].clear();
 }
 
@@ -65,20 +67,26 @@ int OGL_CountTextures(short Collection)
 
 extern void OGL_ProgressCallback(int);
 
+// The images are loaded in the background; progress is reported
+// as they are installed
 void OGL_LoadTextures(short Collection)
 {
+	OGL_CancelTextureLoads(Collection);
 
 	for (TOHash::iterator it = Collections[Collection].begin(); it != Collections[Collection].end(); ++it)
 	{
-		it->second.Load();
-		OGL_ProgressCallback(1);
-		
+		if (it->second.NormalImg.IsPresent())
+			OGL_ProgressCallback(1);
+		else
+			OGL_QueueTextureLoad(Collection, it->first.second, it->second);
 	}
 }
 
 
 void OGL_UnloadTextures(short Collection)
 {
+	OGL_CancelTextureLoads(Collection);
+
 	for (TOHash::iterator it = Collections[Collection].begin(); it != Collections[Collection].end(); ++it)
 	{
 		it->second.Unload();
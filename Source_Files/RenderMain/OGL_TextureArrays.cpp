@@ -0,0 +1,230 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+#include "cseries.h"
+#include "OGL_TextureArrays.h"
+
+#ifdef HAVE_OPENGL
+
+#include "ImageLoader.h"
+#include "OGL_Setup.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <vector>
+
+// Each array is sized to hold about this much level-0 image data;
+// textures too large for two layers are not worth sharing
+static const int kBytesPerArray = 16 * 1024 * 1024;
+static const GLint kMaxLayersPerArray = 256;
+
+struct TextureArray
+{
+	GLuint Texture;
+	std::vector<GLint> FreeLayers;
+};
+
+// All the arrays holding one size and format
+struct TextureArrayBucket
+{
+	GLsizei Width, Height;
+	GLenum InternalFormat;
+	GLint Levels;
+	GLint Layers;
+	std::vector<TextureArray> Arrays;
+};
+
+typedef std::tuple<GLsizei, GLsizei, GLenum, GLint> TextureArrayKey;
+
+static std::map<TextureArrayKey, TextureArrayBucket> Buckets;
+static std::map<GLuint, TextureArrayKey> ArrayKeys;
+
+static bool ArraysActive = false;
+static GLint MaxLayers = 0;
+
+void OGL_StartTextureArrays()
+{
+	OGL_StopTextureArrays();
+
+	ArraysActive = TEST_FLAG(Get_OGL_ConfigureData().Flags, OGL_Flag_TextureArrays) &&
+		OGL_CheckExtension("GL_EXT_texture_array");
+	if (ArraysActive)
+	{
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &MaxLayers);
+		MaxLayers = std::min(MaxLayers, kMaxLayersPerArray);
+		ArraysActive = (MaxLayers > 1);
+	}
+}
+
+void OGL_StopTextureArrays()
+{
+	for (auto& it : ArrayKeys)
+		glDeleteTextures(1, &it.first);
+
+	ArrayKeys.clear();
+	Buckets.clear();
+	ArraysActive = false;
+}
+
+bool OGL_TextureArraysActive()
+{
+	return ArraysActive;
+}
+
+static void CreateArray(TextureArrayBucket& Bucket, GLenum NearFilter, GLenum FarFilter)
+{
+	TextureArray Array;
+	glGenTextures(1, &Array.Texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, Array.Texture);
+
+	for (GLint Level = 0; Level < Bucket.Levels; Level++)
+	{
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, Level, Bucket.InternalFormat,
+			std::max(1, Bucket.Width >> Level), std::max(1, Bucket.Height >> Level), Bucket.Layers,
+			0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	}
+
+	// Same sampling as the walls' 2D textures get in PlaceTexture()
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, Bucket.Levels - 1);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, NearFilter);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, FarFilter);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+#if defined(GL_TEXTURE_MAX_ANISOTROPY_EXT)
+	float anisoLevel = Get_OGL_ConfigureData().AnisotropyLevel;
+	if (anisoLevel > 0.0) {
+		GLfloat max_aniso;
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso);
+		glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1.0F + ((anisoLevel-1.0F)/15.0F)*(max_aniso-1.0F));
+	}
+#endif
+
+	// Hand out the low layers first
+	for (GLint Layer = Bucket.Layers - 1; Layer >= 0; Layer--)
+		Array.FreeLayers.push_back(Layer);
+
+	ArrayKeys[Array.Texture] = TextureArrayKey(Bucket.Width, Bucket.Height, Bucket.InternalFormat, Bucket.Levels);
+	Bucket.Arrays.push_back(Array);
+}
+
+bool OGL_PlaceInTextureArray(const ImageDescriptor& Image, GLenum InternalFormat,
+	GLenum NearFilter, GLenum FarFilter, TextureArraySlot& Slot)
+{
+	if (!ArraysActive || !Image.IsPresent() || Image.GetFormat() != ImageDescriptor::RGBA8)
+		return false;
+
+	GLsizei Width = Image.GetWidth();
+	GLsizei Height = Image.GetHeight();
+	GLint Layers = std::min<GLint>(MaxLayers, kBytesPerArray / (Width * Height * 4));
+	if (Layers < 2)
+		return false;
+
+	bool Mipmapped = (FarFilter != GL_NEAREST && FarFilter != GL_LINEAR);
+	GLint Levels = 1;
+	if (Mipmapped)
+	{
+		while ((std::max(Width, Height) >> Levels) > 0)
+			Levels++;
+	}
+
+	TextureArrayKey Key(Width, Height, InternalFormat, Levels);
+	TextureArrayBucket& Bucket = Buckets[Key];
+	if (Bucket.Arrays.empty())
+	{
+		Bucket.Width = Width;
+		Bucket.Height = Height;
+		Bucket.InternalFormat = InternalFormat;
+		Bucket.Levels = Levels;
+		Bucket.Layers = Layers;
+	}
+
+	GLint PreviousBinding = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &PreviousBinding);
+
+	auto Array = std::find_if(Bucket.Arrays.begin(), Bucket.Arrays.end(),
+		[](const TextureArray& a) { return !a.FreeLayers.empty(); });
+	if (Array == Bucket.Arrays.end())
+	{
+		CreateArray(Bucket, NearFilter, FarFilter);
+		Array = Bucket.Arrays.end() - 1;
+	}
+	else
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, Array->Texture);
+	}
+
+	Slot.Texture = Array->Texture;
+	Slot.Layer = Array->FreeLayers.back();
+	Array->FreeLayers.pop_back();
+
+	// Use the image's own mipmaps where it has them
+	std::vector<uint32> Reduced[2];
+	const uint32* Pixels = Image.GetBuffer();
+	for (GLint Level = 0; Level < Levels; Level++)
+	{
+		if (Level > 0)
+		{
+			if (Level < Image.GetMipMapCount())
+			{
+				Pixels = Image.GetMipMapPtr(Level);
+			}
+			else
+			{
+				std::vector<uint32>& Dest = Reduced[Level & 1];
+				Dest.resize(std::max(1, Width >> Level) * std::max(1, Height >> Level));
+				ImageDescriptor::HalveRGBA(Pixels, std::max(1, Width >> (Level - 1)), std::max(1, Height >> (Level - 1)), Dest.data());
+				Pixels = Dest.data();
+			}
+		}
+
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, Level, 0, 0, Slot.Layer,
+			std::max(1, Width >> Level), std::max(1, Height >> Level), 1,
+			GL_RGBA, GL_UNSIGNED_BYTE, Pixels);
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, PreviousBinding);
+	return true;
+}
+
+void OGL_ReleaseTextureArraySlot(TextureArraySlot& Slot)
+{
+	if (!Slot.IsPresent())
+		return;
+
+	// The arrays may already be gone
+	auto Key = ArrayKeys.find(Slot.Texture);
+	if (Key != ArrayKeys.end())
+	{
+		for (auto& Array : Buckets[Key->second].Arrays)
+		{
+			if (Array.Texture == Slot.Texture)
+				Array.FreeLayers.push_back(Slot.Layer);
+		}
+	}
+
+	Slot = TextureArraySlot();
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef _OGL_TEXTURE_ARRAYS_H_
+#define _OGL_TEXTURE_ARRAYS_H_
+
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  OGL_TextureArrays.h - shared texture arrays for wall textures
+ *
+ *  Wall textures of the same size and format are placed as layers of a few
+ *  GL_TEXTURE_2D_ARRAY objects, so the shader renderer can draw surfaces
+ *  with different textures out of one binding. Only plain RGBA8 images are
+ *  placed; anything else keeps a 2D texture of its own.
+ */
+
+#include "OGL_Headers.h"
+
+#ifdef HAVE_OPENGL
+
+class ImageDescriptor;
+
+// Where a texture lives in the arrays
+struct TextureArraySlot
+{
+	GLuint Texture;
+	GLint Layer;
+
+	TextureArraySlot() : Texture(0), Layer(-1) {}
+	bool IsPresent() const {return Texture != 0;}
+};
+
+// Called from OGL_StartTextures() and OGL_StopTextures()
+void OGL_StartTextureArrays();
+void OGL_StopTextureArrays();
+
+// Whether the preference is on and the driver supports texture arrays
+bool OGL_TextureArraysActive();
+
+// Copies an image and its mipmaps into a free layer of an array with its
+// dimensions and format; returns false if the image was not placed.
+// Leaves the texture-array binding of the active texture unit as it was.
+bool OGL_PlaceInTextureArray(const ImageDescriptor& Image, GLenum InternalFormat,
+	GLenum NearFilter, GLenum FarFilter, TextureArraySlot& Slot);
+
+// Hands the slot's layer back for reuse
+void OGL_ReleaseTextureArraySlot(TextureArraySlot& Slot);
+
+#endif
+
+#endif
@@ -0,0 +1,250 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+#include "cseries.h"
+#include "OGL_TextureLoader.h"
+
+#ifdef HAVE_OPENGL
+
+#include "Logging.h"
+#include "OGL_Textures.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Decoding is mostly file and memory bound; more threads than this
+// mostly fight over the disk
+static constexpr int kMaximumLoaderThreads = 4;
+
+struct TextureLoadJob
+{
+	short Collection;
+	short Bitmap;
+	uint32 Generation;
+
+	int Flags;
+	int MaxSize;
+
+	// Only touched on the main thread
+	OGL_TextureOptions* Target;
+
+	// A copy of the target's file names, which the images are loaded into
+	OGL_TextureOptionsBase Loaded;
+
+	TextureLoadJob(OGL_TextureOptions& Options) : Target(&Options), Loaded(Options) {}
+
+	size_t Bytes() const {
+		return Loaded.NormalImg.GetTotalBytes() + Loaded.GlowImg.GetTotalBytes() + Loaded.OffsetImg.GetTotalBytes();
+	}
+};
+
+class texture_loader
+{
+public:
+	~texture_loader();
+
+	void queue(std::unique_ptr<TextureLoadJob> job);
+	void cancel(short collection);
+	int pending();
+	bool wait(int timeout);
+	int install(size_t max_bytes);
+
+private:
+	void worker();
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable work, done;
+
+	std::deque<std::unique_ptr<TextureLoadJob>> queued;
+	std::deque<std::unique_ptr<TextureLoadJob>> finished;
+	int running = 0;
+
+	// Bumped to cancel all of a collection's loads at once
+	uint32 generations[NUMBER_OF_COLLECTIONS] = {};
+	bool quit = false;
+};
+
+static texture_loader loader;
+
+texture_loader::~texture_loader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queued.clear();
+		quit = true;
+	}
+	work.notify_all();
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void texture_loader::queue(std::unique_ptr<TextureLoadJob> job)
+{
+	if (threads.empty())
+	{
+		int count = std::thread::hardware_concurrency();
+		count = std::max(1, std::min(count - 1, kMaximumLoaderThreads));
+		for (int i = 0; i < count; ++i)
+			threads.emplace_back(&texture_loader::worker, this);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job->Generation = generations[job->Collection];
+		queued.push_back(std::move(job));
+	}
+	work.notify_one();
+}
+
+void texture_loader::cancel(short collection)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	++generations[collection];
+	queued.erase(std::remove_if(queued.begin(), queued.end(), [collection](const std::unique_ptr<TextureLoadJob>& job) {
+		return job->Collection == collection;
+	}), queued.end());
+}
+
+int texture_loader::pending()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return static_cast<int>(queued.size()) + running;
+}
+
+bool texture_loader::wait(int timeout)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait_for(lock, std::chrono::milliseconds(timeout), [this] {
+		return !finished.empty() || (queued.empty() && running == 0);
+	});
+	return !finished.empty();
+}
+
+int texture_loader::install(size_t max_bytes)
+{
+	std::vector<std::unique_ptr<TextureLoadJob>> jobs;
+	uint32 current[NUMBER_OF_COLLECTIONS];
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		size_t bytes = 0;
+		while (!finished.empty() && (jobs.empty() || bytes < max_bytes))
+		{
+			bytes += finished.front()->Bytes();
+			jobs.push_back(std::move(finished.front()));
+			finished.pop_front();
+		}
+		std::copy(generations, generations + NUMBER_OF_COLLECTIONS, current);
+	}
+
+	for (auto& job : jobs)
+	{
+		if (job->Generation != current[job->Collection])
+			continue;
+
+		// The options may have been reparsed since the load was queued
+		OGL_TextureOptions& Options = *job->Target;
+		if (Options.NormalImg.IsPresent() || Options.NormalColors != job->Loaded.NormalColors)
+			continue;
+
+		Options.NormalImg.Swap(job->Loaded.NormalImg);
+		Options.GlowImg.Swap(job->Loaded.GlowImg);
+		Options.OffsetImg.Swap(job->Loaded.OffsetImg);
+
+		// Drop whatever was made from the shapes file in the meantime
+		OGL_ResetTextureStates(job->Collection, job->Bitmap);
+	}
+
+	return static_cast<int>(jobs.size());
+}
+
+void texture_loader::worker()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		work.wait(lock, [this] { return quit || !queued.empty(); });
+		if (quit)
+			return;
+
+		std::unique_ptr<TextureLoadJob> job = std::move(queued.front());
+		queued.pop_front();
+		++running;
+		lock.unlock();
+
+		try
+		{
+			job->Loaded.LoadImages(job->Flags, job->MaxSize);
+		}
+		catch (const std::exception& e)
+		{
+			logWarning("Couldn't load replacement texture %s: %s", job->Loaded.NormalColors.GetPath(), e.what());
+			job->Loaded.Unload();
+		}
+
+		lock.lock();
+		--running;
+		finished.push_back(std::move(job));
+		done.notify_all();
+	}
+}
+
+void OGL_QueueTextureLoad(short Collection, short Bitmap, OGL_TextureOptions& Options)
+{
+	auto job = std::make_unique<TextureLoadJob>(Options);
+	job->Collection = Collection;
+	job->Bitmap = Bitmap;
+	job->Flags = Options.GetLoadFlags();
+	job->MaxSize = Options.GetLoadMaxSize();
+	loader.queue(std::move(job));
+}
+
+void OGL_CancelTextureLoads(short Collection)
+{
+	loader.cancel(Collection);
+}
+
+int OGL_PendingTextureLoads()
+{
+	return loader.pending();
+}
+
+bool OGL_WaitForTextureLoads(int Timeout)
+{
+	return loader.wait(Timeout);
+}
+
+int OGL_InstallLoadedTextures(size_t MaxBytes)
+{
+	return loader.install(MaxBytes);
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef _OGL_TEXTURE_LOADER_H_
+#define _OGL_TEXTURE_LOADER_H_
+
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  OGL_TextureLoader.h - replacement textures decoded on loader threads
+ *
+ *  Decoding, downsizing and mipmap generation of wall and sprite
+ *  replacements run on a few worker threads. Finished images are handed to
+ *  their texture options between frames, a few megabytes at a time; until
+ *  then a texture is drawn from the shapes file as usual.
+ */
+
+#include "OGL_Subst_Texture_Def.h"
+
+#include <stddef.h>
+
+#ifdef HAVE_OPENGL
+
+// Loads the images of these options in the background;
+// the options must outlive the load or have it cancelled
+void OGL_QueueTextureLoad(short Collection, short Bitmap, OGL_TextureOptions& Options);
+
+// Forgets a collection's loads; ones already running are discarded when done
+void OGL_CancelTextureLoads(short Collection);
+
+// How many loads have not finished yet
+int OGL_PendingTextureLoads();
+
+// Waits up to Timeout milliseconds for a load to finish;
+// returns whether any finished load is waiting to be installed
+bool OGL_WaitForTextureLoads(int Timeout);
+
+// Installs finished loads until about MaxBytes of images have been
+// installed (at least one); returns how many loads were used up
+int OGL_InstallLoadedTextures(size_t MaxBytes);
+
+#endif
+
+#endif
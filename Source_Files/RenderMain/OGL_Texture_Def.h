@@ -147,6 +147,13 @@ struct OGL_TextureOptionsBase
 	void Load();
 	void Unload();
 
+	// Load() in two parts: the flags and size limit come from the OpenGL
+	// context, and the loading proper needs no context, so it can run
+	// on a loader thread (on a copy of these options)
+	int GetLoadFlags();
+	int GetLoadMaxSize();
+	void LoadImages(int flags, int maxTextureSize);
+
 	virtual int GetMaxSize();
 	
 	OGL_TextureOptionsBase():
@@ -139,6 +139,13 @@ bool TextureState::Use(int Which)
 	return result;
 }
 
+// Use the array layer that the normal texture had been placed in
+void TextureState::UseArray()
+{
+	glBindTexture(GL_TEXTURE_2D_ARRAY,ArraySlot.Texture);
+	IDUsage[Normal]++;
+}
+
 
 // Resets the object's texture state
 void TextureState::Reset()
@@ -149,6 +156,7 @@ void TextureState::Reset()
 		gGLTxStats.inUse--;
 		glDeleteTextures(NUMBER_OF_TEXTURES,IDs);
 	}
+	OGL_ReleaseTextureArraySlot(ArraySlot);
 	IsUsed = IsGlowing = IsBumped = TexGened[Normal] = TexGened[Glowing] = TexGened[Bump] = false;
 	IDUsage[Normal] = IDUsage[Glowing] = IDUsage[Bump] = unusedFrames = 0;
 }
@@ -310,6 +318,8 @@ void OGL_StartTextures()
 #if defined GL_SGIS_generate_mipmap
 	useSGISMipmaps = OGL_CheckExtension("GL_SGIS_generate_mipmap");
 #endif
+
+	OGL_StartTextureArrays();
 }
 
 
@@ -321,6 +331,8 @@ void OGL_StopTextures()
 		for (int ic=0; ic<MAXIMUM_COLLECTIONS; ic++)
 			if (TextureStateSets[it][ic]) delete []TextureStateSets[it][ic];
 
+	OGL_StopTextureArrays();
+
 	// clear blitters and fonts
 	OGL_Blitter::StopTextures();
 	FontSpecifier::OGL_ResetFonts(false);
@@ -451,6 +463,12 @@ bool TextureManager::Setup()
 	// If "Use()" is true, then load, otherwise, assume the texture is loaded and skip
 	TxtrStatePtr = &CBTS.CTStates[CTable];
 	TextureState &CTState = *TxtrStatePtr;
+
+	// Shared arrays keep no copy of the image, so reload it for a caller
+	// that wants an ordinary texture
+	if (CTState.ArraySlot.IsPresent() && !UseTextureArray)
+		CTState.Reset();
+
 	if (!CTState.IsUsed)
 	{
 		// Initial sprite scale/offset
@@ -528,6 +546,9 @@ bool TextureManager::Setup()
 				if (!OffsetImage.edit()->Minify()) break;
 			}			
 		}
+
+		if (UseTextureArray)
+			PlaceInTextureArray();
 		
 		// Kludge for making top and bottom look flat
 		/*
@@ -1357,6 +1378,21 @@ void TextureManager::PlaceTexture(const ImageDescriptor *Image, bool normal_map)
 	}
 }
 
+// Only opaque-format wall textures without glow or bump maps are shared,
+// since glow and bump maps are bound alongside their texture
+void TextureManager::PlaceInTextureArray()
+{
+	TxtrTypeInfoData& TxtrTypeInfo = TxtrTypeInfoList[TextureType];
+
+	if (TextureType != OGL_Txtr_Wall || IsGlowing || TxtrStatePtr->IsBumped ||
+		TxtrTypeInfo.ColorFormat != GL_RGBA8 || !OGL_TextureArraysActive())
+		return;
+
+	GLenum internalFormat = Wanting_sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+	if (OGL_PlaceInTextureArray(*NormalImage.get(), internalFormat, TxtrTypeInfo.NearFilter, TxtrTypeInfo.FarFilter, TxtrStatePtr->ArraySlot))
+		TxtrStatePtr->Allocate(TextureType);
+}
+
 // What to render:
 
 // Always call this one and call it first; safe to allocate texture ID's in it
@@ -1365,6 +1401,13 @@ void TextureManager::RenderNormal()
 
 
 	TxtrStatePtr->Allocate(TextureType);
+
+	if (TxtrStatePtr->ArraySlot.IsPresent())
+	{
+		TxtrStatePtr->UseArray();
+		gGLTxStats.binds++;
+		return;
+	}
 	
 	if (TxtrStatePtr->UseNormal())
 	{
@@ -1490,6 +1533,7 @@ TextureManager::TextureManager()
 	TxtrOptsPtr = 0;
 
 	FastPath = 0;
+	UseTextureArray = false;
 	
 	LowLevelShape = 0;
 	
@@ -1537,6 +1581,26 @@ void OGL_ResetTextures()
 
 	glDeleteTextures(1, &flatBumpTextureID);
 	flatBumpTextureID = 0;
+
+	// Start the arrays over, picking up a change of preference
+	OGL_StartTextureArrays();
+}
+
+
+void OGL_ResetTextureStates(short Collection, short Bitmap)
+{
+	if (!OGL_IsActive()) return;
+	if (!is_collection_present(Collection) || Bitmap >= get_number_of_collection_bitmaps(Collection)) return;
+
+	for (int it=0; it<OGL_NUMBER_OF_TEXTURE_TYPES; it++)
+	{
+		CollBitmapTextureState *CBTSSet = TextureStateSets[it][Collection];
+		if (!CBTSSet) continue;
+
+		TextureState *TSSet = CBTSSet[Bitmap].CTStates;
+		for (int ist=0; ist<NUMBER_OF_OPENGL_BITMAP_SETS; ist++)
+			TSSet[ist].Reset();
+	}
 }
 
 
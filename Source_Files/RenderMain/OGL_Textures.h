@@ -31,6 +31,7 @@
 
 #include "OGL_Headers.h"
 #include "OGL_Subst_Texture_Def.h"
+#include "OGL_TextureArrays.h"
 #include "scottish_textures.h"
 
 #ifdef HAVE_OPENGL
@@ -55,6 +56,9 @@ void OGL_StopTextures();
 // Call this after every frame for housekeeping stuff
 void OGL_FrameTickTextures();
 
+// Reset all the states of one bitmap, as when its replacement has changed
+void OGL_ResetTextureStates(short Collection, short Bitmap);
+
 // State of an individual texture set:
 struct TextureState
 {
@@ -74,6 +78,7 @@ struct TextureState
 	int IDUsage[NUMBER_OF_TEXTURES];	// Which ID's are being used?  Reset every frame.
 	int unusedFrames;					// How many frames have passed since we were last used.
 	short TextureType;
+	TextureArraySlot ArraySlot;			// Where the normal texture went if it is in a shared array
     
     GLdouble U_Scale;
     GLdouble V_Scale;
@@ -91,6 +96,7 @@ struct TextureState
 	bool UseNormal() {return Use(Normal);}
 	bool UseGlowing() {return Use(Glowing);}
 	bool UseBump() {return Use(Bump);}
+	void UseArray();
 	
 	void FrameTick();
 	
@@ -202,6 +208,9 @@ class TextureManager
 	// This is for placing a texture in OpenGL
 	void PlaceTexture(const ImageDescriptor *, bool normal_map = false);
 
+	// This tries placing a freshly-loaded wall texture in a shared texture array
+	void PlaceInTextureArray();
+
 public:
 
 	// Inputs: get off of texture object passed to scottish_textures.
@@ -216,6 +225,10 @@ public:
 	bool LandscapeVertRepeat;
 
 	bool FastPath;
+
+	// Whether a plain wall texture may go into a shared texture array;
+	// only for callers whose shaders can sample one
+	bool UseTextureArray;
 	
 	// The width of a landscape texture will be 2^(-Landscape_AspRatExp) * (the height)
 	short Landscape_AspRatExp;
@@ -247,6 +260,13 @@ public:
 	float GlowBloomShift() {return (TxtrOptsPtr->GlowBloomShift);}
 	float LandscapeBloom() {return (TxtrOptsPtr->LandscapeBloom);}
 	int TileRatio() { return (1 << TxtrOptsPtr->TileRatioExp); }
+	bool IsSubstituted() {return (TxtrOptsPtr->Substitution);}
+
+	// Whether RenderNormal() binds a layer of a shared texture array
+	// rather than a 2D texture, and which one
+	bool InTextureArray() {return (TxtrStatePtr && TxtrStatePtr->ArraySlot.IsPresent());}
+	GLuint GetTextureArray() {return TxtrStatePtr->ArraySlot.Texture;}
+	GLint GetTextureArrayLayer() {return TxtrStatePtr->ArraySlot.Layer;}
 	
 	// Scaling and offset of the current texture;
 	// important for sprites, which will be padded to make them OpenGL-friendly.
@@ -0,0 +1,228 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  Rasterizer_SW.cpp - threaded playback for the software rasterizer
+ *
+ *  The texture mappers draw each screen row from the rendering calls alone,
+ *  so a frame can be split into horizontal bands drawn in parallel, each
+ *  thread playing back every call in order but writing only its own rows.
+ *  Static is the exception: its random seed runs across the whole frame,
+ *  so every band steps through all of it.
+ */
+
+#include "cseries.h"
+#include "Rasterizer_SW.h"
+#include "low_level_textures.h"
+#include "preferences.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// bands thinner than this cost more to set up than they save
+static constexpr int kMinimumBandHeight = 32;
+static constexpr int kMaximumBands = 16;
+
+class band_threads
+{
+public:
+	~band_threads();
+
+	// runs job(0) .. job(count-1), the last one on the calling thread, and
+	// returns once they have all finished
+	void run(int count, const std::function<void(int)>& job);
+
+private:
+	void worker(int band, uint32 generation);
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable start, done;
+
+	const std::function<void(int)>* current_job = nullptr;
+	int band_count = 0;
+	int pending = 0;
+	uint32 generation = 0;
+	bool quit = false;
+};
+
+static band_threads rendering_threads;
+
+band_threads::~band_threads()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	start.notify_all();
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void band_threads::run(int count, const std::function<void(int)>& job)
+{
+	while (static_cast<int>(threads.size()) < count - 1)
+		threads.emplace_back(&band_threads::worker, this, static_cast<int>(threads.size()), generation);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		current_job = &job;
+		band_count = count;
+		pending = count - 1;
+		++generation;
+	}
+	start.notify_all();
+
+	job(count - 1);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return pending == 0; });
+	current_job = nullptr;
+}
+
+void band_threads::worker(int band, uint32 seen)
+{
+	allocate_texture_tables();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		start.wait(lock, [this, seen] { return quit || generation != seen; });
+		if (quit)
+			return;
+
+		seen = generation;
+		if (band >= band_count - 1)
+			continue;
+
+		const std::function<void(int)>* job = current_job;
+		lock.unlock();
+		(*job)(band);
+		lock.lock();
+
+		if (--pending == 0)
+			done.notify_one();
+	}
+}
+
+Rasterizer_SW_Class::Rasterizer_SW_Class() :
+	view(nullptr), screen(nullptr), band_y0(0), band_y1(SHRT_MAX), band_count(1)
+{
+}
+
+void Rasterizer_SW_Class::Begin()
+{
+	int threads = graphics_preferences->software_rendering_threads;
+	if (threads <= 0)
+		threads = std::thread::hardware_concurrency();
+
+	threads = MIN(threads, kMaximumBands);
+	threads = MIN(threads, screen->height / kMinimumBandHeight);
+	band_count = MAX(threads, 1);
+}
+
+void Rasterizer_SW_Class::End()
+{
+	if (band_count > 1)
+	{
+		uint16 seed = texture_random_seed();
+
+		rendering_threads.run(band_count, [this, seed](int band) {
+			Rasterizer_SW_Class rasterizer;
+			rasterizer.view = view;
+			rasterizer.screen = screen;
+			rasterizer.band_y0 = screen->height * band / band_count;
+			rasterizer.band_y1 = screen->height * (band + 1) / band_count;
+
+			texture_random_seed() = seed;
+
+			for (const auto& command : commands)
+			{
+				switch (command.type)
+				{
+					case _horizontal_polygon_command:
+						rasterizer.draw_horizontal_polygon(polygons[command.index]);
+						break;
+
+					case _vertical_polygon_command:
+						rasterizer.draw_vertical_polygon(polygons[command.index]);
+						break;
+
+					case _rectangle_command:
+					{
+						// clipping is done in place
+						rectangle_definition rectangle = rectangles[command.index];
+						rasterizer.draw_rectangle(rectangle);
+						break;
+					}
+				}
+			}
+		});
+
+		// the last band was drawn on this thread, so its seed is already where
+		// drawing directly would have left it
+
+		commands.clear();
+		polygons.clear();
+		rectangles.clear();
+	}
+
+	band_count = 1;
+}
+
+void Rasterizer_SW_Class::texture_horizontal_polygon(polygon_definition& textured_polygon)
+{
+	if (band_count > 1)
+	{
+		commands.push_back({ _horizontal_polygon_command, static_cast<int32>(polygons.size()) });
+		polygons.push_back(textured_polygon);
+	}
+	else
+		draw_horizontal_polygon(textured_polygon);
+}
+
+void Rasterizer_SW_Class::texture_vertical_polygon(polygon_definition& textured_polygon)
+{
+	if (band_count > 1)
+	{
+		commands.push_back({ _vertical_polygon_command, static_cast<int32>(polygons.size()) });
+		polygons.push_back(textured_polygon);
+	}
+	else
+		draw_vertical_polygon(textured_polygon);
+}
+
+void Rasterizer_SW_Class::texture_rectangle(rectangle_definition& textured_rectangle)
+{
+	if (band_count > 1)
+	{
+		commands.push_back({ _rectangle_command, static_cast<int32>(rectangles.size()) });
+		rectangles.push_back(textured_rectangle);
+	}
+	else
+		draw_rectangle(textured_rectangle);
+}
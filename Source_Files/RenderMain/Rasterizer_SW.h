@@ -27,11 +27,15 @@
 
 #include "Rasterizer.h"
 
+#include <vector>
+
 
 class Rasterizer_SW_Class: public RasterizerClass
 {
 public:
 
+	Rasterizer_SW_Class();
+
 	// Pointers to stuff used in scottish_textures:
 	view_data *view;
 	// Calling this one "screen" for scottish_textures convenience:
@@ -41,14 +45,49 @@ public:
 	// be sure to call it before doing any rendering
 	void SetView(view_data& View) {view = &View;}
 	
+	// With more than one rendering thread, Begin() starts recording the
+	// rendering calls and End() plays them back, each thread drawing its
+	// own band of screen rows; the result is the same as drawing directly
+	void Begin();
+	void End();
+	
 	// Rendering calls
-	// These are defined in scottish_textures.c (too great a name to change)
 	
 	void texture_horizontal_polygon(polygon_definition& textured_polygon);
 	
 	void texture_vertical_polygon(polygon_definition& textured_polygon);
 	
 	void texture_rectangle(rectangle_definition& textured_rectangle);
+
+private:
+
+	// Only screen rows in [band_y0, band_y1) are drawn
+	short band_y0, band_y1;
+	
+	// These are defined in scottish_textures.c (too great a name to change)
+	
+	void draw_horizontal_polygon(polygon_definition& textured_polygon);
+	
+	void draw_vertical_polygon(polygon_definition& textured_polygon);
+	
+	void draw_rectangle(rectangle_definition& textured_rectangle);
+	
+	enum {
+		_horizontal_polygon_command,
+		_vertical_polygon_command,
+		_rectangle_command
+	};
+	
+	struct command {
+		int16 type;
+		int32 index; // into polygons or rectangles
+	};
+	
+	// Bands drawn at End(); 1 when drawing directly
+	int16 band_count;
+	std::vector<command> commands;
+	std::vector<polygon_definition> polygons;
+	std::vector<rectangle_definition> rectangles;
 };
 
 
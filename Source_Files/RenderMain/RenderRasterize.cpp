@@ -206,6 +206,7 @@ void RenderRasterizerClass::render_node(
 					if (surface.p0 == surface.p1)
 						continue; // skip sides that are degenerate, as produced by store_endpoint()
 					
+					surface.side_index= side_index;
 					surface.ambient_delta= side->ambient_delta;
 					
 					// LP change: indicate in all cases whether the void is on the other side;
@@ -71,6 +71,7 @@ struct vertical_surface_data
 	// LP change: made this more long-distance friendly
 	long_vector2d p0, p1; /* will transform into left, right points on the screen (respectively) */
 	
+	short side_index;
 	struct side_texture_definition *texture_definition;
 	short transfer_mode;
 };
@@ -24,7 +24,10 @@
 
 #include "OGL_Headers.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
+#include <vector>
 
 #include "RenderRasterize_Shader.h"
 
@@ -103,6 +106,300 @@ public:
 	}
 };
 
+struct SurfaceVertex {
+	GLfloat position[3];
+	GLfloat texcoord[3];	// the third is the layer when drawing from a texture array
+	GLfloat normal[3];
+	GLfloat tangent[4];
+};
+
+// Every floor, ceiling, liquid surface and wall section of the level has a
+// fixed slot in one vertex buffer that stays on the card. Each slot remembers
+// what its vertices were built from; only when a platform, liquid, Lua script
+// or scrolling texture changes that is the slot rebuilt and sent again, so a
+// static scene costs a comparison per visible surface.
+class LevelGeometry {
+
+public:
+
+	enum {
+		_ceiling_slot,
+		_floor_slot,
+		_media_slot,
+		NUMBER_OF_HORIZONTAL_SLOTS
+	};
+
+	enum {
+		_primary_slot,
+		_secondary_slot,
+		_transparent_slot,
+		NUMBER_OF_SIDE_SLOTS
+	};
+
+	// horizontal surfaces: height, facing, origin, transfer offset, scale;
+	// sides: top, bottom, texture top, texture offset, transfer offset, scale;
+	// both: texture array layer
+	struct Source {
+		int32 heights[3];
+		int32 origin[2];
+		int32 transfer[2];
+		float scale;
+		int32 layer;
+
+		bool operator==(const Source& other) const {
+			return heights[0] == other.heights[0] && heights[1] == other.heights[1] && heights[2] == other.heights[2] &&
+				origin[0] == other.origin[0] && origin[1] == other.origin[1] &&
+				transfer[0] == other.transfer[0] && transfer[1] == other.transfer[1] &&
+				scale == other.scale && layer == other.layer;
+		}
+	};
+
+	LevelGeometry() : _buffer(0), _checksum(0), _level(NONE), _polygon_count(0), _side_count(0), _side_slots(0) {}
+
+	~LevelGeometry() {
+		if (_buffer) {
+			glDeleteBuffers(1, &_buffer);
+		}
+	}
+
+	// lays the slots out again when a different level is up
+	void prepare() {
+		uint32 checksum = get_current_map_checksum();
+		if (_buffer && checksum == _checksum && dynamic_world->current_level_number == _level &&
+			dynamic_world->polygon_count == _polygon_count && dynamic_world->side_count == _side_count)
+			return;
+
+		_checksum = checksum;
+		_level = dynamic_world->current_level_number;
+		_polygon_count = dynamic_world->polygon_count;
+		_side_count = dynamic_world->side_count;
+		_side_slots = _polygon_count * NUMBER_OF_HORIZONTAL_SLOTS;
+
+		_slot_first.clear();
+		GLuint vertex_count = 0;
+		for (short i = 0; i < _polygon_count; ++i) {
+			for (int j = 0; j < NUMBER_OF_HORIZONTAL_SLOTS; ++j) {
+				_slot_first.push_back(vertex_count);
+				vertex_count += get_polygon_data(i)->vertex_count;
+			}
+		}
+		for (int i = 0; i < _side_count * NUMBER_OF_SIDE_SLOTS; ++i) {
+			_slot_first.push_back(vertex_count);
+			vertex_count += 4;
+		}
+
+		_vertices.assign(vertex_count, SurfaceVertex());
+		_sources.assign(_slot_first.size(), Source());
+		_valid.assign(_slot_first.size(), false);
+		_pending.assign(_slot_first.size(), false);
+		_dirty.clear();
+
+		if (!_buffer) {
+			glGenBuffers(1, &_buffer);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+		glBufferData(GL_ARRAY_BUFFER, std::max<size_t>(_vertices.size(), 1) * sizeof(SurfaceVertex), NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	int horizontal_slot(short polygon_index, int surface) const { return polygon_index * NUMBER_OF_HORIZONTAL_SLOTS + surface; }
+	int side_slot(short side_index, int surface) const { return _side_slots + side_index * NUMBER_OF_SIDE_SLOTS + surface; }
+
+	GLuint first_vertex(int slot) const { return _slot_first[slot]; }
+
+	bool current(int slot, const Source& source) const { return _valid[slot] && _sources[slot] == source; }
+
+	// the new vertices reach the card with the next bind()
+	void patch(int slot, const Source& source, const SurfaceVertex* vertices, int count) {
+		std::copy(vertices, vertices + count, _vertices.begin() + _slot_first[slot]);
+		_sources[slot] = source;
+		_valid[slot] = true;
+		if (!_pending[slot]) {
+			_pending[slot] = true;
+			_dirty.push_back(slot);
+		}
+	}
+
+	void bind() {
+		glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+		for (int slot : _dirty) {
+			GLuint first = _slot_first[slot];
+			GLuint last = (slot + 1 < static_cast<int>(_slot_first.size())) ? _slot_first[slot + 1] : static_cast<GLuint>(_vertices.size());
+			glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(SurfaceVertex), (last - first) * sizeof(SurfaceVertex), &_vertices[first]);
+			_pending[slot] = false;
+		}
+		_dirty.clear();
+	}
+
+private:
+	GLuint _buffer;
+
+	uint32 _checksum;
+	int16 _level;
+	int16 _polygon_count;
+	int16 _side_count;
+	int _side_slots;
+
+	std::vector<SurfaceVertex> _vertices;
+	std::vector<GLuint> _slot_first;
+	std::vector<Source> _sources;
+	std::vector<bool> _valid;
+	std::vector<bool> _pending;
+	std::vector<int> _dirty;
+};
+
+// Consecutive walls, floors and ceilings that would be drawn with identical
+// state (texture, transfer mode, light, clipping window...) are collected
+// here and drawn with one indexed call out of the level's vertex buffer.
+// Nothing is reordered, so painter's order -- and with it blending of
+// semitransparent surfaces -- is exactly what it was drawing them one by one.
+class SurfaceBatch {
+
+public:
+
+	struct Key {
+		shape_descriptor texture;
+		short transfer_mode;
+		float intensity;
+		float offset;
+		bool side;
+		bool void_present;
+		long_vector2d left;
+		long_vector2d right;
+
+		// see use_material()
+		GLuint texture_array;
+		short blend;
+		bool substituted;
+		float bloom_scale;
+		float bloom_shift;
+
+		bool operator==(const Key& other) const {
+			return texture == other.texture &&
+				transfer_mode == other.transfer_mode &&
+				intensity == other.intensity &&
+				offset == other.offset &&
+				side == other.side &&
+				void_present == other.void_present &&
+				left.i == other.left.i && left.j == other.left.j &&
+				right.i == other.right.i && right.j == other.right.j &&
+				texture_array == other.texture_array &&
+				blend == other.blend &&
+				substituted == other.substituted &&
+				bloom_scale == other.bloom_scale &&
+				bloom_shift == other.bloom_shift;
+		}
+
+		// A texture in a shared array is told apart by what it draws with
+		// rather than by its shape, so the other textures in the array
+		// can join its batch
+		void use_material(TextureManager& TMgr) {
+			if (!TMgr.InTextureArray())
+				return;
+
+			texture = UNONE;
+			texture_array = TMgr.GetTextureArray();
+			blend = TMgr.IsBlended() ? TMgr.NormalBlend() : NONE;
+			substituted = TMgr.IsSubstituted();
+			bloom_scale = TMgr.BloomScale();
+			bloom_shift = TMgr.BloomShift();
+		}
+	};
+
+	SurfaceBatch() : _index_buffer(0), _glow_wobble(0), _render_step(kDiffuse), _mergeable(false) {}
+
+	~SurfaceBatch() {
+		if (_index_buffer) {
+			glDeleteBuffers(1, &_index_buffer);
+		}
+	}
+
+	bool empty() const { return !_texture_manager; }
+
+	// glow-mapped surfaces draw their glow right after themselves, so they
+	// never share a batch
+	bool continues(const Key& key) const { return _texture_manager && _mergeable && key == _key; }
+
+	void begin(const Key& key, std::unique_ptr<TextureManager> TMgr, float glow_wobble, RenderStep renderStep) {
+		_key = key;
+		_texture_manager = std::move(TMgr);
+		_glow_wobble = glow_wobble;
+		_render_step = renderStep;
+		_mergeable = !_texture_manager->IsGlowMapped();
+	}
+
+	const Key& key() const { return _key; }
+	std::unique_ptr<TextureManager>& texture_manager() { return _texture_manager; }
+	float glow_wobble() const { return _glow_wobble; }
+	RenderStep render_step() const { return _render_step; }
+
+	// fans a convex polygon out into triangles
+	void add_polygon(GLuint first_vertex, int count) {
+		for (int i = 2; i < count; ++i) {
+			_indices.push_back(first_vertex);
+			_indices.push_back(first_vertex + i - 1);
+			_indices.push_back(first_vertex + i);
+		}
+	}
+
+	bool upload(LevelGeometry& geometry) {
+		if (_indices.empty())
+			return false;
+
+		if (!_index_buffer) {
+			glGenBuffers(1, &_index_buffer);
+		}
+
+		geometry.bind();
+
+		// respecifying the whole store lets the driver hand out fresh memory
+		// instead of waiting on draws that still read the previous batch
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indices.size() * sizeof(GLuint), _indices.data(), GL_STREAM_DRAW);
+
+		glVertexPointer(3, GL_FLOAT, sizeof(SurfaceVertex), reinterpret_cast<const GLvoid*>(offsetof(SurfaceVertex, position)));
+		glTexCoordPointer(3, GL_FLOAT, sizeof(SurfaceVertex), reinterpret_cast<const GLvoid*>(offsetof(SurfaceVertex, texcoord)));
+
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glNormalPointer(GL_FLOAT, sizeof(SurfaceVertex), reinterpret_cast<const GLvoid*>(offsetof(SurfaceVertex, normal)));
+
+		glClientActiveTextureARB(GL_TEXTURE1_ARB);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(4, GL_FLOAT, sizeof(SurfaceVertex), reinterpret_cast<const GLvoid*>(offsetof(SurfaceVertex, tangent)));
+		glClientActiveTextureARB(GL_TEXTURE0_ARB);
+		return true;
+	}
+
+	void draw() {
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(_indices.size()), GL_UNSIGNED_INT, 0);
+	}
+
+	// everything else still draws from client memory
+	void end() {
+		if (!_indices.empty()) {
+			glDisableClientState(GL_NORMAL_ARRAY);
+			glClientActiveTextureARB(GL_TEXTURE1_ARB);
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+			glClientActiveTextureARB(GL_TEXTURE0_ARB);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		}
+
+		_indices.clear();
+		_texture_manager.reset();
+	}
+
+private:
+	GLuint _index_buffer;
+	std::vector<GLuint> _indices;
+
+	Key _key;
+	std::unique_ptr<TextureManager> _texture_manager;
+	float _glow_wobble;
+	RenderStep _render_step;
+	bool _mergeable;
+};
+
 
 RenderRasterize_Shader::RenderRasterize_Shader() = default;
 RenderRasterize_Shader::~RenderRasterize_Shader() = default;
@@ -120,6 +417,9 @@ void RenderRasterize_Shader::setupGL(Rasterizer_Shader_Class& Rasterizer) {
 	Shader* s_blur = Shader::get(Shader::S_Blur);
 	Shader* s_bloom = Shader::get(Shader::S_Bloom);
 
+	level_geometry.reset(new LevelGeometry);
+	surface_batch.reset(new SurfaceBatch);
+
 	blur.reset();
 	if(TEST_FLAG(Get_OGL_ConfigureData().Flags, OGL_Flag_Blur)) {
 		if(s_blur && s_bloom) {
@@ -145,21 +445,25 @@ void RenderRasterize_Shader::render_tree() {
 	weaponFlare = PIN(view->maximum_depth_intensity - NATURAL_LIGHT_INTENSITY, 0, FIXED_ONE)/float(FIXED_ONE);
 	selfLuminosity = PIN(NATURAL_LIGHT_INTENSITY, 0, FIXED_ONE)/float(FIXED_ONE);
 
-	Shader* s = Shader::get(Shader::S_Invincible);
-	s->enable();
-	s->setFloat(Shader::U_Time, view->tick_count);
-	s->setFloat(Shader::U_LogicalWidth, view->screen_width);
-	s->setFloat(Shader::U_LogicalHeight, view->screen_height);
-	s->setFloat(Shader::U_PixelWidth, view->screen_width * MainScreenPixelScale());
-	s->setFloat(Shader::U_PixelHeight, view->screen_height * MainScreenPixelScale());
-	if (blur.get()) {
-		s = Shader::get(Shader::S_InvincibleBloom);
+	for (auto type : { Shader::S_Invincible, Shader::S_InvincibleSkinned }) {
+		Shader* s = Shader::get(type);
 		s->enable();
 		s->setFloat(Shader::U_Time, view->tick_count);
 		s->setFloat(Shader::U_LogicalWidth, view->screen_width);
 		s->setFloat(Shader::U_LogicalHeight, view->screen_height);
-		s->setFloat(Shader::U_PixelWidth, blur->width());
-		s->setFloat(Shader::U_PixelHeight, blur->height());
+		s->setFloat(Shader::U_PixelWidth, view->screen_width * MainScreenPixelScale());
+		s->setFloat(Shader::U_PixelHeight, view->screen_height * MainScreenPixelScale());
+	}
+	if (blur.get()) {
+		for (auto type : { Shader::S_InvincibleBloom, Shader::S_InvincibleSkinnedBloom }) {
+			Shader* s = Shader::get(type);
+			s->enable();
+			s->setFloat(Shader::U_Time, view->tick_count);
+			s->setFloat(Shader::U_LogicalWidth, view->screen_width);
+			s->setFloat(Shader::U_LogicalHeight, view->screen_height);
+			s->setFloat(Shader::U_PixelWidth, blur->width());
+			s->setFloat(Shader::U_PixelHeight, blur->height());
+		}
 	}
 
 	short leftmost = INT16_MAX;
@@ -216,9 +520,23 @@ void RenderRasterize_Shader::render_tree() {
 		Shader::get(Shader::S_Wall),
 		Shader::get(Shader::S_WallBloom),
 		Shader::get(Shader::S_WallInfravision),
+		Shader::get(Shader::S_WallArray),
+		Shader::get(Shader::S_WallArrayBloom),
+		Shader::get(Shader::S_WallArrayInfravision),
+		Shader::get(Shader::S_BumpArray),
+		Shader::get(Shader::S_BumpArrayBloom),
 		Shader::get(Shader::S_Sprite),
 		Shader::get(Shader::S_SpriteBloom),
-		Shader::get(Shader::S_SpriteInfravision)
+		Shader::get(Shader::S_SpriteInfravision),
+		Shader::get(Shader::S_InvincibleSkinned),
+		Shader::get(Shader::S_InvincibleSkinnedBloom),
+		Shader::get(Shader::S_InvisibleSkinned),
+		Shader::get(Shader::S_InvisibleSkinnedBloom),
+		Shader::get(Shader::S_WallSkinned),
+		Shader::get(Shader::S_WallSkinnedBloom),
+		Shader::get(Shader::S_WallSkinnedInfravision),
+		Shader::get(Shader::S_BumpSkinned),
+		Shader::get(Shader::S_BumpSkinnedBloom)
 	};
 	
 	for (auto s : fog_mode_shaders) {
@@ -228,7 +546,31 @@ void RenderRasterize_Shader::render_tree() {
 	
 	Shader::disable();
 
-	RenderRasterizerClass::render_tree(kDiffuse);
+	// wall programs from MML would be bypassed by the array variants
+	use_texture_arrays = OGL_TextureArraysActive() &&
+		Shader::get(Shader::S_Wall)->builtIn() &&
+		Shader::get(Shader::S_WallBloom)->builtIn() &&
+		Shader::get(Shader::S_WallInfravision)->builtIn() &&
+		Shader::get(Shader::S_Bump)->builtIn() &&
+		Shader::get(Shader::S_BumpBloom)->builtIn();
+
+	// likewise the model programs; the bones take 12 uniform components each
+	GLint max_vertex_uniforms = 0;
+	glGetIntegerv(GL_MAX_VERTEX_UNIFORM_COMPONENTS, &max_vertex_uniforms);
+	use_model_skinning = max_vertex_uniforms >= 1024 &&
+		Shader::get(Shader::S_Invincible)->builtIn() &&
+		Shader::get(Shader::S_InvincibleBloom)->builtIn() &&
+		Shader::get(Shader::S_Invisible)->builtIn() &&
+		Shader::get(Shader::S_InvisibleBloom)->builtIn() &&
+		Shader::get(Shader::S_Wall)->builtIn() &&
+		Shader::get(Shader::S_WallBloom)->builtIn() &&
+		Shader::get(Shader::S_WallInfravision)->builtIn() &&
+		Shader::get(Shader::S_Bump)->builtIn() &&
+		Shader::get(Shader::S_BumpBloom)->builtIn();
+
+	level_geometry->prepare();
+
+	render_tree(kDiffuse);
         render_viewer_sprite_layer(kDiffuse);
 
 	if (current_player->infravision_duration == 0 &&
@@ -236,7 +578,7 @@ void RenderRasterize_Shader::render_tree() {
 		blur.get())
 	{
 		blur->begin();
-		RenderRasterizerClass::render_tree(kGlow);
+		render_tree(kGlow);
                 render_viewer_sprite_layer(kGlow);
 		blur->end();
 		RasPtr->swapper->deactivate();
@@ -247,6 +589,16 @@ void RenderRasterize_Shader::render_tree() {
 	glAlphaFunc(GL_GREATER, 0.5);
 }
 
+void RenderRasterize_Shader::render_tree(RenderStep renderStep)
+{
+	RenderRasterizerClass::render_tree(renderStep);
+	flush_surfaces();
+
+	// turn off clipping planes
+	glDisable(GL_CLIP_PLANE0);
+	glDisable(GL_CLIP_PLANE1);
+}
+
 void RenderRasterize_Shader::render_node(sorted_node_data *node, bool SeeThruLiquids, RenderStep renderStep)
 {
 	// parasitic object detection
@@ -255,9 +607,12 @@ void RenderRasterize_Shader::render_node(sorted_node_data *node, bool SeeThruLiq
 
     RenderRasterizerClass::render_node(node, SeeThruLiquids, renderStep);
 
-	// turn off clipping planes
-	glDisable(GL_CLIP_PLANE0);
-	glDisable(GL_CLIP_PLANE1);
+	// turn off clipping planes, unless the next node's surfaces may still
+	// join the pending batch, which is drawn with them
+	if (surface_batch->empty()) {
+		glDisable(GL_CLIP_PLANE0);
+		glDisable(GL_CLIP_PLANE1);
+	}
 }
 
 void RenderRasterize_Shader::clip_to_window(clipping_window_data *win)
@@ -411,12 +766,9 @@ std::unique_ptr<TextureManager> RenderRasterize_Shader::setupSpriteTexture(const
 const double Radian2Circle = 1/TWO_PI;			// A circle is 2*pi radians
 const double FullCircleReciprocal = 1/double(FULL_CIRCLE);
 
-std::unique_ptr<TextureManager> RenderRasterize_Shader::setupWallTexture(const shape_descriptor& Texture, short transferMode, float pulsate, float wobble, float intensity, float offset, RenderStep renderStep) {
-
-	Shader *s = NULL;
+std::unique_ptr<TextureManager> RenderRasterize_Shader::loadWallTexture(const shape_descriptor& Texture, short transferMode) {
 
 	auto TMgr = std::make_unique<TextureManager>();
-	LandscapeOptions *opts = NULL;
 	TMgr->ShapeDesc = Texture;
 	if (TMgr->ShapeDesc == UNONE) { return TMgr; }
 	get_shape_bitmap_and_shading_table(Texture, &TMgr->Texture, &TMgr->ShadingTables, _shading_normal);
@@ -425,6 +777,38 @@ std::unique_ptr<TextureManager> RenderRasterize_Shader::setupWallTexture(const s
 	TMgr->IsShadeless = current_player->infravision_duration ? 1 : 0;
 	TMgr->TransferData = 0;
 
+	switch(transferMode) {
+		case _xfer_static:
+			TMgr->TextureType = OGL_Txtr_Wall;
+			TMgr->TransferMode = _static_transfer;
+			TMgr->IsShadeless = 1;
+			break;
+		case _xfer_landscape:
+		case _xfer_big_landscape:
+		{
+			TMgr->TextureType = OGL_Txtr_Landscape;
+			TMgr->TransferMode = _big_landscaped_transfer;
+			LandscapeOptions *opts = View_GetLandscapeOptions(Texture);
+			TMgr->LandscapeVertRepeat = opts->VertRepeat;
+			TMgr->Landscape_AspRatExp = opts->SphereMap ? 1 : opts->OGL_AspRatExp;
+			break;
+		}
+		default:
+			TMgr->TextureType = OGL_Txtr_Wall;
+			TMgr->UseTextureArray = use_texture_arrays;
+	}
+
+	if (!TMgr->Setup()) {
+		TMgr->ShapeDesc = UNONE;
+	}
+	return TMgr;
+}
+
+void RenderRasterize_Shader::setupWallTexture(TextureManager& TMgr, short transferMode, float pulsate, float wobble, float intensity, float offset, RenderStep renderStep) {
+
+	Shader *s = NULL;
+
+	LandscapeOptions *opts = NULL;
 	float flare = weaponFlare;
 
 	glEnable(GL_TEXTURE_2D);
@@ -432,9 +816,6 @@ std::unique_ptr<TextureManager> RenderRasterize_Shader::setupWallTexture(const s
 
 	switch(transferMode) {
 		case _xfer_static:
-			TMgr->TextureType = OGL_Txtr_Wall;
-			TMgr->TransferMode = _static_transfer;
-			TMgr->IsShadeless = 1;
 			flare = -1;
 			s = Shader::get(renderStep == kGlow ? Shader::S_InvincibleBloom : Shader::S_Invincible);
 			s->enable();
@@ -442,14 +823,10 @@ std::unique_ptr<TextureManager> RenderRasterize_Shader::setupWallTexture(const s
 			break;
 		case _xfer_landscape:
 		case _xfer_big_landscape:
-			TMgr->TextureType = OGL_Txtr_Landscape;
-			TMgr->TransferMode = _big_landscaped_transfer;
-			opts = View_GetLandscapeOptions(Texture);
-			TMgr->LandscapeVertRepeat = opts->VertRepeat;
-			TMgr->Landscape_AspRatExp = opts->SphereMap ? 1 : opts->OGL_AspRatExp;
+			opts = View_GetLandscapeOptions(TMgr.ShapeDesc);
 			if (current_player->infravision_duration) {
 				GLfloat color[3] {1, 1, 1};
-				FindInfravisionVersionRGBA(GET_COLLECTION(GET_DESCRIPTOR_COLLECTION(Texture)), color);
+				FindInfravisionVersionRGBA(GET_COLLECTION(GET_DESCRIPTOR_COLLECTION(TMgr.ShapeDesc)), color);
 				glColor4f(color[0], color[1], color[2], 1);
 				if (opts->SphereMap)
 				{
@@ -483,8 +860,7 @@ std::unique_ptr<TextureManager> RenderRasterize_Shader::setupWallTexture(const s
 			s->enable();
 			break;
 		default:
-			TMgr->TextureType = OGL_Txtr_Wall;
-			if(TMgr->IsShadeless) {
+			if(TMgr.IsShadeless) {
 				if (renderStep == kDiffuse) {
 					glColor4f(1,1,1,1);
 				} else {
@@ -495,41 +871,45 @@ std::unique_ptr<TextureManager> RenderRasterize_Shader::setupWallTexture(const s
 	}
 
 	if(s == NULL) {
+		bool in_array = TMgr.InTextureArray();
 		if (current_player->infravision_duration) {
 			GLfloat color[3] {1, 1, 1};
-			FindInfravisionVersionRGBA(GET_COLLECTION(GET_DESCRIPTOR_COLLECTION(Texture)), color);
+			FindInfravisionVersionRGBA(GET_COLLECTION(GET_DESCRIPTOR_COLLECTION(TMgr.ShapeDesc)), color);
 			glColor4f(color[0], color[1], color[2], 1);
-			s = Shader::get(Shader::S_WallInfravision);
+			s = Shader::get(in_array ? Shader::S_WallArrayInfravision : Shader::S_WallInfravision);
 		} else if(TEST_FLAG(Get_OGL_ConfigureData().Flags, OGL_Flag_BumpMap)) {
-			s = Shader::get(renderStep == kGlow ? Shader::S_BumpBloom : Shader::S_Bump);
+			if (in_array) {
+				s = Shader::get(renderStep == kGlow ? Shader::S_BumpArrayBloom : Shader::S_BumpArray);
+			} else {
+				s = Shader::get(renderStep == kGlow ? Shader::S_BumpBloom : Shader::S_Bump);
+			}
 		} else {
-			s = Shader::get(renderStep == kGlow ? Shader::S_WallBloom : Shader::S_Wall);
+			if (in_array) {
+				s = Shader::get(renderStep == kGlow ? Shader::S_WallArrayBloom : Shader::S_WallArray);
+			} else {
+				s = Shader::get(renderStep == kGlow ? Shader::S_WallBloom : Shader::S_Wall);
+			}
 		}
 		s->enable();
 	}
 
-	if(TMgr->Setup()) {
-		TMgr->RenderNormal(); // must allocate first
-		if (TEST_FLAG(Get_OGL_ConfigureData().Flags, OGL_Flag_BumpMap)) {
-			glActiveTextureARB(GL_TEXTURE1_ARB);
-			TMgr->RenderBump();
-			glActiveTextureARB(GL_TEXTURE0_ARB);
-		}
-	} else {
-		TMgr->ShapeDesc = UNONE;
-		return TMgr;
+	TMgr.RenderNormal(); // must allocate first
+	if (TEST_FLAG(Get_OGL_ConfigureData().Flags, OGL_Flag_BumpMap)) {
+		glActiveTextureARB(GL_TEXTURE1_ARB);
+		TMgr.RenderBump();
+		glActiveTextureARB(GL_TEXTURE0_ARB);
 	}
 
-	TMgr->SetupTextureMatrix();
+	TMgr.SetupTextureMatrix();
 	
-	if (TMgr->TextureType == OGL_Txtr_Landscape && opts) {
+	if (TMgr.TextureType == OGL_Txtr_Landscape && opts) {
 		if (opts->SphereMap)
 		{
 			s->setFloat(Shader::U_OffsetX, opts->Azimuth * TWO_PI * FullCircleReciprocal);
 		}
 		else
 		{
-			double TexScale = std::abs(TMgr->U_Scale);
+			double TexScale = std::abs(TMgr.U_Scale);
 			double HorizScale = double(1 << opts->HorizExp);
 			s->setFloat(Shader::U_ScaleX, HorizScale * (npotTextures ? 1.0 : TexScale) * Radian2Circle);
 			s->setFloat(Shader::U_OffsetX, HorizScale * (0.25 + opts->Azimuth * FullCircleReciprocal));
@@ -538,16 +918,16 @@ std::unique_ptr<TextureManager> RenderRasterize_Shader::setupWallTexture(const s
 			double VertScale = (AdjustedVertExp >= 0) ? double(1 << AdjustedVertExp)
 		                       : 1/double(1 << (-AdjustedVertExp));
 			s->setFloat(Shader::U_ScaleY, VertScale * TexScale * Radian2Circle);
-			s->setFloat(Shader::U_OffsetY, (0.5 + TMgr->U_Offset) * TexScale);
+			s->setFloat(Shader::U_OffsetY, (0.5 + TMgr.U_Offset) * TexScale);
 		}
 	}
 
 	if (renderStep == kGlow) {
-		if (TMgr->TextureType == OGL_Txtr_Landscape) {
-			s->setFloat(Shader::U_BloomScale, TMgr->LandscapeBloom());
+		if (TMgr.TextureType == OGL_Txtr_Landscape) {
+			s->setFloat(Shader::U_BloomScale, TMgr.LandscapeBloom());
 		} else {
-			s->setFloat(Shader::U_BloomScale, TMgr->BloomScale());
-			s->setFloat(Shader::U_BloomShift, TMgr->BloomShift());
+			s->setFloat(Shader::U_BloomScale, TMgr.BloomScale());
+			s->setFloat(Shader::U_BloomShift, TMgr.BloomShift());
 		}
 	}
 	s->setFloat(Shader::U_Flare, flare);
@@ -556,7 +936,6 @@ std::unique_ptr<TextureManager> RenderRasterize_Shader::setupWallTexture(const s
 	s->setFloat(Shader::U_Wobble, wobble);
 	s->setFloat(Shader::U_Depth, offset);
 	s->setFloat(Shader::U_Glow, 0);
-	return TMgr;
 }
 
 void instantiate_transfer_mode(struct view_data *view, short transfer_mode, world_distance &x0, world_distance &y0) {
@@ -675,114 +1054,157 @@ bool setupGlow(struct view_data *view, std::unique_ptr<TextureManager>& TMgr, fl
 	return false;
 }
 
+void RenderRasterize_Shader::flush_surfaces()
+{
+	if (surface_batch->empty())
+		return;
+
+	if (surface_batch->upload(*level_geometry)) {
+		surface_batch->draw();
+
+		// pulsate uniform should stay set from setupWall call
+		const SurfaceBatch::Key& key = surface_batch->key();
+		if (setupGlow(view, surface_batch->texture_manager(), surface_batch->glow_wobble(), key.intensity, weaponFlare, selfLuminosity, key.offset, surface_batch->render_step())) {
+			surface_batch->draw();
+		}
+	}
+
+	Shader::disable();
+	glMatrixMode(GL_TEXTURE);
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+
+	surface_batch->end();
+}
+
 void RenderRasterize_Shader::render_node_floor_or_ceiling(clipping_window_data *window,
 	polygon_data *polygon, horizontal_surface_data *surface, bool void_present, bool ceil, RenderStep renderStep) {
 
 	float offset = 0;
 
+	short vertex_count = polygon->vertex_count;
 	const shape_descriptor& texture = AnimTxtr_Translate(surface->texture);
+	if (!vertex_count || texture == UNONE) { return; }
+
 	float intensity = get_light_intensity(surface->lightsource_index) / float(FIXED_ONE - 1);
-	float wobble = calcWobble(surface->transfer_mode, view->tick_count);
-	// note: wobble and pulsate behave the same way on floors and ceilings
-	// note 2: stronger wobble looks more like classic with default shaders
-	auto TMgr = setupWallTexture(texture, surface->transfer_mode, wobble * 4.0, 0, intensity, offset, renderStep);
-	if(TMgr->ShapeDesc == UNONE) { return; }
 
-	if (TMgr->IsBlended()) {
-		glEnable(GL_BLEND);
-		setupBlendFunc(TMgr->NormalBlend());
-		glEnable(GL_ALPHA_TEST);
-		glAlphaFunc(GL_GREATER, 0.001);
-	} else {
-		glDisable(GL_BLEND);
-		glEnable(GL_ALPHA_TEST);
-		glAlphaFunc(GL_GREATER, 0.5);
-	}
+	SurfaceBatch::Key key = { texture, surface->transfer_mode, intensity, offset, false, void_present, window->left, window->right };
 
-	if (void_present && TMgr->IsBlended()) {
-		glDisable(GL_BLEND);
-		glDisable(GL_ALPHA_TEST);
+	// with texture arrays, the texture decides whether the batch goes on
+	std::unique_ptr<TextureManager> TMgr;
+	if (use_texture_arrays) {
+		TMgr = loadWallTexture(texture, surface->transfer_mode);
+		if(TMgr->ShapeDesc == UNONE) { return; }
+		key.use_material(*TMgr);
 	}
 
-	short vertex_count = polygon->vertex_count;
+	if (!surface_batch->continues(key)) {
+		flush_surfaces();
 
-	if (vertex_count) {
-        clip_to_window(window);
+		if (!TMgr) {
+			TMgr = loadWallTexture(texture, surface->transfer_mode);
+			if(TMgr->ShapeDesc == UNONE) { return; }
+		}
 
-		world_distance x = 0.0, y = 0.0;
-		instantiate_transfer_mode(view, surface->transfer_mode, x, y);
+		float wobble = calcWobble(surface->transfer_mode, view->tick_count);
+		// note: wobble and pulsate behave the same way on floors and ceilings
+		// note 2: stronger wobble looks more like classic with default shaders
+		setupWallTexture(*TMgr, surface->transfer_mode, wobble * 4.0, 0, intensity, offset, renderStep);
 
-		vec3 N;
-		vec3 T;
-		float sign;
-		if(ceil) {
-			N = vec3(0,0,-1);
-			T = vec3(0,1,0);
-			sign = 1;
+		if (TMgr->IsBlended()) {
+			glEnable(GL_BLEND);
+			setupBlendFunc(TMgr->NormalBlend());
+			glEnable(GL_ALPHA_TEST);
+			glAlphaFunc(GL_GREATER, 0.001);
 		} else {
-			N = vec3(0,0,1);
-			T = vec3(0,1,0);
-			sign = -1;
+			glDisable(GL_BLEND);
+			glEnable(GL_ALPHA_TEST);
+			glAlphaFunc(GL_GREATER, 0.5);
 		}
-		glNormal3f(N[0], N[1], N[2]);
-		glMultiTexCoord4fARB(GL_TEXTURE1_ARB, T[0], T[1], T[2], sign);
 
-		GLfloat vertex_array[MAXIMUM_VERTICES_PER_POLYGON * 3];
-		GLfloat texcoord_array[MAXIMUM_VERTICES_PER_POLYGON * 2];
+		if (void_present && TMgr->IsBlended()) {
+			glDisable(GL_BLEND);
+			glDisable(GL_ALPHA_TEST);
+		}
 
-		GLfloat* vp = vertex_array;
-		GLfloat* tp = texcoord_array;
-		float scale;
+		clip_to_window(window);
 
-		switch (surface->transfer_mode)
-		{
-			case _xfer_2x:
-				scale = 2 * WORLD_ONE * TMgr->TileRatio();
-				break;
-		    case _xfer_4x:
-				scale = 4 * WORLD_ONE * TMgr->TileRatio();
-				break;
-			default:
-				scale = WORLD_ONE * TMgr->TileRatio();
-				break;
-		}
+		// see note 2 above; the glow pass doesn't wobble
+		surface_batch->begin(key, std::move(TMgr), 0, renderStep);
+	}
+	TextureManager& texture_manager = TMgr ? *TMgr : *surface_batch->texture_manager();
+	int32 layer = texture_manager.InTextureArray() ? texture_manager.GetTextureArrayLayer() : 0;
+
+	world_distance x = 0.0, y = 0.0;
+	instantiate_transfer_mode(view, surface->transfer_mode, x, y);
+
+	vec3 N;
+	vec3 T;
+	float sign;
+	if(ceil) {
+		N = vec3(0,0,-1);
+		T = vec3(0,1,0);
+		sign = 1;
+	} else {
+		N = vec3(0,0,1);
+		T = vec3(0,1,0);
+		sign = -1;
+	}
 
-		if (ceil)
-		{
-			for(short i = 0; i < vertex_count; ++i) {
-				world_point2d vertex = get_endpoint_data(polygon->endpoint_indexes[vertex_count - 1 - i])->vertex;
-				*vp++ = vertex.x;
-				*vp++ = vertex.y;
-				*vp++ = surface->height;
-				*tp++ = (vertex.x + surface->origin.x + x) / scale;
-				*tp++ = (vertex.y + surface->origin.y + y) / scale;
-			}
-		}
-		else
-		{
-			for(short i=0; i<vertex_count; ++i) {
-				world_point2d vertex = get_endpoint_data(polygon->endpoint_indexes[i])->vertex;
-				*vp++ = vertex.x;
-				*vp++ = vertex.y;
-				*vp++ = surface->height;
-				*tp++ = (vertex.x + surface->origin.x + x) / scale;
-				*tp++ = (vertex.y + surface->origin.y + y) / scale;
-			}
-		}
-		glVertexPointer(3, GL_FLOAT, 0, vertex_array);
-		glTexCoordPointer(2, GL_FLOAT, 0, texcoord_array);
+	float scale;
 
-		glDrawArrays(GL_POLYGON, 0, vertex_count);
+	switch (surface->transfer_mode)
+	{
+		case _xfer_2x:
+			scale = 2 * WORLD_ONE * texture_manager.TileRatio();
+			break;
+	    case _xfer_4x:
+			scale = 4 * WORLD_ONE * texture_manager.TileRatio();
+			break;
+		default:
+			scale = WORLD_ONE * texture_manager.TileRatio();
+			break;
+	}
 
-		// see note 2 above; pulsate uniform should stay set from setupWall call
-		if (setupGlow(view, TMgr, 0, intensity, weaponFlare, selfLuminosity, offset, renderStep)) {
-			glDrawArrays(GL_POLYGON, 0, vertex_count);
+	// liquids get a slot of their own so they don't keep evicting the
+	// floor or ceiling they are seen along with
+	int slot_surface = ceil ? LevelGeometry::_ceiling_slot : LevelGeometry::_floor_slot;
+	if (polygon->media_index != NONE) {
+		media_data *media = get_media_data(polygon->media_index);
+		if (media && surface->texture == media->texture && surface->height == media->height)
+			slot_surface = LevelGeometry::_media_slot;
+	}
+	int slot = level_geometry->horizontal_slot(static_cast<short>(polygon - map_polygons), slot_surface);
+
+	LevelGeometry::Source source = { { surface->height, ceil, 0 }, { surface->origin.x, surface->origin.y }, { x, y }, scale, layer };
+	if (!level_geometry->current(slot, source)) {
+		SurfaceVertex vertex_array[MAXIMUM_VERTICES_PER_POLYGON];
+
+		for(short i = 0; i < vertex_count; ++i) {
+			short endpoint = ceil ? vertex_count - 1 - i : i;
+			world_point2d vertex = get_endpoint_data(polygon->endpoint_indexes[endpoint])->vertex;
+			SurfaceVertex& v = vertex_array[i];
+			v.position[0] = vertex.x;
+			v.position[1] = vertex.y;
+			v.position[2] = surface->height;
+			v.texcoord[0] = (vertex.x + surface->origin.x + x) / scale;
+			v.texcoord[1] = (vertex.y + surface->origin.y + y) / scale;
+			v.texcoord[2] = layer;
+			v.normal[0] = N[0];
+			v.normal[1] = N[1];
+			v.normal[2] = N[2];
+			v.tangent[0] = T[0];
+			v.tangent[1] = T[1];
+			v.tangent[2] = T[2];
+			v.tangent[3] = sign;
 		}
+		level_geometry->patch(slot, source, vertex_array, vertex_count);
+	}
+	surface_batch->add_polygon(level_geometry->first_vertex(slot), vertex_count);
 
-		Shader::disable();
-		glMatrixMode(GL_TEXTURE);
-		glLoadIdentity();
-		glMatrixMode(GL_MODELVIEW);
+	// glow-mapped surfaces are drawn on their own
+	if (!surface_batch->continues(key)) {
+		flush_surfaces();
 	}
 }
 
@@ -794,132 +1216,197 @@ void RenderRasterize_Shader::render_node_side(clipping_window_data *window, vert
 	}
 
 	const shape_descriptor& texture = AnimTxtr_Translate(surface->texture_definition->texture);
+	world_distance h= MIN(surface->h1, surface->hmax);
+	if (texture == UNONE || h <= surface->h0) { return; }
+
 	float intensity = (get_light_intensity(surface->lightsource_index) + surface->ambient_delta) / float(FIXED_ONE - 1);
-	float wobble = calcWobble(surface->transfer_mode, view->tick_count);
-	float pulsate = 0;
-	if (surface->transfer_mode == _xfer_pulsate) {
-		pulsate = wobble;
-		wobble = 0;
-	}
-	auto TMgr = setupWallTexture(texture, surface->transfer_mode, pulsate, wobble, intensity, offset, renderStep);
-	if(TMgr->ShapeDesc == UNONE) { return; }
 
-	if (TMgr->IsBlended()) {
-		glEnable(GL_BLEND);
-		setupBlendFunc(TMgr->NormalBlend());
-		glEnable(GL_ALPHA_TEST);
-		glAlphaFunc(GL_GREATER, 0.001);
-	} else {
-		glDisable(GL_BLEND);
-		glEnable(GL_ALPHA_TEST);
-		glAlphaFunc(GL_GREATER, 0.5);
-	}
+	SurfaceBatch::Key key = { texture, surface->transfer_mode, intensity, offset, true, void_present, window->left, window->right };
 
-	if (void_present && TMgr->IsBlended()) {
-		glDisable(GL_BLEND);
-		glDisable(GL_ALPHA_TEST);
+	std::unique_ptr<TextureManager> TMgr;
+	if (use_texture_arrays) {
+		TMgr = loadWallTexture(texture, surface->transfer_mode);
+		if(TMgr->ShapeDesc == UNONE) { return; }
+		key.use_material(*TMgr);
 	}
 
-	world_distance h= MIN(surface->h1, surface->hmax);
-
-	if (h>surface->h0) {
+	if (!surface_batch->continues(key)) {
+		flush_surfaces();
 
-		world_point2d vertex[2];
-		uint16 flags;
-		flagged_world_point3d vertices[MAXIMUM_VERTICES_PER_WORLD_POLYGON];
-		short vertex_count;
+		if (!TMgr) {
+			TMgr = loadWallTexture(texture, surface->transfer_mode);
+			if(TMgr->ShapeDesc == UNONE) { return; }
+		}
 
-		/* initialize the two posts of our trapezoid */
-		vertex_count= 2;
-		long_to_overflow_short_2d(surface->p0, vertex[0], flags);
-		long_to_overflow_short_2d(surface->p1, vertex[1], flags);
+		float wobble = calcWobble(surface->transfer_mode, view->tick_count);
+		float pulsate = 0;
+		if (surface->transfer_mode == _xfer_pulsate) {
+			pulsate = wobble;
+			wobble = 0;
+		}
+		setupWallTexture(*TMgr, surface->transfer_mode, pulsate, wobble, intensity, offset, renderStep);
 
-		if (vertex_count) {
-            clip_to_window(window);
-
-			vertex_count= 4;
-			vertices[0].z= vertices[1].z= h + view->origin.z;
-			vertices[2].z= vertices[3].z= surface->h0 + view->origin.z;
-			vertices[0].x= vertices[3].x= vertex[0].x, vertices[0].y= vertices[3].y= vertex[0].y;
-			vertices[1].x= vertices[2].x= vertex[1].x, vertices[1].y= vertices[2].y= vertex[1].y;
-			vertices[0].flags = vertices[3].flags = 0;
-			vertices[1].flags = vertices[2].flags = 0;
-
-			uint16 div;
-			switch (surface->transfer_mode)
-			{
-				case _xfer_2x:
-					div = 2 * WORLD_ONE * TMgr->TileRatio();
-					break;
-				case _xfer_4x:
-					div = 4 * WORLD_ONE * TMgr->TileRatio();
-					break;
-				default:
-					div = WORLD_ONE * TMgr->TileRatio();;
-					break;
-			}
-			
-			double dx = (surface->p1.i - surface->p0.i) / double(surface->length);
-			double dy = (surface->p1.j - surface->p0.j) / double(surface->length);
+		if (TMgr->IsBlended()) {
+			glEnable(GL_BLEND);
+			setupBlendFunc(TMgr->NormalBlend());
+			glEnable(GL_ALPHA_TEST);
+			glAlphaFunc(GL_GREATER, 0.001);
+		} else {
+			glDisable(GL_BLEND);
+			glEnable(GL_ALPHA_TEST);
+			glAlphaFunc(GL_GREATER, 0.5);
+		}
 
-			world_distance x0 = surface->texture_definition->x0 % div;
-			world_distance y0 = surface->texture_definition->y0 % div;
+		if (void_present && TMgr->IsBlended()) {
+			glDisable(GL_BLEND);
+			glDisable(GL_ALPHA_TEST);
+		}
 
-			double tOffset = surface->h1 + view->origin.z + y0;
+		clip_to_window(window);
 
-			vec3 N(-dy, dx, 0);
-			vec3 T(dx, dy, 0);
-			float sign = 1;
-			glNormal3f(N[0], N[1], N[2]);
-			glMultiTexCoord4fARB(GL_TEXTURE1_ARB, T[0], T[1], T[2], sign);
+		surface_batch->begin(key, std::move(TMgr), wobble, renderStep);
+	}
+	TextureManager& texture_manager = TMgr ? *TMgr : *surface_batch->texture_manager();
+	int32 layer = texture_manager.InTextureArray() ? texture_manager.GetTextureArrayLayer() : 0;
 
-			world_distance x = 0.0, y = 0.0;
-			instantiate_transfer_mode(view, surface->transfer_mode, x, y);
+	uint16 div;
+	switch (surface->transfer_mode)
+	{
+		case _xfer_2x:
+			div = 2 * WORLD_ONE * texture_manager.TileRatio();
+			break;
+		case _xfer_4x:
+			div = 4 * WORLD_ONE * texture_manager.TileRatio();
+			break;
+		default:
+			div = WORLD_ONE * texture_manager.TileRatio();;
+			break;
+	}
 
-			x0 -= x;
-			tOffset -= y;
+	world_distance x0 = surface->texture_definition->x0 % div;
+	world_distance y0 = surface->texture_definition->y0 % div;
 
-			GLfloat vertex_array[12];
-			GLfloat texcoord_array[8];
+	world_distance x = 0.0, y = 0.0;
+	instantiate_transfer_mode(view, surface->transfer_mode, x, y);
 
-			GLfloat* vp = vertex_array;
-			GLfloat* tp = texcoord_array;
+	side_data *side = get_side_data(surface->side_index);
+	int slot_surface = LevelGeometry::_primary_slot;
+	if (surface->texture_definition == &side->secondary_texture)
+		slot_surface = LevelGeometry::_secondary_slot;
+	else if (surface->texture_definition == &side->transparent_texture)
+		slot_surface = LevelGeometry::_transparent_slot;
+	int slot = level_geometry->side_slot(surface->side_index, slot_surface);
 
-			for(int i = 0; i < vertex_count; ++i) {
-				float p2 = 0;
-				if(i == 1 || i == 2) { p2 = surface->length; }
+	short vertex_count= 4;
+	world_distance top = h + view->origin.z;
+	world_distance bottom = surface->h0 + view->origin.z;
 
-				*vp++ = vertices[i].x;
-				*vp++ = vertices[i].y;
-				*vp++ = vertices[i].z;
-				*tp++ = (tOffset - vertices[i].z) / static_cast<float>(div);
-				*tp++ = (x0+p2) / static_cast<float>(div);
-			}
-			glVertexPointer(3, GL_FLOAT, 0, vertex_array);
-			glTexCoordPointer(2, GL_FLOAT, 0, texcoord_array);
-			
-			glDrawArrays(GL_QUADS, 0, vertex_count);
+	LevelGeometry::Source source = { { top, bottom, surface->h1 + view->origin.z }, { x0, y0 }, { x, y }, static_cast<float>(div), layer };
+	if (!level_geometry->current(slot, source)) {
+		world_point2d vertex[2];
+		uint16 flags;
+		flagged_world_point3d vertices[MAXIMUM_VERTICES_PER_WORLD_POLYGON];
 
-			if (setupGlow(view, TMgr, wobble, intensity, weaponFlare, selfLuminosity, offset, renderStep)) {
-				glDrawArrays(GL_QUADS, 0, vertex_count);
-			}
+		/* initialize the two posts of our trapezoid */
+		long_to_overflow_short_2d(surface->p0, vertex[0], flags);
+		long_to_overflow_short_2d(surface->p1, vertex[1], flags);
 
-			Shader::disable();
-			glMatrixMode(GL_TEXTURE);
-			glLoadIdentity();
-			glMatrixMode(GL_MODELVIEW);
+		vertices[0].z= vertices[1].z= top;
+		vertices[2].z= vertices[3].z= bottom;
+		vertices[0].x= vertices[3].x= vertex[0].x, vertices[0].y= vertices[3].y= vertex[0].y;
+		vertices[1].x= vertices[2].x= vertex[1].x, vertices[1].y= vertices[2].y= vertex[1].y;
+		vertices[0].flags = vertices[3].flags = 0;
+		vertices[1].flags = vertices[2].flags = 0;
+
+		double dx = (surface->p1.i - surface->p0.i) / double(surface->length);
+		double dy = (surface->p1.j - surface->p0.j) / double(surface->length);
+
+		double tOffset = surface->h1 + view->origin.z + y0;
+
+		vec3 N(-dy, dx, 0);
+		vec3 T(dx, dy, 0);
+		float sign = 1;
+
+		x0 -= x;
+		tOffset -= y;
+
+		SurfaceVertex vertex_array[4];
+
+		for(int i = 0; i < vertex_count; ++i) {
+			float p2 = 0;
+			if(i == 1 || i == 2) { p2 = surface->length; }
+
+			SurfaceVertex& v = vertex_array[i];
+			v.position[0] = vertices[i].x;
+			v.position[1] = vertices[i].y;
+			v.position[2] = vertices[i].z;
+			v.texcoord[0] = (tOffset - vertices[i].z) / static_cast<float>(div);
+			v.texcoord[1] = (x0+p2) / static_cast<float>(div);
+			v.texcoord[2] = layer;
+			v.normal[0] = N[0];
+			v.normal[1] = N[1];
+			v.normal[2] = N[2];
+			v.tangent[0] = T[0];
+			v.tangent[1] = T[1];
+			v.tangent[2] = T[2];
+			v.tangent[3] = sign;
 		}
+		level_geometry->patch(slot, source, vertex_array, vertex_count);
+	}
+	surface_batch->add_polygon(level_geometry->first_vertex(slot), vertex_count);
+
+	// glow-mapped surfaces are drawn on their own
+	if (!surface_batch->continues(key)) {
+		flush_surfaces();
 	}
 }
 
 extern void FlatBumpTexture(); // from OGL_Textures.cpp
 
-bool RenderModel(rectangle_definition& RenderRectangle, short Collection, short CLUT, float flare, float selfLuminosity, RenderStep renderStep) {
+// the program for a model, or its variant that moves the vertices by their bones
+static Shader* model_shader(Shader::ShaderType type, bool skinning) {
+	if (skinning) {
+		switch (type) {
+			case Shader::S_Invincible: type = Shader::S_InvincibleSkinned; break;
+			case Shader::S_InvincibleBloom: type = Shader::S_InvincibleSkinnedBloom; break;
+			case Shader::S_Invisible: type = Shader::S_InvisibleSkinned; break;
+			case Shader::S_InvisibleBloom: type = Shader::S_InvisibleSkinnedBloom; break;
+			case Shader::S_Wall: type = Shader::S_WallSkinned; break;
+			case Shader::S_WallBloom: type = Shader::S_WallSkinnedBloom; break;
+			case Shader::S_WallInfravision: type = Shader::S_WallSkinnedInfravision; break;
+			case Shader::S_Bump: type = Shader::S_BumpSkinned; break;
+			case Shader::S_BumpBloom: type = Shader::S_BumpSkinnedBloom; break;
+			default: break;
+		}
+	}
+	return Shader::get(type);
+}
+
+static std::vector<Model3D_Transform> bone_transforms;
+
+bool RenderModel(rectangle_definition& RenderRectangle, short Collection, short CLUT, float flare, float selfLuminosity, bool skinning, RenderStep renderStep) {
 
 	OGL_ModelData *ModelPtr = RenderRectangle.ModelPtr;
 	OGL_SkinData *SkinPtr = ModelPtr->GetSkin(CLUT);
 	if(!SkinPtr) { return false; }
 
+	// An animated model is drawn from buffers on the card, with only its
+	// bones posed here; otherwise its vertex positions and normals are found
+	short ModelSequence = RenderRectangle.ModelSequence;
+	int NumFrames = (ModelSequence >= 0) ? ModelPtr->Model.NumSeqFrames(ModelSequence) : 0;
+	short ModelFrame = 0;
+	short NextModelFrame = 0;
+	float MixFrac = 0;
+	if (NumFrames > 0)
+	{
+		ModelFrame = PIN(RenderRectangle.ModelFrame, 0, NumFrames - 1);
+		NextModelFrame = PIN(RenderRectangle.NextModelFrame, 0, NumFrames - 1);
+		MixFrac = RenderRectangle.MixFrac;
+	}
+	skinning = skinning && NumFrames > 0 && ModelPtr->CanSkin(Shader::MAX_BONES) &&
+		ModelPtr->Model.FindBoneTransforms_Sequence(bone_transforms,
+			ModelSequence, ModelFrame, MixFrac, NextModelFrame);
+
 	if (ModelPtr->Sidedness < 0) {
 		glEnable(GL_CULL_FACE);
 		glFrontFace(GL_CCW);
@@ -951,22 +1438,22 @@ bool RenderModel(rectangle_definition& RenderRectangle, short Collection, short
 	if (RenderRectangle.transfer_mode == _static_transfer) {
 		flare = -1;
 		if (renderStep == kDiffuse) {
-			s = Shader::get(Shader::S_Invincible);
+			s = model_shader(Shader::S_Invincible, skinning);
 		} else {
-			s = Shader::get(Shader::S_InvincibleBloom);
+			s = model_shader(Shader::S_InvincibleBloom, skinning);
 		}
         s->enable();
         s->setFloat(Shader::U_TransferFadeOut,((float)((uint16)RenderRectangle.transfer_data))/(float)((int)FIXED_ONE));
 	} else if (current_player->infravision_duration) {
 		color[0] = color[1] = color[2] = 1;
 		FindInfravisionVersionRGBA(GET_COLLECTION(GET_DESCRIPTOR_COLLECTION(RenderRectangle.ShapeDesc)), color);
-		s = Shader::get(Shader::S_WallInfravision);
+		s = model_shader(Shader::S_WallInfravision, skinning);
 	} else if (RenderRectangle.transfer_mode == _tinted_transfer) {
 			flare = -1;
 			if (renderStep == kDiffuse) {
-				s = Shader::get(Shader::S_Invisible);
+				s = model_shader(Shader::S_Invisible, skinning);
 			} else {
-				s = Shader::get(Shader::S_InvisibleBloom);
+				s = model_shader(Shader::S_InvisibleBloom, skinning);
 			}
 			s->enable();
 			s->setFloat(Shader::U_Visibility, 1.0 - RenderRectangle.transfer_data/32.0f);
@@ -993,13 +1480,18 @@ bool RenderModel(rectangle_definition& RenderRectangle, short Collection, short
 
 	if(s == NULL) {
 		if(TEST_FLAG(Get_OGL_ConfigureData().Flags, OGL_Flag_BumpMap)) {
-			s = Shader::get(renderStep == kGlow ? Shader::S_BumpBloom : Shader::S_Bump);
+			s = model_shader(renderStep == kGlow ? Shader::S_BumpBloom : Shader::S_Bump, skinning);
 		} else {
-			s = Shader::get(renderStep == kGlow ? Shader::S_WallBloom : Shader::S_Wall);
+			s = model_shader(renderStep == kGlow ? Shader::S_WallBloom : Shader::S_Wall, skinning);
 		}
 		s->enable();
 	}
 
+	if (skinning) {
+		s->enable();
+		s->setVec4Array(Shader::U_BoneTransforms, 3 * static_cast<int>(bone_transforms.size()), bone_transforms[0].M[0]);
+	}
+
 	if (renderStep == kGlow) {
 		s->setFloat(Shader::U_BloomScale, SkinPtr->BloomScale);
 		s->setFloat(Shader::U_BloomShift, SkinPtr->BloomShift);
@@ -1011,39 +1503,55 @@ bool RenderModel(rectangle_definition& RenderRectangle, short Collection, short
 	s->setFloat(Shader::U_Glow, 0);
 	glColor4f(color[0], color[1], color[2], 1);
 
-	// Find an animated model's vertex positions and normals:
-	short ModelSequence = RenderRectangle.ModelSequence;
-	if (ModelSequence >= 0)
+	const GLushort *indices = 0;
+	if (skinning)
+	{
+		ModelPtr->UseSkinnedBuffers();
+
+		glVertexPointer(3,GL_FLOAT,sizeof(OGL_SkinnedVertex),reinterpret_cast<const GLvoid*>(offsetof(OGL_SkinnedVertex, Position)));
+		glClientActiveTextureARB(GL_TEXTURE0_ARB);
+		if (ModelPtr->Model.TxtrCoords.empty()) {
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		} else {
+			glTexCoordPointer(2,GL_FLOAT,sizeof(OGL_SkinnedVertex),reinterpret_cast<const GLvoid*>(offsetof(OGL_SkinnedVertex, TxtrCoord)));
+		}
+
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glNormalPointer(GL_FLOAT,sizeof(OGL_SkinnedVertex),reinterpret_cast<const GLvoid*>(offsetof(OGL_SkinnedVertex, Normal)));
+
+		glClientActiveTextureARB(GL_TEXTURE2_ARB);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(3,GL_FLOAT,sizeof(OGL_SkinnedVertex),reinterpret_cast<const GLvoid*>(offsetof(OGL_SkinnedVertex, Bones)));
+
+		glClientActiveTextureARB(GL_TEXTURE1_ARB);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(4,GL_FLOAT,sizeof(OGL_SkinnedVertex),reinterpret_cast<const GLvoid*>(offsetof(OGL_SkinnedVertex, Tangent)));
+	}
+	else
 	{
-		int NumFrames = ModelPtr->Model.NumSeqFrames(ModelSequence);
 		if (NumFrames > 0)
-		{
-			short ModelFrame = PIN(RenderRectangle.ModelFrame, 0, NumFrames - 1);
-			short NextModelFrame = PIN(RenderRectangle.NextModelFrame, 0, NumFrames - 1);
-			float MixFrac = RenderRectangle.MixFrac;
 			ModelPtr->Model.FindPositions_Sequence(true,
 				ModelSequence, ModelFrame, MixFrac, NextModelFrame);
-		}
 		else
-			ModelPtr->Model.FindPositions_Neutral(true);	// Fallback: neutral
-	}
-	else
-		ModelPtr->Model.FindPositions_Neutral(true);	// Fallback: neutral (will do nothing for static models)
+			ModelPtr->Model.FindPositions_Neutral(true);	// Fallback: neutral (will do nothing for static models)
 
-	glVertexPointer(3,GL_FLOAT,0,ModelPtr->Model.PosBase());
-	glClientActiveTextureARB(GL_TEXTURE0_ARB);
-	if (ModelPtr->Model.TxtrCoords.empty()) {
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	} else {
-		glTexCoordPointer(2,GL_FLOAT,0,ModelPtr->Model.TCBase());
-	}
+		glVertexPointer(3,GL_FLOAT,0,ModelPtr->Model.PosBase());
+		glClientActiveTextureARB(GL_TEXTURE0_ARB);
+		if (ModelPtr->Model.TxtrCoords.empty()) {
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		} else {
+			glTexCoordPointer(2,GL_FLOAT,0,ModelPtr->Model.TCBase());
+		}
+
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glNormalPointer(GL_FLOAT,0,ModelPtr->Model.NormBase());
 
-	glEnableClientState(GL_NORMAL_ARRAY);
-	glNormalPointer(GL_FLOAT,0,ModelPtr->Model.NormBase());
+		glClientActiveTextureARB(GL_TEXTURE1_ARB);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(4,GL_FLOAT,sizeof(vec4),ModelPtr->Model.TangentBase());
 
-	glClientActiveTextureARB(GL_TEXTURE1_ARB);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-	glTexCoordPointer(4,GL_FLOAT,sizeof(vec4),ModelPtr->Model.TangentBase());
+		indices = ModelPtr->Model.VIBase();
+	}
 
 	if(ModelPtr->Use(CLUT,OGL_SkinManager::Normal)) {
 		LoadModelSkin(SkinPtr->NormalImg, Collection, CLUT);
@@ -1060,7 +1568,7 @@ bool RenderModel(rectangle_definition& RenderRectangle, short Collection, short
 		glActiveTextureARB(GL_TEXTURE0_ARB);
 	}
 
-	glDrawElements(GL_TRIANGLES,(GLsizei)ModelPtr->Model.NumVI(),GL_UNSIGNED_SHORT,ModelPtr->Model.VIBase());
+	glDrawElements(GL_TRIANGLES,(GLsizei)ModelPtr->Model.NumVI(),GL_UNSIGNED_SHORT,indices);
 
 	if (canGlow && SkinPtr->GlowImg.IsPresent()) {
 		glEnable(GL_BLEND);
@@ -1078,11 +1586,17 @@ bool RenderModel(rectangle_definition& RenderRectangle, short Collection, short
 		if(ModelPtr->Use(CLUT,OGL_SkinManager::Glowing)) {
 			LoadModelSkin(SkinPtr->GlowImg, Collection, CLUT);
 		}
-		glDrawElements(GL_TRIANGLES,(GLsizei)ModelPtr->Model.NumVI(),GL_UNSIGNED_SHORT,ModelPtr->Model.VIBase());
+		glDrawElements(GL_TRIANGLES,(GLsizei)ModelPtr->Model.NumVI(),GL_UNSIGNED_SHORT,indices);
 	}
 
 	glDisableClientState(GL_NORMAL_ARRAY);
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	if (skinning) {
+		glClientActiveTextureARB(GL_TEXTURE2_ARB);
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
 	glClientActiveTextureARB(GL_TEXTURE0_ARB);
 	if (ModelPtr->Model.TxtrCoords.empty()) {
 		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -1107,6 +1621,14 @@ void RenderRasterize_Shader::render_node_object(render_object_data *object, bool
 	// software renderer.
 	short media_index = get_polygon_data(object->node->polygon_index)->media_index;
 	media_data *media = (media_index != NONE) ? get_media_data(media_index) : NULL;
+	if (!media && other_side_of_media) {
+		// When there's no media present, we can skip the second pass.
+		return;
+	}
+
+	// the media clip plane must not apply to the pending surfaces
+	flush_surfaces();
+
 	if (media) {
 		float h = media->height;
 		GLdouble plane[] = { 0.0, 0.0, 1.0, -h };
@@ -1116,9 +1638,6 @@ void RenderRasterize_Shader::render_node_object(render_object_data *object, bool
 		}
 		glClipPlane(GL_CLIP_PLANE5, plane);
 		glEnable(GL_CLIP_PLANE5);
-	} else if (other_side_of_media) {
-		// When there's no media present, we can skip the second pass.
-		return;
 	}
 
     for (win = object->clipping_windows; win; win = win->next_window)
@@ -1146,7 +1665,7 @@ void RenderRasterize_Shader::_render_node_object_helper(render_object_data *obje
 		short collection = GET_COLLECTION(descriptor);
 		short clut = ModifyCLUT(rect.transfer_mode,GET_COLLECTION_CLUT(descriptor));
 
-		RenderModel(rect, collection, clut, weaponFlare, selfLuminosity, renderStep);
+		RenderModel(rect, collection, clut, weaponFlare, selfLuminosity, use_model_skinning, renderStep);
 		glPopMatrix();
 		return;
 	}
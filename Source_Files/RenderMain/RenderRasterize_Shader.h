@@ -37,19 +37,29 @@
 #ifdef HAVE_OPENGL
 
 class Blur;
+class LevelGeometry;
+class SurfaceBatch;
 class RenderRasterize_Shader : public RenderRasterizerClass {
 
 	std::unique_ptr<Blur> blur;
+	std::unique_ptr<LevelGeometry> level_geometry;
+	std::unique_ptr<SurfaceBatch> surface_batch;
 	Rasterizer_Shader_Class *RasPtr;
 	
 	int objectCount;
 	world_distance objectY;
 	float weaponFlare;
 	float selfLuminosity;
+	bool use_texture_arrays;
+	bool use_model_skinning;
 	
 	long_vector2d leftmost_clip, rightmost_clip;
 
+	// draws the pending run of walls, floors and ceilings
+	void flush_surfaces();
+
 protected:
+	virtual void render_tree(RenderStep renderStep);
 	virtual void render_node(sorted_node_data *node, bool SeeThruLiquids, RenderStep renderStep);	
 	virtual void store_endpoint(endpoint_data *endpoint, long_vector2d& p);
 
@@ -78,7 +88,10 @@ public:
 	virtual void render_tree(void);
         bool renders_viewer_sprites_in_tree() { return true; }
 
-	std::unique_ptr<TextureManager> setupWallTexture(const shape_descriptor& Texture, short transferMode, float pulsate, float wobble, float intensity, float offset, RenderStep renderStep);
+	// loadWallTexture() leaves the GL state alone, so it can be called while
+	// surfaces are still pending; setupWallTexture() then binds and enables
+	std::unique_ptr<TextureManager> loadWallTexture(const shape_descriptor& Texture, short transferMode);
+	void setupWallTexture(TextureManager& TMgr, short transferMode, float pulsate, float wobble, float intensity, float offset, RenderStep renderStep);
 	std::unique_ptr<TextureManager> setupSpriteTexture(const rectangle_definition& rect, short type, float offset, RenderStep renderStep);
 };
 
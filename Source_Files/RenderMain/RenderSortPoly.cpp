@@ -49,6 +49,7 @@ enum /* build_clipping_window() window states */
 
 
 RenderSortPolyClass::RenderSortPolyClass():
+	sorted_clipping_window_count(0),
 	view(NULL),	// Idiot-proofing
 	RVPtr(NULL)
 {
@@ -111,40 +112,7 @@ void RenderSortPolyClass::sort_render_tree()
 		// LP change: Replaced all this code with binary-search code for polygon value,
 		// followed by building of node-alias list
 		short PolygonToFind = leaf->polygon_index;
-		
-		// Look for the first node with that polygon index;
-		// start search off with the hypothesis of failure
-		node_data *FoundNode = NULL;
-		node_data *CurrNode = &Nodes.front();
-		while(true)
-		{
-			int32 PolyDiff = int32(PolygonToFind) - int32(CurrNode->polygon_index);
-			if (PolyDiff > 0)
-			{
-				node_data *NextNode = CurrNode->PS_Greater;
-				if (NextNode)
-					// Advance
-					CurrNode = NextNode;
-				else
-					// Failed
-					break;
-			}
-			else if (PolyDiff < 0)
-			{
-				node_data *NextNode = CurrNode->PS_Less;
-				if (NextNode)
-					// Advance
-					CurrNode = NextNode;
-				else
-					// Failed
-					break;
-			}
-			else // Equal: the search was a success
-			{
-				FoundNode = CurrNode;
-				break;
-			}
-		}
+		node_data *FoundNode = find_first_node(PolygonToFind);
 		
 		// Now load up the node aliases and check for children
 		if (FoundNode)
@@ -229,6 +197,69 @@ void RenderSortPolyClass::sort_render_tree()
 	}
 
 	while (last_leaf != &Nodes.front()); /* continue until we remove the root */
+	
+	sorted_clipping_window_count = RVPtr->ClippingWindows.size();
+}
+
+// Look for the first node with that polygon index in the polygon-sort tree
+// (sorting only unlinks nodes from their parents, so this works after it too)
+node_data *RenderSortPolyClass::find_first_node(short polygon_index)
+{
+	node_data *CurrNode = &RVPtr->Nodes.front();
+	while(true)
+	{
+		int32 PolyDiff = int32(polygon_index) - int32(CurrNode->polygon_index);
+		if (PolyDiff > 0)
+		{
+			node_data *NextNode = CurrNode->PS_Greater;
+			if (NextNode)
+				// Advance
+				CurrNode = NextNode;
+			else
+				// Failed
+				return NULL;
+		}
+		else if (PolyDiff < 0)
+		{
+			node_data *NextNode = CurrNode->PS_Less;
+			if (NextNode)
+				// Advance
+				CurrNode = NextNode;
+			else
+				// Failed
+				return NULL;
+		}
+		else // Equal: the search was a success
+			return CurrNode;
+	}
+}
+
+void RenderSortPolyClass::reuse_sorted_render_tree(bool rebuild_clipping_windows)
+{
+	assert(view);	// Idiot-proofing
+	assert(RVPtr);
+	vector<clipping_window_data>& ClippingWindows = RVPtr->ClippingWindows;
+	
+	for (auto& sorted_node : SortedNodes)
+	{
+		sorted_node.interior_objects= NULL;
+		sorted_node.exterior_objects= NULL;
+		if (rebuild_clipping_windows)
+			sorted_node.clipping_windows= NULL;
+	}
+	
+	if (!rebuild_clipping_windows)
+	{
+		// Drop the windows object placement made; shrinking leaves the sorted nodes' pointers valid
+		ClippingWindows.resize(sorted_clipping_window_count);
+		return;
+	}
+	
+	// Build them again in the same order as sort_render_tree() did
+	ClippingWindows.clear();
+	for (auto& sorted_node : SortedNodes)
+		sorted_node.clipping_windows= build_clipping_windows(find_first_node(sorted_node.polygon_index));
+	sorted_clipping_window_count = ClippingWindows.size();
 }
 
 /* ---------- initializing and calculating clip data */
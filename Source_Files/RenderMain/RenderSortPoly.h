@@ -56,6 +56,8 @@ class RenderSortPolyClass
 
 	void initialize_sorted_render_tree();
 	
+	node_data *find_first_node(short polygon_index);
+	
 	clipping_window_data *build_clipping_windows(node_data *ChainBegin);
 
 	void calculate_vertical_clip_data(line_clip_data **accumulated_line_clips,
@@ -75,6 +77,10 @@ public:
 	// used in build_clipping_windows()
 	vector<endpoint_clip_data *> AccumulatedEndpointClips;
 	vector<line_clip_data *> AccumulatedLineClips;
+	
+	// How many of the clipping windows belong to the sorted nodes;
+	// object placement adds its own after these
+	size_t sorted_clipping_window_count;
 
 	// Pointers to view and calculated visibility tree
 	view_data *view;
@@ -86,6 +92,10 @@ public:
 
 	// Does the sorting
 	void sort_render_tree();
+	
+	// Takes the last sorting for a reused render tree (see RenderVisTreeClass::check_reuse()),
+	// dropping its render objects; rebuilds the clipping windows if its line clips were updated
+	void reuse_sorted_render_tree(bool rebuild_clipping_windows);
   	
   	// Inits everything
  	RenderSortPolyClass();
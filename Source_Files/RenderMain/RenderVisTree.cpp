@@ -31,6 +31,7 @@
 
 #include "map.h"
 #include "RenderVisTree.h"
+#include "crc.h"
 
 
 // LP: "recommended" sizes of stuff in growable lists
@@ -77,9 +78,11 @@ inline void INITIALIZE_NODE(node_data *node, short node_polygon_index, uint16 no
 
 // Inits everything
 RenderVisTreeClass::RenderVisTreeClass():
-	view(NULL), mark_as_explored(false), add_to_automap(true)
+	built_geometry_hash(0), tree_is_valid(false), view(NULL), mark_as_explored(false), add_to_automap(true)
 {
 	PolygonQueue.reserve(POLYGON_QUEUE_SIZE);
+	VisitedPolygons.reserve(POLYGON_QUEUE_SIZE);
+	LineClipSources.reserve(MAXIMUM_LINE_CLIPS);
 	EndpointClips.reserve(MAXIMUM_ENDPOINT_CLIPS);
 	LineClips.reserve(MAXIMUM_LINE_CLIPS);
 	ClippingWindows.reserve(MAXIMUM_CLIPPING_WINDOWS);
@@ -107,6 +110,7 @@ void RenderVisTreeClass::PUSH_POLYGON_INDEX(short polygon_index)
 		
 		// polygon_queue[polygon_queue_size++]= polygon_index;
 		SET_RENDER_FLAG(polygon_index, _polygon_is_visible);
+		VisitedPolygons.push_back(polygon_index);
 	}
 }
 
@@ -117,6 +121,7 @@ void RenderVisTreeClass::build_render_tree()
 
 	/* initialize the queue where we remember polygons we need to fire at */
 	initialize_polygon_queue();
+	VisitedPolygons.clear();
 
 	/* initialize our node list to contain the root, etc. */
 	initialize_render_tree();
@@ -179,6 +184,105 @@ void RenderVisTreeClass::build_render_tree()
 			}
 		}
 	}
+	
+	built_key = get_view_key();
+	built_geometry_hash = calculate_geometry_hash();
+	tree_is_valid = true;
+}
+
+/* ---------- reusing the render tree */
+
+RenderVisTreeClass::tree_view_key RenderVisTreeClass::get_view_key()
+{
+	tree_view_key key;
+	
+	key.origin_polygon_index = view->origin_polygon_index;
+	key.origin = {view->origin.x, view->origin.y};
+	key.yaw = view->yaw;
+	key.left_edge = view->left_edge;
+	key.right_edge = view->right_edge;
+	key.screen_width = view->screen_width;
+	key.screen_height = view->screen_height;
+	key.world_to_screen_x = view->world_to_screen_x;
+	key.origin_z = view->origin.z;
+	key.world_to_screen_y = view->world_to_screen_y;
+	key.dtanpitch = view->dtanpitch;
+	
+	return key;
+}
+
+/* FNV-1a over the map state the rays looked at: the heights of every visited polygon and
+	the heights and transparency of their lines and endpoints (platforms, doors, Lua and
+	interpolated frames all change these) */
+uint32 RenderVisTreeClass::calculate_geometry_hash()
+{
+	uint32 hash= FNV1A_OFFSET_BASIS;
+	auto add= [&hash](int32 value) { hash= calculate_value_fnv1a(value, hash); };
+	
+	add(static_cast<int32>(VisitedPolygons.size()));
+	for (auto polygon_index : VisitedPolygons)
+	{
+		polygon_data *polygon= get_polygon_data(polygon_index);
+		
+		add(polygon_index);
+		add(polygon->floor_height), add(polygon->ceiling_height);
+		for (short i= 0; i<polygon->vertex_count; ++i)
+		{
+			line_data *line= get_line_data(polygon->line_indexes[i]);
+			endpoint_data *endpoint= get_endpoint_data(polygon->endpoint_indexes[i]);
+			
+			add(line->flags);
+			add(line->highest_adjacent_floor), add(line->lowest_adjacent_ceiling);
+			// the low bits are solid/elevation/transparent; the rest are transform overflow flags
+			add(endpoint->flags&7);
+		}
+	}
+	
+	return hash;
+}
+
+short RenderVisTreeClass::check_reuse()
+{
+	assert(view);
+	
+	if (!tree_is_valid)
+		return _render_tree_stale;
+	
+	tree_view_key key = get_view_key();
+	if (key.origin_polygon_index != built_key.origin_polygon_index ||
+		key.origin.x != built_key.origin.x || key.origin.y != built_key.origin.y ||
+		key.yaw != built_key.yaw ||
+		key.left_edge.i != built_key.left_edge.i || key.left_edge.j != built_key.left_edge.j ||
+		key.right_edge.i != built_key.right_edge.i || key.right_edge.j != built_key.right_edge.j ||
+		key.screen_width != built_key.screen_width || key.screen_height != built_key.screen_height ||
+		key.world_to_screen_x != built_key.world_to_screen_x)
+		return _render_tree_stale;
+	
+	if (calculate_geometry_hash() != built_geometry_hash)
+		return _render_tree_stale;
+	
+	if (key.origin_z != built_key.origin_z ||
+		key.world_to_screen_y != built_key.world_to_screen_y ||
+		key.dtanpitch != built_key.dtanpitch)
+		return _render_tree_vertical_change;
+	
+	return _render_tree_unchanged;
+}
+
+/* which lines clip, and where they clip horizontally, depends only on the viewer's position
+	and yaw; their top and bottom clips are all the viewer's height and pitch affect */
+void RenderVisTreeClass::update_vertical_clips()
+{
+	assert(tree_is_valid);
+	
+	initialize_screen_line_clip();
+	for (size_t k= NUMBER_OF_INITIAL_LINE_CLIPS; k<LineClips.size(); ++k)
+	{
+		const auto& source= LineClipSources[k];
+		calculate_vertical_line_clip_data(&LineClips[k], source.first, source.second);
+	}
+	
+	built_key = get_view_key();
 }
 
 /* ---------- building the render tree */
@@ -620,25 +724,27 @@ void RenderVisTreeClass::initialize_clip_data()
 	}
 	
 	ResetLineClips();
-
-	/* set default line clip (top and bottom of screen) */
-	{
-		line_clip_data *line= &LineClips[indexTOP_AND_BOTTOM_OF_SCREEN];
-
-		line->flags= _clip_up|_clip_down;
-		line->x0 = INT16_MIN;
-		line->x1 = INT16_MAX;
-		line->top_y = 0;
-		line->bottom_y = view->screen_height;
-		// Top clip vector is negated to clip upward
-		line->top_vector = {-view->world_to_screen_y, -(+view->half_screen_height + view->dtanpitch)}; // {i, k}
-		line->bottom_vector = {view->world_to_screen_y, -view->half_screen_height + view->dtanpitch}; // {i, k}
-	}
+	initialize_screen_line_clip();
 
 	// LP change:
 	ClippingWindows.clear();
 }
 
+/* set default line clip (top and bottom of screen) */
+void RenderVisTreeClass::initialize_screen_line_clip()
+{
+	line_clip_data *line= &LineClips[indexTOP_AND_BOTTOM_OF_SCREEN];
+
+	line->flags= _clip_up|_clip_down;
+	line->x0 = INT16_MIN;
+	line->x1 = INT16_MAX;
+	line->top_y = 0;
+	line->bottom_y = view->screen_height;
+	// Top clip vector is negated to clip upward
+	line->top_vector = {-view->world_to_screen_y, -(+view->half_screen_height + view->dtanpitch)}; // {i, k}
+	line->bottom_vector = {view->world_to_screen_y, -view->half_screen_height + view->dtanpitch}; // {i, k}
+}
+
 void RenderVisTreeClass::calculate_line_clipping_information(
 	short line_index,
 	uint16 clip_flags)
@@ -652,12 +758,26 @@ void RenderVisTreeClass::calculate_line_clipping_information(
 	assert(Length >= 1);
 	size_t LastIndex = Length-1;
 	
+	assert(!TEST_RENDER_FLAG(line_index, _line_has_clip_data));
+
+	SET_RENDER_FLAG(line_index, _line_has_clip_data);
+	line_clip_indexes[line_index]= static_cast<vector<size_t>::value_type>(LastIndex);
+	
+	LineClipSources.resize(Length);
+	LineClipSources[LastIndex]= {line_index, clip_flags};
+	
+	calculate_vertical_line_clip_data(&LineClips[LastIndex], line_index, clip_flags);
+}
+
+void RenderVisTreeClass::calculate_vertical_line_clip_data(
+	line_clip_data *data,
+	short line_index,
+	uint16 clip_flags)
+{
 	line_data *line= get_line_data(line_index);
 	// LP change: relabeling p0 and p1 so as not to conflict with later use
 	world_point2d p0_orig= get_endpoint_data(line->endpoint_indexes[0])->vertex;
 	world_point2d p1_orig= get_endpoint_data(line->endpoint_indexes[1])->vertex;
-	// LP addition: place for new line data
-	line_clip_data *data= &LineClips[LastIndex];
 
 	/* it’s possible (in fact, likely) that this line’s endpoints have not been transformed yet,
 		so we have to do it ourselves */
@@ -674,10 +794,6 @@ void RenderVisTreeClass::calculate_line_clipping_information(
 	
 	clip_flags&= _clip_up|_clip_down;	
 	assert(clip_flags&(_clip_up|_clip_down));
-	assert(!TEST_RENDER_FLAG(line_index, _line_has_clip_data));
-
-	SET_RENDER_FLAG(line_index, _line_has_clip_data);
-	line_clip_indexes[line_index]= static_cast<vector<size_t>::value_type>(LastIndex);
 	
 	data->flags= 0;
 
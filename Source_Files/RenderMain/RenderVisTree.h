@@ -83,6 +83,13 @@ enum /* top and bottom sides of screen */
 	NUMBER_OF_INITIAL_LINE_CLIPS
 };
 
+enum /* RenderVisTreeClass::check_reuse() results */
+{
+	_render_tree_stale, /* build it again */
+	_render_tree_unchanged, /* nothing it depends on has changed; use it as is */
+	_render_tree_vertical_change /* only the viewer's height or pitch changed; the line clips need recalculating */
+};
+
 struct line_clip_data
 {
 	uint16 flags;
@@ -160,6 +167,32 @@ class RenderVisTreeClass
 	/* translates from map indexes to clip indexes, only valid if appropriate render flag is set */
 	vector<size_t> line_clip_indexes;
 	
+	// What the last tree was built from, so the next frame can tell whether it can reuse it
+	struct tree_view_key
+	{
+		short origin_polygon_index;
+		world_point2d origin;
+		angle yaw;
+		long_vector2d left_edge, right_edge;
+		short screen_width, screen_height;
+		short world_to_screen_x;
+		
+		// only the line clips depend on these
+		world_distance origin_z;
+		short world_to_screen_y;
+		short dtanpitch;
+	};
+	tree_view_key built_key;
+	uint32 built_geometry_hash;
+	bool tree_is_valid;
+	
+	// Every polygon the last tree visited, and the (line, clip flags) each line clip was made from
+	vector<short> VisitedPolygons;
+	vector<std::pair<short, uint16> > LineClipSources;
+	
+	tree_view_key get_view_key();
+	uint32 calculate_geometry_hash();
+	
 	// Turned preprocessor macro into function
 	void PUSH_POLYGON_INDEX(short polygon_index);
 	
@@ -181,6 +214,10 @@ class RenderVisTreeClass
 
 	void calculate_line_clipping_information(short line_index, uint16 clip_flags);
 	
+	void calculate_vertical_line_clip_data(line_clip_data *data, short line_index, uint16 clip_flags);
+	
+	void initialize_screen_line_clip();
+	
 	short calculate_endpoint_clipping_information(short endpoint_index, uint16 clip_flags);
 	
 	void ResetEndpointClips(void);
@@ -232,6 +269,16 @@ public:
 	
 	// Builds the visibility tree
  	void build_render_tree();
+	
+	// Whether the last tree can be used for the view as it is now (see the enum above);
+	// the render flags and transformed endpoints it left behind must still be intact
+	short check_reuse();
+	
+	// Recalculates the line clips of the last tree for the view's new height and pitch
+	void update_vertical_clips();
+	
+	// The next check_reuse() says _render_tree_stale
+	void invalidate() {tree_is_valid = false;}
  	
   	// Inits everything
  	RenderVisTreeClass();
@@ -1,6 +1,13 @@
 R"(
 
+#ifdef TEXTURE_ARRAY
+#extension GL_EXT_texture_array : require
+uniform sampler2DArray texture0;
+#define SAMPLE_TEXTURE0(coords) texture2DArray(texture0, vec3(coords, gl_TexCoord[0].z))
+#else
 uniform sampler2D texture0;
+#define SAMPLE_TEXTURE0(coords) texture2D(texture0, coords)
+#endif
 uniform sampler2D texture1;
 uniform float pulsate;
 uniform float wobble;
@@ -45,7 +52,7 @@ void main (void) {
 	if (glow > 0.001) {
 		diffuse = 1.0;
 	}
-	vec4 color = texture2D(texture0, texCoords.xy);
+	vec4 color = SAMPLE_TEXTURE0(texCoords.xy);
 	vec3 intensity = clamp(vertexColor.rgb, glow, 1.0);
 	intensity = clamp(intensity * bloomScale + bloomShift, 0.0, 1.0);
 #ifdef GAMMA_CORRECTED_BLENDING
@@ -5,14 +5,26 @@ uniform float strictDepthMode;
 varying vec3 viewDir;
 varying vec4 vertexColor;
 varying float classicDepth;
+#ifdef SKINNED
+/* rows of each bone's transform; gl_MultiTexCoord2 = (bone 0, bone 1, blend) */
+uniform vec4 bones[3 * MAX_BONES];
+vec4 skinPoint(int bone, vec4 p) {
+	return vec4(dot(bones[3*bone], p), dot(bones[3*bone+1], p), dot(bones[3*bone+2], p), 1.0);
+}
+#endif
 void main(void) {
-	gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+#ifdef SKINNED
+	vec4 vertex = mix(skinPoint(int(gl_MultiTexCoord2.x + 0.5), gl_Vertex), skinPoint(int(gl_MultiTexCoord2.y + 0.5), gl_Vertex), gl_MultiTexCoord2.z);
+#else
+	vec4 vertex = gl_Vertex;
+#endif
+	gl_Position = gl_ModelViewProjectionMatrix * vertex;
 	classicDepth = gl_Position.z / 8192.0;
 #ifndef DISABLE_CLIP_VERTEX
-	gl_ClipVertex = gl_ModelViewMatrix * gl_Vertex;
+	gl_ClipVertex = gl_ModelViewMatrix * vertex;
 #endif
 	vec4 v = gl_ModelViewMatrixInverse * vec4(0.0, 0.0, 0.0, 1.0);
-	viewDir = (gl_Vertex - v).xyz;
+	viewDir = (vertex - v).xyz;
 	gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;
 	vertexColor = gl_Color;
 }
@@ -1,6 +1,13 @@
 R"(
 
+#ifdef TEXTURE_ARRAY
+#extension GL_EXT_texture_array : require
+uniform sampler2DArray texture0;
+#define SAMPLE_TEXTURE0(coords) texture2DArray(texture0, vec3(coords, gl_TexCoord[0].z))
+#else
 uniform sampler2D texture0;
+#define SAMPLE_TEXTURE0(coords) texture2D(texture0, coords)
+#endif
 uniform float pulsate;
 uniform float wobble;
 uniform float glow;
@@ -40,7 +47,7 @@ void main (void) {
 #ifdef GAMMA_CORRECTED_BLENDING
 	intensity = intensity * intensity; // approximation of pow(intensity, 2.2)
 #endif
-	vec4 color = texture2D(texture0, texCoords.xy);
+	vec4 color = SAMPLE_TEXTURE0(texCoords.xy);
 	float fogFactor = getFogFactor(length(viewDir));
 	gl_FragColor = vec4(mix(gl_Fog.color.rgb, color.rgb * intensity, fogFactor), vertexColor.a * color.a);
 }
@@ -5,23 +5,45 @@ varying vec3 viewXY;
 varying vec3 viewDir;
 varying vec4 vertexColor;
 varying float classicDepth;
+#ifdef SKINNED
+/* rows of each bone's transform; gl_MultiTexCoord2 = (bone 0, bone 1, blend) */
+uniform vec4 bones[3 * MAX_BONES];
+vec4 skinPoint(int bone, vec4 p) {
+	return vec4(dot(bones[3*bone], p), dot(bones[3*bone+1], p), dot(bones[3*bone+2], p), 1.0);
+}
+vec3 skinVector(int bone, vec3 v) {
+	return vec3(dot(bones[3*bone].xyz, v), dot(bones[3*bone+1].xyz, v), dot(bones[3*bone+2].xyz, v));
+}
+#endif
 void main(void) {
-	gl_Position  = gl_ModelViewProjectionMatrix * gl_Vertex;
+#ifdef SKINNED
+	int bone0 = int(gl_MultiTexCoord2.x + 0.5);
+	int bone1 = int(gl_MultiTexCoord2.y + 0.5);
+	float blend = gl_MultiTexCoord2.z;
+	vec4 vertex = mix(skinPoint(bone0, gl_Vertex), skinPoint(bone1, gl_Vertex), blend);
+	vec3 normal = mix(skinVector(bone0, gl_Normal), skinVector(bone1, gl_Normal), blend);
+	vec3 tangent = mix(skinVector(bone0, gl_MultiTexCoord1.xyz), skinVector(bone1, gl_MultiTexCoord1.xyz), blend);
+#else
+	vec4 vertex = gl_Vertex;
+	vec3 normal = gl_Normal;
+	vec3 tangent = gl_MultiTexCoord1.xyz;
+#endif
+	gl_Position  = gl_ModelViewProjectionMatrix * vertex;
 	gl_Position.z = gl_Position.z + depth*gl_Position.z/65536.0;
 	classicDepth = gl_Position.z / 8192.0;
 #ifndef DISABLE_CLIP_VERTEX
-	gl_ClipVertex = gl_ModelViewMatrix * gl_Vertex;
+	gl_ClipVertex = gl_ModelViewMatrix * vertex;
 #endif
 	gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;
 	/* SETUP TBN MATRIX in normal matrix coords, gl_MultiTexCoord1 = tangent vector */
-	vec3 n = normalize(gl_NormalMatrix * gl_Normal);
-	vec3 t = normalize(gl_NormalMatrix * gl_MultiTexCoord1.xyz);
+	vec3 n = normalize(gl_NormalMatrix * normal);
+	vec3 t = normalize(gl_NormalMatrix * tangent);
 	vec3 b = normalize(cross(n, t) * gl_MultiTexCoord1.w);
 	/* (column wise) */
 	mat3 tbnMatrix = mat3(t.x, b.x, n.x, t.y, b.y, n.y, t.z, b.z, n.z);
 
 	/* SETUP VIEW DIRECTION in unprojected local coords */
-	viewDir = tbnMatrix * (gl_ModelViewMatrix * gl_Vertex).xyz;
+	viewDir = tbnMatrix * (gl_ModelViewMatrix * vertex).xyz;
 	viewXY = -(gl_TextureMatrix[0] * vec4(viewDir.xyz, 1.0)).xyz;
 	viewDir = -viewDir;
 	vertexColor = gl_Color;
@@ -1,6 +1,13 @@
 R"(
 
+#ifdef TEXTURE_ARRAY
+#extension GL_EXT_texture_array : require
+uniform sampler2DArray texture0;
+#define SAMPLE_TEXTURE0(coords) texture2DArray(texture0, vec3(coords, gl_TexCoord[0].z))
+#else
 uniform sampler2D texture0;
+#define SAMPLE_TEXTURE0(coords) texture2D(texture0, coords)
+#endif
 uniform float pulsate;
 uniform float wobble;
 uniform float glow;
@@ -29,7 +36,7 @@ void main (void) {
 	vec3 normXY = normalize(viewXY);
 	texCoords += vec3(normXY.y * -pulsate, normXY.x * pulsate, 0.0);
 	texCoords += vec3(normXY.y * -wobble * texCoords.y, wobble * texCoords.y, 0.0);
-	vec4 color = texture2D(texture0, texCoords.xy);
+	vec4 color = SAMPLE_TEXTURE0(texCoords.xy);
 	vec3 intensity = clamp(vertexColor.rgb, glow, 1.0);
 	float diffuse = abs(dot(vec3(0.0, 0.0, 1.0), normalize(viewDir)));
 	intensity = clamp(intensity * bloomScale + bloomShift, 0.0, 1.0);
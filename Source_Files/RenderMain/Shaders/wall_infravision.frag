@@ -1,6 +1,13 @@
 R"(
 
+#ifdef TEXTURE_ARRAY
+#extension GL_EXT_texture_array : require
+uniform sampler2DArray texture0;
+#define SAMPLE_TEXTURE0(coords) texture2DArray(texture0, vec3(coords, gl_TexCoord[0].z))
+#else
 uniform sampler2D texture0;
+#define SAMPLE_TEXTURE0(coords) texture2D(texture0, coords)
+#endif
 uniform float pulsate;
 uniform float wobble;
 uniform float fogMode;
@@ -27,7 +34,7 @@ void main (void) {
 	vec3 normXY = normalize(viewXY);
 	texCoords += vec3(normXY.y * -pulsate, normXY.x * pulsate, 0.0);
 	texCoords += vec3(normXY.y * -wobble * texCoords.y, wobble * texCoords.y, 0.0);
-	vec4 color = texture2D(texture0, texCoords.xy);
+	vec4 color = SAMPLE_TEXTURE0(texCoords.xy);
 	float avg = (color.r + color.g + color.b) / 3.0;
 	float fogFactor = getFogFactor(length(viewDir));
 	gl_FragColor = vec4(mix(gl_Fog.color.rgb, vertexColor.rgb * avg, fogFactor), vertexColor.a * color.a);
@@ -0,0 +1,250 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+#include "TextureCache.h"
+
+#include "AStream.h"
+#include "ImageLoader.h"
+#include "Logging.h"
+#include "crc.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Bump when the packed image format changes
+static const uint32 kTextureCacheVersion = 1;
+static const uint32 kTextureCacheMagic = 0x41425443; // 'ABTC'
+
+static const char* kTextureCacheDirectory = "Textures";
+
+static std::string hex(uint64_t value)
+{
+	char buffer[17];
+	snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+	return buffer;
+}
+
+TextureCache* TextureCache::instance()
+{
+	static TextureCache* m_instance = nullptr;
+	if (!m_instance)
+		m_instance = new TextureCache;
+	return m_instance;
+}
+
+void TextureCache::initialize_cache()
+{
+	FileSpecifier dir = directory();
+	dir.CreateDirectory();
+
+	struct entry {
+		FileSpecifier file;
+		TimeType date;
+		size_t size;
+	};
+	std::vector<entry> entries;
+
+	size_t total = 0;
+	for (const auto& it : dir.ReadDirectory())
+	{
+		if (it.is_directory)
+			continue;
+
+		FileSpecifier file = dir + it.name;
+
+		// Left over from a write that never finished
+		if (it.name.size() < 4 || it.name.compare(it.name.size() - 4, 4, ".tex") != 0)
+		{
+			file.Delete();
+			continue;
+		}
+
+		OpenedFile opened;
+		int32 length = 0;
+		if (!file.Open(opened) || !opened.GetLength(length))
+			continue;
+		opened.Close();
+
+		entries.push_back({file, it.date, static_cast<size_t>(length)});
+		total += length;
+	}
+
+	if (total > m_sizelimit)
+	{
+		// Make some room for this run's textures too
+		std::sort(entries.begin(), entries.end(), [](const entry& a, const entry& b) { return a.date < b.date; });
+		for (auto& it : entries)
+		{
+			if (total <= m_sizelimit / 4 * 3)
+				break;
+			if (it.file.Delete())
+				total -= it.size;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_cachesize = total;
+	m_initialized = true;
+}
+
+void TextureCache::add_file_to_key(std::string& key, FileSpecifier& file)
+{
+	OpenedFile opened;
+	int32 length = 0;
+	if (file == FileSpecifier() || !file.Open(opened) || !opened.GetLength(length))
+	{
+		key += " -";
+		return;
+	}
+	opened.Close();
+
+	// Reading every source image just to build its key costs about as
+	// much as decoding it, so trust the file system to notice changes
+	key += " " + std::string(file.GetPath()) + ":" + std::to_string(length) + ":" + std::to_string(static_cast<long long>(file.GetDate()));
+}
+
+std::string TextureCache::name_for_key(const std::string& key) const
+{
+	// FNV-1a; keys only need to tell files apart, not resist tampering
+	return hex(calculate_data_fnv1a_64(key.data(), key.size()));
+}
+
+FileSpecifier TextureCache::directory() const
+{
+	FileSpecifier dir;
+	dir.SetToImageCacheDir();
+	dir.AddPart(kTextureCacheDirectory);
+	return dir;
+}
+
+bool TextureCache::retrieve(const std::string& key, ImageDescriptor& normal, ImageDescriptor& glow, ImageDescriptor& offset)
+{
+	if (!m_initialized)
+		return false;
+
+	FileSpecifier file = directory() + name_for_key(key) + ".tex";
+	OpenedFile opened;
+	int32 length = 0;
+	if (!file.Exists() || !file.Open(opened) || !opened.GetLength(length))
+		return false;
+
+	// One read for the whole entry
+	std::vector<uint8> data(length);
+	if (!opened.Read(length, data.data()))
+		return false;
+	opened.Close();
+
+	try
+	{
+		AIStreamLE stream(data.data(), data.size());
+
+		uint32 magic, version, key_length;
+		stream >> magic >> version >> key_length;
+		if (magic != kTextureCacheMagic || version != kTextureCacheVersion || key_length != key.size())
+			return false;
+
+		std::string stored_key(key_length, '\0');
+		stream.read(&stored_key[0], key_length);
+		if (stored_key != key)
+			return false;
+
+		ImageDescriptor new_normal, new_glow, new_offset;
+		new_normal.Unpack(stream);
+		new_glow.Unpack(stream);
+		new_offset.Unpack(stream);
+
+		normal.Swap(new_normal);
+		glow.Swap(new_glow);
+		offset.Swap(new_offset);
+		return true;
+	}
+	catch (const AStream::failure& e)
+	{
+		logWarning("Discarding damaged texture cache entry %s (%s)", file.GetPath(), e.what());
+		file.Delete();
+		return false;
+	}
+}
+
+void TextureCache::store(const std::string& key, const ImageDescriptor& normal, const ImageDescriptor& glow, const ImageDescriptor& offset)
+{
+	if (!m_initialized)
+		return;
+
+	std::string name = name_for_key(key);
+	FileSpecifier file = directory() + (name + ".tex");
+
+	// An entry that went stale is about to be overwritten
+	size_t replaced = 0;
+	{
+		OpenedFile opened;
+		int32 old_length = 0;
+		if (file.Exists() && file.Open(opened) && opened.GetLength(old_length))
+			replaced = old_length;
+	}
+
+	size_t length = 12 + key.size() + normal.GetPackedSize() + glow.GetPackedSize() + offset.GetPackedSize();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_cachesize + length > m_sizelimit + replaced)
+			return;
+		m_cachesize += length;
+	}
+
+	std::vector<uint8> data(length);
+	AOStreamLE stream(data.data(), data.size());
+	stream << kTextureCacheMagic << kTextureCacheVersion << static_cast<uint32>(key.size());
+	stream.write(const_cast<char*>(key.data()), key.size());
+	normal.Pack(stream);
+	glow.Pack(stream);
+	offset.Pack(stream);
+
+	// Write under a name of its own and rename, so that a reader never
+	// sees half an entry
+	FileSpecifier temporary = directory() + (name + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())));
+
+	OpenedFile opened;
+	bool success = temporary.Open(opened, true) && opened.Write(static_cast<int32>(length), data.data());
+	opened.Close();
+
+	// Windows won't always rename over an existing file, so move the old
+	// entry out of the way and try again
+	if (success && !temporary.Rename(file))
+		success = file.Exists() && file.Delete() && temporary.Rename(file);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (success)
+	{
+		m_cachesize -= std::min(replaced, m_cachesize);
+	}
+	else
+	{
+		logWarning("Couldn't write texture cache entry %s", file.GetPath());
+		temporary.Delete();
+		m_cachesize -= length;
+		if (!file.Exists())
+			m_cachesize -= std::min(replaced, m_cachesize);
+	}
+}
@@ -0,0 +1,81 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  TextureCache.h - an on-disk cache for loaded replacement textures
+ *
+ *  Decoding a replacement texture and building its mipmaps is much slower
+ *  than reading the result back, so finished images are kept in the image
+ *  cache directory, one file per texture. Entries are keyed by the source
+ *  files' paths, sizes and modification times plus every option that
+ *  changes what loading them produces; a changed image file or option
+ *  simply misses. Safe to use from the texture loader threads.
+ */
+
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include "cseries.h"
+#include "FileHandler.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+class ImageDescriptor;
+
+class TextureCache
+{
+public:
+	static TextureCache* instance();
+
+	// Call this at startup, after the image cache directory exists;
+	// trims the cache to its size limit, oldest entries first
+	void initialize_cache();
+
+	// Appends a file's path, size and modification time to a key (or a
+	// placeholder if there is no such file)
+	static void add_file_to_key(std::string& key, FileSpecifier& file);
+
+	// Reads back all three images, or returns false and leaves them alone
+	bool retrieve(const std::string& key, ImageDescriptor& normal, ImageDescriptor& glow, ImageDescriptor& offset);
+
+	void store(const std::string& key, const ImageDescriptor& normal, const ImageDescriptor& glow, const ImageDescriptor& offset);
+
+	size_t size() const { return m_cachesize; }
+	size_t limit() const { return m_sizelimit; }
+
+private:
+	TextureCache() { }
+
+	FileSpecifier directory() const;
+	std::string name_for_key(const std::string& key) const;
+
+	std::mutex m_mutex;
+	std::atomic<bool> m_initialized{false};
+	size_t m_cachesize = 0;
+	size_t m_sizelimit = size_t(2000) << 20;
+};
+
+#endif
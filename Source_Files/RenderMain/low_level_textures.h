@@ -29,12 +29,17 @@
 #include "preferences.h"
 #include "textures.h"
 #include "scottish_textures.h"
+#include "low_level_textures_simd.h"
+
+#include <type_traits>
 
 /* ---------- global state */
 
+// per thread, so that every band of a threaded frame steps through the same
+// sequence (see Rasterizer_SW_Class::End)
 inline uint16 & texture_random_seed()
 {
-	static uint16 seed = 6906;
+	static thread_local uint16 seed = 6906;
 	return seed;
 }
 
@@ -212,6 +217,13 @@ void texture_horizontal_polygon_lines
 		uint32 source_dy= data->source_dy;
 		short count= x1-x0;
 		
+		if (std::is_same<T, pixel32>::value)
+		{
+			struct horizontal_span32 span= { (pixel32 *)write, base_address, (pixel32 *)shading_table, opacity_table,
+				source_x, source_y, source_dx, source_dy, count, TEXBITS, sw_alpha_blend, rmask, gmask, bmask };
+			if (texture_horizontal_span32(span)) count= 0;
+		}
+		
 		while ((count-= 1)>=0)
 		{
 			write_pixel<T, sw_alpha_blend, false>(write++, base_address[((source_y>>(HORIZONTAL_HEIGHT_DOWNSHIFT-TEXBITS))&(((1<<TEXBITS)-1)<<TEXBITS))+(source_x>>HORIZONTAL_WIDTH_DOWNSHIFT)], shading_table, opacity_table, rmask, gmask, bmask);
@@ -252,6 +264,13 @@ void landscape_horizontal_polygon_lines(
 		uint32 source_dx= data->source_dx;
 		short count= x1-x0;
 		
+		if (std::is_same<T, pixel32>::value)
+		{
+			struct landscape_span32 span= { (pixel32 *)write, read, (pixel32 *)shading_table, source_x, source_dx,
+				landscape_texture_width_downshift, count };
+			if (landscape_horizontal_span32(span)) count= 0;
+		}
+		
 		while ((count-= 1)>=0)
 		{
 			*write++= shading_table[read[source_x>>landscape_texture_width_downshift]];
@@ -273,13 +292,51 @@ void inline copy_check_transparent(T *dst, pixel8 read, T *shading_table)
 }
 
 
+/* maps rows [y0,y1) of one column, skipping those outside [band_y0,band_y1); texture_y is
+	the texture position at y0 */
+template <typename T, int sw_alpha_blend, bool check_transparent>
+void inline texture_vertical_column(
+	T *column,
+	int bytes_per_row,
+	int y0,
+	int y1,
+	uint32 texture_y,
+	uint32 texture_dy,
+	int downshift,
+	pixel8 *read,
+	T *shading_table,
+	uint8 *opacity_table,
+	pixel32 rmask,
+	pixel32 gmask,
+	pixel32 bmask,
+	int band_y0,
+	int band_y1)
+{
+	int first= MAX(y0, band_y0), last= MIN(y1, band_y1);
+	T *write= (T *)((byte *)column + bytes_per_row * first); // invalid but unread if first >= last
+
+	texture_y+= (first-y0)*texture_dy;
+	for (int count= last-first; count>0; --count)
+	{
+		write_pixel<T, sw_alpha_blend, check_transparent>(write, read[texture_y>>downshift], shading_table, opacity_table, rmask, gmask, bmask);
+
+		write = (T *)((byte *)write + bytes_per_row);
+		texture_y+= texture_dy;
+	}
+}
+
+/* the sync and desync runs of each group of four columns are mapped without blending, so
+	the runs are always found from the whole columns; only rows in [band_y0,band_y1) are
+	written */
 template <typename T, int sw_alpha_blend, bool check_transparent>
 void texture_vertical_polygon_lines(
 	struct bitmap_definition *screen,
 	struct view_data *view,
 	struct _vertical_polygon_data *data,
 	short *y0_table,
-	short *y1_table, 
+	short *y1_table,
+	short band_y0,
+	short band_y1,
 	uint8 *opacity_table = 0)
 {
 	struct _vertical_polygon_line_data *line= (struct _vertical_polygon_line_data *) (data+1);
@@ -307,25 +364,15 @@ void texture_vertical_polygon_lines(
 
 	while (line_count>0)	
 	{
+		T *column= (T *)screen->row_addresses[0] + x;
+
 		if (line_count<4 || (x&3) || aborted)
 		{
 			int y0= *y0_table++, y1= *y1_table++;
-			uint32 texture_y= line->texture_y;
-			uint32 texture_dy= line->texture_dy;
-			T *write, *shading_table;
-			pixel8 *read;
-
-			shading_table= (T *)line->shading_table;
-			read= line->texture;
-			write = (T *)(screen->row_addresses[0] + bytes_per_row * y0) + x; // invalid but unread if y0 == screen->height
 
-			for (count= y1-y0; count>0; --count)
-			{
-				write_pixel<T, sw_alpha_blend, check_transparent>(write, read[texture_y>>downshift], shading_table, opacity_table, rmask, gmask, bmask);
-
-				write = (T *)((byte *)write + bytes_per_row);
-				texture_y+= texture_dy;
-			}
+			texture_vertical_column<T, sw_alpha_blend, check_transparent>(column, bytes_per_row, y0, y1,
+				line->texture_y, line->texture_dy, downshift, line->texture, (T *)line->shading_table,
+				opacity_table, rmask, gmask, bmask, band_y0, band_y1);
 			
 			x+= 1;
 			line+= 1;
@@ -335,86 +382,58 @@ void texture_vertical_polygon_lines(
 		}
 		else
 		{
-			uint32 texture_y0= line[0].texture_y, texture_dy0= line[0].texture_dy;
-			pixel8 *read0= line[0].texture;
-			T *shading_table0= (T *)line[0].shading_table;
-			
-			uint32 texture_y1= line[1].texture_y, texture_dy1= line[1].texture_dy;
-			pixel8 *read1= line[1].texture;
-			T *shading_table1= (T *)line[1].shading_table;
-			
-			uint32 texture_y2= line[2].texture_y, texture_dy2= line[2].texture_dy;
-			pixel8 *read2= line[2].texture;
-			T *shading_table2= (T *)line[2].shading_table;
-			
-			uint32 texture_y3= line[3].texture_y, texture_dy3= line[3].texture_dy;
-			pixel8 *read3= line[3].texture;
-			T *shading_table3= (T *)line[3].shading_table;
-			
-			T *write;
+			int ymax, ymin;
+			int i;
 
-			int ymax;
+			ymax= MAX(y0_table[0], y0_table[1]), ymax= MAX(ymax, y0_table[2]), ymax= MAX(ymax, y0_table[3]);
+			ymin= MIN(y1_table[0], y1_table[1]), ymin= MIN(ymin, y1_table[2]), ymin= MIN(ymin, y1_table[3]);
+			if (ymin<=ymax)
+			{
+				aborted= true;
+				continue;
+			}
 			
 			/* sync */	
+			for (i= 0; i<4; ++i)
 			{
-				int y0= y0_table[0], y1= y0_table[1], y2= y0_table[2], y3= y0_table[3];
-				T *temp_write;
+				texture_vertical_column<T, _sw_alpha_off, check_transparent>(column + i, bytes_per_row, y0_table[i], ymax,
+					line[i].texture_y, line[i].texture_dy, downshift, line[i].texture, (T *)line[i].shading_table,
+					opacity_table, rmask, gmask, bmask, band_y0, band_y1);
+			}
+
+			/* parallel map (x4) */
+			{
+				int first= MAX(ymax, band_y0), last= MIN(ymin, band_y1);
+
+				uint32 texture_dy0= line[0].texture_dy, texture_y0= line[0].texture_y + (first-y0_table[0])*texture_dy0;
+				pixel8 *read0= line[0].texture;
+				T *shading_table0= (T *)line[0].shading_table;
 				
-				ymax= MAX(y0, y1), ymax= MAX(ymax, y2), ymax= MAX(ymax, y3);
+				uint32 texture_dy1= line[1].texture_dy, texture_y1= line[1].texture_y + (first-y0_table[1])*texture_dy1;
+				pixel8 *read1= line[1].texture;
+				T *shading_table1= (T *)line[1].shading_table;
 				
-				{
-					int ymin= MIN(y1_table[0], y1_table[1]);
-					
-					ymin= MIN(ymin, y1_table[2]);
-					ymin= MIN(ymin, y1_table[3]);
-					
-					if (ymin<=ymax)
-					{
-						aborted= true;
-						continue;
-					}
-				}
-
-				write = (T *)screen->row_addresses[ymax] + x;
+				uint32 texture_dy2= line[2].texture_dy, texture_y2= line[2].texture_y + (first-y0_table[2])*texture_dy2;
+				pixel8 *read2= line[2].texture;
+				T *shading_table2= (T *)line[2].shading_table;
 				
-				for (count= ymax-y0, temp_write= (T *)screen->row_addresses[y0] + x; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write, read0[texture_y0>>downshift], shading_table0);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y0+= texture_dy0;
-				}
+				uint32 texture_dy3= line[3].texture_dy, texture_y3= line[3].texture_y + (first-y0_table[3])*texture_dy3;
+				pixel8 *read3= line[3].texture;
+				T *shading_table3= (T *)line[3].shading_table;
 				
-				for (count= ymax-y1, temp_write= (T *)screen->row_addresses[y1] + x; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write + 1, read1[texture_y1>>downshift], shading_table1);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y1+= texture_dy1;
-				}
+				T *write= (T *)((byte *)column + bytes_per_row * first);
 				
-				for (count= ymax-y2, temp_write= (T *)screen->row_addresses[y2] + x; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write + 2, read2[texture_y2>>downshift], shading_table2);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y2+= texture_dy2;
-				}
-		
-				for (count= ymax-y3, temp_write= (T *)screen->row_addresses[y3] + x; count>0; --count)
+				count= last-first;
+				if (std::is_same<T, pixel32>::value && count>0)
 				{
-					copy_check_transparent<T, check_transparent>(temp_write + 3, read3[texture_y3>>downshift], shading_table3);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y3+= texture_dy3;
+					struct vertical_quad32 quad= { (pixel32 *)write, bytes_per_row, count, downshift,
+						{ read0, read1, read2, read3 },
+						{ (pixel32 *)shading_table0, (pixel32 *)shading_table1, (pixel32 *)shading_table2, (pixel32 *)shading_table3 },
+						{ texture_y0, texture_y1, texture_y2, texture_y3 },
+						{ texture_dy0, texture_dy1, texture_dy2, texture_dy3 },
+						check_transparent, sw_alpha_blend, opacity_table, rmask, gmask, bmask };
+					if (texture_vertical_quad32(quad)) count= 0;
 				}
-			}
-
-			/* parallel map (x4) */
-			{
-				int dy0= y1_table[0] - ymax;
-				int dy1= y1_table[1] - ymax;
-				int dy2= y1_table[2] - ymax;
-				int dy3= y1_table[3] - ymax;
-				
-				count= MIN(dy0, dy1), count= MIN(count, dy2), count= MIN(count, dy3);
-				ymax+= count;
 				
 				for (; count>0; --count)
 				{
@@ -435,36 +454,11 @@ void texture_vertical_polygon_lines(
 			}
 
 			/* desync */	
+			for (i= 0; i<4; ++i)
 			{
-				T *temp_write;
-				
-				for (count= y1_table[0] - ymax, temp_write= write; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write, read0[texture_y0>>downshift], shading_table0);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y0+= texture_dy0;
-				}
-				
-				for (count= y1_table[1] - ymax, temp_write= write; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write + 1, read1[texture_y1>>downshift], shading_table1);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y1+= texture_dy1;
-				}
-				
-				for (count= y1_table[2] - ymax, temp_write= write; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write + 2, read2[texture_y2>>downshift], shading_table2);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y2+= texture_dy2;
-				}
-		
-				for (count= y1_table[3] - ymax, temp_write= write; count>0; --count)
-				{
-					copy_check_transparent<T, check_transparent>(temp_write + 3, read3[texture_y3>>downshift], shading_table3);
-					temp_write = (T *)((byte *)temp_write + bytes_per_row);
-					texture_y3+= texture_dy3;
-				}
+				texture_vertical_column<T, _sw_alpha_off, check_transparent>(column + i, bytes_per_row, ymin, y1_table[i],
+					(uint32)line[i].texture_y + (ymin-y0_table[i])*(uint32)line[i].texture_dy, line[i].texture_dy, downshift, line[i].texture, (T *)line[i].shading_table,
+					opacity_table, rmask, gmask, bmask, band_y0, band_y1);
 			}
 
 			y0_table+= 4, y1_table+= 4;
@@ -540,6 +534,8 @@ void tint_vertical_polygon_lines(
 	struct _vertical_polygon_data *data,
 	short *y0_table,
 	short *y1_table,
+	short band_y0,
+	short band_y1,
 	uint16 transfer_data)
 {
 	short tint_table_index= transfer_data&0xff;
@@ -559,11 +555,13 @@ void tint_vertical_polygon_lines(
 	while ((line_count-= 1)>=0)
 	{
 		short y0= *y0_table++, y1= *y1_table++;
-		T *write= (T *) screen->row_addresses[y0] + x;
+		short first= MAX(y0, band_y0), last= MIN(y1, band_y1);
+		T *write= (T *) (screen->row_addresses[0] + bytes_per_row * first) + x;
 		pixel8 *read= line->texture;
 		_fixed texture_y= line->texture_y, texture_dy= line->texture_dy;
-		short count= y1-y0;
+		short count= last-first;
 
+		texture_y+= (first-y0)*texture_dy;
 		while ((count-=1)>=0)
 		{
 			if (read[FIXED_INTEGERAL_PART(texture_y)])
@@ -601,6 +599,8 @@ void randomize_vertical_polygon_lines(
 	struct _vertical_polygon_data *data,
 	short *y0_table,
 	short *y1_table,
+	short band_y0,
+	short band_y1,
 	uint16 transfer_data)
 {
 	struct _vertical_polygon_line_data *line= (struct _vertical_polygon_line_data *) (data+1);
@@ -618,13 +618,13 @@ void randomize_vertical_polygon_lines(
 		T *write= (T *) screen->row_addresses[y0] + x;
 		pixel8 *read= line->texture;
 		_fixed texture_y= line->texture_y, texture_dy= line->texture_dy;
-		short count= y1-y0;
 
-		while ((count-=1)>=0)
+		/* rows outside the band still step the seed, so every band sees the same static */
+		for (short y= y0; y<y1; ++y)
 		{
 			if (!check_transparent || read[texture_y>>(data->downshift)])
 			{
-				if (seed >= drop_less_than) *write = randomize_vertical_polygon_lines_write<T>(seed);
+				if (seed >= drop_less_than && y >= band_y0 && y < band_y1) *write = randomize_vertical_polygon_lines_write<T>(seed);
 				if (seed&1) seed= (seed>>1)^0xb400; else seed= seed>>1;
 			}
 
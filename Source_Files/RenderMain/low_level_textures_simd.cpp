@@ -0,0 +1,375 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  low_level_textures_simd.cpp - vector versions of the 32-bit texture mapper loops
+ *
+ *  SSE2 maps four pixels at a time; it has no gathers, so it only saves the
+ *  blending and the stores. AVX2 maps eight, gathering the texels and the
+ *  shading table entries. Both give exactly the scalar results: texture
+ *  coordinates wrap the same way in 32-bit lanes, and the "nice" blend is
+ *  done per byte with the same rounding (which needs 8-bit red, green and
+ *  blue channels in the low 24 bits, as the scalar blend already assumes).
+ */
+
+#include "low_level_textures_simd.h"
+#include "low_level_textures.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TEXTURE_SIMD_X86
+#include <immintrin.h>
+
+#if defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+#endif
+
+static int simd_level = texture_simd_supported();
+
+int texture_simd_supported(void)
+{
+#ifdef TEXTURE_SIMD_X86
+	if (SDL_HasAVX2()) return _texture_simd_avx2;
+	if (SDL_HasSSE2()) return _texture_simd_sse2;
+#endif
+	return _texture_simd_none;
+}
+
+int get_texture_simd_level(void)
+{
+	return simd_level;
+}
+
+void set_texture_simd_level(int level)
+{
+	simd_level = PIN(level, _texture_simd_none, texture_simd_supported());
+}
+
+/* ---------- scalar */
+
+static inline void blend_pixel(pixel32 *write, pixel32 pixel, uint8 alpha, int sw_alpha_blend, pixel32 rmask, pixel32 gmask, pixel32 bmask)
+{
+	switch (sw_alpha_blend)
+	{
+		case _sw_alpha_off: *write = pixel; break;
+		case _sw_alpha_fast: *write = average(pixel, *write); break;
+		case _sw_alpha_nice: *write = alpha_blend(pixel, *write, alpha, rmask, gmask, bmask); break;
+	}
+}
+
+static bool byte_channels(pixel32 rmask, pixel32 gmask, pixel32 bmask)
+{
+	return (rmask|gmask|bmask) == 0x00ffffff &&
+		(rmask == 0xff || rmask == 0xff00 || rmask == 0xff0000) &&
+		(gmask == 0xff || gmask == 0xff00 || gmask == 0xff0000) &&
+		(bmask == 0xff || bmask == 0xff00 || bmask == 0xff0000);
+}
+
+#ifdef TEXTURE_SIMD_X86
+
+/* ---------- sse2 */
+
+TARGET_SSE2 static inline __m128i average_sse2(__m128i fg, __m128i bg)
+{
+	__m128i odd_bits = _mm_and_si128(_mm_xor_si128(fg, bg), _mm_set1_epi32((int)0xfffefefe));
+	return _mm_add_epi32(_mm_srli_epi32(odd_bits, 1), _mm_and_si128(fg, bg));
+}
+
+/* (bg*(256-alpha) + fg*alpha)>>8 per byte, which is what alpha_blend() works out to
+	for 8-bit channels; alpha is one per 32-bit lane */
+TARGET_SSE2 static inline __m128i alpha_blend_sse2(__m128i fg, __m128i bg, __m128i alpha)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i one = _mm_set1_epi16(256);
+	__m128i alpha16 = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+	__m128i alpha_lo = _mm_unpacklo_epi32(alpha16, alpha16);
+	__m128i alpha_hi = _mm_unpackhi_epi32(alpha16, alpha16);
+
+	__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(fg, zero), alpha_lo),
+		_mm_mullo_epi16(_mm_unpacklo_epi8(bg, zero), _mm_sub_epi16(one, alpha_lo)));
+	__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(fg, zero), alpha_hi),
+		_mm_mullo_epi16(_mm_unpackhi_epi8(bg, zero), _mm_sub_epi16(one, alpha_hi)));
+
+	return _mm_and_si128(_mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)), _mm_set1_epi32(0x00ffffff));
+}
+
+TARGET_SSE2 static inline __m128i blend_sse2(__m128i fg, __m128i bg, __m128i alpha, int sw_alpha_blend)
+{
+	switch (sw_alpha_blend)
+	{
+		case _sw_alpha_fast: return average_sse2(fg, bg);
+		case _sw_alpha_nice: return alpha_blend_sse2(fg, bg, alpha);
+		default: return fg;
+	}
+}
+
+TARGET_SSE2 static void texture_horizontal_span32_sse2(const horizontal_span32& span)
+{
+	pixel32 *write = span.write;
+	pixel32 *shading_table = span.shading_table;
+	uint8 *opacity_table = span.opacity_table;
+	uint32 source_x = span.source_x, source_y = span.source_y;
+	int x_downshift = 32 - span.texture_bits;
+	int y_downshift = 32 - 2*span.texture_bits;
+	uint32 y_mask = ((1 << span.texture_bits) - 1) << span.texture_bits;
+	int count = span.count;
+
+	for (; count >= 4; count -= 4, write += 4)
+	{
+		pixel8 texels[4];
+		for (int i = 0; i < 4; ++i)
+		{
+			texels[i] = span.texture[((source_y >> y_downshift) & y_mask) + (source_x >> x_downshift)];
+			source_x += span.source_dx, source_y += span.source_dy;
+		}
+
+		__m128i fg = _mm_setr_epi32(shading_table[texels[0]], shading_table[texels[1]], shading_table[texels[2]], shading_table[texels[3]]);
+		__m128i alpha = _mm_setzero_si128();
+		if (span.sw_alpha_blend == _sw_alpha_nice)
+			alpha = _mm_setr_epi32(opacity_table[texels[0]], opacity_table[texels[1]], opacity_table[texels[2]], opacity_table[texels[3]]);
+
+		__m128i bg = span.sw_alpha_blend == _sw_alpha_off ? fg : _mm_loadu_si128((__m128i *)write);
+		_mm_storeu_si128((__m128i *)write, blend_sse2(fg, bg, alpha, span.sw_alpha_blend));
+	}
+
+	for (; count > 0; --count, ++write)
+	{
+		pixel8 texel = span.texture[((source_y >> y_downshift) & y_mask) + (source_x >> x_downshift)];
+		blend_pixel(write, shading_table[texel], opacity_table ? opacity_table[texel] : 0, span.sw_alpha_blend, span.rmask, span.gmask, span.bmask);
+		source_x += span.source_dx, source_y += span.source_dy;
+	}
+}
+
+TARGET_SSE2 static void texture_vertical_quad32_sse2(const vertical_quad32& quad)
+{
+	pixel32 *write = quad.write;
+	__m128i texture_y = _mm_setr_epi32(quad.texture_y[0], quad.texture_y[1], quad.texture_y[2], quad.texture_y[3]);
+	__m128i texture_dy = _mm_setr_epi32(quad.texture_dy[0], quad.texture_dy[1], quad.texture_dy[2], quad.texture_dy[3]);
+	__m128i downshift = _mm_cvtsi32_si128(quad.downshift);
+	__m128i zero = _mm_setzero_si128();
+
+	for (int count = quad.count; count > 0; --count)
+	{
+		alignas(16) uint32 offsets[4];
+		_mm_store_si128((__m128i *)offsets, _mm_srl_epi32(texture_y, downshift));
+		texture_y = _mm_add_epi32(texture_y, texture_dy);
+
+		pixel8 texels[4];
+		for (int i = 0; i < 4; ++i)
+			texels[i] = quad.read[i][offsets[i]];
+
+		__m128i fg = _mm_setr_epi32(quad.shading_table[0][texels[0]], quad.shading_table[1][texels[1]],
+			quad.shading_table[2][texels[2]], quad.shading_table[3][texels[3]]);
+		__m128i alpha = zero;
+		if (quad.sw_alpha_blend == _sw_alpha_nice)
+			alpha = _mm_setr_epi32(quad.opacity_table[texels[0]], quad.opacity_table[texels[1]],
+				quad.opacity_table[texels[2]], quad.opacity_table[texels[3]]);
+
+		__m128i bg = _mm_loadu_si128((__m128i *)write);
+		__m128i result = blend_sse2(fg, bg, alpha, quad.sw_alpha_blend);
+		if (quad.check_transparent)
+		{
+			__m128i transparent = _mm_cmpeq_epi32(_mm_setr_epi32(texels[0], texels[1], texels[2], texels[3]), zero);
+			result = _mm_or_si128(_mm_and_si128(transparent, bg), _mm_andnot_si128(transparent, result));
+		}
+		_mm_storeu_si128((__m128i *)write, result);
+
+		write = (pixel32 *)((byte *)write + quad.bytes_per_row);
+	}
+}
+
+/* ---------- avx2 */
+
+TARGET_AVX2 static inline __m256i average_avx2(__m256i fg, __m256i bg)
+{
+	__m256i odd_bits = _mm256_and_si256(_mm256_xor_si256(fg, bg), _mm256_set1_epi32((int)0xfffefefe));
+	return _mm256_add_epi32(_mm256_srli_epi32(odd_bits, 1), _mm256_and_si256(fg, bg));
+}
+
+/* as alpha_blend_sse2(); the unpacks and the pack all stay within 128-bit halves, so
+	the pixels come back in order */
+TARGET_AVX2 static inline __m256i alpha_blend_avx2(__m256i fg, __m256i bg, __m256i alpha)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i one = _mm256_set1_epi16(256);
+	__m256i alpha16 = _mm256_or_si256(alpha, _mm256_slli_epi32(alpha, 16));
+	__m256i alpha_lo = _mm256_unpacklo_epi32(alpha16, alpha16);
+	__m256i alpha_hi = _mm256_unpackhi_epi32(alpha16, alpha16);
+
+	__m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(fg, zero), alpha_lo),
+		_mm256_mullo_epi16(_mm256_unpacklo_epi8(bg, zero), _mm256_sub_epi16(one, alpha_lo)));
+	__m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(fg, zero), alpha_hi),
+		_mm256_mullo_epi16(_mm256_unpackhi_epi8(bg, zero), _mm256_sub_epi16(one, alpha_hi)));
+
+	return _mm256_and_si256(_mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8)), _mm256_set1_epi32(0x00ffffff));
+}
+
+/* bytes base[index] for eight indexes; gathers the aligned words holding them, so
+	nothing past the word holding the last byte of the table is touched */
+TARGET_AVX2 static inline __m256i gather_bytes_avx2(const pixel8 *base, __m256i index)
+{
+	uintptr_t misalignment = (uintptr_t)base & 3;
+	const int *words = (const int *)(base - misalignment);
+	__m256i offset = _mm256_add_epi32(index, _mm256_set1_epi32((int)misalignment));
+	__m256i three = _mm256_set1_epi32(3);
+
+	__m256i word = _mm256_i32gather_epi32(words, _mm256_andnot_si256(three, offset), 1);
+	__m256i shift = _mm256_slli_epi32(_mm256_and_si256(offset, three), 3);
+	return _mm256_and_si256(_mm256_srlv_epi32(word, shift), _mm256_set1_epi32(0xff));
+}
+
+/* start, start+delta, .. start+7*delta, wrapping like the scalar sums */
+TARGET_AVX2 static inline __m256i ramp_avx2(uint32 start, uint32 delta)
+{
+	return _mm256_add_epi32(_mm256_set1_epi32((int)start),
+		_mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int)delta)));
+}
+
+TARGET_AVX2 static void texture_horizontal_span32_avx2(const horizontal_span32& span)
+{
+	pixel32 *write = span.write;
+	int x_downshift = 32 - span.texture_bits;
+	int y_downshift = 32 - 2*span.texture_bits;
+	uint32 y_mask = ((1 << span.texture_bits) - 1) << span.texture_bits;
+	int count = span.count;
+
+	__m256i source_x = ramp_avx2(span.source_x, span.source_dx);
+	__m256i source_y = ramp_avx2(span.source_y, span.source_dy);
+	__m256i source_dx = _mm256_set1_epi32((int)(span.source_dx*8));
+	__m256i source_dy = _mm256_set1_epi32((int)(span.source_dy*8));
+	__m128i x_shift = _mm_cvtsi32_si128(x_downshift);
+	__m128i y_shift = _mm_cvtsi32_si128(y_downshift);
+	__m256i y_masks = _mm256_set1_epi32((int)y_mask);
+
+	for (; count >= 8; count -= 8, write += 8)
+	{
+		__m256i index = _mm256_add_epi32(_mm256_and_si256(_mm256_srl_epi32(source_y, y_shift), y_masks), _mm256_srl_epi32(source_x, x_shift));
+		__m256i texels = gather_bytes_avx2(span.texture, index);
+		__m256i fg = _mm256_i32gather_epi32((const int *)span.shading_table, texels, 4);
+
+		switch (span.sw_alpha_blend)
+		{
+			case _sw_alpha_fast:
+				fg = average_avx2(fg, _mm256_loadu_si256((__m256i *)write));
+				break;
+			case _sw_alpha_nice:
+				fg = alpha_blend_avx2(fg, _mm256_loadu_si256((__m256i *)write), gather_bytes_avx2(span.opacity_table, texels));
+				break;
+		}
+		_mm256_storeu_si256((__m256i *)write, fg);
+
+		source_x = _mm256_add_epi32(source_x, source_dx);
+		source_y = _mm256_add_epi32(source_y, source_dy);
+	}
+
+	uint32 done = span.count - count;
+	uint32 scalar_x = span.source_x + done*span.source_dx;
+	uint32 scalar_y = span.source_y + done*span.source_dy;
+	for (; count > 0; --count, ++write)
+	{
+		pixel8 texel = span.texture[((scalar_y >> y_downshift) & y_mask) + (scalar_x >> x_downshift)];
+		blend_pixel(write, span.shading_table[texel], span.opacity_table ? span.opacity_table[texel] : 0, span.sw_alpha_blend, span.rmask, span.gmask, span.bmask);
+		scalar_x += span.source_dx, scalar_y += span.source_dy;
+	}
+}
+
+TARGET_AVX2 static void landscape_horizontal_span32_avx2(const landscape_span32& span)
+{
+	pixel32 *write = span.write;
+	int count = span.count;
+
+	__m256i source_x = ramp_avx2(span.source_x, span.source_dx);
+	__m256i source_dx = _mm256_set1_epi32((int)(span.source_dx*8));
+	__m128i shift = _mm_cvtsi32_si128(span.downshift);
+
+	for (; count >= 8; count -= 8, write += 8)
+	{
+		__m256i texels = gather_bytes_avx2(span.read, _mm256_srl_epi32(source_x, shift));
+		_mm256_storeu_si256((__m256i *)write, _mm256_i32gather_epi32((const int *)span.shading_table, texels, 4));
+		source_x = _mm256_add_epi32(source_x, source_dx);
+	}
+
+	uint32 scalar_x = span.source_x + (span.count - count)*span.source_dx;
+	for (; count > 0; --count)
+	{
+		*write++ = span.shading_table[span.read[scalar_x >> span.downshift]];
+		scalar_x += span.source_dx;
+	}
+}
+
+#endif
+
+/* ---------- dispatch */
+
+bool texture_horizontal_span32(const horizontal_span32& span)
+{
+#ifdef TEXTURE_SIMD_X86
+	if (span.sw_alpha_blend == _sw_alpha_nice && !byte_channels(span.rmask, span.gmask, span.bmask))
+		return false;
+
+	switch (simd_level)
+	{
+		case _texture_simd_avx2:
+			texture_horizontal_span32_avx2(span);
+			return true;
+		case _texture_simd_sse2:
+			texture_horizontal_span32_sse2(span);
+			return true;
+	}
+#endif
+	return false;
+}
+
+bool landscape_horizontal_span32(const landscape_span32& span)
+{
+#ifdef TEXTURE_SIMD_X86
+	// without gathers there is nothing to gain over the scalar loop
+	if (simd_level == _texture_simd_avx2)
+	{
+		landscape_horizontal_span32_avx2(span);
+		return true;
+	}
+#endif
+	return false;
+}
+
+bool texture_vertical_quad32(const vertical_quad32& quad)
+{
+#ifdef TEXTURE_SIMD_X86
+	if (quad.sw_alpha_blend == _sw_alpha_nice && !byte_channels(quad.rmask, quad.gmask, quad.bmask))
+		return false;
+
+	// four columns is one SSE2 register; AVX2 adds nothing here
+	if (simd_level >= _texture_simd_sse2)
+	{
+		texture_vertical_quad32_sse2(quad);
+		return true;
+	}
+#endif
+	return false;
+}
@@ -0,0 +1,99 @@
+#ifndef __LOW_LEVEL_TEXTURES_SIMD_H
+#define __LOW_LEVEL_TEXTURES_SIMD_H
+
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  low_level_textures_simd.h - vector versions of the 32-bit texture mapper loops
+ *
+ *  Each call maps one span exactly as the scalar loops in low_level_textures.h
+ *  would, or returns false (no usable instruction set, or a pixel format the
+ *  blend can't handle) so the caller falls back to them.
+ */
+
+#include "cseries.h"
+
+enum /* texture simd levels */
+{
+	_texture_simd_none,
+	_texture_simd_sse2,
+	_texture_simd_avx2
+};
+
+// best level this processor supports
+int texture_simd_supported(void);
+
+// level the mappers use, the supported one by default; lowering it gives the
+// scalar reference
+int get_texture_simd_level(void);
+void set_texture_simd_level(int level);
+
+/* one row of texture_horizontal_polygon_lines */
+struct horizontal_span32
+{
+	pixel32 *write;
+	pixel8 *texture; /* row_addresses[0] */
+	pixel32 *shading_table;
+	uint8 *opacity_table; /* _sw_alpha_nice only */
+	uint32 source_x, source_y;
+	uint32 source_dx, source_dy;
+	int count;
+	int texture_bits;
+	int sw_alpha_blend;
+	pixel32 rmask, gmask, bmask;
+};
+
+/* one row of landscape_horizontal_polygon_lines */
+struct landscape_span32
+{
+	pixel32 *write;
+	pixel8 *read;
+	pixel32 *shading_table;
+	uint32 source_x, source_dx;
+	int downshift;
+	int count;
+};
+
+/* the parallel part of four columns in texture_vertical_polygon_lines */
+struct vertical_quad32
+{
+	pixel32 *write;
+	int bytes_per_row;
+	int count;
+	int downshift;
+	pixel8 *read[4];
+	pixel32 *shading_table[4];
+	uint32 texture_y[4], texture_dy[4];
+	bool check_transparent;
+	int sw_alpha_blend;
+	uint8 *opacity_table;
+	pixel32 rmask, gmask, bmask;
+};
+
+bool texture_horizontal_span32(const horizontal_span32& span);
+bool landscape_horizontal_span32(const landscape_span32& span);
+bool texture_vertical_quad32(const vertical_quad32& quad);
+
+#endif
@@ -38,6 +38,8 @@
 
 // LP additions
 #include "dynamic_limits.h"
+#include "FilmProfile.h"
+#include "pvs.h"
 #include "AnimatedTextures.h"
 #ifdef HAVE_OPENGL
 #include "OGL_Render.h"
@@ -51,6 +53,8 @@ extern WindowPtr screen_window;
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <chrono>
 
 // LP additions for decomposition of this code:
 #include "RenderVisTree.h"
@@ -128,6 +132,62 @@ static const int TICKS_PER_EXPLORE = 4;
 // M1 exploration mission helpers
 static struct view_data explore_view;
 static RenderVisTreeClass explore_tree;
+static std::vector<short> explore_targets;
+
+// the directions from the view's origin between a left and a right edge
+struct explore_wedge
+{
+	long_vector2d left, right;
+};
+
+struct explore_frame
+{
+	short polygon_index;
+	short next_edge;
+	explore_wedge wedge;
+};
+
+static std::vector<explore_frame> explore_stack;
+static std::vector<bool> explore_in_path;
+
+// a walk from one view that takes more steps than this hands over to the view tree
+static const int32 MAXIMUM_EXPLORE_STEPS = 16384;
+
+static bool render_phase_timing = false;
+static double render_phase_times[NUMBER_OF_RENDER_PHASES];
+
+// Adds the time since the last mark to a phase; costs one branch when off
+class RenderPhaseClock {
+public:
+	RenderPhaseClock() {
+		if (render_phase_timing) {
+			objlist_clear(render_phase_times, NUMBER_OF_RENDER_PHASES);
+			mark = std::chrono::steady_clock::now();
+		}
+	}
+
+	void end(render_phase phase) {
+		if (render_phase_timing) {
+			auto now = std::chrono::steady_clock::now();
+			render_phase_times[phase] += std::chrono::duration<double>(now - mark).count();
+			mark = now;
+		}
+	}
+
+private:
+	std::chrono::steady_clock::time_point mark;
+};
+
+void set_render_phase_timing(bool enabled)
+{
+	render_phase_timing = enabled;
+	objlist_clear(render_phase_times, NUMBER_OF_RENDER_PHASES);
+}
+
+double get_render_phase_time(render_phase phase)
+{
+	return render_phase_times[phase];
+}
 
 void OGL_Rasterizer_Init() {
 	
@@ -174,6 +234,7 @@ void allocate_render_memory(
 	
 	// Reset to have the tree correctly resized if m1 exploration level
 	explore_tree.view = nullptr;
+	RenderVisTree.invalidate();
 	// LP change: set up pointers
 	RenderSortPoly.RVPtr = &RenderVisTree;
 	RenderPlaceObjs.RVPtr = &RenderVisTree;
@@ -244,8 +305,16 @@ void render_view(
 {
 	update_view_data(view);
 
+	/* keep last frame's render tree (and the render flags it set) if nothing it depends on
+		has changed; the overhead map and terminals transform endpoints for themselves */
+	short tree_state= _render_tree_stale;
+	RenderVisTree.view = view;
+	if (!view->terminal_mode_active && !view->overhead_map_active)
+		tree_state= RenderVisTree.check_reuse();
+	
 	/* clear the render flags */
-	objlist_clear(render_flags, RENDER_FLAGS_BUFFER_SIZE);
+	if (tree_state==_render_tree_stale)
+		objlist_clear(render_flags, RENDER_FLAGS_BUFFER_SIZE);
 
 	ResetOverheadMap();
 /*
@@ -267,8 +336,12 @@ void render_view(
 		
 		// LP: now from the visibility-tree class
 		/* build the render tree, regardless of map mode, so the automap updates while active */
-		RenderVisTree.view = view;
-		RenderVisTree.build_render_tree();
+		RenderPhaseClock phase_clock;
+		if (tree_state==_render_tree_stale)
+			RenderVisTree.build_render_tree();
+		else if (tree_state==_render_tree_vertical_change)
+			RenderVisTree.update_vertical_clips();
+		phase_clock.end(_render_phase_vis_tree);
 		
 		/* do something complicated and difficult to explain */
 		if (!view->overhead_map_active || map_is_translucent())
@@ -277,12 +350,17 @@ void render_view(
 			/* sort the render tree (so we have a depth-ordering of polygons) and accumulate
 				clipping information for each polygon */
 			RenderSortPoly.view = view;
-			RenderSortPoly.sort_render_tree();
+			if (tree_state==_render_tree_stale)
+				RenderSortPoly.sort_render_tree();
+			else
+				RenderSortPoly.reuse_sorted_render_tree(tree_state==_render_tree_vertical_change);
+			phase_clock.end(_render_phase_sort_polygons);
 			
 			// LP: now from the object-placement class
 			/* build the render object list by looking at the sorted render tree */
 			RenderPlaceObjs.view = view;
 			RenderPlaceObjs.build_render_object_list();
+			phase_clock.end(_render_phase_place_objects);
 			
 			// LP addition: set the current rasterizer to whichever is appropriate here
 			RasterizerClass *RasPtr;
@@ -325,6 +403,7 @@ void render_view(
 			
 			// Finish rendering main view
 			RasPtr->End();
+			phase_clock.end(_render_phase_rasterize);
 		}
 
 		if (view->overhead_map_active)
@@ -333,6 +412,16 @@ void render_view(
 			render_overhead_map(view);
 		}
 	}
+	
+	/* a tree built for the overhead map alone was never sorted */
+	if (view->terminal_mode_active || view->overhead_map_active)
+		RenderVisTree.invalidate();
+}
+
+void invalidate_render_tree(
+	void)
+{
+	RenderVisTree.invalidate();
 }
 
 void start_render_effect(
@@ -343,14 +432,144 @@ void start_render_effect(
 	view->effect_phase= NONE;
 }
 
+static bool unexplored_polygon_is_potentially_visible(short polygon_index)
+{
+	for (auto target : explore_targets)
+	{
+		if (get_polygon_data(target)->type == _polygon_must_be_explored &&
+		    polygon_is_potentially_visible(polygon_index, target))
+			return true;
+	}
+	return false;
+}
+
+static inline int64_t explore_cross(const long_vector2d& a, const long_vector2d& b)
+{
+	return int64_t(a.i) * b.j - int64_t(a.j) * b.i;
+}
+
+// The same test the view tree applies to endpoints; exact for wedges
+// narrower than 180 degrees, which all of these are
+static inline bool explore_wedge_contains(const explore_wedge& wedge, const long_vector2d& v)
+{
+	return explore_cross(wedge.right, v) <= 0 && explore_cross(wedge.left, v) >= 0;
+}
+
+static bool intersect_explore_wedges(const explore_wedge& a, const explore_wedge& b, explore_wedge& result)
+{
+	if (explore_wedge_contains(b, a.left))
+		result.left = a.left;
+	else if (explore_wedge_contains(a, b.left))
+		result.left = b.left;
+	else
+		return false;
+
+	if (explore_wedge_contains(b, a.right))
+		result.right = a.right;
+	else if (explore_wedge_contains(a, b.right))
+		result.right = b.right;
+	else
+		return false;
+
+	return true;
+}
+
+// Follows every chain of transparent lines that some line of sight inside
+// the view cone passes through, narrowing the cone to each line's span the
+// way the view tree clips to it, and marks what it reaches as explored.
+// Counts remaining down and stops at zero; false if there were too many
+// chains to follow. Not the tree's exact result: lines seen edge-on,
+// endpoints on a cone's boundary and the tree's node limits can all come
+// out differently, which is why no film profile turns it on
+static bool explore_visible_polygons(struct view_data *view, size_t& remaining)
+{
+	long_vector2d origin = { view->origin.x, view->origin.y };
+
+	// the view tree always takes in the polygon it starts from
+	struct polygon_data *origin_polygon = get_polygon_data(view->origin_polygon_index);
+	if (origin_polygon->type == _polygon_must_be_explored)
+	{
+		origin_polygon->type = _polygon_is_normal;
+		if (--remaining == 0)
+			return true;
+	}
+
+	explore_in_path.assign(dynamic_world->polygon_count, false);
+	explore_stack.clear();
+	explore_stack.push_back({view->origin_polygon_index, 0, {view->left_edge, view->right_edge}});
+	explore_in_path[view->origin_polygon_index] = true;
+
+	int32 steps = 0;
+	while (!explore_stack.empty())
+	{
+		explore_frame& frame = explore_stack.back();
+		struct polygon_data *polygon = get_polygon_data(frame.polygon_index);
+
+		if (frame.next_edge >= polygon->vertex_count)
+		{
+			explore_in_path[frame.polygon_index] = false;
+			explore_stack.pop_back();
+			continue;
+		}
+
+		short i = frame.next_edge++;
+		short line_index = polygon->line_indexes[i];
+		short adjacent_polygon_index = find_adjacent_polygon(frame.polygon_index, line_index);
+		if (adjacent_polygon_index == NONE || explore_in_path[adjacent_polygon_index] ||
+		    !LINE_IS_TRANSPARENT(get_line_data(line_index)))
+			continue;
+
+		if (++steps > MAXIMUM_EXPLORE_STEPS)
+			return false;
+
+		const world_point2d& e0 = get_endpoint_data(polygon->endpoint_indexes[i])->vertex;
+		const world_point2d& e1 = get_endpoint_data(polygon->endpoint_indexes[i == polygon->vertex_count - 1 ? 0 : i + 1])->vertex;
+		long_vector2d v0 = { e0.x - origin.i, e0.y - origin.j };
+		long_vector2d v1 = { e1.x - origin.i, e1.y - origin.j };
+
+		explore_wedge wedge;
+		int64_t cross = explore_cross(v0, v1);
+		if (cross == 0)
+		{
+			// seen edge-on, unless the viewer is standing on it
+			if (int64_t(v0.i) * v1.i + int64_t(v0.j) * v1.j > 0)
+				continue;
+			wedge = frame.wedge;
+		}
+		else
+		{
+			explore_wedge span = cross > 0 ? explore_wedge{v0, v1} : explore_wedge{v1, v0};
+			if (!intersect_explore_wedges(frame.wedge, span, wedge))
+				continue;
+		}
+
+		struct polygon_data *adjacent_polygon = get_polygon_data(adjacent_polygon_index);
+		if (adjacent_polygon->type == _polygon_must_be_explored)
+		{
+			adjacent_polygon->type = _polygon_is_normal;
+			if (--remaining == 0)
+				return true;
+		}
+
+		explore_in_path[adjacent_polygon_index] = true;
+		explore_stack.push_back({adjacent_polygon_index, 0, wedge});
+	}
+
+	return true;
+}
+
 void check_m1_exploration(void)
 {
 	// Are we even on an exploration mission?
 	if (!(static_world->mission_flags & _mission_exploration_m1))
 		return;
 
+	// Is any player's view due for a check this tick?
+	if (dynamic_world->tick_count % TICKS_PER_EXPLORE >= dynamic_world->player_count)
+		return;
+
 	// Are there still polygons to explore?
-	bool need_exploring = false;
+	explore_targets.clear();
 	short polygon_index;
 	struct polygon_data *polygon;
 	for (polygon_index = 0, polygon = map_polygons;
@@ -358,12 +577,9 @@ void check_m1_exploration(void)
 	     ++polygon_index, ++polygon)
     {
 		if (polygon->type == _polygon_must_be_explored)
-		{
-			need_exploring = true;
-			break;
-		}
+			explore_targets.push_back(polygon_index);
 	}
-	if (!need_exploring)
+	if (explore_targets.empty())
 		return;
 
 	// All right, we need to do something.
@@ -400,12 +616,32 @@ void check_m1_exploration(void)
 	     i += TICKS_PER_EXPLORE)
 	{
 		struct player_data *explore_player = &players[i];
+
+		// The explore tree can't reach anything outside the camera
+		// polygon's potentially visible set.
+		if (film_profile.potentially_visible_sets &&
+		    !unexplored_polygon_is_potentially_visible(explore_player->camera_polygon_index))
+			continue;
+
 		explore_view.yaw = explore_player->facing;
 		explore_view.pitch = explore_player->elevation;
 		explore_view.origin = explore_player->camera_location;
 		explore_view.origin_polygon_index = explore_player->camera_polygon_index;
 
 		update_view_data(&explore_view);
+
+		if (film_profile.m1_exploration_portals)
+		{
+			// Walk the transparent lines in view instead of building a tree
+			size_t remaining = std::count_if(explore_targets.begin(), explore_targets.end(),
+				[](short target) { return get_polygon_data(target)->type == _polygon_must_be_explored; });
+			if (explore_visible_polygons(&explore_view, remaining))
+			{
+				if (remaining == 0)
+					break;
+				continue;
+			}
+		}
 		
 		std::vector<uint16_t> saved_render_flags{RenderFlagList};
 		objlist_clear(render_flags, RENDER_FLAGS_BUFFER_SIZE);
@@ -414,6 +650,7 @@ void check_m1_exploration(void)
 		explore_tree.build_render_tree();
 
 		RenderFlagList = std::move(saved_render_flags);
+		invalidate_render_tree();
 	}
 }
 
@@ -174,6 +174,24 @@ void start_render_effect(struct view_data *view, short effect);
 
 void check_m1_exploration(void);
 
+// render_view() reuses the last frame's visibility tree and polygon order while the
+// view and the geometry it saw are unchanged; anything else that transforms endpoints
+// (the overhead map, the exploration tree) must call this
+void invalidate_render_tree(void);
+
+// Wall-clock time of each stage of the last render_view(), in seconds;
+// only measured while enabled (by alephbet-renderbench)
+enum render_phase {
+	_render_phase_vis_tree,		// RenderVisTreeClass
+	_render_phase_sort_polygons,	// RenderSortPolyClass
+	_render_phase_place_objects,	// RenderPlaceObjsClass
+	_render_phase_rasterize,	// the rasterizer, weapons in hand included
+	NUMBER_OF_RENDER_PHASES
+};
+
+void set_render_phase_timing(bool enabled);
+double get_render_phase_time(render_phase phase);
+
 
 /* ----------- prototypes/SCREEN.C */
 void render_overhead_map(struct view_data *view);
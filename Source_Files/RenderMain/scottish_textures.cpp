@@ -105,9 +105,9 @@ static void calculate_shading_table(void * &result,view_data *view, void *shadin
 	right lines of the current polygon), the trapezoid rasterizer (to store the y-coordinates
 	of the top and bottom of the current trapezoid) and the rectangle mapper (for it’s
 	vertical and if necessary horizontal distortion tables).  these are not necessary as
-	globals, just as global storage. */
-static short *scratch_table0 = NULL, *scratch_table1 = NULL;
-static void *precalculation_table = NULL;
+	globals, just as global storage; every rendering thread has its own. */
+static thread_local short *scratch_table0 = NULL, *scratch_table1 = NULL;
+static thread_local void *precalculation_table = NULL;
 
 /* ---------- private prototypes */
 
@@ -129,17 +129,20 @@ static void _prelandscape_horizontal_polygon_lines(struct polygon_definition *po
 /* ---------- code */
 
 /* set aside memory at launch for two line tables (remember, we precalculate all the y-values
-	for trapezoids and two lines worth of x-values for polygons before mapping them) */
+	for trapezoids and two lines worth of x-values for polygons before mapping them); rendering
+	threads call this when they start */
 void allocate_texture_tables(
 	void)
 {
+	if (precalculation_table) return;
+	
 	scratch_table0= new short[MAXIMUM_SCRATCH_TABLE_ENTRIES];
 	scratch_table1= new short[MAXIMUM_SCRATCH_TABLE_ENTRIES];
 	precalculation_table= (void*)new char[MAXIMUM_PRECALCULATION_TABLE_ENTRY_SIZE*MAXIMUM_SCRATCH_TABLE_ENTRIES];
 	fc_assert(scratch_table0&&scratch_table1&&precalculation_table);
 }
 
-void Rasterizer_SW_Class::texture_horizontal_polygon(polygon_definition& textured_polygon)
+void Rasterizer_SW_Class::draw_horizontal_polygon(polygon_definition& textured_polygon)
 {
 	polygon_definition *polygon = &textured_polygon;	// Reference to pointer
 	short vertex, highest_vertex, lowest_vertex;
@@ -149,7 +152,7 @@ void Rasterizer_SW_Class::texture_horizontal_polygon(polygon_definition& texture
 
 	/* if we get static, tinted or landscaped transfer modes punt to the vertical polygon mapper */
 	if (polygon->transfer_mode == _static_transfer) {
-		texture_vertical_polygon(textured_polygon);
+		draw_vertical_polygon(textured_polygon);
 		return;
 	}
 
@@ -233,17 +236,30 @@ void Rasterizer_SW_Class::texture_horizontal_polygon(polygon_definition& texture
 		fc_assert(aggregate_right_line_count==aggregate_total_line_count);
 		fc_assert(aggregate_left_line_count==aggregate_total_line_count);
 
+		/* lines are independent of each other, so drop those outside our band before
+			precalculating anything */
+		short y0= vertices[highest_vertex].y, line_count= aggregate_total_line_count;
+		if (y0<band_y0)
+		{
+			short delta= MIN(band_y0-y0, line_count);
+
+			left_table+= delta, right_table+= delta;
+			y0+= delta, line_count-= delta;
+		}
+		if (y0+line_count>band_y1) line_count= MAX(band_y1-y0, 0);
+		if (!line_count) return;
+
 		/* precalculate mode-specific data */
 		switch (polygon->transfer_mode)
 		{
 			case _textured_transfer:
-				TEXBITS_DISPATCH(polygon->texture, _pretexture_horizontal_polygon_lines, (polygon, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table, vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count));
+				TEXBITS_DISPATCH(polygon->texture, _pretexture_horizontal_polygon_lines, (polygon, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table, y0, left_table, right_table, line_count));
 				break;
 
 			case _big_landscaped_transfer:
 				_prelandscape_horizontal_polygon_lines(polygon, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-					vertices[highest_vertex].y, left_table, right_table,
-					aggregate_total_line_count);
+					y0, left_table, right_table,
+					line_count);
 				break;
 			
 			default:
@@ -259,11 +275,11 @@ void Rasterizer_SW_Class::texture_horizontal_polygon(polygon_definition& texture
 	
 					case _textured_transfer:
 						TEXBITS_DISPATCH_2(polygon->texture, texture_horizontal_polygon_lines, pixel8, _sw_alpha_off, (polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-							vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count));
+							y0, left_table, right_table, line_count));
 						break;
 					case _big_landscaped_transfer:
 						landscape_horizontal_polygon_lines<pixel8>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-							vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count);
+							y0, left_table, right_table, line_count);
 						break;
 						
 					default:
@@ -285,21 +301,21 @@ void Rasterizer_SW_Class::texture_horizontal_polygon(polygon_definition& texture
 						if (sw_texture && !polygon->VoidPresent && sw_texture->opac_type())
 						{
 							if (graphics_preferences->software_alpha_blending == _sw_alpha_fast) {
-								TEXBITS_DISPATCH_2(polygon->texture, texture_horizontal_polygon_lines, pixel16, _sw_alpha_fast, (polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table, vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count));
+								TEXBITS_DISPATCH_2(polygon->texture, texture_horizontal_polygon_lines, pixel16, _sw_alpha_fast, (polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table, y0, left_table, right_table, line_count));
 							}
 							else if (graphics_preferences->software_alpha_blending == _sw_alpha_nice) {
-								TEXBITS_DISPATCH_2(polygon->texture, texture_horizontal_polygon_lines, pixel16, _sw_alpha_nice, (polygon->texture, screen, view, (struct _horizontal_polygon_line_data *) precalculation_table, vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count, sw_texture->opac_table()));
+								TEXBITS_DISPATCH_2(polygon->texture, texture_horizontal_polygon_lines, pixel16, _sw_alpha_nice, (polygon->texture, screen, view, (struct _horizontal_polygon_line_data *) precalculation_table, y0, left_table, right_table, line_count, sw_texture->opac_table()));
 							}
 						} else {
 							TEXBITS_DISPATCH_2(polygon->texture, texture_horizontal_polygon_lines, pixel16, _sw_alpha_off, (polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-											  vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count));
+											  y0, left_table, right_table, line_count));
 						}
 					}
 					break;
 						
 				case _big_landscaped_transfer:
 						landscape_horizontal_polygon_lines<pixel16>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-							vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count);
+							y0, left_table, right_table, line_count);
 						break;
 					default:
 						fc_assert(false);
@@ -321,24 +337,24 @@ void Rasterizer_SW_Class::texture_horizontal_polygon(polygon_definition& texture
 					{
 						if (graphics_preferences->software_alpha_blending == _sw_alpha_fast)
 						{
-							TEXBITS_DISPATCH_2(polygon->texture, texture_horizontal_polygon_lines, pixel32, _sw_alpha_fast, (polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table, vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count));
+							TEXBITS_DISPATCH_2(polygon->texture, texture_horizontal_polygon_lines, pixel32, _sw_alpha_fast, (polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table, y0, left_table, right_table, line_count));
 						} 
 						else if (graphics_preferences->software_alpha_blending == _sw_alpha_nice)
 						{
-							TEXBITS_DISPATCH_2(polygon->texture, texture_horizontal_polygon_lines, pixel32, _sw_alpha_nice, (polygon->texture, screen, view, (struct _horizontal_polygon_line_data *) precalculation_table, vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count, sw_texture->opac_table()));
+							TEXBITS_DISPATCH_2(polygon->texture, texture_horizontal_polygon_lines, pixel32, _sw_alpha_nice, (polygon->texture, screen, view, (struct _horizontal_polygon_line_data *) precalculation_table, y0, left_table, right_table, line_count, sw_texture->opac_table()));
 						}
 					}
 					else 
 					{
 						TEXBITS_DISPATCH_2(polygon->texture, texture_horizontal_polygon_lines, pixel32, _sw_alpha_off, (polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-											  vertices[highest_vertex].y, left_table, right_table,
-											  aggregate_total_line_count));
+											  y0, left_table, right_table,
+											  line_count));
 					}
 				}
 				break;
 					case _big_landscaped_transfer:
 						landscape_horizontal_polygon_lines<pixel32>(polygon->texture, screen, view, (struct _horizontal_polygon_line_data *)precalculation_table,
-							vertices[highest_vertex].y, left_table, right_table, aggregate_total_line_count);
+							y0, left_table, right_table, line_count);
 						break;
 					
 					default:
@@ -354,7 +370,7 @@ void Rasterizer_SW_Class::texture_horizontal_polygon(polygon_definition& texture
 	}
 }
 
-void Rasterizer_SW_Class::texture_vertical_polygon(polygon_definition& textured_polygon)
+void Rasterizer_SW_Class::draw_vertical_polygon(polygon_definition& textured_polygon)
 {
 	polygon_definition *polygon = &textured_polygon;	// Reference to pointer
 	short vertex, highest_vertex, lowest_vertex;
@@ -363,7 +379,7 @@ void Rasterizer_SW_Class::texture_vertical_polygon(polygon_definition& textured_
 	fc_assert(polygon->vertex_count>=MINIMUM_VERTICES_PER_SCREEN_POLYGON&&polygon->vertex_count<MAXIMUM_VERTICES_PER_SCREEN_POLYGON);
 
     if (polygon->transfer_mode == _big_landscaped_transfer) {
-        texture_horizontal_polygon(textured_polygon);
+        draw_horizontal_polygon(textured_polygon);
         return;
     }
      
@@ -465,15 +481,15 @@ void Rasterizer_SW_Class::texture_vertical_polygon(polygon_definition& textured_
 				{
 					case _textured_transfer:
 						if (polygon->texture->flags&_TRANSPARENT_BIT)
-							texture_vertical_polygon_lines<pixel8, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
+							texture_vertical_polygon_lines<pixel8, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1);
 						else
-							texture_vertical_polygon_lines<pixel8, _sw_alpha_off, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
+							texture_vertical_polygon_lines<pixel8, _sw_alpha_off, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1);
 						break;
 					case _static_transfer:
 						if (polygon->texture->flags&_TRANSPARENT_BIT)
-							randomize_vertical_polygon_lines<pixel8, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, polygon->transfer_data);
+							randomize_vertical_polygon_lines<pixel8, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1, polygon->transfer_data);
 						else
-							randomize_vertical_polygon_lines<pixel8, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, polygon->transfer_data);
+							randomize_vertical_polygon_lines<pixel8, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1, polygon->transfer_data);
 						break;
 						
 				default:
@@ -496,32 +512,32 @@ void Rasterizer_SW_Class::texture_vertical_polygon(polygon_definition& textured_
 					{
 						if (graphics_preferences->software_alpha_blending == _sw_alpha_fast) {
 							if (polygon->texture->flags & _TRANSPARENT_BIT) {
-								texture_vertical_polygon_lines<pixel16, _sw_alpha_fast, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
+								texture_vertical_polygon_lines<pixel16, _sw_alpha_fast, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1);
 							} else {
-								texture_vertical_polygon_lines<pixel16, _sw_alpha_fast, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
+								texture_vertical_polygon_lines<pixel16, _sw_alpha_fast, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1);
 							}
 						} 
 						else if (graphics_preferences->software_alpha_blending == _sw_alpha_nice) {
 							if (polygon->texture->flags & _TRANSPARENT_BIT)  {
-								texture_vertical_polygon_lines<pixel16, _sw_alpha_nice, true>(screen, view, (struct _vertical_polygon_data *) precalculation_table, left_table, right_table, sw_texture->opac_table());
+								texture_vertical_polygon_lines<pixel16, _sw_alpha_nice, true>(screen, view, (struct _vertical_polygon_data *) precalculation_table, left_table, right_table, band_y0, band_y1, sw_texture->opac_table());
 							} else {
-								texture_vertical_polygon_lines<pixel16, _sw_alpha_nice, false>(screen, view, (struct _vertical_polygon_data *) precalculation_table, left_table, right_table, sw_texture->opac_table());
+								texture_vertical_polygon_lines<pixel16, _sw_alpha_nice, false>(screen, view, (struct _vertical_polygon_data *) precalculation_table, left_table, right_table, band_y0, band_y1, sw_texture->opac_table());
 							}
 						}
 					} else {
 						if (polygon->texture->flags & _TRANSPARENT_BIT) {
-							texture_vertical_polygon_lines<pixel16, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
+							texture_vertical_polygon_lines<pixel16, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1);
 						} else {
-							texture_vertical_polygon_lines<pixel16, _sw_alpha_off, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
+							texture_vertical_polygon_lines<pixel16, _sw_alpha_off, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1);
 						}
 					}
 				}
 				break;
 				case _static_transfer:
 					if (polygon->texture->flags & _TRANSPARENT_BIT) {
-						randomize_vertical_polygon_lines<pixel16, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, polygon->transfer_data);
+						randomize_vertical_polygon_lines<pixel16, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1, polygon->transfer_data);
 					} else {
-						randomize_vertical_polygon_lines<pixel16, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, polygon->transfer_data);
+						randomize_vertical_polygon_lines<pixel16, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1, polygon->transfer_data);
 					}
 					break;
 				default:
@@ -544,30 +560,30 @@ void Rasterizer_SW_Class::texture_vertical_polygon(polygon_definition& textured_
 						{
 							if (graphics_preferences->software_alpha_blending == _sw_alpha_fast) {
 								if (polygon->texture->flags&_TRANSPARENT_BIT)
-									texture_vertical_polygon_lines<pixel32, _sw_alpha_fast, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
+									texture_vertical_polygon_lines<pixel32, _sw_alpha_fast, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1);
 								else
-									texture_vertical_polygon_lines<pixel32, _sw_alpha_fast, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
+									texture_vertical_polygon_lines<pixel32, _sw_alpha_fast, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1);
 							}
 							else if (graphics_preferences->software_alpha_blending == _sw_alpha_nice) 
 							{
 								if (polygon->texture->flags & _TRANSPARENT_BIT)
-									texture_vertical_polygon_lines<pixel32, _sw_alpha_nice, true>(screen, view, (struct _vertical_polygon_data *) precalculation_table, left_table, right_table, sw_texture->opac_table());
+									texture_vertical_polygon_lines<pixel32, _sw_alpha_nice, true>(screen, view, (struct _vertical_polygon_data *) precalculation_table, left_table, right_table, band_y0, band_y1, sw_texture->opac_table());
 								else
-									texture_vertical_polygon_lines<pixel32, _sw_alpha_nice, false>(screen, view, (struct _vertical_polygon_data *) precalculation_table, left_table, right_table, sw_texture->opac_table());
+									texture_vertical_polygon_lines<pixel32, _sw_alpha_nice, false>(screen, view, (struct _vertical_polygon_data *) precalculation_table, left_table, right_table, band_y0, band_y1, sw_texture->opac_table());
 							}
 						} else {
 							if (polygon->texture->flags & _TRANSPARENT_BIT)
-								texture_vertical_polygon_lines<pixel32, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
+								texture_vertical_polygon_lines<pixel32, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1);
 							else
-								texture_vertical_polygon_lines<pixel32, _sw_alpha_off, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table);
+								texture_vertical_polygon_lines<pixel32, _sw_alpha_off, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1);
 						}
 						break;
 					}
 					case _static_transfer:
 						if (polygon->texture->flags & _TRANSPARENT_BIT)
-							randomize_vertical_polygon_lines<pixel32, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, polygon->transfer_data);
+							randomize_vertical_polygon_lines<pixel32, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1, polygon->transfer_data);
 						else
-							randomize_vertical_polygon_lines<pixel32, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, polygon->transfer_data);
+							randomize_vertical_polygon_lines<pixel32, false>(screen, view, (struct _vertical_polygon_data *)precalculation_table, left_table, right_table, band_y0, band_y1, polygon->transfer_data);
 						break;
 						
 				default:
@@ -583,7 +599,7 @@ void Rasterizer_SW_Class::texture_vertical_polygon(polygon_definition& textured_
 	}
 }
 
-void Rasterizer_SW_Class::texture_rectangle(rectangle_definition& textured_rectangle)
+void Rasterizer_SW_Class::draw_rectangle(rectangle_definition& textured_rectangle)
 {
 	rectangle_definition *rectangle = &textured_rectangle;	// Reference to pointer
 
@@ -738,17 +754,17 @@ void Rasterizer_SW_Class::texture_rectangle(rectangle_definition& textured_recta
 						{
 							case _textured_transfer:
 								texture_vertical_polygon_lines<pixel8, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1);
+									scratch_table0, scratch_table1, band_y0, band_y1);
 								break;
 							
 							case _static_transfer:
 								randomize_vertical_polygon_lines<pixel8, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1, rectangle->transfer_data);
+									scratch_table0, scratch_table1, band_y0, band_y1, rectangle->transfer_data);
 								break;
 							
 							case _tinted_transfer:
 								tint_vertical_polygon_lines<pixel8>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1, rectangle->transfer_data);
+									scratch_table0, scratch_table1, band_y0, band_y1, rectangle->transfer_data);
 								break;
 							
 							default:
@@ -761,17 +777,17 @@ void Rasterizer_SW_Class::texture_rectangle(rectangle_definition& textured_recta
 						switch (rectangle->transfer_mode)
 						{
 							case _textured_transfer:
-								texture_vertical_polygon_lines<pixel16, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, scratch_table0, scratch_table1);
+								texture_vertical_polygon_lines<pixel16, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table, scratch_table0, scratch_table1, band_y0, band_y1);
 								break;
 								
 							case _static_transfer:
 								randomize_vertical_polygon_lines<pixel16, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1, rectangle->transfer_data);
+									scratch_table0, scratch_table1, band_y0, band_y1, rectangle->transfer_data);
 								break;
 							
 							case _tinted_transfer:
 								tint_vertical_polygon_lines<pixel16>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1, rectangle->transfer_data);
+									scratch_table0, scratch_table1, band_y0, band_y1, rectangle->transfer_data);
 								break;
 							
 							default:
@@ -785,17 +801,17 @@ void Rasterizer_SW_Class::texture_rectangle(rectangle_definition& textured_recta
 						{
 							case _textured_transfer:
 								texture_vertical_polygon_lines<pixel32, _sw_alpha_off, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1);
+									scratch_table0, scratch_table1, band_y0, band_y1);
 								break;
 							
 							case _static_transfer:
 								randomize_vertical_polygon_lines<pixel32, true>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1, rectangle->transfer_data);
+									scratch_table0, scratch_table1, band_y0, band_y1, rectangle->transfer_data);
 								break;
 							
 							case _tinted_transfer:
 								tint_vertical_polygon_lines<pixel32>(screen, view, (struct _vertical_polygon_data *)precalculation_table,
-									scratch_table0, scratch_table1, rectangle->transfer_data);
+									scratch_table0, scratch_table1, band_y0, band_y1, rectangle->transfer_data);
 								break;
 							
 							default:
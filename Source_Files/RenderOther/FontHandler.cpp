@@ -152,16 +152,18 @@ int FontSpecifier::TextWidth(const char *text)
 }
 
 #ifdef HAVE_OPENGL
+// Padding around each glyph in the texture so as to avoid clipping it
+static const int GlyphPad = 1;
+
 // Reset the OpenGL fonts; its arg indicates whether this is for starting an OpenGL session
-// (this is to avoid texture and display-list memory leaks and other such things)
+// (this is to avoid texture memory leaks and other such things)
 void FontSpecifier::OGL_Reset(bool IsStarting)
 {
 	// Don't delete these if there is no valid texture;
-	// that indicates that there are no valid texture and display-list ID's.
+	// that indicates that there is no valid texture ID.
 	if (!IsStarting && OGL_Texture)
 	{
 		glDeleteTextures(1,&TxtrID);
-		glDeleteLists(DispList,256);
 		OGL_Deregister(this);
 	}
 
@@ -175,8 +177,7 @@ void FontSpecifier::OGL_Reset(bool IsStarting)
     if (!IsStarting)
         return;
 	
-	// Put some padding around each glyph so as to avoid clipping it
-	const int Pad = 1;
+	const int Pad = GlyphPad;
 	int ascent_p = Ascent + Pad, descent_p = Descent + Pad;
 	int widths_p[256];
 	for (int i=0; i<256; i++) {
@@ -282,8 +283,7 @@ void FontSpecifier::OGL_Reset(bool IsStarting)
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 	
- 	// Allocate and create display lists of rendering commands
- 	DispList = glGenLists(256);
+ 	// Remember where each glyph is, for building the quads in OGL_Render()
  	GLfloat TWidNorm = GLfloat(1)/TxtrWidth;
  	GLfloat THtNorm = GLfloat(1)/TxtrHeight;
  	for (int k=0; k<=LastLine; k++)
@@ -296,22 +296,11 @@ void FontSpecifier::OGL_Reset(bool IsStarting)
  		{
  			short Width = widths_p[Which];
  			int NewPos = Pos + Width;
- 			GLfloat Left = TWidNorm*Pos;
- 			GLfloat Right = TWidNorm*NewPos;
- 			
- 			glNewList(DispList + Which, GL_COMPILE);
- 			
- 			// Move to the current glyph's (padded) position
- 			glTranslatef(-Pad,0,0);
- 			
- 			// Draw the glyph rectangle
-			OGL_RenderTexturedRect(0, -ascent_p, Width, descent_p + ascent_p,
-								   Left, Top, Right, Bottom);
-			
-			// Move to the next glyph's position
-			glTranslated(Width-Pad,0,0);
-			
- 			glEndList();
+ 			GLfloat *TexCoords = GlyphTexCoords[Which];
+ 			TexCoords[0] = TWidNorm*Pos;
+ 			TexCoords[1] = Top;
+ 			TexCoords[2] = TWidNorm*NewPos;
+ 			TexCoords[3] = Bottom;
  			
  			// For next one
  			Pos = NewPos;
@@ -343,14 +332,44 @@ void FontSpecifier::OGL_Render(const char *Text)
 
 	glBindTexture(GL_TEXTURE_2D,TxtrID);
 	
+	// Two triangles per glyph, all drawn in one batch
+	GLfloat Vertices[255*12], TexCoords[255*12];
+	GLfloat Top = -(Ascent + GlyphPad), Bottom = Descent + GlyphPad;
+	GLfloat Pos = 0;
+	
 	size_t Len = MIN(strlen(Text),255);
 	for (size_t k=0; k<Len; k++)
 	{
 		unsigned char c = Text[k];
-		glCallList(DispList+c);
+		GLfloat Left = Pos - GlyphPad;
+		GLfloat Right = Pos + Widths[c] + GlyphPad;
+		const GLfloat *T = GlyphTexCoords[c];
+		
+		GLfloat QuadVertices[12] = {
+			Left, Top, Right, Top, Right, Bottom,
+			Left, Top, Right, Bottom, Left, Bottom
+		};
+		GLfloat QuadTexCoords[12] = {
+			T[0], T[1], T[2], T[1], T[2], T[3],
+			T[0], T[1], T[2], T[3], T[0], T[3]
+		};
+		memcpy(Vertices + 12*k, QuadVertices, sizeof(QuadVertices));
+		memcpy(TexCoords + 12*k, QuadTexCoords, sizeof(QuadTexCoords));
+		
+		Pos += Widths[c];
+	}
+	
+	if (Len)
+	{
+		glVertexPointer(2, GL_FLOAT, 0, Vertices);
+		glTexCoordPointer(2, GL_FLOAT, 0, TexCoords);
+		glDrawArrays(GL_TRIANGLES, 0, 6*Len);
 	}
 	
 	glPopAttrib();
+	
+	// Move to the next character's position
+	glTranslatef(Pos,0,0);
 }
 
 
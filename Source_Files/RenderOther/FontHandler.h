@@ -78,7 +78,7 @@ public:
 	
 #ifdef HAVE_OPENGL	
 	// Reset the OpenGL fonts; its arg indicates whether this is for starting an OpenGL session
-	// (this is to avoid texture and display-list memory leaks and other such things)
+	// (this is to avoid texture memory leaks and other such things)
 	void OGL_Reset(bool IsStarting);
 	
 	// Renders a C-style string in OpenGL.
@@ -92,7 +92,7 @@ public:
 	void OGL_DrawText(const char *Text, const screen_rectangle &r, short flags);
 	
 	// Calls OGL_Reset() on all fonts. This is used when the OpenGL context
-	// is changing, so that textures and display lists are cleaned up.
+	// is changing, so that textures are cleaned up.
 	static void OGL_ResetFonts(bool IsStarting);	
 
 	// Add or remove an instance from the registry of in-use OpenGL fonts.
@@ -119,14 +119,15 @@ public:
 	// Also, private members are inconsistent with that sort of initialization.
 
 #ifdef HAVE_OPENGL
-	// Stuff for OpenGL font rendering: the font texture and a display list for font rendering;
+	// Stuff for OpenGL font rendering: the font texture and where each (padded) glyph is in it,
+	// as left, top, right, bottom texture coordinates;
 	// if OGL_Texture is NULL, then there is no OpenGL font texture to render.
 	uint8 *OGL_Texture;
 	short TxtrWidth, TxtrHeight;
 	int GetTxtrSize() {return int(TxtrWidth)*int(TxtrHeight);}
 	GLuint TxtrID;
 	GLuint NearFilter = GL_LINEAR;
-	uint32 DispList;
+	GLfloat GlyphTexCoords[256][4];
 	static std::set<FontSpecifier*> *m_font_registry;
 #endif
 };
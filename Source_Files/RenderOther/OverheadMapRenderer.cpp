@@ -82,144 +82,10 @@ void OverheadMapClass::Render(overhead_map_data& Control)
 	
 	if (Control.mode==_rendering_checkpoint_map) generate_false_automap(Control.origin_polygon_index);
 	
-	transform_endpoints_for_overhead_map(Control);
-	
-	// LP addition
-	begin_polygons();
-	
-	/* shade all visible polygons */
-	for (i=0;i<dynamic_world->polygon_count;++i)
-	{
-		struct polygon_data *polygon= get_polygon_data(i);
-		if (POLYGON_IS_IN_AUTOMAP(i) && TEST_STATE_FLAG(i, _polygon_on_automap)
-			&&(polygon->floor_transfer_mode!=_xfer_landscape||polygon->ceiling_transfer_mode!=_xfer_landscape))
-		{
-			
-			if (!POLYGON_IS_DETACHED(polygon))
-			{
-				short color;
-				
-				switch (polygon->type)
-				{
-					case _polygon_is_platform:
-						color= PLATFORM_IS_SECRET(get_platform_data(polygon->permutation)) ?
-							_polygon_color : _polygon_platform_color;
-						if (PLATFORM_IS_FLOODED(get_platform_data(polygon->permutation)))
-						{
-							short adj_index = find_flooding_polygon(i);
-							if (adj_index != NONE)
-							{
-								switch (get_polygon_data(adj_index)->type)
-								{
-									case _polygon_is_minor_ouch:
-										color = _polygon_minor_ouch_color;
-										break;
-									case _polygon_is_major_ouch:
-										color = _polygon_major_ouch_color;
-										break;
-								}
-							}
-						}
-						break;
-					
-					case _polygon_is_minor_ouch:
-						color = _polygon_minor_ouch_color;
-						break;
-					
-					case _polygon_is_major_ouch:
-						color = _polygon_major_ouch_color;
-						break;
-                        
-					case _polygon_is_teleporter:
-						color = _polygon_teleporter_color;
-						break;
-                        
-				case _polygon_is_hill:
-					color = _polygon_hill_color;
-					break;
-					
-					default:
-						color= _polygon_color;
-						break;
-				}
-
-				if (polygon->media_index!=NONE)
-				{
-					struct media_data *media= get_media_data(polygon->media_index);
-					
-					// LP change: idiot-proofing
-					if (media)
-					{
-						if (media->height>=polygon->floor_height)
-						{
-							switch (media->type)
-							{
-								case _media_water: color= _polygon_water_color; break;
-								case _media_lava: color= _polygon_lava_color; break;
-								case _media_goo: color= _polygon_goo_color; break;
-								// LP change: separated sewage and JjaroGoo
-								case _media_sewage: color= _polygon_sewage_color; break;
-								case _media_jjaro: color = _polygon_jjaro_color; break;
-							}
-						}
-					}
-				}
-				
-				draw_polygon(polygon->vertex_count, polygon->endpoint_indexes, color, scale);
-			}
-		}
-	}
-
-	// LP addition
-	end_polygons();
-
-	// LP addition
-	begin_lines();
-	
-	/* draw all visible lines */
-	for (i=0;i<dynamic_world->line_count;++i)
-	{
-		short line_color= NONE;
-		struct line_data *line= get_line_data(i);
-		
-		if (LINE_IS_IN_AUTOMAP(i))
-		{
-			if ((line->clockwise_polygon_owner!=NONE && TEST_STATE_FLAG(line->clockwise_polygon_owner, _polygon_on_automap)) ||
-				(line->counterclockwise_polygon_owner!=NONE && TEST_STATE_FLAG(line->counterclockwise_polygon_owner, _polygon_on_automap)))
-			{
-				struct polygon_data *clockwise_polygon= line->clockwise_polygon_owner==NONE ? NULL : get_polygon_data(line->clockwise_polygon_owner);
-				struct polygon_data *counterclockwise_polygon= line->counterclockwise_polygon_owner==NONE ? NULL : get_polygon_data(line->counterclockwise_polygon_owner);
-
-				if (LINE_IS_SOLID(line) || LINE_IS_VARIABLE_ELEVATION(line))
-				{
-					if (LINE_IS_LANDSCAPED(line))
-					{
-						if ((!clockwise_polygon||clockwise_polygon->floor_transfer_mode!=_xfer_landscape) &&
-							(!counterclockwise_polygon||counterclockwise_polygon->floor_transfer_mode!=_xfer_landscape))
-						{
-							line_color= _elevation_line_color;
-						}
-					}
-					else
-					{
-						line_color= _solid_line_color;
-					}
-				}
-				else
-				{
-					if (clockwise_polygon->floor_height!=counterclockwise_polygon->floor_height)
-					{
-						line_color= LINE_IS_LANDSCAPED(line) ? NONE : static_cast<short>(_elevation_line_color);
-					}
-				}
-			}
-			
-			if (line_color!=NONE) draw_line(i, line_color, scale);
-		}
-	}
-
-	// LP addition
-	end_lines();
+	// a renderer that keeps the automap itself only needs it in world coordinates
+	bool retained= Control.mode==_rendering_game_map && draw_automap(Control);
+	if (!retained)
+		draw_visible_automap(Control);
 	
 	/* print all visible tags */
 	if (scale!=OVERHEAD_MAP_MINIMUM_SCALE)
@@ -229,12 +95,17 @@ void OverheadMapClass::Render(overhead_map_data& Control)
 		i= 0;
 		while ((annotation= get_next_map_annotation(&i))!=NULL)
 		{
-			if (POLYGON_IS_IN_AUTOMAP(annotation->polygon_index) &&
+			if (!POLYGON_IS_IN_AUTOMAP(annotation->polygon_index)) continue;
+			
+			location.x= xoff + WORLD_TO_SCREEN(annotation->location.x, x0, scale);
+			location.y= yoff + WORLD_TO_SCREEN(annotation->location.y, y0, scale);
+			
+			/* without transformed endpoints, go by where the text starts */
+			if (retained ?
+				(location.x >= Control.left && location.x <= Control.left + Control.width &&
+				 location.y >= Control.top && location.y <= Control.top + Control.height) :
 				TEST_STATE_FLAG(annotation->polygon_index, _polygon_on_automap))
 			{
-				location.x= xoff + WORLD_TO_SCREEN(annotation->location.x, x0, scale);
-				location.y= yoff + WORLD_TO_SCREEN(annotation->location.y, y0, scale);
-				
 				draw_annotation(&location, annotation->type, annotation->text, scale);
 			}
 		}
@@ -393,6 +264,173 @@ void OverheadMapClass::Render(overhead_map_data& Control)
 }
 
 
+// The polygons and lines of the automap with an endpoint on the screen,
+// transformed into screen space on the way
+void OverheadMapClass::draw_visible_automap(overhead_map_data& Control)
+{
+	short scale= Control.scale;
+	short i;
+	
+	transform_endpoints_for_overhead_map(Control);
+	
+	// LP addition
+	begin_polygons();
+	
+	/* shade all visible polygons */
+	for (i=0;i<dynamic_world->polygon_count;++i)
+	{
+		if (POLYGON_IS_IN_AUTOMAP(i) && TEST_STATE_FLAG(i, _polygon_on_automap))
+		{
+			short color= automap_polygon_color(i);
+			if (color!=NONE)
+			{
+				struct polygon_data *polygon= get_polygon_data(i);
+				draw_polygon(polygon->vertex_count, polygon->endpoint_indexes, color, scale);
+			}
+		}
+	}
+
+	// LP addition
+	end_polygons();
+
+	// LP addition
+	begin_lines();
+	
+	/* draw all visible lines */
+	for (i=0;i<dynamic_world->line_count;++i)
+	{
+		struct line_data *line= get_line_data(i);
+		
+		if (LINE_IS_IN_AUTOMAP(i) &&
+			((line->clockwise_polygon_owner!=NONE && TEST_STATE_FLAG(line->clockwise_polygon_owner, _polygon_on_automap)) ||
+			 (line->counterclockwise_polygon_owner!=NONE && TEST_STATE_FLAG(line->counterclockwise_polygon_owner, _polygon_on_automap))))
+		{
+			short line_color= automap_line_color(i);
+			if (line_color!=NONE) draw_line(i, line_color, scale);
+		}
+	}
+
+	// LP addition
+	end_lines();
+}
+
+// The color a polygon on the automap is shaded with, or NONE if it isn't shaded
+short OverheadMapClass::automap_polygon_color(
+	short polygon_index)
+{
+	struct polygon_data *polygon= get_polygon_data(polygon_index);
+	short color;
+	
+	if (polygon->floor_transfer_mode==_xfer_landscape && polygon->ceiling_transfer_mode==_xfer_landscape)
+		return NONE;
+	if (POLYGON_IS_DETACHED(polygon))
+		return NONE;
+	
+	switch (polygon->type)
+	{
+		case _polygon_is_platform:
+			color= PLATFORM_IS_SECRET(get_platform_data(polygon->permutation)) ?
+				_polygon_color : _polygon_platform_color;
+			if (PLATFORM_IS_FLOODED(get_platform_data(polygon->permutation)))
+			{
+				short adj_index = find_flooding_polygon(polygon_index);
+				if (adj_index != NONE)
+				{
+					switch (get_polygon_data(adj_index)->type)
+					{
+						case _polygon_is_minor_ouch:
+							color = _polygon_minor_ouch_color;
+							break;
+						case _polygon_is_major_ouch:
+							color = _polygon_major_ouch_color;
+							break;
+					}
+				}
+			}
+			break;
+		
+		case _polygon_is_minor_ouch:
+			color = _polygon_minor_ouch_color;
+			break;
+		
+		case _polygon_is_major_ouch:
+			color = _polygon_major_ouch_color;
+			break;
+			
+		case _polygon_is_teleporter:
+			color = _polygon_teleporter_color;
+			break;
+			
+		case _polygon_is_hill:
+			color = _polygon_hill_color;
+			break;
+		
+		default:
+			color= _polygon_color;
+			break;
+	}
+
+	if (polygon->media_index!=NONE)
+	{
+		struct media_data *media= get_media_data(polygon->media_index);
+		
+		// LP change: idiot-proofing
+		if (media)
+		{
+			if (media->height>=polygon->floor_height)
+			{
+				switch (media->type)
+				{
+					case _media_water: color= _polygon_water_color; break;
+					case _media_lava: color= _polygon_lava_color; break;
+					case _media_goo: color= _polygon_goo_color; break;
+					// LP change: separated sewage and JjaroGoo
+					case _media_sewage: color= _polygon_sewage_color; break;
+					case _media_jjaro: color = _polygon_jjaro_color; break;
+				}
+			}
+		}
+	}
+	
+	return color;
+}
+
+// The line definition a line on the automap is drawn with, or NONE if it isn't drawn
+short OverheadMapClass::automap_line_color(
+	short line_index)
+{
+	struct line_data *line= get_line_data(line_index);
+	struct polygon_data *clockwise_polygon= line->clockwise_polygon_owner==NONE ? NULL : get_polygon_data(line->clockwise_polygon_owner);
+	struct polygon_data *counterclockwise_polygon= line->counterclockwise_polygon_owner==NONE ? NULL : get_polygon_data(line->counterclockwise_polygon_owner);
+	short line_color= NONE;
+
+	if (LINE_IS_SOLID(line) || LINE_IS_VARIABLE_ELEVATION(line))
+	{
+		if (LINE_IS_LANDSCAPED(line))
+		{
+			if ((!clockwise_polygon||clockwise_polygon->floor_transfer_mode!=_xfer_landscape) &&
+				(!counterclockwise_polygon||counterclockwise_polygon->floor_transfer_mode!=_xfer_landscape))
+			{
+				line_color= _elevation_line_color;
+			}
+		}
+		else
+		{
+			line_color= _solid_line_color;
+		}
+	}
+	else
+	{
+		if (clockwise_polygon->floor_height!=counterclockwise_polygon->floor_height)
+		{
+			line_color= LINE_IS_LANDSCAPED(line) ? NONE : static_cast<short>(_elevation_line_color);
+		}
+	}
+	
+	return line_color;
+}
+
+
 void OverheadMapClass::transform_endpoints_for_overhead_map(
 	struct overhead_map_data& Control)
 {
@@ -161,6 +161,7 @@ class OverheadMapClass
 	// The cost function for the checkpoint automap must be static
 	// so it can be called properly
 	void transform_endpoints_for_overhead_map(overhead_map_data &Control);
+	void draw_visible_automap(overhead_map_data &Control);
 	void generate_false_automap(short polygon_index);
 	static int32 false_automap_cost_proc(short source_polygon_index, short line_index, short destination_polygon_index, void *caller_data);
 	void replace_real_automap(void);
@@ -181,6 +182,16 @@ protected:
 	virtual void begin_overall() {}
 	virtual void end_overall() {}
 
+	// For a renderer that keeps the automap's polygons and lines from frame to
+	// frame, in world coordinates: draws them all and returns true, in place of
+	// the draw_polygon() and draw_line() calls for those on the screen
+	virtual bool draw_automap(overhead_map_data& Control) {return false;}
+
+	// What the automap's polygons and lines are drawn in (indexes into the
+	// configuration's colors and line definitions), or NONE if they aren't
+	static short automap_polygon_color(short polygon_index);
+	static short automap_line_color(short line_index);
+
 	virtual void begin_polygons() {}
 	virtual void draw_polygon(
 		short vertex_count,
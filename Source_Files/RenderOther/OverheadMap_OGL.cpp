@@ -65,6 +65,8 @@ Jan 25, 2002 (Br'fin (Jeremy Parsons)):
 
 #include <math.h>
 #include <string.h>
+#include <stddef.h>
+#include <algorithm>
 
 #include "cseries.h"
 #include "OverheadMap_OGL.h"
@@ -101,6 +103,277 @@ static inline bool ColorsEqual(rgb_color& Color1, rgb_color& Color2)
 // these are defined in OGL_Render.cpp
 extern short ViewWidth, ViewHeight;
 
+// As in OverheadMapRenderer.cpp: at scale s, a screen pixel is 2^(8-s) world units
+const int WORLD_TO_SCREEN_SCALE_ONE = 8;
+
+// Entries that haven't been written yet
+const short NOT_WRITTEN = -2;
+
+const int LINE_VERTICES = 6;
+
+static int polygon_vertices(short polygon_index)
+{
+	return 3 * std::max(get_polygon_data(polygon_index)->vertex_count - 2, 0);
+}
+
+static int line_vertices(short line_index)
+{
+	(void) (line_index);
+	return LINE_VERTICES;
+}
+
+static void set_vertex_color(GLubyte *VertexColor, const rgb_color& Color, bool Translucent)
+{
+	VertexColor[0] = Color.red >> 8;
+	VertexColor[1] = Color.green >> 8;
+	VertexColor[2] = Color.blue >> 8;
+	VertexColor[3] = Translucent ? 127 : 255;
+}
+
+OverheadMap_OGL_Class::OverheadMap_OGL_Class() :
+	AutomapChecksum(0), AutomapLevel(NONE), AutomapScale(0), AutomapTranslucent(false)
+{
+}
+
+void OverheadMap_OGL_Class::ResetAutomap()
+{
+	AutomapPolygons.Buffer = AutomapLines.Buffer = 0;
+	AutomapPolygons.Clear();
+	AutomapLines.Clear();
+}
+
+void OverheadMap_OGL_Class::AutomapLayer::Clear()
+{
+	Mapped.clear();
+	Entries.clear();
+	Colors.clear();
+	FirstVertex.clear();
+	Vertices.clear();
+	DirtyFirst = DirtyLast = 0;
+	BufferSize = 0;
+}
+
+// Catches up with the automap bits: whatever was mapped since last time gets
+// its vertices on the end, and if anything was taken off the map (a restored
+// game, a Lua script), the layer starts over
+void OverheadMap_OGL_Class::AutomapLayer::Update(const vector<uint8>& Automap, short Count, int (*VertexCount)(short))
+{
+	size_t Bytes = std::min(Automap.size(), static_cast<size_t>((Count + 7) / 8));
+	
+	bool Removed = Mapped.size() != Bytes;
+	for (size_t i = 0; !Removed && i < Bytes; ++i)
+		Removed = (Mapped[i] & ~Automap[i]) != 0;
+	if (Removed)
+	{
+		GLuint OldBuffer = Buffer;
+		Clear();
+		Buffer = OldBuffer;
+		Mapped.assign(Bytes, 0);
+	}
+	
+	for (size_t i = 0; i < Bytes; ++i)
+	{
+		uint8 Added = Automap[i] & ~Mapped[i];
+		if (!Added) continue;
+		
+		for (int Bit = 0; Bit < 8; ++Bit)
+		{
+			short Index = static_cast<short>(i * 8 + Bit);
+			if (!(Added & (1 << Bit)) || Index >= Count) continue;
+			
+			Entries.push_back(Index);
+			Colors.push_back(NOT_WRITTEN);
+			FirstVertex.push_back(Vertices.size());
+			Vertices.resize(Vertices.size() + VertexCount(Index));
+		}
+		Mapped[i] |= Added;
+	}
+}
+
+void OverheadMap_OGL_Class::AutomapLayer::Touch(size_t First, size_t Count)
+{
+	if (DirtyLast == DirtyFirst)
+	{
+		DirtyFirst = First;
+		DirtyLast = First + Count;
+	}
+	else
+	{
+		DirtyFirst = std::min(DirtyFirst, First);
+		DirtyLast = std::max(DirtyLast, First + Count);
+	}
+}
+
+void OverheadMap_OGL_Class::AutomapLayer::Draw()
+{
+	if (Vertices.empty())
+		return;
+	
+	if (!Buffer)
+	{
+		glGenBuffers(1, &Buffer);
+		BufferSize = 0;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, Buffer);
+	
+	if (Vertices.size() > BufferSize)
+	{
+		// room to map more without reallocating every frame
+		BufferSize = std::max(Vertices.size(), 2 * BufferSize);
+		glBufferData(GL_ARRAY_BUFFER, BufferSize * sizeof(AutomapVertex), NULL, GL_DYNAMIC_DRAW);
+		DirtyFirst = 0;
+		DirtyLast = Vertices.size();
+	}
+	if (DirtyLast > DirtyFirst)
+		glBufferSubData(GL_ARRAY_BUFFER, DirtyFirst * sizeof(AutomapVertex), (DirtyLast - DirtyFirst) * sizeof(AutomapVertex), &Vertices[DirtyFirst]);
+	DirtyFirst = DirtyLast = 0;
+	
+	glVertexPointer(2, GL_FLOAT, sizeof(AutomapVertex), reinterpret_cast<void *>(offsetof(AutomapVertex, x)));
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(AutomapVertex), reinterpret_cast<void *>(offsetof(AutomapVertex, color)));
+	glDrawArrays(GL_TRIANGLES, 0, Vertices.size());
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// A polygon that isn't drawn keeps its vertices, all in one spot
+void OverheadMap_OGL_Class::write_automap_polygon(size_t Entry, short Color)
+{
+	polygon_data *polygon = get_polygon_data(AutomapPolygons.Entries[Entry]);
+	size_t First = AutomapPolygons.FirstVertex[Entry];
+	AutomapVertex *Vertex = &AutomapPolygons.Vertices[First];
+	int Count = polygon_vertices(AutomapPolygons.Entries[Entry]);
+	
+	if (Color == NONE)
+	{
+		for (int k = 0; k < Count; ++k)
+			Vertex[k] = AutomapVertex();
+	}
+	else
+	{
+		// Triangle fans, as in draw_polygon()
+		for (int k = 2; k < polygon->vertex_count; ++k)
+		{
+			short Fan[3] = { polygon->endpoint_indexes[0], polygon->endpoint_indexes[k-1], polygon->endpoint_indexes[k] };
+			for (auto EndpointIndex : Fan)
+			{
+				world_point2d& Point = get_endpoint_data(EndpointIndex)->vertex;
+				Vertex->x = Point.x;
+				Vertex->y = Point.y;
+				set_vertex_color(Vertex->color, AutomapPolygonColors[Color], AutomapTranslucent);
+				++Vertex;
+			}
+		}
+	}
+	
+	AutomapPolygons.Colors[Entry] = Color;
+	AutomapPolygons.Touch(First, Count);
+}
+
+// Lines become two triangles, their pen size wide on the screen, as in OGL_RenderLines()
+void OverheadMap_OGL_Class::write_automap_line(size_t Entry, short Color)
+{
+	line_data *line = get_line_data(AutomapLines.Entries[Entry]);
+	size_t First = AutomapLines.FirstVertex[Entry];
+	AutomapVertex *Vertex = &AutomapLines.Vertices[First];
+	
+	world_point2d& Prev = get_endpoint_data(line->endpoint_indexes[0])->vertex;
+	world_point2d& Cur = get_endpoint_data(line->endpoint_indexes[1])->vertex;
+	float Rise = Cur.y - Prev.y;
+	float Run = Cur.x - Prev.x;
+	float Length = sqrtf(Rise*Rise + Run*Run);
+	
+	if (Color == NONE || Length == 0)
+	{
+		for (int k = 0; k < LINE_VERTICES; ++k)
+			Vertex[k] = AutomapVertex();
+	}
+	else
+	{
+		line_definition& LineDef = AutomapLineDefinitions[Color];
+		float Thickness = LineDef.pen_sizes[AutomapScale-OVERHEAD_MAP_MINIMUM_SCALE] * float(1 << (WORLD_TO_SCREEN_SCALE_ONE - AutomapScale));
+		float Scale = Thickness / Length;
+		float XD = Run * Scale * 0.5f;
+		float YD = Rise * Scale * 0.5f;
+		
+		GLfloat Corners[LINE_VERTICES][2] = {
+			{ Prev.x - YD, Prev.y + XD },
+			{ Prev.x + YD, Prev.y - XD },
+			{ Cur.x - YD, Cur.y + XD },
+			{ Prev.x + YD, Prev.y - XD },
+			{ Cur.x + YD, Cur.y - XD },
+			{ Cur.x - YD, Cur.y + XD }
+		};
+		for (int k = 0; k < LINE_VERTICES; ++k)
+		{
+			Vertex[k].x = Corners[k][0];
+			Vertex[k].y = Corners[k][1];
+			set_vertex_color(Vertex[k].color, LineDef.color, AutomapTranslucent);
+		}
+	}
+	
+	AutomapLines.Colors[Entry] = Color;
+	AutomapLines.Touch(First, LINE_VERTICES);
+}
+
+bool OverheadMap_OGL_Class::draw_automap(overhead_map_data& Control)
+{
+	// A new level starts both layers over
+	uint32 Checksum = get_current_map_checksum();
+	if (Checksum != AutomapChecksum || dynamic_world->current_level_number != AutomapLevel)
+	{
+		AutomapChecksum = Checksum;
+		AutomapLevel = dynamic_world->current_level_number;
+		AutomapPolygons.Mapped.clear();
+		AutomapLines.Mapped.clear();
+	}
+	
+	AutomapPolygons.Update(AutomapPolygonList, dynamic_world->polygon_count, polygon_vertices);
+	AutomapLines.Update(AutomapLineList, dynamic_world->line_count, line_vertices);
+	
+	// Everything is written again when the colors, the translucency or
+	// (for the width of the lines) the scale change
+	bool Rewrite = map_is_translucent() != AutomapTranslucent ||
+		memcmp(AutomapPolygonColors, ConfigPtr->polygon_colors, sizeof(AutomapPolygonColors)) != 0;
+	bool RewriteLines = Rewrite || Control.scale != AutomapScale ||
+		memcmp(AutomapLineDefinitions, ConfigPtr->line_definitions, sizeof(AutomapLineDefinitions)) != 0;
+	AutomapTranslucent = map_is_translucent();
+	AutomapScale = Control.scale;
+	memcpy(AutomapPolygonColors, ConfigPtr->polygon_colors, sizeof(AutomapPolygonColors));
+	memcpy(AutomapLineDefinitions, ConfigPtr->line_definitions, sizeof(AutomapLineDefinitions));
+	
+	// Platforms, media and Lua change what polygons and lines are drawn in
+	for (size_t e = 0; e < AutomapPolygons.Entries.size(); ++e)
+	{
+		short Color = automap_polygon_color(AutomapPolygons.Entries[e]);
+		if (!(Color >= 0 && Color < NUMBER_OF_POLYGON_COLORS)) Color = NONE;
+		if (Rewrite || Color != AutomapPolygons.Colors[e])
+			write_automap_polygon(e, Color);
+	}
+	for (size_t e = 0; e < AutomapLines.Entries.size(); ++e)
+	{
+		short Color = automap_line_color(AutomapLines.Entries[e]);
+		if (!(Color >= 0 && Color < NUMBER_OF_LINE_DEFINITIONS)) Color = NONE;
+		if (RewriteLines || Color != AutomapLines.Colors[e])
+			write_automap_line(e, Color);
+	}
+	
+	// The card does the panning and zooming
+	float Scale = 1.0f / float(1 << (WORLD_TO_SCREEN_SCALE_ONE - Control.scale));
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glTranslatef(Control.left + Control.half_width, Control.top + Control.half_height, 0);
+	glScalef(Scale, Scale, 1);
+	glTranslatef(-Control.origin.x, -Control.origin.y, 0);
+	
+	glEnableClientState(GL_COLOR_ARRAY);
+	AutomapPolygons.Draw();
+	AutomapLines.Draw();
+	glDisableClientState(GL_COLOR_ARRAY);
+	
+	glPopMatrix();
+	return true;
+}
+
 void OverheadMap_OGL_Class::begin_overall()
 {
 
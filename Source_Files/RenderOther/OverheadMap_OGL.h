@@ -33,12 +33,18 @@
 #include <vector>
 #include "OverheadMapRenderer.h"
 
+#ifdef HAVE_OPENGL
+#include "OGL_Headers.h"
+#endif
+
 
 class OverheadMap_OGL_Class: public OverheadMapClass
 {
 	void begin_overall();
 	void end_overall();
 	
+	bool draw_automap(overhead_map_data& Control);
+	
 	void begin_polygons();
 	
 	void draw_polygon(
@@ -102,7 +108,55 @@ class OverheadMap_OGL_Class: public OverheadMapClass
 	// Cached lines For drawing monster paths
 	vector<world_point2d> PathPoints;
 
+#ifdef HAVE_OPENGL
+	// The automap, kept on the card in world coordinates: each polygon and
+	// line gets its run of vertices when it is first mapped, and that run is
+	// only rewritten when what it is drawn in changes
+	struct AutomapVertex
+	{
+		GLfloat x, y;
+		GLubyte color[4];
+	};
+
+	struct AutomapLayer
+	{
+		vector<uint8> Mapped;		// the automap bits the entries were made from
+		vector<short> Entries;		// polygon or line indexes, in the order mapped
+		vector<short> Colors;		// what each entry was last written with
+		vector<size_t> FirstVertex;
+		vector<AutomapVertex> Vertices;
+
+		size_t DirtyFirst, DirtyLast;	// vertices the card doesn't have yet
+		GLuint Buffer;
+		size_t BufferSize;	// in vertices
+
+		AutomapLayer() : DirtyFirst(0), DirtyLast(0), Buffer(0), BufferSize(0) {}
+
+		void Clear();
+		void Update(const vector<uint8>& Automap, short Count, int (*VertexCount)(short));
+		void Touch(size_t First, size_t Count);
+		void Draw();
+	};
+
+	AutomapLayer AutomapPolygons, AutomapLines;
+
+	// what the layers were written for
+	uint32 AutomapChecksum;
+	int16 AutomapLevel;
+	short AutomapScale;
+	bool AutomapTranslucent;
+	rgb_color AutomapPolygonColors[NUMBER_OF_POLYGON_COLORS];
+	line_definition AutomapLineDefinitions[NUMBER_OF_LINE_DEFINITIONS];
+
+	void write_automap_polygon(size_t Entry, short Color);
+	void write_automap_line(size_t Entry, short Color);
+#endif
+
 public:
+	OverheadMap_OGL_Class();
+
+	// forgets the automap's buffers, which went with the old OpenGL context
+	void ResetAutomap();
 };
 
 #endif
@@ -53,6 +53,7 @@
 #include "lua_script.h"
 
 #include "Logging.h"
+#include "world_snapshot.h"
 
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/iostreams/device/array.hpp>
@@ -455,6 +456,12 @@ void initialize_terminal_manager(
 */
 }
 
+void add_player_terminal_snapshot_regions(
+	world_snapshot_regions& regions)
+{
+	regions.push_back({ player_terminals, MAXIMUM_NUMBER_OF_PLAYERS*sizeof(struct player_terminal_data) });
+}
+
 void initialize_player_terminal_info(
 	short player_index)
 {
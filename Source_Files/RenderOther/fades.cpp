@@ -40,6 +40,7 @@
 
 #include "Music.h"
 #include "Movie.h"
+#include "WorldUpdateThread.h"
 
 /* ---------- constants */
 
@@ -287,34 +288,40 @@ void set_fade_effect(
 	
 	if (ForceFEUpdate || fade->fade_effect_type!=type)
 	{
-		fade->fade_effect_type= type;
-		
-		if (!FADE_IS_ACTIVE(fade))
-		{
-			if (type==NONE)
+		// the player entering or leaving a liquid, from within the world's ticks
+		WorldUpdateThread::instance()->run_on_main_thread([type] {
+			fade->fade_effect_type= type;
+			
+			if (!FADE_IS_ACTIVE(fade))
 			{
-				// LP addition: OpenGL-fader handling
-				for (int f=0; f<NUMBER_OF_FADER_QUEUE_ENTRIES; f++)
-					SetOGLFader(f);
-				
-				// Only do the video-card fader if the OpenGL fader is inactive
+				if (type==NONE)
+				{
+					// LP addition: OpenGL-fader handling
+					for (int f=0; f<NUMBER_OF_FADER_QUEUE_ENTRIES; f++)
+						SetOGLFader(f);
+					
+					// Only do the video-card fader if the OpenGL fader is inactive
 #ifdef HAVE_OPENGL
-				if (!OGL_FaderActive())
+					if (!OGL_FaderActive())
 #endif
-					animate_screen_clut(world_color_table, false);
-			}
-			else
-			{
-				recalculate_and_display_color_table(NONE, 0, world_color_table, visible_color_table, false);
+						animate_screen_clut(world_color_table, false);
+				}
+				else
+				{
+					recalculate_and_display_color_table(NONE, 0, world_color_table, visible_color_table, false);
+				}
 			}
-		}
+		});
 	}
 }
 
 void start_fade(
 	short type)
 {
-	explicit_start_fade(type, world_color_table, visible_color_table, true);
+	// damage and pickups start these from within the world's ticks
+	WorldUpdateThread::instance()->run_on_main_thread([type] {
+		explicit_start_fade(type, world_color_table, visible_color_table, true);
+	});
 }
 
 void explicit_start_fade(
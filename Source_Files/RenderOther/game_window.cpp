@@ -42,6 +42,7 @@
 #include "images.h"
 #include "InfoTree.h"
 #include "interface_menus.h"
+#include "WorldUpdateThread.h"
 
 extern void draw_panels(void);
 extern void validate_world_window(void);
@@ -257,29 +258,32 @@ void draw_interface(void)
 	but skip the interface frame) */
 void update_interface(short time_elapsed)
 {
-	if (time_elapsed == NONE)
-        reset_motion_sensor(current_player_index);
-	if (alephbet::Screen::instance()->openGL() || alephbet::Screen::instance()->lua_hud())
-        return;
-
-	if (!game_window_is_full_screen())
-	{
-		// LP addition: don't force an update unless explicitly requested
-		bool force_update = (time_elapsed == NONE);
+	// new and revived players reset the HUD from within the world's ticks
+	WorldUpdateThread::instance()->run_on_main_thread([time_elapsed] {
+		if (time_elapsed == NONE)
+			reset_motion_sensor(current_player_index);
+		if (alephbet::Screen::instance()->openGL() || alephbet::Screen::instance()->lua_hud())
+			return;
+
+		if (!game_window_is_full_screen())
+		{
+			// LP addition: don't force an update unless explicitly requested
+			bool force_update = (time_elapsed == NONE);
 
-		ensure_HUD_buffer();
+			ensure_HUD_buffer();
 
-		// LP addition: added support for HUD buffer;
-		_set_port_to_HUD();
-		if (HUD_SW.update_everything(time_elapsed))
-			force_update = true;
-		_restore_port();
-		
-		// Draw the whole thing if doing so is requested
-		// (may need some smart way of drawing only what has to be drawn)
-		if (force_update)
-			RequestDrawingHUD();
-	}
+			// LP addition: added support for HUD buffer;
+			_set_port_to_HUD();
+			if (HUD_SW.update_everything(time_elapsed))
+				force_update = true;
+			_restore_port();
+			
+			// Draw the whole thing if doing so is requested
+			// (may need some smart way of drawing only what has to be drawn)
+			if (force_update)
+				RequestDrawingHUD();
+		}
+	});
 }
 
 void mark_interface_collections(bool loading)
@@ -266,6 +266,9 @@ void _render_overhead_map(
 	struct overhead_map_data *data)
 {
 	InitMapFonts();
+	
+	// this transforms endpoints into map space
+	invalidate_render_tree();
 		
 	// Select which kind of rendering (OpenGL or software)
 	OverheadMapClass *OvhdMapPtr;
@@ -281,6 +284,13 @@ void _render_overhead_map(
 	OvhdMapPtr->Render(*data);
 }
 
+void OGL_ResetMapGeometry()
+{
+#ifdef HAVE_OPENGL
+	OverheadMap_OGL.ResetAutomap();
+#endif
+}
+
 
 void ResetOverheadMap()
 {
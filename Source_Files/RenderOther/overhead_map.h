@@ -53,6 +53,9 @@ struct overhead_map_data
 
 void _render_overhead_map(struct overhead_map_data *data);
 
+// The OpenGL map keeps the automap in buffers of the current context
+void OGL_ResetMapGeometry();
+
 class InfoTree;
 void parse_mml_overhead_map(const InfoTree& root);
 void reset_mml_overhead_map();
@@ -69,6 +69,7 @@
 #include "HUDRenderer_Lua.h"
 #include "Movie.h"
 #include "shell_options.h"
+#include "WorldUpdateThread.h"
 
 #include <algorithm>
 
@@ -86,7 +87,6 @@ static SDL_Texture *main_texture;
 // The HUD has a separate buffer.
 // It is initialized to NULL so as to allow its initing to be lazy.
 SDL_Surface *world_pixels = NULL;
-SDL_Surface *world_pixels_corrected = NULL;
 SDL_Surface *HUD_Buffer = NULL;
 SDL_Surface *Term_Buffer = NULL;
 SDL_Surface *Intro_Buffer = NULL; // intro screens, main menu, chapters, credits, etc.
@@ -139,6 +139,7 @@ static void apply_gamma(SDL_Surface *src, SDL_Surface *dst);
 static void update_screen(SDL_Rect &source, SDL_Rect &destination, bool hi_rez, bool every_other_line);
 static void update_fps_display(SDL_Surface *s);
 static void DisplayPosition(SDL_Surface *s);
+static void DisplayTickProfile(SDL_Surface *s);
 static void DisplayMessages(SDL_Surface *s);
 static void DrawSurface(SDL_Surface *s, SDL_Rect &dest_rect, SDL_Rect &src_rect);
 static void clear_screen_margin();
@@ -284,14 +285,12 @@ void Screen::Initialize(screen_mode_data* mode)
 		unload_all_collections();
 		if (world_pixels)
 			SDL_FreeSurface(world_pixels);
-		if (world_pixels_corrected)
-			SDL_FreeSurface(world_pixels_corrected);
 	}
 	world_pixels = NULL;
-	world_pixels_corrected = NULL;
 
 	screen_mode = *mode;
-	change_screen_mode(&screen_mode, true);
+	if (!shell_options.headless || shell_options.offscreen)
+		change_screen_mode(&screen_mode, true);
 	screen_initialized = true;
 
 }
@@ -594,10 +593,6 @@ static void reallocate_world_pixels(int width, int height)
 		SDL_FreeSurface(world_pixels);
 		world_pixels = NULL;
 	}
-	if (world_pixels_corrected) {
-		SDL_FreeSurface(world_pixels_corrected);
-		world_pixels_corrected = NULL;
-	}
 	SDL_PixelFormat *f = main_surface->format;
 //	world_pixels = SDL_CreateRGBSurface(SDL_SWSURFACE, width, height, f->BitsPerPixel, f->Rmask, f->Gmask, f->Bmask, f->Amask);
 	switch (bit_depth)
@@ -620,8 +615,7 @@ static void reallocate_world_pixels(int width, int height)
 		SDL_Color colors[256];
 		build_sdl_color_table(world_color_table, colors);
 		SDL_SetPaletteColors(world_pixels->format->palette, colors, 0, 256);
-	} else
-		world_pixels_corrected = SDL_CreateRGBSurface(SDL_SWSURFACE, width, height, world_pixels->format->BitsPerPixel, world_pixels->format->Rmask, world_pixels->format->Gmask, world_pixels->format->Bmask, 0);
+	}
 }
 
 static void reallocate_map_pixels(int width, int height)
@@ -1185,6 +1179,26 @@ void change_screen_mode(struct screen_mode_data *mode, bool redraw, bool resize_
 	fps_counter.reset();
 }
 
+void set_benchmark_screen_mode(short acceleration, short depth, short width, short height)
+{
+	screen_mode_data& mode = graphics_preferences->screen_mode;
+	mode.acceleration = acceleration;
+	mode.bit_depth = depth;
+	mode.width = width;
+	mode.height = height;
+	mode.auto_resolution = false;
+	mode.high_resolution = true;
+	mode.draw_every_other_line = false;
+	mode.fullscreen = false;
+	mode.hud = false;
+
+	// the shading tables are built for the depth the collections load at
+	unload_all_collections();
+	interface_bit_depth = bit_depth = depth;
+	screen_mode = mode;
+	change_screen_mode(&screen_mode, true);
+}
+
 void change_screen_mode(short screentype)
 {
 	struct screen_mode_data *mode = &screen_mode;
@@ -1494,6 +1508,7 @@ void render_screen(short ticks_elapsed)
 		update_fps_display(disp_pixels);
 	  }
 	  DisplayPosition(disp_pixels);
+	  DisplayTickProfile(disp_pixels);
 	  DisplayScores(disp_pixels);
 	}
 	DisplayMessages(disp_pixels);
@@ -1506,6 +1521,10 @@ void render_screen(short ticks_elapsed)
 #endif
 	
 
+	// From here on the world isn't read, so its next ticks can run while the
+	// frame is presented
+	bool world_updating = false;
+
 	// If the main view is not being rendered in software but OpenGL is active,
 	// then blit the software rendering to the screen
 	if (screen_mode.acceleration != _no_acceleration) {
@@ -1569,6 +1588,8 @@ void render_screen(short ticks_elapsed)
 			darken_world_window();
 		}
 
+		world_updating = WorldUpdateThread::instance()->begin_present();
+
 		if (update_full_screen || Screen::instance()->lua_hud())
 		{
 			MainScreenUpdateRect(0, 0, 0, 0);
@@ -1589,177 +1610,214 @@ void render_screen(short ticks_elapsed)
 			darken_world_window();
 		}
 
+		world_updating = WorldUpdateThread::instance()->begin_present();
 		OGL_SwapBuffers();
 	}
 #endif
 	
 	Movie::instance()->AddFrame(Movie::FRAME_NORMAL);
+
+	if (world_updating)
+		WorldUpdateThread::instance()->end_present();
 }
 
 /*
  *  Blit world view to screen
  */
 
-template <class T>
-static inline void quadruple_surface(
-	const T *src,
-	int src_pitch,
-	T *dst, int dst_pitch,
-	const SDL_Rect &dst_rect,
-	bool every_other_line)
-{
-	int width = dst_rect.w / 2;
-	int height = dst_rect.h / 2;
-	dst += dst_rect.y * dst_pitch / sizeof(T) + dst_rect.x;
-	T *dst2 = dst + dst_pitch / sizeof(T);
-
-	uint32 black_pixel = SDL_MapRGB(main_surface->format, 0, 0, 0);
-	bool overlay_active = world_view->overhead_map_active
-		&& map_is_translucent();
-	
-	while (height-- > 0) {
-		if (every_other_line) {
-			if (overlay_active) {
-				// overlay map needs us to clear all the scanlines, so we have
-				// to put black in the "skipped" lines
-				for (int x=0; x<width; x++) {
-					dst[x * 2] = dst[x * 2 + 1] = src[x];
-					dst2[x * 2] = dst2[x * 2 + 1] = black_pixel;
-				}
-			} else {
-				for (int x=0; x<width; x++) {
-					dst[x * 2] = dst[x * 2 + 1] = src[x];
-				}
-			}
-		} else {
-			for (int x=0; x<width; x++) {
-				T p = src[x];
-				dst[x * 2] = dst[x * 2 + 1] = p;
-				dst2[x * 2] = dst2[x * 2 + 1] = p;
-			}
-		}
+// Takes a source pixel straight to its gamma-corrected bits in the destination format,
+// with one lookup per channel; for a palettized source, the first table is the palette.
+// Rebuilt for every blit, which costs next to nothing beside a frame's worth of pixels.
+struct pixel_conversion
+{
+	uint32 channel[3][256];
+	uint32 mask[3];
+	int shift[3];
+	bool identity; // same format and no gamma: pixels are copied as they are
+
+	void build(const SDL_PixelFormat *src, const SDL_PixelFormat *dst, bool gamma);
 
-		src += src_pitch / sizeof(T);
-		dst += dst_pitch * 2 / sizeof(T);
-		dst2 += dst_pitch * 2 / sizeof(T);
+	inline uint32 operator()(uint32 p) const {
+		return channel[0][(p & mask[0]) >> shift[0]] |
+			channel[1][(p & mask[1]) >> shift[1]] |
+			channel[2][(p & mask[2]) >> shift[2]];
 	}
+};
+
+static inline bool pixel_formats_equal(SDL_PixelFormat* a, SDL_PixelFormat* b)
+{
+	return (a->BytesPerPixel == b->BytesPerPixel &&
+		a->Rmask == b->Rmask &&
+		a->Gmask == b->Gmask &&
+		a->Bmask == b->Bmask);
 }
 
-static void apply_gamma(SDL_Surface *src, SDL_Surface *dst)
+void pixel_conversion::build(const SDL_PixelFormat *src, const SDL_PixelFormat *dst, bool gamma)
 {
-	if (SDL_MUSTLOCK(dst)) {
-	    if (SDL_LockSurface(dst) < 0) return;
+	identity = !gamma && !src->palette && pixel_formats_equal(const_cast<SDL_PixelFormat *>(src), const_cast<SDL_PixelFormat *>(dst));
+	if (identity)
+		return;
+
+	if (src->palette) {
+		// gamma is already in the palette
+		mask[0] = 0xff, shift[0] = 0;
+		for (int i = 0; i < src->palette->ncolors; ++i) {
+			const SDL_Color& c = src->palette->colors[i];
+			channel[0][i] = SDL_MapRGB(dst, c.r, c.g, c.b);
+		}
+		for (int i = src->palette->ncolors; i < 256; ++i)
+			channel[0][i] = 0;
+		mask[1] = mask[2] = 0, shift[1] = shift[2] = 0;
+		channel[1][0] = channel[2][0] = 0;
+		return;
 	}
-	uint32 px, dst_px;
-	uint8 src_r, src_g, src_b;
-	uint8 dst_r, dst_g, dst_b;
-	
-	uint32 srm = src->format->Rmask, sgm = src->format->Gmask, sbm = src->format->Bmask;
-	uint32 drm = dst->format->Rmask, dgm = dst->format->Gmask, dbm = dst->format->Bmask;
-	uint32 srs = src->format->Rshift, sgs = src->format->Gshift, sbs = src->format->Bshift;
-	uint32 drs = dst->format->Rshift, dgs = dst->format->Gshift, dbs = dst->format->Bshift;
-	uint32 srl = src->format->Rloss, sgl = src->format->Gloss, sbl = src->format->Bloss;
-	uint32 drl = dst->format->Rloss, dgl = dst->format->Gloss, dbl = dst->format->Bloss;
-	
-	int sbpp = src->format->BytesPerPixel;
-	int dbpp = dst->format->BytesPerPixel;
-	uint8 *sptr = static_cast<uint8*>(src->pixels);
-	uint8 *dptr = static_cast<uint8*>(dst->pixels);
-	size_t numpixels = src->w * src->h;
-	for (size_t i = 0; i < numpixels; ++i) {
-		switch (sbpp) {
-			case 2:
-				px = reinterpret_cast<uint16*>(sptr)[i];
-				break;
-			case 4:
-				px = reinterpret_cast<uint32*>(sptr)[i];
-				break;
-			default:
-				return;
+
+	const uint32 src_masks[3] = { src->Rmask, src->Gmask, src->Bmask };
+	const int src_shifts[3] = { src->Rshift, src->Gshift, src->Bshift };
+	const int src_losses[3] = { src->Rloss, src->Gloss, src->Bloss };
+	const uint32 dst_masks[3] = { dst->Rmask, dst->Gmask, dst->Bmask };
+	const int dst_shifts[3] = { dst->Rshift, dst->Gshift, dst->Bshift };
+	const int dst_losses[3] = { dst->Rloss, dst->Gloss, dst->Bloss };
+	const uint16 *gamma_tables[3] = { current_gamma_r, current_gamma_g, current_gamma_b };
+
+	for (int c = 0; c < 3; ++c) {
+		mask[c] = src_masks[c];
+		shift[c] = src_shifts[c];
+		int levels = (src_masks[c] >> src_shifts[c]) + 1;
+		int loss = src_losses[c];
+		for (int v = 0; v < levels; ++v) {
+			// widen to 8 bits the way SDL does, by repeating the high bits
+			int v8 = (v << loss) | (loss ? v >> (8 - 2 * loss) : 0);
+			if (gamma)
+				v8 = gamma_tables[c][v8] >> 8;
+			channel[c][v] = ((static_cast<uint32>(v8) >> dst_losses[c]) << dst_shifts[c]) & dst_masks[c];
 		}
-	
-		src_r = ((px & srm) >> srs) << srl;
-		src_g = ((px & sgm) >> sgs) << sgl;
-		src_b = ((px & sbm) >> sbs) << sbl;
-		dst_r = current_gamma_r[src_r] >> 8;
-		dst_g = current_gamma_g[src_g] >> 8;
-		dst_b = current_gamma_b[src_b] >> 8;
-		dst_px = (((dst_r >> drl) << drs) & drm) |
-				 (((dst_g >> dgl) << dgs) & dgm) |
-				 (((dst_b >> dbl) << dbs) & dbm);
-			
-		switch (dbpp) {
-			case 2:
-				reinterpret_cast<uint16*>(dptr)[i] = dst_px;
-				break;
-			case 4:
-				reinterpret_cast<uint32*>(dptr)[i] = dst_px;
-				break;
-			default:
-				return;
+	}
+}
+
+// Converts width x height source pixels, doubling each into a 2x2 block if asked;
+// with every_other_line the second row of each block is left alone, or filled with
+// black_pixel if clear_skipped_lines
+template <class S, class D, bool Convert>
+static void blit_pixels(
+	const uint8 *src, int src_pitch,
+	uint8 *dst, int dst_pitch,
+	int width, int height,
+	bool double_size, bool every_other_line, bool clear_skipped_lines,
+	D black_pixel, const pixel_conversion& conversion)
+{
+	for (int y = 0; y < height; ++y) {
+		const S *s = reinterpret_cast<const S *>(src + y * src_pitch);
+		if (!double_size) {
+			D *d = reinterpret_cast<D *>(dst + y * dst_pitch);
+			if (!Convert)
+				memcpy(d, s, width * sizeof(D));
+			else
+				for (int x = 0; x < width; ++x)
+					d[x] = static_cast<D>(conversion(s[x]));
+			continue;
+		}
+
+		D *d = reinterpret_cast<D *>(dst + 2 * y * dst_pitch);
+		D *d2 = reinterpret_cast<D *>(dst + (2 * y + 1) * dst_pitch);
+		for (int x = 0; x < width; ++x) {
+			D p = Convert ? static_cast<D>(conversion(s[x])) : static_cast<D>(s[x]);
+			d[x * 2] = d[x * 2 + 1] = p;
 		}
+		if (!every_other_line)
+			memcpy(d2, d, width * 2 * sizeof(D));
+		else if (clear_skipped_lines)
+			std::fill(d2, d2 + width * 2, black_pixel);
+	}
+}
+
+template <class D>
+static void blit_pixels_to(
+	const SDL_Surface *src, const uint8 *src_pixels,
+	uint8 *dst_pixels, int dst_pitch,
+	int width, int height,
+	bool double_size, bool every_other_line, bool clear_skipped_lines,
+	D black_pixel, const pixel_conversion& conversion)
+{
+	switch (src->format->BytesPerPixel) {
+	case 1:
+		blit_pixels<pixel8, D, true>(src_pixels, src->pitch, dst_pixels, dst_pitch, width, height, double_size, every_other_line, clear_skipped_lines, black_pixel, conversion);
+		break;
+	case 2:
+		if (conversion.identity)
+			blit_pixels<pixel16, D, false>(src_pixels, src->pitch, dst_pixels, dst_pitch, width, height, double_size, every_other_line, clear_skipped_lines, black_pixel, conversion);
+		else
+			blit_pixels<pixel16, D, true>(src_pixels, src->pitch, dst_pixels, dst_pitch, width, height, double_size, every_other_line, clear_skipped_lines, black_pixel, conversion);
+		break;
+	case 4:
+		if (conversion.identity)
+			blit_pixels<pixel32, D, false>(src_pixels, src->pitch, dst_pixels, dst_pitch, width, height, double_size, every_other_line, clear_skipped_lines, black_pixel, conversion);
+		else
+			blit_pixels<pixel32, D, true>(src_pixels, src->pitch, dst_pixels, dst_pitch, width, height, double_size, every_other_line, clear_skipped_lines, black_pixel, conversion);
+		break;
 	}
+}
+
+// Palette or gamma lookup, format conversion and 2x scaling in one pass, straight
+// into the destination; replaces SDL_BlitSurface()/SDL_ConvertSurface(), which
+// allocated a converted copy every frame
+static void blit_surface(
+	SDL_Surface *src, int src_x, int src_y,
+	SDL_Surface *dst, int dst_x, int dst_y,
+	int width, int height,
+	bool gamma, bool double_size, bool every_other_line = false, bool clear_skipped_lines = false)
+{
+	int scale = double_size ? 2 : 1;
+	if (dst_x < 0) src_x -= dst_x / scale, width += dst_x / scale, dst_x = 0;
+	if (dst_y < 0) src_y -= dst_y / scale, height += dst_y / scale, dst_y = 0;
+	width = std::min(width, std::min(src->w - src_x, (dst->w - dst_x) / scale));
+	height = std::min(height, std::min(src->h - src_y, (dst->h - dst_y) / scale));
+	if (width <= 0 || height <= 0)
+		return;
+
+	if (dst->format->BytesPerPixel != 2 && dst->format->BytesPerPixel != 4)
+		return;
+
+	static pixel_conversion conversion;
+	conversion.build(src->format, dst->format, gamma);
+
+	if (SDL_MUSTLOCK(dst) && SDL_LockSurface(dst) < 0)
+		return;
+
+	const uint8 *src_pixels = static_cast<const uint8 *>(src->pixels) + src_y * src->pitch + src_x * src->format->BytesPerPixel;
+	uint8 *dst_pixels = static_cast<uint8 *>(dst->pixels) + dst_y * dst->pitch + dst_x * dst->format->BytesPerPixel;
+	uint32 black_pixel = SDL_MapRGB(dst->format, 0, 0, 0);
+
+	if (dst->format->BytesPerPixel == 2)
+		blit_pixels_to<pixel16>(src, src_pixels, dst_pixels, dst->pitch, width, height, double_size, every_other_line, clear_skipped_lines, black_pixel, conversion);
+	else
+		blit_pixels_to<pixel32>(src, src_pixels, dst_pixels, dst->pitch, width, height, double_size, every_other_line, clear_skipped_lines, black_pixel, conversion);
+
 	if (SDL_MUSTLOCK(dst))
 		SDL_UnlockSurface(dst);
 }
 
-static inline bool pixel_formats_equal(SDL_PixelFormat* a, SDL_PixelFormat* b)
+static void apply_gamma(SDL_Surface *src, SDL_Surface *dst)
 {
-	return (a->BytesPerPixel == b->BytesPerPixel &&
-		a->Rmask == b->Rmask &&
-		a->Gmask == b->Gmask &&
-		a->Bmask == b->Bmask);
+	blit_surface(src, 0, 0, dst, 0, 0, src->w, src->h, true, false);
 }
 
 static void update_screen(SDL_Rect &source, SDL_Rect &destination, bool hi_rez, bool every_other_line)
 {
-	SDL_Surface *s = world_pixels;
-	if (!using_default_gamma && bit_depth > 8) {
-		apply_gamma(world_pixels, world_pixels_corrected);
-		s = world_pixels_corrected;
-	}
+	bool gamma = !using_default_gamma && bit_depth > 8;
 		
 	if (hi_rez) 
 	{
-		SDL_BlitSurface(s, NULL, main_surface, &destination);
+		blit_surface(world_pixels, 0, 0, main_surface, destination.x, destination.y, world_pixels->w, world_pixels->h, gamma, false);
 	} 
 	else 
 	{
-		SDL_Surface* intermediary = 0;
-		if (SDL_MUSTLOCK(main_surface)) 
-		{
-			if (SDL_LockSurface(main_surface) < 0) return;
-		}
-
-		if (!pixel_formats_equal(s->format, main_surface->format))
-		{
-			intermediary = SDL_ConvertSurface(s, main_surface->format, s->flags);
-			s = intermediary;
-		}
-
-		switch (s->format->BytesPerPixel) 
-		{
-		case 1:
-			quadruple_surface((pixel8 *)s->pixels, s->pitch, (pixel8 *)main_surface->pixels, main_surface->pitch, destination, every_other_line);
-			break;
-		case 2:
-			quadruple_surface((pixel16 *)s->pixels, s->pitch, (pixel16 *)main_surface->pixels, main_surface->pitch, destination, every_other_line);
-			break;
-		case 4:
-			quadruple_surface((pixel32 *)s->pixels, s->pitch, (pixel32 *)main_surface->pixels, main_surface->pitch, destination, every_other_line);
-			break;
-		}
-		
-		if (SDL_MUSTLOCK(main_surface)) {
-			SDL_UnlockSurface(main_surface);
-		}
-
-		if (intermediary) 
-		{
-			SDL_FreeSurface(intermediary);
-		}
+		// overlay map needs us to clear all the scanlines, so we have
+		// to put black in the "skipped" lines
+		bool overlay_active = world_view->overhead_map_active
+			&& map_is_translucent();
+		blit_surface(world_pixels, 0, 0, main_surface, destination.x, destination.y, destination.w / 2, destination.h / 2, gamma, true, every_other_line, overlay_active);
 	}
-//	SDL_UpdateRects(main_surface, 1, &destination);
 }
 
 
@@ -2287,7 +2345,31 @@ void MainScreenUpdateRect(int x, int y, int w, int h)
 }
 void MainScreenUpdateRects(size_t count, const SDL_Rect *rects)
 {
-	SDL_UpdateTexture(main_texture, NULL, main_surface->pixels, main_surface->pitch);
+	// Only the given rects changed; as in SDL 1.2, an all-zero rect means the whole screen
+	SDL_Rect screen_rect = { 0, 0, main_surface->w, main_surface->h };
+	int bytes_per_pixel = main_surface->format->BytesPerPixel;
+	for (size_t i = 0; i < count; ++i)
+	{
+		SDL_Rect r;
+		if (rects[i].x == 0 && rects[i].y == 0 && rects[i].w == 0 && rects[i].h == 0)
+			r = screen_rect;
+		else if (!SDL_IntersectRect(&rects[i], &screen_rect, &r))
+			continue;
+
+		void *pixels;
+		int pitch;
+		if (SDL_LockTexture(main_texture, &r, &pixels, &pitch) < 0)
+		{
+			SDL_UpdateTexture(main_texture, NULL, main_surface->pixels, main_surface->pitch);
+			break;
+		}
+		const uint8 *src = static_cast<const uint8 *>(main_surface->pixels) + r.y * main_surface->pitch + r.x * bytes_per_pixel;
+		uint8 *dst = static_cast<uint8 *>(pixels);
+		for (int y = 0; y < r.h; ++y, src += main_surface->pitch, dst += pitch)
+			memcpy(dst, src, r.w * bytes_per_pixel);
+		SDL_UnlockTexture(main_texture);
+	}
+
 	SDL_RenderClear(main_render);
 	SDL_RenderCopy(main_render, main_texture, NULL, NULL);
 //	for (size_t i = 0; i < count; ++i) {
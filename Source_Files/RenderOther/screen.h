@@ -179,6 +179,10 @@ screen_mode_data *get_screen_mode(void);
 void change_screen_mode(struct screen_mode_data *mode, bool redraw, bool resize_hud = false);
 void change_screen_mode(short screentype);
 
+// alephbet-renderbench: windowed, HUD-less mode for the next game; the
+// acceleration falls back to _no_acceleration if no GL context can be made
+void set_benchmark_screen_mode(short acceleration, short depth, short width, short height);
+
 void toggle_fullscreen(bool fs);
 void toggle_fullscreen();
 void update_screen_window(void);
@@ -506,74 +506,101 @@ int sdl_font_info::_draw_text(SDL_Surface *s, const char *text, size_t length, i
 
 int ttf_font_info::_draw_text(SDL_Surface *s, const char *text, size_t length, int x, int y, uint32 pixel, uint16 style, bool utf8) const
 {
-	int clip_top, clip_bottom, clip_left, clip_right;
-	if (draw_clip_rect_active) {
-		clip_top = draw_clip_rect.top;
-		clip_bottom = draw_clip_rect.bottom;
-		clip_left = draw_clip_rect.left;
-		clip_right = draw_clip_rect.right;
-	} else {
-		clip_top = clip_left = 0;
-		clip_right = s->w;
-		clip_bottom = s->h;
+	ttf_glyph_atlas *atlas = get_atlas(style);
+
+	SDL_Rect old_clip_rect;
+	SDL_GetClipRect(s, &old_clip_rect);
+	if (draw_clip_rect_active)
+	{
+		SDL_Rect clip_rect;
+		clip_rect.x = draw_clip_rect.left;
+		clip_rect.y = draw_clip_rect.top;
+		clip_rect.w = draw_clip_rect.right - draw_clip_rect.left;
+		clip_rect.h = draw_clip_rect.bottom - draw_clip_rect.top;
+		if (!SDL_IntersectRect(&old_clip_rect, &clip_rect, &clip_rect))
+			clip_rect.w = clip_rect.h = 0;
+		SDL_SetClipRect(s, &clip_rect);
 	}
 
 	SDL_Color c;
 	SDL_GetRGB(pixel, s->format, &c.r, &c.g, &c.b);
-	c.a = 0xff;
-	SDL_Surface *text_surface = 0;
-	if (utf8) 
-	{
-		char *temp = process_printable(text, length);
-		if (environment_preferences->smooth_text)
-			text_surface = TTF_RenderUTF8_Blended(get_ttf(style), temp, c);	
-		else
-			text_surface = TTF_RenderUTF8_Solid(get_ttf(style), temp, c);
-	}
-	else
-	{
-		uint16 *temp = process_macroman(text, length);
-		if (environment_preferences->smooth_text)
-			text_surface = TTF_RenderUNICODE_Blended(get_ttf(style), temp, c);
-		else
-			text_surface = TTF_RenderUNICODE_Solid(get_ttf(style), temp, c);
-	}
-	if (!text_surface) return 0;
-	
-	SDL_Rect dst_rect;
-	dst_rect.x = x;
-	dst_rect.y = y - TTF_FontAscent(get_ttf(style));
 
-	if (draw_clip_rect_active)
-	{
-		SDL_Rect src_rect;
-		src_rect.x = 0;
-		src_rect.y = 0;
+	int pen = x;
+	uint16 previous = 0;
+	auto draw_glyph = [&](uint16 uc) {
+		const ttf_glyph_atlas::glyph *glyph = atlas->get(uc);
+		if (!glyph)
+			return;
 
-		if (clip_top > dst_rect.y)
+		pen += atlas->kerning(previous, uc);
+		if (glyph->rect.w)
 		{
-			src_rect.y += dst_rect.y - clip_top;
+			SDL_Rect src_rect = glyph->rect;
+			SDL_Rect dst_rect;
+			dst_rect.x = pen + glyph->minx;
+			dst_rect.y = y - glyph->maxy;
+			SDL_SetSurfaceColorMod(atlas->surface(), c.r, c.g, c.b);
+			SDL_BlitSurface(atlas->surface(), &src_rect, s, &dst_rect);
 		}
+		pen += glyph->advance;
+		previous = uc;
+	};
 
-		if (clip_left > dst_rect.x)
-		{
-			src_rect.x += dst_rect.x - clip_left;
-		}
+	if (utf8)
+	{
+		const char *temp = process_printable(text, length);
 
-		src_rect.w = (clip_right > dst_rect.x) ? clip_right - dst_rect.x : 0;
-		src_rect.h = (clip_bottom > dst_rect.y) ? clip_bottom - dst_rect.y : 0;
+		// The atlas only holds the Basic Multilingual Plane; anything
+		// beyond it (emoji, the rarer CJK) is left to SDL_ttf
+		bool supplementary = false;
+		for (const char *p = temp; *p && !supplementary; ++p)
+			supplementary = (static_cast<unsigned char>(*p) >= 0xf0);
 
-		SDL_BlitSurface(text_surface, &src_rect, s, &dst_rect);
+		if (supplementary)
+		{
+			c.a = 0xff;
+			SDL_Surface *text_surface;
+			if (environment_preferences->smooth_text)
+				text_surface = TTF_RenderUTF8_Blended(get_ttf(style), temp, c);
+			else
+				text_surface = TTF_RenderUTF8_Solid(get_ttf(style), temp, c);
+			if (text_surface)
+			{
+				SDL_Rect dst_rect;
+				dst_rect.x = x;
+				dst_rect.y = y - TTF_FontAscent(get_ttf(style));
+				SDL_BlitSurface(text_surface, NULL, s, &dst_rect);
+				SDL_FreeSurface(text_surface);
+			}
+		}
+		else
+		{
+			for (const char *p = temp; *p; )
+			{
+				int used;
+				uint16 uc = utf8_to_unicode(p, used);
+				// don't run past the end of a truncated sequence
+				if (used > 1 && (!p[1] || (used > 2 && !p[2])))
+					break;
+				draw_glyph(uc);
+				p += used;
+			}
+		}
 	}
 	else
-		SDL_BlitSurface(text_surface, NULL, s, &dst_rect);
+	{
+		for (const uint16 *p = process_macroman(text, length); *p; ++p)
+			draw_glyph(*p);
+	}
+
+	if (draw_clip_rect_active)
+		SDL_SetClipRect(s, &old_clip_rect);
 
 	if (s == MainScreenSurface())
 		MainScreenUpdateRect(x, y - TTF_FontAscent(get_ttf(style)), text_width(text, style, utf8), TTF_FontHeight(get_ttf(style)));
 
-	int width = text_surface->w;
-	SDL_FreeSurface(text_surface);
-	return width;
+	// the same width text_width() reports, whichever way the text was drawn
+	return _text_width(text, length, style, utf8);
 }
 
 static void draw_text(const char *text, int x, int y, uint32 pixel, const font_info *font, uint16 style)
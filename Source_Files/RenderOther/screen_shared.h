@@ -48,6 +48,7 @@ extern SDL_Surface *world_pixels;
 #define DEFAULT_WORLD_HEIGHT 320
 
 #include "Console.h"
+#include "TickProfiler.h"
 #include "screen_drawing.h"
 
 #include "network_games.h"
@@ -623,6 +624,54 @@ static void DisplayPosition(SDL_Surface *s)
 	
 }
 
+// top-right table of the rolling per-phase tick cost (".tick_profile on")
+static void DisplayTickProfile(SDL_Surface *s)
+{
+	TickProfiler* profiler = TickProfiler::instance();
+	if (!profiler->overlay_visible()) return;
+
+	FontSpecifier& Font = GetOnScreenFont();
+
+	DisplayTextDest = s;
+	DisplayTextFont = Font.Info;
+	DisplayTextStyle = Font.Style;
+
+	auto text_margins = alephbet::Screen::instance()->lua_text_margins;
+	short LineSpacing = Font.LineSpacing;
+	int CWidth = DisplayTextWidth("0");
+	int WName = CWidth * 17;
+	int WColumn = CWidth * 8;
+	int X = s->w - text_margins.right - LineSpacing/3 - WName - 3 * WColumn;
+	int Y = text_margins.top + LineSpacing;
+
+	DisplayText(X, Y, "ms", 0xbf, 0xbf, 0xbf);
+	DisplayText(X + WName + WColumn - DisplayTextWidth("mean"), Y, "mean", 0xbf, 0xbf, 0xbf);
+	DisplayText(X + WName + 2 * WColumn - DisplayTextWidth("p99"), Y, "p99", 0xbf, 0xbf, 0xbf);
+	DisplayText(X + WName + 3 * WColumn - DisplayTextWidth("max"), Y, "max", 0xbf, 0xbf, 0xbf);
+
+	for (int phase = 0; phase < NUMBER_OF_TICK_PHASES; ++phase)
+	{
+		Y += LineSpacing;
+		auto summary = profiler->window_summary(static_cast<tick_phase>(phase));
+
+		// a phase that ate a third of the tick budget stands out
+		unsigned char g = (summary.max_ms > 1000.0 / TICKS_PER_SECOND / 3) ? 0x7f : 0xff;
+		unsigned char b = g;
+		DisplayText(X, Y, TickProfiler::phase_name(static_cast<tick_phase>(phase)), 0xff, g, b);
+
+		double values[3] = { summary.mean_ms, summary.p99_ms, summary.max_ms };
+		for (int i = 0; i < 3; ++i)
+		{
+			sprintf(temporary, "%.2f", values[i]);
+			DisplayText(X + WName + (i + 1) * WColumn - DisplayTextWidth(temporary), Y, temporary, 0xff, g, b);
+		}
+	}
+
+	Y += LineSpacing;
+	sprintf(temporary, "over budget: %d", profiler->ticks_over_budget());
+	DisplayText(X, Y, temporary, 0xbf, 0xbf, 0xbf);
+}
+
 static void DisplayInputLine(SDL_Surface *s)
 {
   if (Console::instance()->input_active() && 
@@ -32,6 +32,7 @@
 #include <SDL2/SDL_endian.h>
 #include <vector>
 #include <map>
+#include <memory>
 
 #include <boost/tokenizer.hpp>
 #include <string>
@@ -60,6 +61,10 @@ typedef pair<TTF_Font *, int> ref_counted_ttf_font_t;
 typedef map<ttf_font_key_t, ref_counted_ttf_font_t> ttf_font_list_t;
 static ttf_font_list_t ttf_font_list;
 
+// Glyph atlases of the loaded TTF fonts, freed when the font is closed
+typedef map<ttf_font_key_t, std::unique_ptr<ttf_glyph_atlas> > ttf_glyph_atlas_list_t;
+static ttf_glyph_atlas_list_t ttf_glyph_atlases;
+
 // From shell_sdl.cpp
 extern vector<DirectorySpecifier> data_search_path;
 
@@ -449,12 +454,14 @@ void ttf_font_info::_unload()
 			--(it->second.second);
 			if (it->second.second <= 0)
 			{
+				ttf_glyph_atlases.erase(m_keys[i]);
 				TTF_CloseFont(it->second.first);
 				ttf_font_list.erase(m_keys[i]);
 			}
 		}
 
 		m_styles[i] = 0;
+		m_atlases[i] = 0;
 	}
 
 	delete this;
@@ -563,6 +570,188 @@ int ttf_font_info::_trunc_text(const char *text, int max_width, uint16 style) co
 
 // ttf_font_info::_draw_text is in screen_drawing.cpp
 
+ttf_glyph_atlas *ttf_font_info::get_atlas(uint16 style) const
+{
+	int face = style & (styleBold | styleItalic);
+	if (!m_atlases[face])
+	{
+		std::unique_ptr<ttf_glyph_atlas>& atlas = ttf_glyph_atlases[m_keys[face]];
+		if (!atlas)
+			atlas.reset(new ttf_glyph_atlas(m_styles[face]));
+		m_atlases[face] = atlas.get();
+	}
+
+	return m_atlases[face];
+}
+
+// Wide enough for a few rows of glyphs at the usual sizes; the atlas grows
+// downward as glyphs are added
+static const int kGlyphAtlasWidth = 512;
+
+ttf_glyph_atlas::ttf_glyph_atlas(TTF_Font *font) :
+	m_font(font), m_smooth(environment_preferences->smooth_text), m_surface(0),
+	m_row_x(0), m_row_y(0), m_row_height(0)
+{
+}
+
+ttf_glyph_atlas::~ttf_glyph_atlas()
+{
+	clear();
+}
+
+void ttf_glyph_atlas::clear()
+{
+	if (m_surface)
+		SDL_FreeSurface(m_surface);
+	m_surface = 0;
+	m_row_x = m_row_y = m_row_height = 0;
+	m_glyphs.clear();
+}
+
+const ttf_glyph_atlas::glyph *ttf_glyph_atlas::get(uint16 c)
+{
+	// the glyphs were rendered for the other text smoothing; start over
+	if (m_smooth != environment_preferences->smooth_text)
+	{
+		clear();
+		m_smooth = environment_preferences->smooth_text;
+	}
+
+	std::unordered_map<uint16, glyph>::iterator it = m_glyphs.find(c);
+	if (it != m_glyphs.end())
+		return &it->second;
+
+	glyph g;
+	g.rect.x = g.rect.y = g.rect.w = g.rect.h = 0;
+	if (TTF_GlyphMetrics(m_font, c, &g.minx, 0, 0, &g.maxy, &g.advance) != 0)
+		g.minx = g.maxy = g.advance = 0;
+
+	SDL_Color white = { 0xff, 0xff, 0xff, 0xff };
+	SDL_Surface *rendered;
+	if (m_smooth)
+		rendered = TTF_RenderGlyph_Blended(m_font, c, white);
+	else
+		rendered = TTF_RenderGlyph_Solid(m_font, c, white);
+
+	// blank glyphs (spaces) may not render at all; they only advance
+	if (rendered)
+	{
+		bool placed = place(rendered, g.rect);
+		SDL_FreeSurface(rendered);
+		if (!placed)
+			return 0;
+	}
+
+	return &(m_glyphs[c] = g);
+}
+
+// SDL_ttf versions differ in how much room they leave around a rendered
+// glyph, so only its ink is kept, to be placed from the glyph's metrics
+bool ttf_glyph_atlas::find_ink(SDL_Surface *s, SDL_Rect& ink)
+{
+	int left = s->w, right = -1, top = s->h, bottom = -1;
+	for (int y = 0; y < s->h; ++y)
+	{
+		const uint32 *row = reinterpret_cast<const uint32 *>(static_cast<const uint8 *>(s->pixels) + y * s->pitch);
+		for (int x = 0; x < s->w; ++x)
+		{
+			if (!(row[x] & s->format->Amask))
+				continue;
+			left = std::min(left, x);
+			right = std::max(right, x);
+			top = std::min(top, y);
+			bottom = std::max(bottom, y);
+		}
+	}
+
+	if (right < 0)
+		return false;
+
+	ink.x = left;
+	ink.y = top;
+	ink.w = right - left + 1;
+	ink.h = bottom - top + 1;
+	return true;
+}
+
+bool ttf_glyph_atlas::place(SDL_Surface *rendered, SDL_Rect& rect)
+{
+	// Solid glyphs come back palettized with a colour key, which the
+	// conversion turns into alpha
+	SDL_Surface *converted = SDL_ConvertSurfaceFormat(rendered, SDL_PIXELFORMAT_ARGB8888, 0);
+	if (!converted)
+		return false;
+
+	SDL_Rect ink;
+	if (!find_ink(converted, ink))
+	{
+		// nothing to draw, only an advance
+		SDL_FreeSurface(converted);
+		rect.x = rect.y = rect.w = rect.h = 0;
+		return true;
+	}
+
+	if (ink.w > kGlyphAtlasWidth)
+	{
+		SDL_FreeSurface(converted);
+		return false;
+	}
+
+	if (m_row_x + ink.w > kGlyphAtlasWidth)
+	{
+		m_row_x = 0;
+		m_row_y += m_row_height;
+		m_row_height = 0;
+	}
+
+	int height = m_surface ? m_surface->h : 0;
+	if (m_row_y + ink.h > height)
+	{
+		int new_height = std::max(height, 64);
+		while (m_row_y + ink.h > new_height)
+			new_height *= 2;
+
+		SDL_Surface *grown = SDL_CreateRGBSurface(SDL_SWSURFACE, kGlyphAtlasWidth, new_height, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+		if (!grown)
+		{
+			SDL_FreeSurface(converted);
+			return false;
+		}
+
+		SDL_FillRect(grown, NULL, 0);
+		if (m_surface)
+		{
+			SDL_SetSurfaceBlendMode(m_surface, SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(m_surface, NULL, grown, NULL);
+			SDL_FreeSurface(m_surface);
+		}
+		SDL_SetSurfaceBlendMode(grown, SDL_BLENDMODE_BLEND);
+		m_surface = grown;
+	}
+
+	rect.x = m_row_x;
+	rect.y = m_row_y;
+	rect.w = ink.w;
+	rect.h = ink.h;
+
+	SDL_SetSurfaceBlendMode(converted, SDL_BLENDMODE_NONE);
+	SDL_Rect dst_rect = rect;
+	SDL_BlitSurface(converted, &ink, m_surface, &dst_rect);
+	SDL_FreeSurface(converted);
+
+	m_row_x += rect.w;
+	m_row_height = std::max(m_row_height, static_cast<int>(rect.h));
+	return true;
+}
+
+int ttf_glyph_atlas::kerning(uint16 previous, uint16 c) const
+{
+	if (!previous || !TTF_GetFontKerning(m_font))
+		return 0;
+
+	return TTF_GetFontKerningSizeGlyphs(m_font, previous, c);
+}
+
 char *ttf_font_info::process_printable(const char *src, int len) const 
 {
 	static char dst[1024];
@@ -35,6 +35,7 @@
 #include <SDL2/SDL_ttf.h>
 #include <tuple>
 #include <string>
+#include <unordered_map>
 
 /*
  *  Definitions
@@ -114,6 +115,40 @@ private:
 
 typedef std::tuple<std::string, uint16, int16> ttf_font_key_t;
 
+// Glyphs of one loaded TTF face, rendered once in white and packed into a
+// single surface; strings are drawn by colour-modulated blits (or textured
+// quads) out of it instead of a TTF_Render call and a new surface each time.
+// Shared by every ttf_font_info using the face, and freed with it.
+class ttf_glyph_atlas {
+public:
+	struct glyph {
+		SDL_Rect rect;	// the glyph's ink in surface(); empty for blank glyphs
+		int minx, maxy;	// where the ink goes, from the pen and the baseline
+		int advance;
+	};
+
+	ttf_glyph_atlas(TTF_Font *font);
+	~ttf_glyph_atlas();
+
+	// renders c into the atlas the first time it is asked for; NULL if the
+	// atlas can't hold it
+	const glyph *get(uint16 c);
+	int kerning(uint16 previous, uint16 c) const;
+
+	SDL_Surface *surface() const { return m_surface; }
+
+private:
+	bool place(SDL_Surface *rendered, SDL_Rect& rect);
+	static bool find_ink(SDL_Surface *s, SDL_Rect& ink);
+	void clear();
+
+	TTF_Font *m_font;
+	bool m_smooth;		// smooth_text when the glyphs were rendered
+	SDL_Surface *m_surface;
+	int m_row_x, m_row_y, m_row_height;
+	std::unordered_map<uint16, glyph> m_glyphs;
+};
+
 class ttf_font_info : public font_info { 
 public:
 	uint16 get_ascent() const { return TTF_FontAscent(m_styles[styleNormal]); };
@@ -130,7 +165,7 @@ public:
 	int8 char_width(uint8, uint16) const;
 
 	ttf_font_info() { 
-		for (int i = 0; i < styleUnderline; i++) { m_styles[i] = 0; } 
+		for (int i = 0; i < styleUnderline; i++) { m_styles[i] = 0; m_atlases[i] = 0; } 
 	}
 	virtual ~ttf_font_info() = default;
 protected:
@@ -142,7 +177,10 @@ private:
 	char *process_printable(const char *src, int len) const;
 	uint16 *process_macroman(const char *src, int len) const;
 	TTF_Font *get_ttf(uint16 style) const { return m_styles[style & (styleBold | styleItalic)]; }
+	ttf_glyph_atlas *get_atlas(uint16 style) const;
 	virtual void _unload();
+
+	mutable ttf_glyph_atlas *m_atlases[styleUnderline];
 };
 
 /*
@@ -0,0 +1,287 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  renderbench_main.cpp - alephbet-renderbench, the renderer benchmark
+ *
+ *  Usage: alephbet-renderbench [--frames n] [--renderers sw8,sw16,sw32,gl]
+ *                              [--size WxH] scenario-directory film
+ *
+ *  Replays the film once per renderer and renders a frame after every tick
+ *  from the recording player's viewpoint, so each run sees the same frames.
+ *  After kWarmupFrames it times n frames and reports the mean, p50, p95 and
+ *  p99 of the whole frame and of each render_view() phase; "other" is what
+ *  is left of the frame (HUD, blit, present). Set SDL_VIDEODRIVER to
+ *  "offscreen" (the default here) or "dummy" to run without a display; GL
+ *  needs a software implementation such as Mesa's llvmpipe on a GPU-less
+ *  box, and is reported as unavailable if no context can be created.
+ */
+
+#include "shell_options.h"
+#include "shell.h"
+#include "interface.h"
+#include "screen.h"
+#include "render.h"
+#include "preferences.h"
+#include "OGL_Headers.h"
+#include "OGL_Render.h"
+#include "FileHandler.h"
+#include "Logging.h"
+#include <SDL2/SDL_main.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static constexpr int kWarmupFrames = 30;
+
+struct renderer_definition {
+	const char* name;
+	short acceleration;
+	short bit_depth;
+};
+
+static const renderer_definition renderer_definitions[] = {
+	{ "sw8", _no_acceleration, 8 },
+	{ "sw16", _no_acceleration, 16 },
+	{ "sw32", _no_acceleration, 32 },
+	{ "gl", _opengl_acceleration, 32 }
+};
+
+static const char* phase_names[NUMBER_OF_RENDER_PHASES] = {
+	"vis_tree",
+	"sort_polygons",
+	"place_objects",
+	"rasterize"
+};
+
+// state of the run in progress, for render_tick
+static int frames_wanted;
+static int frames_rendered;
+static bool want_opengl;
+static bool opengl_unavailable;
+static std::vector<double> frame_times;
+static std::array<std::vector<double>, NUMBER_OF_RENDER_PHASES> phase_times;
+
+static bool render_tick()
+{
+	if (want_opengl && !OGL_IsActive())
+	{
+		opengl_unavailable = true;
+		return false;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	render_screen(1);
+#ifdef HAVE_OPENGL
+	if (want_opengl)
+		glFinish();
+#endif
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (frames_rendered++ >= kWarmupFrames)
+	{
+		frame_times.push_back(seconds);
+		for (int phase = 0; phase < NUMBER_OF_RENDER_PHASES; ++phase)
+			phase_times[phase].push_back(get_render_phase_time(static_cast<render_phase>(phase)));
+	}
+
+	return frames_rendered < kWarmupFrames + frames_wanted;
+}
+
+static void print_statistics(const char* renderer, const char* name, std::vector<double> samples)
+{
+	if (samples.empty())
+		return;
+
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0;
+	for (auto sample : samples)
+		sum += sample;
+
+	auto percentile = [&samples](int p) { return samples[(samples.size() - 1) * p / 100] * 1000.0; };
+
+	printf("%s\t%zu\t%s\t%.3f\t%.3f\t%.3f\t%.3f\n", renderer, samples.size(), name,
+		   sum * 1000.0 / samples.size(), percentile(50), percentile(95), percentile(99));
+}
+
+// returns false if the film couldn't be played
+static bool run_renderer(const renderer_definition& renderer, const std::string& film, short width, short height)
+{
+	frames_rendered = 0;
+	want_opengl = renderer.acceleration != _no_acceleration;
+	opengl_unavailable = false;
+	frame_times.clear();
+	for (auto& times : phase_times)
+		times.clear();
+
+	set_benchmark_screen_mode(renderer.acceleration, renderer.bit_depth, width, height);
+	set_render_phase_timing(true);
+
+	FileSpecifier file = film;
+	int32 ticks = 0;
+	bool played = run_headless_replay(file, ticks, render_tick);
+
+	set_render_phase_timing(false);
+
+	if (opengl_unavailable)
+	{
+		printf("%s\t0\tunavailable\n", renderer.name);
+		fflush(stdout);
+		return played;
+	}
+
+	if (static_cast<int>(frame_times.size()) < frames_wanted)
+		logWarning("%s: the film ended after %zu timed frames", renderer.name, frame_times.size());
+
+	std::vector<double> other_times(frame_times);
+	for (size_t i = 0; i < other_times.size(); ++i)
+	{
+		for (const auto& times : phase_times)
+			other_times[i] -= times[i];
+	}
+
+	print_statistics(renderer.name, "frame", frame_times);
+	for (int phase = 0; phase < NUMBER_OF_RENDER_PHASES; ++phase)
+		print_statistics(renderer.name, phase_names[phase], phase_times[phase]);
+	print_statistics(renderer.name, "other", other_times);
+	fflush(stdout);
+
+	return played;
+}
+
+static void print_usage()
+{
+	printf("Usage: %s [--frames n] [--renderers sw8,sw16,sw32,gl] [--size WxH] scenario-directory film\n",
+		   shell_options.program_name.c_str());
+}
+
+int main(int argc, char** argv)
+{
+	int frames = 600;
+	std::string renderers = "sw8,sw16,sw32,gl";
+	int width = 1280, height = 720;
+
+	// take our own options out before the shell sees the rest
+	std::vector<char*> args;
+	bool bad_args = false;
+	for (int i = 0; i < argc; ++i)
+	{
+		bool has_value = i + 1 < argc;
+		if (strcmp(argv[i], "--frames") == 0 && has_value)
+			bad_args |= (frames = atoi(argv[++i])) <= 0;
+		else if (strcmp(argv[i], "--renderers") == 0 && has_value)
+			renderers = argv[++i];
+		else if (strcmp(argv[i], "--size") == 0 && has_value)
+			bad_args |= sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 640 || height < 480;
+		else
+			args.push_back(argv[i]);
+	}
+
+	shell_options.parse(static_cast<int>(args.size()), args.data());
+	shell_options.headless = true;
+	shell_options.offscreen = true;
+
+	std::vector<const renderer_definition*> selected;
+	size_t start = 0;
+	while (start <= renderers.size())
+	{
+		size_t end = std::min(renderers.find(',', start), renderers.size());
+		std::string name = renderers.substr(start, end - start);
+		auto it = std::find_if(std::begin(renderer_definitions), std::end(renderer_definitions),
+							   [&name](const renderer_definition& r) { return name == r.name; });
+		if (it == std::end(renderer_definitions))
+			bad_args = true;
+		else
+			selected.push_back(&*it);
+		start = end + 1;
+	}
+
+	if (bad_args || shell_options.files.size() != 1)
+	{
+		print_usage();
+		return 1;
+	}
+
+	SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+	frames_wanted = frames;
+
+	auto code = 0;
+
+	try {
+
+		initialize_application();
+
+		// one frame per tick, with no interpolation between ticks
+		graphics_preferences->fps_target = 30;
+
+		printf("renderer\tframes\tphase\tmean_ms\tp50_ms\tp95_ms\tp99_ms\n");
+		for (auto renderer : selected)
+		{
+			if (!run_renderer(*renderer, shell_options.files.front(), width, height))
+			{
+				fprintf(stderr, "Couldn't play %s\n", shell_options.files.front().c_str());
+				code = 1;
+				break;
+			}
+		}
+
+	}
+	catch (std::exception& e) {
+		try
+		{
+			logFatal("Unhandled exception: %s", e.what());
+		}
+		catch (...)
+		{
+		}
+		fprintf(stderr, "%s\n", e.what());
+		code = 1;
+	}
+	catch (...) {
+		try
+		{
+			logFatal("Unknown exception");
+		}
+		catch (...)
+		{
+		}
+		code = 1;
+	}
+
+	try
+	{
+		shutdown_application();
+	}
+	catch (...)
+	{
+
+	}
+
+	return code;
+}
@@ -0,0 +1,206 @@
+/*
+ *
+ *  Aleph Bet is copyright ©1994-2024 Bungie Inc., the Aleph One developers,
+ *  and the Aleph Bet developers.
+ *
+ *  Aleph Bet is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Aleph Bet is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  This license notice applies only to the Aleph Bet engine itself, and
+ *  does not apply to Marathon, Marathon 2, or Marathon Infinity scenarios
+ *  and assets, nor to elements of any third-party scenarios.
+ *
+ */
+
+/*
+ *  replay_main.cpp - alephbet-replay, the headless film runner
+ *
+ *  Usage: alephbet-replay [-l replay-directory] scenario-directory [film...]
+ *
+ *  Plays every film as fast as the simulation allows, without a window,
+ *  OpenGL context or audio device, and reports per film the ticks stepped,
+ *  the wall time, the throughput and the final random seed. Films named
+ *  "name.<seed>.filA" (as in tests/replay_film_test.cpp) are checked against
+ *  that seed, and films that carry world hash samples are checked against
+ *  those tick by tick ("diverged"); any mismatch or failure to play makes
+ *  the exit code nonzero.
+ */
+
+#include "shell_options.h"
+#include "shell.h"
+#include "interface.h"
+#include "world.h"
+#include "FileHandler.h"
+#include "Logging.h"
+#include <SDL2/SDL_main.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+static void find_films(const std::string& directory_path, std::vector<std::string>& films)
+{
+	FileSpecifier directory = directory_path;
+
+	std::vector<dir_entry> entries;
+	if (!directory.ReadDirectory(entries))
+		return;
+
+	for (const auto& it : entries)
+	{
+		FileSpecifier entry = directory + it.name;
+
+		if (entry.IsDir())
+			find_films(entry.GetPath(), films);
+		else if (entry.GetType() == _typecode_film)
+			films.push_back(entry.GetPath());
+	}
+}
+
+// returns -1 if the film name carries no seed
+static int32 get_seed_from_filename(const std::string& path)
+{
+	FileSpecifier file = path;
+	std::string directory, file_name;
+	file.SplitPath(directory, file_name);
+
+	auto name_without_ext = file_name.substr(0, file_name.find_last_of('.'));
+	auto seed_position = name_without_ext.find_last_of('.');
+	if (seed_position == std::string::npos)
+		return -1;
+
+	try {
+		return std::stoi(name_without_ext.substr(seed_position + 1));
+	}
+	catch (...) {
+		return -1;
+	}
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int run_films(const std::vector<std::string>& films)
+{
+	int failures = 0;
+	int64_t total_ticks = 0;
+	double total_seconds = 0;
+
+	printf("film\tticks\tseconds\tticks/s\tseed\tresult\n");
+
+	for (const auto& path : films)
+	{
+		FileSpecifier file = path;
+		int32 ticks = 0;
+
+		auto start = std::chrono::steady_clock::now();
+		bool played = run_headless_replay(file, ticks);
+		double seconds = seconds_since(start);
+
+		uint16 seed = get_random_seed();
+		int32 expected_seed = get_seed_from_filename(path);
+
+		int32 divergent_tick;
+		uint32 divergent_subsystems;
+		bool diverged = get_replay_world_hash_desync(divergent_tick, divergent_subsystems);
+
+		const char* result = "ok";
+		if (!played)
+			result = "failed";
+		else if (expected_seed >= 0 && expected_seed != seed)
+			result = "mismatch";
+		else if (diverged)
+			result = "diverged";
+
+		if (strcmp(result, "ok") != 0)
+			++failures;
+
+		// a film that didn't load leaves the previous film's seed behind
+		char seed_text[8] = "-";
+		if (played)
+			snprintf(seed_text, sizeof(seed_text), "%hu", seed);
+
+		printf("%s\t%d\t%.3f\t%.0f\t%s\t%s\n", path.c_str(), ticks, seconds,
+			   seconds > 0 ? ticks / seconds : 0.0, seed_text, result);
+		fflush(stdout);
+
+		total_ticks += ticks;
+		total_seconds += seconds;
+	}
+
+	printf("%zu films, %d failed, %lld ticks in %.3f s (%.0f ticks/s)\n",
+		   films.size(), failures, static_cast<long long>(total_ticks), total_seconds,
+		   total_seconds > 0 ? total_ticks / total_seconds : 0.0);
+
+	return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+	shell_options.parse(argc, argv);
+	shell_options.headless = true;
+
+	std::vector<std::string> films;
+	if (!shell_options.replay_directory.empty())
+		find_films(shell_options.replay_directory, films);
+	films.insert(films.end(), shell_options.files.begin(), shell_options.files.end());
+
+	if (films.empty())
+	{
+		printf("Usage: %s [-l replay-directory] scenario-directory [film...]\n", shell_options.program_name.c_str());
+		return 1;
+	}
+
+	auto code = 0;
+
+	try {
+
+		initialize_application();
+		code = run_films(films);
+
+	}
+	catch (std::exception& e) {
+		try
+		{
+			logFatal("Unhandled exception: %s", e.what());
+		}
+		catch (...)
+		{
+		}
+		fprintf(stderr, "%s\n", e.what());
+		code = 1;
+	}
+	catch (...) {
+		try
+		{
+			logFatal("Unknown exception");
+		}
+		catch (...)
+		{
+		}
+		code = 1;
+	}
+
+	try
+	{
+		shutdown_application();
+	}
+	catch (...)
+	{
+
+	}
+
+	return code;
+}
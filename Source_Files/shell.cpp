@@ -115,6 +115,8 @@
 #include "Movie.h"
 #include "HTTP.h"
 #include "WadImageCache.h"
+#include "TextureCache.h"
+#include "map_index_cache.h"
 
 #ifdef __WIN32__
 #define WIN32_LEAN_AND_MEAN
@@ -254,8 +256,19 @@ void initialize_application(void)
 	SDL_setenv("SDL_AUDIODRIVER", "directsound", 0);
 #endif
 
+	// A headless run never opens a window or touches the audio device;
+	// an offscreen one (alephbet-renderbench) keeps video for the renderers
+	if (shell_options.headless)
+	{
+		shell_options.nosound = true;
+		shell_options.nojoystick = true;
+		shell_options.nogl = !shell_options.offscreen;
+		shell_options.nogamma = true;
+	}
+	bool want_video = !shell_options.headless || shell_options.offscreen;
+
 	// Initialize SDL
-	int retval = SDL_Init(SDL_INIT_VIDEO |
+	int retval = SDL_Init((want_video ? SDL_INIT_VIDEO : 0) |
 						  (shell_options.nosound ? 0 : SDL_INIT_AUDIO) |
 						  (shell_options.nojoystick ? 0 : SDL_INIT_JOYSTICK|SDL_INIT_GAMECONTROLLER) |
 						  (shell_options.debug ? SDL_INIT_NOPARACHUTE : 0));
@@ -275,7 +288,7 @@ void initialize_application(void)
 	SDL_StopTextInput();
 	
 	// See if we had a scenario folder dropped on us
-	if (shell_options.directory == "") {
+	if (shell_options.directory == "" && !shell_options.headless) {
 		SDL_EventState(SDL_DROPFILE, SDL_ENABLE);
 		SDL_Event event;
 		while (SDL_PollEvent(&event)) {
@@ -388,6 +401,9 @@ void initialize_application(void)
 	}
 	
 	// Check for presence of files (one last chance to change data_search_path)
+	if (!have_default_files() && shell_options.headless) {
+		throw std::runtime_error("Can't find default data files (pass the scenario directory)");
+	}
 	if (!have_default_files()) {
 		char chosen_dir[256];
 		if (alert_choose_scenario(chosen_dir)) {
@@ -432,6 +448,8 @@ void initialize_application(void)
 	screenshots_dir.CreateDirectory();
 	
 	WadImageCache::instance()->initialize_cache();
+	TextureCache::instance()->initialize_cache();
+	prune_map_cache();
 
 #ifndef HAVE_OPENGL
 	graphics_preferences->screen_mode.acceleration = _no_acceleration;
@@ -442,7 +460,8 @@ void initialize_application(void)
 		graphics_preferences->screen_mode.fullscreen = true;
 	if (shell_options.force_windowed)		// takes precedence over fullscreen because windowed is safer
 		graphics_preferences->screen_mode.fullscreen = false;
-	write_preferences();
+	if (!shell_options.headless)
+		write_preferences();
 
 	Plugins::instance()->load_mml(true);
 
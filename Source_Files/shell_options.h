@@ -46,6 +46,8 @@ struct ShellOptions {
 
 	bool skip_intro;
 	bool editor;
+	bool headless;	// set by alephbet-replay; no window, GL or audio device
+	bool offscreen;	// set by alephbet-renderbench; headless, but renders into a window
 
 	std::string replay_directory;
 
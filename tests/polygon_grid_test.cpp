@@ -0,0 +1,145 @@
+#include "cseries.h"
+#include "map.h"
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <vector>
+
+// the search world_point_to_polygon_index() did before it had a grid
+static short linear_point_to_polygon_index(world_point2d *location) {
+	for (short polygon_index = 0; polygon_index < dynamic_world->polygon_count; ++polygon_index) {
+		if (!POLYGON_IS_DETACHED(get_polygon_data(polygon_index)) && point_in_polygon(polygon_index, location))
+			return polygon_index;
+	}
+	return NONE;
+}
+
+// just enough of a map for point_in_polygon(): endpoints, and one line per polygon edge
+class TestMap {
+public:
+	TestMap() {
+		if (!dynamic_world) {
+			dynamic_world = new dynamic_data;
+			obj_clear(*dynamic_world);
+		}
+		EndpointList.clear();
+		LineList.clear();
+		PolygonList.clear();
+	}
+
+	~TestMap() {
+		EndpointList.clear();
+		LineList.clear();
+		PolygonList.clear();
+		dynamic_world->endpoint_count = dynamic_world->line_count = dynamic_world->polygon_count = 0;
+		invalidate_polygon_grid();
+	}
+
+	short add_endpoint(int16 x, int16 y) {
+		endpoint_data endpoint;
+		obj_clear(endpoint);
+		endpoint.vertex.x = x;
+		endpoint.vertex.y = y;
+		EndpointList.push_back(endpoint);
+		return static_cast<short>(EndpointList.size() - 1);
+	}
+
+	// flipped edges get their line the other way around, as broken maps do
+	short add_polygon(const std::vector<short>& endpoints, const std::vector<bool>& flipped = {}, bool detached = false) {
+		polygon_data polygon;
+		obj_clear(polygon);
+		polygon.vertex_count = static_cast<uint16>(endpoints.size());
+		for (size_t i = 0; i < endpoints.size(); ++i) {
+			line_data line;
+			obj_clear(line);
+			short e0 = endpoints[i], e1 = endpoints[(i + 1) % endpoints.size()];
+			bool flip = i < flipped.size() && flipped[i];
+			line.endpoint_indexes[0] = flip ? e1 : e0;
+			line.endpoint_indexes[1] = flip ? e0 : e1;
+			LineList.push_back(line);
+
+			polygon.endpoint_indexes[i] = endpoints[i];
+			polygon.line_indexes[i] = static_cast<short>(LineList.size() - 1);
+		}
+		if (detached)
+			polygon.flags |= POLYGON_IS_DETACHED_BIT;
+		PolygonList.push_back(polygon);
+		return static_cast<short>(PolygonList.size() - 1);
+	}
+
+	void finish() {
+		dynamic_world->endpoint_count = static_cast<int16>(EndpointList.size());
+		dynamic_world->line_count = static_cast<int16>(LineList.size());
+		dynamic_world->polygon_count = static_cast<int16>(PolygonList.size());
+		invalidate_polygon_grid();
+	}
+};
+
+static void check_point(int16 x, int16 y) {
+	world_point2d p = { x, y };
+	INFO("(" << x << ", " << y << ")");
+	CHECK(world_point_to_polygon_index(&p) == linear_point_to_polygon_index(&p));
+}
+
+TEST_CASE("Polygon grid matches the linear search on degenerate geometry", "[PolygonGrid]") {
+	TestMap map;
+
+	short a = map.add_endpoint(0, 0), b = map.add_endpoint(1024, 0), c = map.add_endpoint(1024, 1024), d = map.add_endpoint(0, 1024);
+	short e = map.add_endpoint(2048, 0), f = map.add_endpoint(2048, 1024);
+	short m0 = map.add_endpoint(-512, 512), m1 = map.add_endpoint(512, 512), m2 = map.add_endpoint(1536, 512);
+
+	map.add_polygon({m0, m1, m2});                          // zero area: three points along a line
+	map.add_polygon({a, b, c, d});                          // an ordinary square
+	map.add_polygon({b, e, f, c}, {false, true});           // one line the wrong way round: an unbounded strip
+	map.add_polygon({a, a, b, b});                          // repeated vertices
+	map.add_polygon({d, c, b, a});                          // wound backwards
+	map.add_polygon({b, e, f, c}, {}, true);                // detached
+	map.add_polygon({b, e, f, c});                          // covered by the strip above
+	map.add_polygon({});                                    // no vertices at all
+	map.finish();
+
+	for (int y = -1536; y <= 2560; y += 64)
+		for (int x = -1536; x <= 3584; x += 64)
+			check_point(x, y);
+
+	for (const auto& endpoint : EndpointList)
+		check_point(endpoint.vertex.x, endpoint.vertex.y);
+}
+
+TEST_CASE("Polygon grid matches the linear search on random polygons", "[PolygonGrid]") {
+	TestMap map;
+	std::mt19937 rng(4);
+	std::uniform_int_distribution<int> coordinate(-4096, 4096);
+	std::uniform_int_distribution<int> vertices(3, MAXIMUM_VERTICES_PER_POLYGON);
+	std::bernoulli_distribution flip(0.1);
+
+	for (int i = 0; i < 128; ++i)
+		map.add_endpoint(coordinate(rng), coordinate(rng));
+
+	// convex polygons around random centers, plus arbitrary (often self-crossing) ones
+	for (int i = 0; i < 256; ++i) {
+		std::vector<short> endpoints;
+		std::vector<bool> flipped;
+		int count = vertices(rng);
+		if (i % 2) {
+			int cx = coordinate(rng), cy = coordinate(rng), radius = 64 + (rng() % 1024);
+			for (int j = 0; j < count; ++j) {
+				double angle = 2 * M_PI * j / count;
+				endpoints.push_back(map.add_endpoint(cx + static_cast<int>(radius * cos(angle)), cy + static_cast<int>(radius * sin(angle))));
+			}
+		} else {
+			for (int j = 0; j < count; ++j)
+				endpoints.push_back(static_cast<short>(rng() % 128));
+		}
+		for (int j = 0; j < count; ++j)
+			flipped.push_back(flip(rng));
+		map.add_polygon(endpoints, flipped, rng() % 16 == 0);
+	}
+	map.finish();
+
+	std::uniform_int_distribution<int> sample(-6000, 6000);
+	for (int i = 0; i < 50000; ++i)
+		check_point(sample(rng), sample(rng));
+
+	for (const auto& endpoint : EndpointList)
+		check_point(endpoint.vertex.x, endpoint.vertex.y);
+}
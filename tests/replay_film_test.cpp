@@ -55,13 +55,14 @@ TEST_CASE("Film replay", "[Replay]") {
 
 	const auto replays = get_replays(shell_options.replay_directory);
 
+	shell_options.headless = true;
 	initialize_application();
 
 	for (const auto& replay : replays) {
 		INFO(replay.first);
-		REQUIRE(handle_open_document(replay.first));
-		set_replay_speed(INT16_MAX);
-		main_event_loop();
+		FileSpecifier file = replay.first;
+		int32 ticks;
+		REQUIRE(run_headless_replay(file, ticks));
 		auto seed = get_random_seed();
 		CHECK(seed == replay.second);
 	}
@@ -111,15 +112,15 @@ TEST_CASE("Film replay set seed", "[Replay]") {
 
 	const auto replays = get_replays(shell_options.replay_directory);
 
+	shell_options.headless = true;
 	initialize_application();
 
 	for (const auto& replay : replays) {
 		INFO(replay);
-		REQUIRE(handle_open_document(replay));
-		set_replay_speed(INT16_MAX);
-		main_event_loop();
-		auto seed = get_random_seed();
 		FileSpecifier file = replay;
+		int32 ticks;
+		REQUIRE(run_headless_replay(file, ticks));
+		auto seed = get_random_seed();
 		std::string directory, file_name;
 		file.SplitPath(directory, file_name);
 		auto position = file_name.find_last_of('.');
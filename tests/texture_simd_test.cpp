@@ -0,0 +1,184 @@
+#include "cseries.h"
+#include "low_level_textures.h"
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <vector>
+
+extern SDL_Surface *world_pixels;
+
+static constexpr int kScreenWidth = 157;
+static constexpr int kScreenHeight = 61;
+
+// a 32-bit screen that the "nice" blend also takes its pixel format from
+class TestScreen {
+public:
+	TestScreen() : bitmap_buffer(sizeof(bitmap_definition) + kScreenHeight * sizeof(pixel8*)) {
+		surface = SDL_CreateRGBSurfaceWithFormat(0, kScreenWidth, kScreenHeight, 32, SDL_PIXELFORMAT_ARGB8888);
+		world_pixels = surface;
+
+		bitmap = reinterpret_cast<bitmap_definition*>(bitmap_buffer.data());
+		bitmap->width = kScreenWidth;
+		bitmap->height = kScreenHeight;
+		bitmap->bytes_per_row = surface->pitch;
+		for (int y = 0; y < kScreenHeight; ++y)
+			bitmap->row_addresses[y] = static_cast<pixel8*>(surface->pixels) + y * surface->pitch;
+	}
+
+	~TestScreen() {
+		world_pixels = nullptr;
+		SDL_FreeSurface(surface);
+	}
+
+	void fill(uint32 seed) {
+		std::mt19937 rng(seed);
+		for (int y = 0; y < kScreenHeight; ++y)
+			for (int x = 0; x < kScreenWidth; ++x)
+				reinterpret_cast<pixel32*>(bitmap->row_addresses[y])[x] = rng();
+	}
+
+	std::vector<pixel32> pixels() const {
+		std::vector<pixel32> result;
+		for (int y = 0; y < kScreenHeight; ++y)
+			result.insert(result.end(), reinterpret_cast<pixel32*>(bitmap->row_addresses[y]), reinterpret_cast<pixel32*>(bitmap->row_addresses[y]) + kScreenWidth);
+		return result;
+	}
+
+	bitmap_definition* bitmap;
+
+private:
+	SDL_Surface* surface;
+	std::vector<byte> bitmap_buffer;
+};
+
+// rows of width pixels stored one after the other, as the horizontal mappers expect
+class TestTexture {
+public:
+	TestTexture(int width, int height, std::mt19937& rng) : pixels(width * height), bitmap_buffer(sizeof(bitmap_definition) + height * sizeof(pixel8*)) {
+		for (auto& pixel : pixels)
+			pixel = rng() % 4 ? rng() : 0;
+
+		bitmap = reinterpret_cast<bitmap_definition*>(bitmap_buffer.data());
+		bitmap->width = height; // rows are columns, as in the shapes file
+		bitmap->height = width;
+		bitmap->bytes_per_row = width;
+		for (int row = 0; row < height; ++row)
+			bitmap->row_addresses[row] = &pixels[row * width];
+	}
+
+	bitmap_definition* bitmap;
+
+private:
+	std::vector<pixel8> pixels;
+	std::vector<byte> bitmap_buffer;
+};
+
+// draws with the scalar mappers, then with every vector level this processor has
+template <typename Draw>
+static void require_same_pixels(Draw draw) {
+	TestScreen screen;
+	int level = get_texture_simd_level();
+
+	set_texture_simd_level(_texture_simd_none);
+	screen.fill(1);
+	draw(screen.bitmap);
+	auto expected = screen.pixels();
+
+	for (int simd = _texture_simd_sse2; simd <= texture_simd_supported(); ++simd) {
+		set_texture_simd_level(simd);
+		screen.fill(1);
+		draw(screen.bitmap);
+		CAPTURE(simd);
+		REQUIRE(screen.pixels() == expected);
+	}
+
+	set_texture_simd_level(level);
+}
+
+TEST_CASE("Vector texture mappers match the scalar ones", "[Textures]") {
+
+	if (texture_simd_supported() == _texture_simd_none)
+		return;
+
+	std::mt19937 rng(6906);
+
+	std::vector<pixel32> shading_table(256);
+	std::vector<uint8> opacity_table(256);
+	for (int i = 0; i < 256; ++i) {
+		shading_table[i] = rng();
+		opacity_table[i] = rng();
+	}
+
+	std::vector<short> x0_table(kScreenHeight), x1_table(kScreenHeight);
+	for (int y = 0; y < kScreenHeight; ++y) {
+		x0_table[y] = rng() % kScreenWidth;
+		x1_table[y] = x0_table[y] + rng() % (kScreenWidth - x0_table[y] + 1);
+	}
+
+	SECTION("Horizontal polygons") {
+		TestTexture texture7(128, 128, rng), texture8(256, 256, rng);
+
+		std::vector<_horizontal_polygon_line_data> lines(kScreenHeight);
+		for (auto& line : lines)
+			line = { static_cast<uint32>(rng()), static_cast<uint32>(rng()), static_cast<uint32>(rng()), static_cast<uint32>(rng()), shading_table.data() };
+
+		require_same_pixels([&](bitmap_definition* screen) {
+			texture_horizontal_polygon_lines<pixel32, _sw_alpha_off, 7>(texture7.bitmap, screen, nullptr, lines.data(), 0, x0_table.data(), x1_table.data(), kScreenHeight);
+			texture_horizontal_polygon_lines<pixel32, _sw_alpha_off, 8>(texture8.bitmap, screen, nullptr, lines.data(), 0, x0_table.data(), x1_table.data(), kScreenHeight);
+		});
+		require_same_pixels([&](bitmap_definition* screen) {
+			texture_horizontal_polygon_lines<pixel32, _sw_alpha_fast, 7>(texture7.bitmap, screen, nullptr, lines.data(), 0, x0_table.data(), x1_table.data(), kScreenHeight);
+		});
+		require_same_pixels([&](bitmap_definition* screen) {
+			texture_horizontal_polygon_lines<pixel32, _sw_alpha_nice, 8>(texture8.bitmap, screen, nullptr, lines.data(), 0, x0_table.data(), x1_table.data(), kScreenHeight, opacity_table.data());
+		});
+	}
+
+	SECTION("Landscapes") {
+		TestTexture landscape(512, 64, rng);
+
+		std::vector<_horizontal_polygon_line_data> lines(kScreenHeight);
+		for (auto& line : lines)
+			line = { static_cast<uint32>(rng()), static_cast<uint32>(rng() % 64), static_cast<uint32>(rng()), 0, shading_table.data() };
+
+		require_same_pixels([&](bitmap_definition* screen) {
+			landscape_horizontal_polygon_lines<pixel32>(landscape.bitmap, screen, nullptr, lines.data(), 0, x0_table.data(), x1_table.data(), kScreenHeight);
+		});
+	}
+
+	SECTION("Vertical polygons") {
+		TestTexture texture(128, 128, rng);
+
+		const int columns = 128;
+		std::vector<byte> buffer(sizeof(_vertical_polygon_data) + columns * sizeof(_vertical_polygon_line_data));
+		auto data = reinterpret_cast<_vertical_polygon_data*>(buffer.data());
+		data->downshift = 32 - 7;
+		data->x0 = 4;
+		data->width = columns;
+
+		std::vector<short> y0_table(columns), y1_table(columns);
+		auto line = reinterpret_cast<_vertical_polygon_line_data*>(data + 1);
+		for (int x = 0; x < columns; ++x) {
+			// mostly overlapping columns, so the four-column path does most of the work
+			y0_table[x] = rng() % 8 ? rng() % 12 : rng() % kScreenHeight;
+			y1_table[x] = rng() % 8 ? kScreenHeight - rng() % 12 : rng() % (kScreenHeight + 1);
+			if (y0_table[x] > y1_table[x])
+				std::swap(y0_table[x], y1_table[x]);
+
+			line[x].shading_table = shading_table.data();
+			line[x].texture = texture.bitmap->row_addresses[rng() % 128];
+			line[x].texture_y = rng();
+			line[x].texture_dy = rng() >> 6;
+		}
+
+		require_same_pixels([&](bitmap_definition* screen) {
+			texture_vertical_polygon_lines<pixel32, _sw_alpha_off, false>(screen, nullptr, data, y0_table.data(), y1_table.data(), 0, kScreenHeight);
+			texture_vertical_polygon_lines<pixel32, _sw_alpha_off, true>(screen, nullptr, data, y0_table.data(), y1_table.data(), 0, kScreenHeight);
+		});
+		require_same_pixels([&](bitmap_definition* screen) {
+			texture_vertical_polygon_lines<pixel32, _sw_alpha_fast, true>(screen, nullptr, data, y0_table.data(), y1_table.data(), 0, kScreenHeight);
+		});
+		require_same_pixels([&](bitmap_definition* screen) {
+			texture_vertical_polygon_lines<pixel32, _sw_alpha_nice, true>(screen, nullptr, data, y0_table.data(), y1_table.data(), 0, kScreenHeight, opacity_table.data());
+		});
+	}
+}